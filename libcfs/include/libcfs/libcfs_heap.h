@@ -34,8 +34,8 @@
 
 /** \defgroup heap Binary heap
  *
- * The binary heap is a scalable data structure created using a binary tree. It
- * is capable of maintaining large sets of elements sorted usually by one or
+ * The binary heap is a scalable data structure created using a tree. It is
+ * capable of maintaining large sets of elements sorted usually by one or
  * more element properties, but really based on anything that can be used as a
  * binary predicate in order to determine the relevant ordering of any two nodes
  * that belong to the set. There is no search operation, rather the intention is
@@ -43,6 +43,12 @@
  * the tree (as this is an implementation of a min-heap) to be removed by users
  * for consumption.
  *
+ * Despite its name, each node of the tree has CBH_ARITY children rather than
+ * two. A wider tree is shallower, so inserting a node (the most common
+ * operation for NRS policies) visits fewer levels, and the children of a node
+ * are stored next to each other, which keeps the cache footprint of the array
+ * small when the heap holds hundreds of thousands of elements.
+ *
  * Users of the heap should embed a \e struct cfs_binheap_node object instance
  * on every object of the set that they wish the binary heap instance to handle,
  * and (at a minimum) provide a struct cfs_binheap_ops::hop_compare()
@@ -64,10 +70,15 @@
  * be maintained by a \e struct cfs_binheap instance.
  */
 struct cfs_binheap_node {
-	/** Index into the binary tree */
+	/** Index into the tree */
 	unsigned int	chn_index;
 };
 
+#define CBH_ARITY_SHIFT	2
+#define CBH_ARITY	(1 << CBH_ARITY_SHIFT)	    /* # children per node */
+#define CBH_PARENT(idx)		(((idx) - 1) >> CBH_ARITY_SHIFT)
+#define CBH_FIRST_CHILD(idx)	(((idx) << CBH_ARITY_SHIFT) + 1)
+
 #define CBH_SHIFT	9
 #define CBH_SIZE       (1 << CBH_SHIFT)		    /* # ptrs per level */
 #define CBH_MASK       (CBH_SIZE - 1)
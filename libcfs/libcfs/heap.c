@@ -255,8 +255,7 @@ cfs_binheap_destroy(struct cfs_binheap *h)
 EXPORT_SYMBOL(cfs_binheap_destroy);
 
 /**
- * Obtains a double pointer to a heap element, given its index into the binary
- * tree.
+ * Obtains a double pointer to a heap element, given its index into the tree.
  *
  * \param[in] h	  The binary heap instance
  * \param[in] idx The requested node's index
@@ -280,7 +279,7 @@ cfs_binheap_pointer(struct cfs_binheap *h, unsigned int idx)
 }
 
 /**
- * Obtains a pointer to a heap element, given its index into the binary tree.
+ * Obtains a pointer to a heap element, given its index into the tree.
  *
  * \param[in] h	  The binary heap
  * \param[in] idx The requested node's index
@@ -299,7 +298,7 @@ cfs_binheap_find(struct cfs_binheap *h, unsigned int idx)
 EXPORT_SYMBOL(cfs_binheap_find);
 
 /**
- * Moves a node upwards, towards the root of the binary tree.
+ * Moves a node upwards, towards the root of the tree.
  *
  * \param[in] h The heap
  * \param[in] e The node
@@ -320,7 +319,7 @@ cfs_binheap_bubble(struct cfs_binheap *h, struct cfs_binheap_node *e)
 	LASSERT(*cur_ptr == e);
 
 	while (cur_idx > 0) {
-		parent_idx = (cur_idx - 1) >> 1;
+		parent_idx = CBH_PARENT(cur_idx);
 
 		parent_ptr = cfs_binheap_pointer(h, parent_idx);
 		LASSERT((*parent_ptr)->chn_index == parent_idx);
@@ -342,7 +341,11 @@ cfs_binheap_bubble(struct cfs_binheap *h, struct cfs_binheap_node *e)
 }
 
 /**
- * Moves a node downwards, towards the last level of the binary tree.
+ * Moves a node downwards, towards the last level of the tree.
+ *
+ * All CBH_ARITY children of a node are adjacent in the element array, so
+ * unless they straddle two chunks of pointers they are reached through a
+ * single cfs_binheap_pointer() lookup and usually share a cache line.
  *
  * \param[in] h The heap
  * \param[in] e The node
@@ -354,14 +357,17 @@ static int
 cfs_binheap_sink(struct cfs_binheap *h, struct cfs_binheap_node *e)
 {
 	unsigned int	     n = h->cbh_nelements;
+	unsigned int	     first_idx;
+	unsigned int	     last_idx;
+	struct cfs_binheap_node **first_ptr;
 	unsigned int	     child_idx;
 	struct cfs_binheap_node **child_ptr;
 	struct cfs_binheap_node  *child;
-	unsigned int	     child2_idx;
-	struct cfs_binheap_node **child2_ptr;
-	struct cfs_binheap_node  *child2;
+	unsigned int	     idx;
+	struct cfs_binheap_node **ptr;
 	unsigned int	     cur_idx;
 	struct cfs_binheap_node **cur_ptr;
+	bool		     contig;
 	int		     did_sth = 0;
 
 	cur_idx = e->chn_index;
@@ -369,22 +375,27 @@ cfs_binheap_sink(struct cfs_binheap *h, struct cfs_binheap_node *e)
 	LASSERT(*cur_ptr == e);
 
 	while (cur_idx < n) {
-		child_idx = (cur_idx << 1) + 1;
-		if (child_idx >= n)
+		first_idx = CBH_FIRST_CHILD(cur_idx);
+		if (first_idx >= n)
 			break;
 
-		child_ptr = cfs_binheap_pointer(h, child_idx);
+		last_idx = min(first_idx + CBH_ARITY, n);
+		contig = (first_idx & CBH_MASK) + CBH_ARITY <= CBH_SIZE;
+
+		first_ptr = cfs_binheap_pointer(h, first_idx);
+		child_idx = first_idx;
+		child_ptr = first_ptr;
 		child = *child_ptr;
 
-		child2_idx = child_idx + 1;
-		if (child2_idx < n) {
-			child2_ptr = cfs_binheap_pointer(h, child2_idx);
-			child2 = *child2_ptr;
+		/* pick the child with the highest priority */
+		for (idx = first_idx + 1; idx < last_idx; idx++) {
+			ptr = contig ? first_ptr + (idx - first_idx) :
+				       cfs_binheap_pointer(h, idx);
 
-			if (h->cbh_ops->hop_compare(child2, child)) {
-				child_idx = child2_idx;
-				child_ptr = child2_ptr;
-				child = child2;
+			if (h->cbh_ops->hop_compare(*ptr, child)) {
+				child_idx = idx;
+				child_ptr = ptr;
+				child = *ptr;
 			}
 		}
 
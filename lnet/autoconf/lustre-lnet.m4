@@ -658,6 +658,36 @@ kern_sock_flag, [
 EXTRA_KCFLAGS="$tmp_flags"
 ]) # LN_CONFIG_SOCK_ACCEPT
 
+#
+# LN_CONFIG_SOCK_RECVMSG_ITER
+#
+# 4.7 commit 2da62906b1e298695e1bb725927041cd59942c98
+# net: get rid of an extra argument to sock_recvmsg
+# sock_recvmsg() takes the data from msg->msg_iter, so a bvec
+# iterator can be used to receive straight into pages
+#
+AC_DEFUN([LN_CONFIG_SOCK_RECVMSG_ITER], [
+tmp_flags="$EXTRA_KCFLAGS"
+EXTRA_KCFLAGS="-Werror"
+LB_CHECK_COMPILE([if 'sock_recvmsg' takes a bvec 'msg_iter'],
+sock_recvmsg_iter, [
+	#include <linux/bvec.h>
+	#include <linux/net.h>
+	#include <linux/socket.h>
+	#include <linux/uio.h>
+],[
+	struct msghdr msg = { .msg_flags = 0 };
+	struct bio_vec bvec = { .bv_len = 0 };
+
+	iov_iter_bvec(&msg.msg_iter, READ, &bvec, 1, 0);
+	sock_recvmsg(NULL, &msg, MSG_DONTWAIT);
+],[
+	AC_DEFINE(HAVE_SOCK_RECVMSG_ITER, 1,
+		['sock_recvmsg' takes a bvec 'msg_iter'])
+])
+EXTRA_KCFLAGS="$tmp_flags"
+]) # LN_CONFIG_SOCK_RECVMSG_ITER
+
 #
 # LN_HAVE_ORACLE_OFED_EXTENSIONS
 #
@@ -678,6 +708,33 @@ oracle_ofed_ext, [
 ])
 ]) # LN_HAVE_ORACLE_OFED_EXTENSIONS
 
+#
+# LN_CONFIG_SOCK_ZEROCOPY
+#
+# 4.14 commit 52267790ef52d7513879238ca9fac22c1733e0e3
+# sock: add MSG_ZEROCOPY
+#
+AC_DEFUN([LN_CONFIG_SOCK_ZEROCOPY], [
+tmp_flags="$EXTRA_KCFLAGS"
+EXTRA_KCFLAGS="-Werror"
+LB_CHECK_COMPILE([if sockets support MSG_ZEROCOPY],
+sock_zerocopy, [
+	#include <linux/errqueue.h>
+	#include <net/sock.h>
+],[
+	struct sock *sk = NULL;
+	int flags = MSG_ZEROCOPY | SO_ZEROCOPY;
+
+	flags |= SO_EE_ORIGIN_ZEROCOPY | SO_EE_CODE_ZEROCOPY_COPIED;
+	flags |= atomic_read(&sk->sk_zckey);
+	(void)flags;
+],[
+	AC_DEFINE(HAVE_SOCK_ZEROCOPY, 1,
+		[sockets support MSG_ZEROCOPY])
+])
+EXTRA_KCFLAGS="$tmp_flags"
+]) # LN_CONFIG_SOCK_ZEROCOPY
+
 #
 # LN_CONFIG_SOCK_GETNAME
 #
@@ -766,10 +823,13 @@ LN_EXPORT_KMAP_TO_PAGE
 LN_CONFIG_SK_DATA_READY
 # 4.x
 LN_CONFIG_SOCK_CREATE_KERN
+# 4.7
+LN_CONFIG_SOCK_RECVMSG_ITER
 # 4.11
 LN_CONFIG_SOCK_ACCEPT
 # 4.14
 LN_HAVE_ORACLE_OFED_EXTENSIONS
+LN_CONFIG_SOCK_ZEROCOPY
 # 4.17
 LN_CONFIG_SOCK_GETNAME
 ]) # LN_PROG_LINUX
@@ -196,6 +196,15 @@ extern struct kmem_cache *lnet_small_mds_cachep; /* <= LNET_SMALL_MD_SIZE bytes
 						  * MDs kmem_cache */
 extern struct kmem_cache *lnet_rspt_cachep;
 extern struct kmem_cache *lnet_msg_cachep;
+/* per-CPT magazines in front of the caches above */
+extern struct lnet_obj_cache **lnet_me_objcache;
+extern struct lnet_obj_cache **lnet_small_md_objcache;
+extern struct lnet_obj_cache **lnet_msg_objcache;
+
+void *lnet_obj_cache_alloc(struct lnet_obj_cache **caches,
+			   struct kmem_cache *slab, size_t size);
+void lnet_obj_cache_free(struct lnet_obj_cache **caches,
+			 struct kmem_cache *slab, void *obj);
 
 static inline struct lnet_eq *
 lnet_eq_alloc (void)
@@ -229,8 +238,9 @@ lnet_md_alloc(struct lnet_md *umd)
 	}
 
 	if (size <= LNET_SMALL_MD_SIZE) {
-		md = kmem_cache_alloc(lnet_small_mds_cachep,
-				      GFP_NOFS | __GFP_ZERO);
+		md = lnet_obj_cache_alloc(lnet_small_md_objcache,
+					  lnet_small_mds_cachep,
+					  LNET_SMALL_MD_SIZE);
 		if (md) {
 			CDEBUG(D_MALLOC, "slab-alloced 'md' of size %u at "
 			       "%p.\n", size, md);
@@ -248,6 +258,7 @@ lnet_md_alloc(struct lnet_md *umd)
 		md->md_options = umd->options;
 		md->md_niov = niov;
 		INIT_LIST_HEAD(&md->md_list);
+		spin_lock_init(&md->md_handler_lock);
 	}
 
 	return md;
@@ -267,7 +278,8 @@ lnet_md_free(struct lnet_libmd *md)
 
 	if (size <= LNET_SMALL_MD_SIZE) {
 		CDEBUG(D_MALLOC, "slab-freed 'md' at %p.\n", md);
-		kmem_cache_free(lnet_small_mds_cachep, md);
+		lnet_obj_cache_free(lnet_small_md_objcache,
+				    lnet_small_mds_cachep, md);
 	} else {
 		LIBCFS_FREE(md, size);
 	}
@@ -278,7 +290,8 @@ lnet_me_alloc (void)
 {
 	struct lnet_me *me;
 
-	me = kmem_cache_alloc(lnet_mes_cachep, GFP_NOFS | __GFP_ZERO);
+	me = lnet_obj_cache_alloc(lnet_me_objcache, lnet_mes_cachep,
+				  sizeof(*me));
 
 	if (me)
 		CDEBUG(D_MALLOC, "slab-alloced 'me' at %p.\n", me);
@@ -292,7 +305,7 @@ static inline void
 lnet_me_free(struct lnet_me *me)
 {
 	CDEBUG(D_MALLOC, "slab-freed 'me' at %p.\n", me);
-	kmem_cache_free(lnet_mes_cachep, me);
+	lnet_obj_cache_free(lnet_me_objcache, lnet_mes_cachep, me);
 }
 
 struct lnet_libhandle *lnet_res_lh_lookup(struct lnet_res_container *rec,
@@ -464,7 +477,8 @@ lnet_msg_alloc(void)
 {
 	struct lnet_msg *msg;
 
-	msg = kmem_cache_alloc(lnet_msg_cachep, GFP_NOFS | __GFP_ZERO);
+	msg = lnet_obj_cache_alloc(lnet_msg_objcache, lnet_msg_cachep,
+				   sizeof(*msg));
 
 	return (msg);
 }
@@ -473,7 +487,7 @@ static inline void
 lnet_msg_free(struct lnet_msg *msg)
 {
 	LASSERT(!msg->msg_onactivelist);
-	kmem_cache_free(lnet_msg_cachep, msg);
+	lnet_obj_cache_free(lnet_msg_objcache, lnet_msg_cachep, msg);
 }
 
 static inline struct lnet_rsp_tracker *
@@ -547,6 +561,7 @@ void lnet_lib_exit(void);
 extern unsigned lnet_transaction_timeout;
 extern unsigned lnet_retry_count;
 extern unsigned int lnet_numa_range;
+extern unsigned int lnet_weighted_selection;
 extern unsigned int lnet_health_sensitivity;
 extern unsigned int lnet_recovery_interval;
 extern unsigned int lnet_peer_discovery_disabled;
@@ -587,6 +602,7 @@ void lnet_router_debugfs_fini(void);
 int  lnet_rtrpools_alloc(int im_a_router);
 void lnet_destroy_rtrbuf(struct lnet_rtrbuf *rb, int npages);
 int  lnet_rtrpools_adjust(int tiny, int small, int large);
+void lnet_rtrpools_tune(void);
 int lnet_rtrpools_enable(void);
 void lnet_rtrpools_disable(void);
 void lnet_rtrpools_free(int keep_pools);
@@ -612,6 +628,9 @@ void lnet_msg_commit(struct lnet_msg *msg, int cpt);
 void lnet_msg_decommit(struct lnet_msg *msg, int cpt, int status);
 
 void lnet_eq_enqueue_event(struct lnet_eq *eq, struct lnet_event *ev);
+lnet_eq_handler_t lnet_eq_prepare_event(struct lnet_eq *eq,
+					struct lnet_event *ev, int cpt);
+void lnet_eq_handler_done(struct lnet_eq *eq, int cpt);
 void lnet_prep_send(struct lnet_msg *msg, int type,
 		    struct lnet_process_id target, unsigned int offset,
 		    unsigned int len);
@@ -1035,4 +1054,34 @@ __u32 lnet_sum_stats(struct lnet_element_stats *stats,
 void lnet_usr_translate_stats(struct lnet_ioctl_element_msg_stats *msg_stats,
 			      struct lnet_element_stats *stats);
 
+/*
+ * The round robin sequence of the fastest interface advances by
+ * LNET_SEL_STRIDE_BASE each time it is selected, slower ones by
+ * proportionally more, up to LNET_SEL_STRIDE_MAX.
+ */
+#define LNET_SEL_STRIDE_BASE	16
+#define LNET_SEL_STRIDE_MAX	(LNET_SEL_STRIDE_BASE * 16)
+
+static inline void
+lnet_sel_stats_init(struct lnet_sel_stats *ss)
+{
+	memset(ss, 0, sizeof(*ss));
+	ss->ss_stride = LNET_SEL_STRIDE_BASE;
+}
+
+void lnet_sel_stats_update(struct lnet_sel_stats *ss, unsigned int nob,
+			   ktime_t sent, ktime_t now);
+
+static inline void
+lnet_lat_hist_add(struct lnet_lat_hist *hist, ktime_t start, ktime_t end)
+{
+	s64 us = ktime_us_delta(end, start);
+	int idx = us > 0 ? fls64(us) : 0;
+
+	atomic_inc(&hist->lh_count[min(idx, LNET_LAT_BUCKETS - 1)]);
+}
+
+void lnet_usr_translate_sel_stats(struct lnet_ioctl_sel_stats *sel_stats,
+				  struct lnet_sel_stats *ss);
+
 #endif
@@ -117,6 +117,15 @@ struct lnet_msg {
 	 */
 	ktime_t			msg_deadline;
 
+	/* When the message started waiting for a router buffer. */
+	ktime_t			msg_rtrbuf_wait;
+
+	/* When the message was handed to the LND. */
+	ktime_t			msg_send_time;
+
+	/* When the message was queued waiting for credits. */
+	ktime_t			msg_txq_time;
+
 	/* The message health status. */
 	enum lnet_msg_hstatus	msg_health_status;
 	/* This is a recovery message */
@@ -222,6 +231,9 @@ struct lnet_libmd {
 	struct lnet_rsp_tracker *md_rspt_ptr;
 	struct lnet_eq	        *md_eq;
 	struct lnet_handle_md	 md_bulk_handle;
+	/* held while the EQ handler runs for an event of the MD, which is
+	 * not its last one; nests inside lnet_res_lock */
+	spinlock_t		 md_handler_lock;
 	union {
 		struct kvec	 iov[LNET_MAX_IOV];
 		lnet_kiov_t	 kiov[LNET_MAX_IOV];
@@ -351,6 +363,32 @@ struct lnet_element_stats {
 	struct lnet_comm_count el_drop_stats;
 };
 
+/*
+ * Moving averages of completed sends, used to weight Multi-Rail selection
+ * between the NIs of a net and the peer NIs of a peer net.
+ */
+struct lnet_sel_stats {
+	/* average send completion latency, in nanoseconds */
+	u64			ss_latency;
+	/* average size of sends, in bytes */
+	u64			ss_size;
+	/* average throughput over the busy seconds, in bytes/second */
+	u64			ss_throughput;
+	/* bytes of completed sends */
+	atomic64_t		ss_total_bytes;
+	/* ss_total_bytes when ss_throughput was last updated */
+	u64			ss_last_bytes;
+	/* when ss_throughput was last updated, in nanoseconds */
+	s64			ss_stamp;
+	/* amount the round robin sequence advances when selected */
+	u32			ss_stride;
+};
+
+/* latency histogram, see struct lnet_ioctl_lat_stats for the buckets */
+struct lnet_lat_hist {
+	atomic_t		lh_count[LNET_LAT_BUCKETS];
+};
+
 struct lnet_health_local_stats {
 	atomic_t hlt_local_interrupt;
 	atomic_t hlt_local_dropped;
@@ -475,6 +513,13 @@ struct lnet_ni {
 	/* sequence number used to round robin over nis within a net */
 	__u32			ni_seq;
 
+	/* averages used to weight ni_seq */
+	struct lnet_sel_stats	ni_sel;
+
+	/* send completion and credit queueing latencies */
+	struct lnet_lat_hist	ni_send_lat;
+	struct lnet_lat_hist	ni_queue_lat;
+
 	/*
 	 * health value
 	 *	initialized to LNET_MAX_HEALTH_VALUE
@@ -571,6 +616,11 @@ struct lnet_peer_ni {
 	__u32			lpni_ns_status;
 	/* sequence number used to round robin over peer nis within a net */
 	__u32			lpni_seq;
+	/* averages used to weight lpni_seq */
+	struct lnet_sel_stats	lpni_sel;
+	/* send completion and credit queueing latencies */
+	struct lnet_lat_hist	lpni_send_lat;
+	struct lnet_lat_hist	lpni_queue_lat;
 	/* sequence number used to round robin over gateways */
 	__u32			lpni_gw_seq;
 	/* returned RC ping features. Protected with lpni_lock */
@@ -815,7 +865,7 @@ struct lnet_route {
 	int			lr_seq;		/* sequence for round-robin */
 	__u32			lr_hops;	/* how far I am */
 	unsigned int		lr_priority;	/* route priority */
-	bool			lr_alive;	/* cached route aliveness */
+	atomic_t		lr_alive;	/* cached route aliveness */
 };
 
 #define LNET_REMOTE_NETS_HASH_DEFAULT	(1U << 7)
@@ -853,6 +903,16 @@ struct lnet_rtrbufpool {
 	int			rbp_credits;
 	/* low water mark */
 	int			rbp_mincredits;
+	/* configured # buffers, auto tuning never goes below it */
+	int			rbp_min_nbuffers;
+	/* low water mark since the pool was last tuned */
+	int			rbp_tune_mincredits;
+	/* # tuning intervals in a row the pool had idle buffers */
+	int			rbp_tune_idle;
+	/* # messages which had to wait for a buffer */
+	__u64			rbp_nwaits;
+	/* total time messages waited for a buffer, in nanoseconds */
+	__u64			rbp_wait_ns;
 };
 
 struct lnet_rtrbuf {
@@ -960,6 +1020,25 @@ struct lnet_res_container {
 	struct list_head	*rec_lh_hash;	/* handle hash */
 };
 
+#define LNET_OBJ_CACHE_SIZE	64
+/* # objects moved between a magazine and its kmem_cache at a time */
+#define LNET_OBJ_CACHE_BATCH	16
+
+/*
+ * Per-CPT magazine of free objects kept in front of one of the LNet
+ * kmem_caches (messages, small MDs, MEs)
+ */
+struct lnet_obj_cache {
+	spinlock_t		oc_lock;
+	/* # objects in oc_objs */
+	int			oc_count;
+	/* allocations served from the magazine */
+	__u64			oc_hits;
+	/* allocations that had to go to the kmem_cache */
+	__u64			oc_misses;
+	void			*oc_objs[LNET_OBJ_CACHE_SIZE];
+};
+
 /* message container */
 struct lnet_msg_container {
 	int			msc_init;	/* initialized or not */
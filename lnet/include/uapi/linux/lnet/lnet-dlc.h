@@ -200,6 +200,43 @@ struct lnet_ioctl_peer_ni_hstats {
 	__s32 hlpni_health_value;
 };
 
+/*
+ * Multi-Rail selection averages of a local NI or peer NI, depending on
+ * iss_type (enum lnet_health_type)
+ */
+struct lnet_ioctl_sel_stats {
+	struct libcfs_ioctl_hdr iss_hdr;
+	lnet_nid_t iss_nid;
+	__u32 iss_type;
+	/* round robin stride, LNET_SEL_STRIDE_BASE for the fastest */
+	__u32 iss_stride;
+	/* average send completion latency in nanoseconds */
+	__u64 iss_latency;
+	/* average send size in bytes */
+	__u64 iss_size;
+	/* average throughput in bytes/second */
+	__u64 iss_throughput;
+};
+
+/*
+ * Latency histograms of a local NI or peer NI, depending on ils_type
+ * (enum lnet_health_type). Bucket 0 counts latencies below 1us and
+ * bucket N > 0 those in [2^(N-1), 2^N) us; the last bucket also counts
+ * everything above.
+ */
+#define LNET_LAT_BUCKETS	24
+
+struct lnet_ioctl_lat_stats {
+	struct libcfs_ioctl_hdr ils_hdr;
+	lnet_nid_t ils_nid;
+	__u32 ils_type;
+	__u32 ils_pad;
+	/* from handing a message to the LND to its completion */
+	__u32 ils_send[LNET_LAT_BUCKETS];
+	/* from queueing a message for credits to handing it to the LND */
+	__u32 ils_queue[LNET_LAT_BUCKETS];
+};
+
 struct lnet_ioctl_element_msg_stats {
 	struct libcfs_ioctl_hdr im_hdr;
 	__u32 im_idx;
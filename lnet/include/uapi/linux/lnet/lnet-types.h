@@ -711,6 +711,10 @@ struct lnet_event {
  *
  * The handler must not block, must be reentrant, and must not call any LNet
  * API functions. It should return as quickly as possible.
+ *
+ * The handler runs without LNet locks held, so it may run concurrently for
+ * events of different MDs, but the events of a single MD are handled one
+ * at a time and in order, the one which has \a unlinked set last.
  */
 typedef void (*lnet_eq_handler_t)(struct lnet_event *event);
 #define LNET_EQ_HANDLER_NONE NULL
@@ -39,9 +39,14 @@
 
 #define LST_FEAT_NONE		(0)
 #define LST_FEAT_BULK_LEN	(1 << 0)	/* enable variable page size */
+#define LST_FEAT_LATENCY	(1 << 1)	/* RPC latency histograms */
 
 #define LST_FEATS_EMPTY		(LST_FEAT_NONE)
+/* features of a session unless LST_FEATURES asks for others */
 #define LST_FEATS_MASK		(LST_FEAT_NONE | LST_FEAT_BULK_LEN)
+/* all features this version understands; the optional ones are left out
+ * of the default so that sessions still include older nodes */
+#define LST_FEATS_ALL		(LST_FEATS_MASK | LST_FEAT_LATENCY)
 
 #define LST_NAME_SIZE		32		/* max name buffer length */
 
@@ -64,6 +69,7 @@
 #define LSTIO_TEST_ADD		0xC26		/* add test (to batch) */
 #define LSTIO_BATCH_QUERY	0xC27		/* query batch status */
 #define LSTIO_STAT_QUERY	0xC30		/* get stats */
+#define LSTIO_LAT_QUERY		0xC31		/* get RPC latency histograms */
 
 struct lst_sid {
 	lnet_nid_t	ses_nid;	/* nid of console node */
@@ -468,7 +474,8 @@ struct lstio_test_args {
 
 enum lst_brw_type {
 	LST_BRW_READ	= 1,
-	LST_BRW_WRITE	= 2
+	LST_BRW_WRITE	= 2,
+	LST_BRW_MIX	= 3	/* blk_write_pct% writes, reads otherwise */
 };
 
 enum lst_brw_flags {
@@ -484,6 +491,7 @@ struct lst_test_bulk_param {
 	int blk_flags;		/* reserved flags */
 	int blk_cli_off;	/* bulk offset on client */
 	int blk_srv_off;	/* reserved: bulk offset on server */
+	int blk_write_pct;	/* share of writes for LST_BRW_MIX */
 };
 
 struct lst_test_ping_param {
@@ -512,4 +520,16 @@ struct sfw_counters {
 	__u32 ping_errors;
 } WIRE_ATTR;
 
+#define LST_LAT_BUCKETS		28
+
+/**
+ * Round trip times of the test RPCs completed by a node since its session
+ * started. Bucket 0 counts RPCs which took less than 1 microsecond, and
+ * bucket N counts those which took [2^(N-1), 2^N) microseconds; the last
+ * bucket also counts anything slower.
+ */
+struct sfw_latency {
+	__u32 lat_count[LST_LAT_BUCKETS];
+} WIRE_ATTR;
+
 #endif
@@ -81,6 +81,7 @@ ksocknal_create_route(__u32 ipaddr, int port)
         route->ksnr_deleted = 0;
         route->ksnr_conn_count = 0;
         route->ksnr_share_count = 0;
+	memset(route->ksnr_type_conns, 0, sizeof(route->ksnr_type_conns));
 
         return (route);
 }
@@ -337,8 +338,12 @@ ksocknal_associate_route_conn_locked(struct ksock_route *route, struct ksock_con
                         iface->ksni_nroutes++;
         }
 
-        route->ksnr_connected |= (1<<type);
-        route->ksnr_conn_count++;
+	/* the route counts as connected for this type once it has all the
+	 * connections of that type it wants */
+	route->ksnr_type_conns[type]++;
+	if (route->ksnr_type_conns[type] >= ksocknal_route_type_conns(type))
+		route->ksnr_connected |= (1 << type);
+	route->ksnr_conn_count++;
 
         /* Successful connection => further attempts can
          * proceed immediately */
@@ -1036,6 +1041,9 @@ ksocknal_create_conn(struct lnet_ni *ni, struct ksock_route *route,
 	conn->ksnc_tx_scheduled = 0;
 	conn->ksnc_tx_carrier = NULL;
 	atomic_set (&conn->ksnc_tx_nob, 0);
+	conn->ksnc_zc_msg = 0;
+	conn->ksnc_zc_scheduled = 0;
+	INIT_LIST_HEAD(&conn->ksnc_zc_msg_txs);
 
 	LIBCFS_ALLOC(hello, offsetof(struct ksock_hello_msg,
 				     kshm_ips[LNET_INTERFACES_NUM]));
@@ -1182,9 +1190,11 @@ ksocknal_create_conn(struct lnet_ni *ni, struct ksock_route *route,
                 goto failed_2;
         }
 
-	/* Refuse to duplicate an existing connection, unless this is a
-	 * loopback connection */
+	/* Refuse to add more connections of this type than wanted between
+	 * the same pair of addresses, unless this is a loopback connection */
 	if (conn->ksnc_ipaddr != conn->ksnc_myipaddr) {
+		int nconns = 0;
+
 		list_for_each(tmp, &peer_ni->ksnp_conns) {
 			conn2 = list_entry(tmp, struct ksock_conn, ksnc_list);
 
@@ -1193,6 +1203,9 @@ ksocknal_create_conn(struct lnet_ni *ni, struct ksock_route *route,
                             conn2->ksnc_type != conn->ksnc_type)
                                 continue;
 
+			if (++nconns < ksocknal_route_type_conns(conn->ksnc_type))
+				continue;
+
                         /* Reply on a passive connection attempt so the peer_ni
                          * realises we're connected. */
                         LASSERT (rc == 0);
@@ -1308,6 +1321,11 @@ ksocknal_create_conn(struct lnet_ni *ni, struct ksock_route *route,
         if (rc == 0)
                 rc = ksocknal_lib_setup_sock(sock);
 
+	/* no payload can be sent until the callbacks below are set */
+	if (rc == 0 && *ksocknal_tunables.ksnd_msg_zerocopy &&
+	    conn->ksnc_zc_capable)
+		ksocknal_lib_zc_msg_enable(conn);
+
 	write_lock_bh(global_lock);
 
         /* NB my callbacks block while I hold ksnd_global_lock */
@@ -1399,8 +1417,6 @@ ksocknal_close_conn_locked(struct ksock_conn *conn, int error)
          * Caller holds ksnd_global_lock exclusively in irq context */
 	struct ksock_peer_ni *peer_ni = conn->ksnc_peer;
 	struct ksock_route *route;
-	struct ksock_conn *conn2;
-	struct list_head *tmp;
 
 	LASSERT(peer_ni->ksnp_error == 0);
 	LASSERT(!conn->ksnc_closing);
@@ -1413,19 +1429,10 @@ ksocknal_close_conn_locked(struct ksock_conn *conn, int error)
 	if (route != NULL) {
 		/* dissociate conn from route... */
 		LASSERT(!route->ksnr_deleted);
-		LASSERT((route->ksnr_connected & (1 << conn->ksnc_type)) != 0);
-
-		conn2 = NULL;
-		list_for_each(tmp, &peer_ni->ksnp_conns) {
-			conn2 = list_entry(tmp, struct ksock_conn, ksnc_list);
-
-			if (conn2->ksnc_route == route &&
-			    conn2->ksnc_type == conn->ksnc_type)
-				break;
-
-			conn2 = NULL;
-		}
-		if (conn2 == NULL)
+		LASSERT(route->ksnr_type_conns[conn->ksnc_type] > 0);
+		route->ksnr_type_conns[conn->ksnc_type]--;
+		if (route->ksnr_type_conns[conn->ksnc_type] <
+		    ksocknal_route_type_conns(conn->ksnc_type))
 			route->ksnr_connected &= ~(1 << conn->ksnc_type);
 
 		conn->ksnc_route = NULL;
@@ -1525,6 +1532,13 @@ ksocknal_finalize_zcreq(struct ksock_conn *conn)
 		list_move(&tx->tx_zc_list, &zlist);
 	}
 
+	/* MSG_ZEROCOPY sends that never completed */
+	list_for_each_entry_safe(tx, tmp, &conn->ksnc_zc_msg_txs, tx_zc_list) {
+		tx->tx_zc_msg_nids = 0;
+		tx->tx_zc_aborted = 1;
+		list_move(&tx->tx_zc_list, &zlist);
+	}
+
 	spin_unlock(&peer_ni->ksnp_lock);
 
 	while (!list_empty(&zlist)) {
@@ -1624,6 +1638,8 @@ ksocknal_destroy_conn(struct ksock_conn *conn)
 	LASSERT (!conn->ksnc_tx_scheduled);
 	LASSERT (!conn->ksnc_rx_scheduled);
 	LASSERT(list_empty(&conn->ksnc_tx_queue));
+	LASSERT(!conn->ksnc_zc_scheduled);
+	LASSERT(list_empty(&conn->ksnc_zc_msg_txs));
 
         /* complete current receive if any */
         switch (conn->ksnc_rx_state) {
@@ -2192,6 +2208,7 @@ ksocknal_base_shutdown(void)
 				LASSERT(list_empty(&sched->kss_tx_conns));
 				LASSERT(list_empty(&sched->kss_rx_conns));
 				LASSERT(list_empty(&sched->kss_zombie_noop_txs));
+				LASSERT(list_empty(&sched->kss_zc_conns));
 				LASSERT(sched->kss_nconns == 0);
 			}
 		}
@@ -2302,6 +2319,7 @@ ksocknal_base_startup(void)
 		INIT_LIST_HEAD(&sched->kss_rx_conns);
 		INIT_LIST_HEAD(&sched->kss_tx_conns);
 		INIT_LIST_HEAD(&sched->kss_zombie_noop_txs);
+		INIT_LIST_HEAD(&sched->kss_zc_conns);
 		init_waitqueue_head(&sched->kss_waitq);
         }
 
@@ -33,6 +33,7 @@
 
 #include <linux/crc32.h>
 #include <linux/errno.h>
+#include <linux/errqueue.h>
 #include <linux/if.h>
 #include <linux/init.h>
 #include <linux/kernel.h>
@@ -67,6 +68,8 @@
 #define SOCKNAL_RESCHED		100	/* # scheduler loops before reschedule */
 #define SOCKNAL_INSANITY_RECONN	5000	/* connd is trying on reconn infinitely */
 #define SOCKNAL_ENOMEM_RETRY	1	/* seconds between retries */
+#define SOCKNAL_CONNS_PER_PEER_MAX 127	/* fits ksock_route::ksnr_type_conns */
+#define SOCKNAL_BUSY_POLL_MIN_NS 1000	/* smallest scheduler spin window */
 
 #define SOCKNAL_SINGLE_FRAG_TX      0	/* disable multi-fragment sends */
 #define SOCKNAL_SINGLE_FRAG_RX      0	/* disable multi-fragment receives */
@@ -81,6 +84,15 @@
 # define SOCKNAL_RISK_KMAP_DEADLOCK  1
 #endif
 
+/* per-thread scheduler scratch space: LNET_MAX_IOV kvecs, or bio_vecs for
+ * the iov_iter send/receive paths, which may be larger (e.g. on 32-bit) */
+#if defined(HAVE_SOCK_RECVMSG_ITER) || defined(HAVE_SOCK_ZEROCOPY)
+# define KSOCK_SCRATCH_SIZE	(LNET_MAX_IOV * max(sizeof(struct kvec), \
+						    sizeof(struct bio_vec)))
+#else
+# define KSOCK_SCRATCH_SIZE	(LNET_MAX_IOV * sizeof(struct kvec))
+#endif
+
 /* per scheduler state */
 struct ksock_sched {
 	/* serialise */
@@ -90,6 +102,8 @@ struct ksock_sched {
 	struct list_head kss_tx_conns;
 	/* zombie noop tx list */
 	struct list_head kss_zombie_noop_txs;
+	/* conns with MSG_ZEROCOPY completions to reap */
+	struct list_head kss_zc_conns;
 	/* where scheduler sleeps */
 	wait_queue_head_t kss_waitq;
 	/* # connections assigned to this scheduler */
@@ -102,6 +116,16 @@ struct ksock_sched {
 	int kss_cpt;
 };
 
+/* per scheduler thread busy-poll state */
+struct ksock_sched_poll {
+	/* current spin window, adapted to how soon work turns up */
+	s64 ksp_window_ns;
+	/* start of the current budget period */
+	ktime_t ksp_period_start;
+	/* time spent spinning in the current budget period */
+	s64 ksp_spent_ns;
+};
+
 #define KSOCK_CPT_SHIFT			16
 #define KSOCK_THREAD_ID(cpt, sid)	(((cpt) << KSOCK_CPT_SHIFT) | (sid))
 #define KSOCK_THREAD_CPT(id)		((id) >> KSOCK_CPT_SHIFT)
@@ -126,6 +150,7 @@ struct ksock_tunables {
         int              *ksnd_max_reconnectms; /* ...exponentially increasing to this */
         int              *ksnd_eager_ack;       /* make TCP ack eagerly? */
         int              *ksnd_typed_conns;     /* drive sockets by type? */
+	int		 *ksnd_conns_per_peer;	/* # bulk sockets of each type */
         int              *ksnd_min_bulk;        /* smallest "large" message */
         int              *ksnd_tx_buffer_size;  /* socket tx buffer size */
         int              *ksnd_rx_buffer_size;  /* socket rx buffer size */
@@ -143,8 +168,10 @@ struct ksock_tunables {
         int              *ksnd_inject_csum_error; /* set non-zero to inject checksum error */
         int              *ksnd_nonblk_zcack;    /* always send zc-ack on non-blocking connection */
         unsigned int     *ksnd_zc_min_payload;  /* minimum zero copy payload size */
-        int              *ksnd_zc_recv;         /* enable ZC receive (for Chelsio TOE) */
-        int              *ksnd_zc_recv_min_nfrags; /* minimum # of fragments to enable ZC receive */
+	int		 *ksnd_rx_batch;	/* max # msgs received from a conn per turn */
+	int		 *ksnd_busy_poll;	/* max usecs to spin before sleeping */
+	int		 *ksnd_busy_poll_budget; /* max % of CPU spent spinning */
+	int		 *ksnd_msg_zerocopy;	/* send ZC payload with MSG_ZEROCOPY */
         int              *ksnd_irq_affinity;    /* enable IRQ affinity? */
 #ifdef SOCKNAL_BACKOFF
         int              *ksnd_backoff_init;    /* initial TCP backoff */
@@ -260,6 +287,13 @@ struct ksock_tx {			/* transmit packet */
         unsigned short tx_zc_capable:1; /* payload is large enough for ZC */
         unsigned short tx_zc_checked:1; /* Have I checked if I should ZC? */
         unsigned short tx_nonblk:1;    /* it's a non-blocking ACK */
+	unsigned short tx_zc_msg:1;	/* payload sent with MSG_ZEROCOPY */
+	/* first MSG_ZEROCOPY completion id used by the payload */
+	__u32		   tx_zc_msg_id;
+	/* # MSG_ZEROCOPY ids used, non-zero while on ksnc_zc_msg_txs */
+	__u32		   tx_zc_msg_nids;
+	/* # of those ids completed */
+	__u32		   tx_zc_msg_done;
         lnet_kiov_t   *tx_kiov;        /* packet page frags */
 	struct ksock_conn *tx_conn;        /* owning conn */
 	struct lnet_msg	  *tx_lnetmsg;	/* lnet message for lnet_finalize() */
@@ -303,6 +337,7 @@ struct ksock_conn {
 	struct socket       *ksnc_sock;		/* actual socket */
 	void                *ksnc_saved_data_ready; /* socket's original data_ready() callback */
 	void                *ksnc_saved_write_space; /* socket's original write_space() callback */
+	void		    *ksnc_saved_error_report; /* socket's original error_report() callback */
 	atomic_t            ksnc_conn_refcount; /* conn refcount */
 	atomic_t            ksnc_sock_refcount; /* sock refcount */
 	struct ksock_sched *ksnc_scheduler;	/* who schedules this connection */
@@ -360,6 +395,14 @@ struct ksock_conn {
 	int			ksnc_tx_scheduled;
 	/* time stamp of the last posted TX */
 	time64_t		ksnc_tx_last_post;
+	/* send zero-copy payload with MSG_ZEROCOPY */
+	int			ksnc_zc_msg;
+	/* TXs waiting for MSG_ZEROCOPY completions: peer_ni's ksnp_lock */
+	struct list_head	ksnc_zc_msg_txs;
+	/* where I enq waiting for completions to be reaped */
+	struct list_head	ksnc_zc_list;
+	/* completions being reaped */
+	int			ksnc_zc_scheduled;
 };
 
 struct ksock_route {
@@ -378,6 +421,8 @@ struct ksock_route {
         unsigned int          ksnr_deleted:1;   /* been removed from peer_ni? */
         unsigned int          ksnr_share_count; /* created explicitly? */
         int                   ksnr_conn_count;  /* # conns established by this route */
+	/* # conns of each type currently established by this route */
+	__u8		   ksnr_type_conns[SOCKLND_CONN_NTYPES];
 };
 
 #define SOCKNAL_KEEPALIVE_PING          1       /* cookie for keepalive ping */
@@ -473,6 +518,17 @@ ksocknal_route_mask(void)
                 (1 << SOCKLND_CONN_BULK_OUT));
 }
 
+/* # connections of \a type a route keeps to its peer_ni; the control
+ * connection carries small messages only, so one is always enough */
+static inline int
+ksocknal_route_type_conns(int type)
+{
+	if (type == SOCKLND_CONN_CONTROL)
+		return 1;
+
+	return *ksocknal_tunables.ksnd_conns_per_peer;
+}
+
 static inline void
 ksocknal_conn_addref(struct ksock_conn *conn)
 {
@@ -628,8 +684,17 @@ int ksocknal_recv_hello(struct lnet_ni *ni, struct ksock_conn *conn,
 			__u64 *incarnation);
 extern void ksocknal_read_callback(struct ksock_conn *conn);
 extern void ksocknal_write_callback(struct ksock_conn *conn);
+extern void ksocknal_zc_msg_callback(struct ksock_conn *conn);
+extern void ksocknal_zc_msg_prep(struct ksock_conn *conn, struct ksock_tx *tx,
+				 __u32 id);
+extern void ksocknal_zc_msg_unprep(struct ksock_conn *conn,
+				   struct ksock_tx *tx);
+extern void ksocknal_zc_msg_complete(struct ksock_conn *conn, __u32 lo,
+				     __u32 hi);
 
 extern int ksocknal_lib_zc_capable(struct ksock_conn *conn);
+extern int ksocknal_lib_zc_msg_enable(struct ksock_conn *conn);
+extern void ksocknal_lib_zc_msg_reap(struct ksock_conn *conn);
 extern void ksocknal_lib_save_callback(struct socket *sock, struct ksock_conn *conn);
 extern void ksocknal_lib_set_callback(struct socket *sock,  struct ksock_conn *conn);
 extern void ksocknal_lib_reset_callback(struct socket *sock,
@@ -644,8 +709,8 @@ extern int ksocknal_lib_send_kiov(struct ksock_conn *conn, struct ksock_tx *tx,
 extern void ksocknal_lib_eager_ack(struct ksock_conn *conn);
 extern int ksocknal_lib_recv_iov(struct ksock_conn *conn,
 				 struct kvec *scratchiov);
-extern int ksocknal_lib_recv_kiov(struct ksock_conn *conn, struct page **pages,
-		       struct kvec *scratchiov);
+extern int ksocknal_lib_recv_kiov(struct ksock_conn *conn,
+				  struct kvec *scratchiov);
 extern int ksocknal_lib_get_conn_tunables(struct ksock_conn *conn, int *txmem,
 					  int *rxmem, int *nagle);
 
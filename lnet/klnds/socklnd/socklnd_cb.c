@@ -57,6 +57,8 @@ ksocknal_alloc_tx(int type, int size)
 	tx->tx_zc_aborted = 0;
 	tx->tx_zc_capable = 0;
 	tx->tx_zc_checked = 0;
+	tx->tx_zc_msg = 0;
+	tx->tx_zc_msg_nids = 0;
 	tx->tx_hstatus = LNET_MSG_STATUS_OK;
 	tx->tx_desc_size  = size;
 
@@ -299,8 +301,7 @@ ksocknal_recv_iov(struct ksock_conn *conn, struct kvec *scratchiov)
 }
 
 static int
-ksocknal_recv_kiov(struct ksock_conn *conn, struct page **rx_scratch_pgs,
-		   struct kvec *scratch_iov)
+ksocknal_recv_kiov(struct ksock_conn *conn, struct kvec *scratch_iov)
 {
 	lnet_kiov_t *kiov = conn->ksnc_rx_kiov;
 	int nob;
@@ -309,7 +310,7 @@ ksocknal_recv_kiov(struct ksock_conn *conn, struct page **rx_scratch_pgs,
 
 	/* Never touch conn->ksnc_rx_kiov or change connection
 	 * status inside ksocknal_lib_recv_iov */
-	rc = ksocknal_lib_recv_kiov(conn, rx_scratch_pgs, scratch_iov);
+	rc = ksocknal_lib_recv_kiov(conn, scratch_iov);
 
 	if (rc <= 0)
 		return rc;
@@ -344,8 +345,7 @@ ksocknal_recv_kiov(struct ksock_conn *conn, struct page **rx_scratch_pgs,
 }
 
 static int
-ksocknal_receive(struct ksock_conn *conn, struct page **rx_scratch_pgs,
-		 struct kvec *scratch_iov)
+ksocknal_receive(struct ksock_conn *conn, struct kvec *scratch_iov)
 {
 	/* Return 1 on success, 0 on EOF, < 0 on error.
 	 * Caller checks ksnc_rx_nob_wanted to determine
@@ -367,8 +367,7 @@ ksocknal_receive(struct ksock_conn *conn, struct page **rx_scratch_pgs,
 		if (conn->ksnc_rx_niov != 0)
 			rc = ksocknal_recv_iov(conn, scratch_iov);
 		else
-			rc = ksocknal_recv_kiov(conn, rx_scratch_pgs,
-						 scratch_iov);
+			rc = ksocknal_recv_kiov(conn, scratch_iov);
 
 		if (rc <= 0) {
 			/* error/EOF or partial receive */
@@ -480,6 +479,13 @@ ksocknal_check_zc_req(struct ksock_tx *tx)
 
         tx->tx_zc_checked = 1;
 
+	if (conn->ksnc_zc_msg) {
+		/* completion comes from my own stack, the peer_ni doesn't
+		 * need to ACK.  See ksocknal_zc_msg_complete() */
+		tx->tx_zc_msg = 1;
+		return;
+	}
+
         if (conn->ksnc_proto == &ksocknal_protocol_v1x ||
             !conn->ksnc_zc_capable)
                 return;
@@ -517,6 +523,13 @@ ksocknal_uncheck_zc_req(struct ksock_tx *tx)
 
 	tx->tx_zc_checked = 0;
 
+	if (tx->tx_zc_msg) {
+		/* any payload already sent stays pinned on the conn until
+		 * it completes or the conn is closed */
+		tx->tx_zc_msg = 0;
+		return;
+	}
+
 	spin_lock(&peer_ni->ksnp_lock);
 
 	if (tx->tx_msg.ksm_zc_cookies[0] == 0) {
@@ -533,6 +546,96 @@ ksocknal_uncheck_zc_req(struct ksock_tx *tx)
 	ksocknal_tx_decref(tx);
 }
 
+void
+ksocknal_zc_msg_prep(struct ksock_conn *conn, struct ksock_tx *tx, __u32 id)
+{
+	struct ksock_peer_ni *peer_ni = conn->ksnc_peer;
+
+	/* Called by the only thread sending on conn, BEFORE sending payload
+	 * that may use MSG_ZEROCOPY completion id 'id', so the completion
+	 * can't be reaped before tx knows about it.  tx is pinned on the
+	 * conn until all the ids it used have completed. */
+	spin_lock(&peer_ni->ksnp_lock);
+
+	if (tx->tx_zc_msg_nids == 0) {
+		ksocknal_tx_addref(tx);
+		tx->tx_zc_msg_id = id;
+		tx->tx_zc_msg_done = 0;
+		list_add_tail(&tx->tx_zc_list, &conn->ksnc_zc_msg_txs);
+	}
+
+	LASSERT(tx->tx_zc_msg_id + tx->tx_zc_msg_nids == id);
+	tx->tx_zc_msg_nids++;
+
+	spin_unlock(&peer_ni->ksnp_lock);
+}
+
+void
+ksocknal_zc_msg_unprep(struct ksock_conn *conn, struct ksock_tx *tx)
+{
+	struct ksock_peer_ni *peer_ni = conn->ksnc_peer;
+	bool done;
+
+	/* The send queued nothing, so it didn't use the id I reserved */
+	spin_lock(&peer_ni->ksnp_lock);
+
+	LASSERT(tx->tx_zc_msg_nids > 0);
+	tx->tx_zc_msg_nids--;
+
+	done = tx->tx_zc_msg_nids == tx->tx_zc_msg_done;
+	if (done) {
+		tx->tx_zc_msg_nids = 0;
+		list_del(&tx->tx_zc_list);
+	}
+
+	spin_unlock(&peer_ni->ksnp_lock);
+
+	if (done)
+		ksocknal_tx_decref(tx);
+}
+
+void
+ksocknal_zc_msg_complete(struct ksock_conn *conn, __u32 lo, __u32 hi)
+{
+	struct ksock_peer_ni *peer_ni = conn->ksnc_peer;
+	struct ksock_tx *tx;
+	struct ksock_tx *tmp;
+	LIST_HEAD(zlist);
+
+	CDEBUG(D_NET, "%s: MSG_ZEROCOPY ids %u-%u completed\n",
+	       libcfs_id2str(peer_ni->ksnp_id), lo, hi);
+
+	spin_lock(&peer_ni->ksnp_lock);
+
+	list_for_each_entry_safe(tx, tmp, &conn->ksnc_zc_msg_txs, tx_zc_list) {
+		/* relative to tx's first id, so ids may wrap */
+		__s32 first = lo - tx->tx_zc_msg_id;
+		__s32 last = hi - tx->tx_zc_msg_id;
+
+		first = max_t(__s32, first, 0);
+		last = min_t(__s32, last, tx->tx_zc_msg_nids - 1);
+		if (first > last)
+			continue;
+
+		tx->tx_zc_msg_done += last - first + 1;
+		LASSERT(tx->tx_zc_msg_done <= tx->tx_zc_msg_nids);
+		if (tx->tx_zc_msg_done < tx->tx_zc_msg_nids)
+			continue;
+
+		tx->tx_zc_msg_nids = 0;
+		list_move(&tx->tx_zc_list, &zlist);
+	}
+
+	spin_unlock(&peer_ni->ksnp_lock);
+
+	while (!list_empty(&zlist)) {
+		tx = list_entry(zlist.next, struct ksock_tx, tx_zc_list);
+
+		list_del(&tx->tx_zc_list);
+		ksocknal_tx_decref(tx);
+	}
+}
+
 static int
 ksocknal_process_transmit(struct ksock_conn *conn, struct ksock_tx *tx,
 			  struct kvec *scratch_iov)
@@ -675,6 +778,9 @@ ksocknal_launch_all_connections_locked(struct ksock_peer_ni *peer_ni)
         }
 }
 
+/* Choose the connection to send \a tx on.  With conns_per_peer > 1 there
+ * are several connections of each bulk type, and traffic is striped over
+ * them by always taking the one with the fewest bytes still queued. */
 struct ksock_conn *
 ksocknal_find_conn_locked(struct ksock_peer_ni *peer_ni, struct ksock_tx *tx, int nonblk)
 {
@@ -1170,7 +1276,6 @@ ksocknal_new_packet(struct ksock_conn *conn, int nob_to_skip)
 
 static int
 ksocknal_process_receive(struct ksock_conn *conn,
-			 struct page **rx_scratch_pgs,
 			 struct kvec *scratch_iov)
 {
 	struct lnet_hdr *lhdr;
@@ -1187,8 +1292,7 @@ ksocknal_process_receive(struct ksock_conn *conn,
 		conn->ksnc_rx_state == SOCKNAL_RX_SLOP);
  again:
 	if (conn->ksnc_rx_nob_wanted != 0) {
-		rc = ksocknal_receive(conn, rx_scratch_pgs,
-				      scratch_iov);
+		rc = ksocknal_receive(conn, scratch_iov);
 
 		if (rc <= 0) {
 			struct lnet_process_id ksnp_id;
@@ -1449,12 +1553,74 @@ ksocknal_sched_cansleep(struct ksock_sched *sched)
 
 	rc = (!ksocknal_data.ksnd_shuttingdown &&
 	      list_empty(&sched->kss_rx_conns) &&
-	      list_empty(&sched->kss_tx_conns));
+	      list_empty(&sched->kss_tx_conns) &&
+	      list_empty(&sched->kss_zc_conns));
 
 	spin_unlock_bh(&sched->kss_lock);
 	return rc;
 }
 
+static inline bool
+ksocknal_sched_idle(struct ksock_sched *sched)
+{
+	/* unlocked peek for the busy-poll loop; the caller rechecks under
+	 * kss_lock */
+	return !ksocknal_data.ksnd_shuttingdown &&
+	       list_empty(&sched->kss_rx_conns) &&
+	       list_empty(&sched->kss_tx_conns) &&
+	       list_empty(&sched->kss_zc_conns);
+}
+
+/* Spin for a while before going to sleep in case more work is about to
+ * arrive, saving the wakeup for back-to-back small RPCs.  The spin window
+ * doubles when work turns up and halves when it doesn't, and spinning is
+ * capped at busy_poll_budget percent of each second.  Returns true if
+ * there is work to do. */
+static bool
+ksocknal_sched_poll(struct ksock_sched *sched, struct ksock_sched_poll *ksp)
+{
+	int max_us = *ksocknal_tunables.ksnd_busy_poll;
+	int budget = *ksocknal_tunables.ksnd_busy_poll_budget;
+	s64 max_ns;
+	ktime_t start;
+	ktime_t end;
+	bool found = false;
+
+	if (max_us <= 0 || budget <= 0)
+		return false;
+
+	start = ktime_get();
+	if (ktime_ms_delta(start, ksp->ksp_period_start) >= MSEC_PER_SEC) {
+		ksp->ksp_period_start = start;
+		ksp->ksp_spent_ns = 0;
+	}
+
+	if (ksp->ksp_spent_ns >= (s64)min(budget, 100) * NSEC_PER_MSEC * 10)
+		return false;
+
+	max_ns = (s64)max_us * NSEC_PER_USEC;
+	ksp->ksp_window_ns = clamp_t(s64, ksp->ksp_window_ns,
+				     SOCKNAL_BUSY_POLL_MIN_NS, max_ns);
+	end = ktime_add_ns(start, ksp->ksp_window_ns);
+
+	do {
+		if (!ksocknal_sched_idle(sched)) {
+			found = true;
+			break;
+		}
+		cpu_relax();
+	} while (!need_resched() && ktime_before(ktime_get(), end));
+
+	ksp->ksp_spent_ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	if (found)
+		ksp->ksp_window_ns = min(ksp->ksp_window_ns << 1, max_ns);
+	else
+		ksp->ksp_window_ns >>= 1;
+
+	return found;
+}
+
 int ksocknal_scheduler(void *arg)
 {
 	struct ksock_sched *sched;
@@ -1463,20 +1629,17 @@ int ksocknal_scheduler(void *arg)
 	int rc;
 	int nloops = 0;
 	long id = (long)arg;
-	struct page **rx_scratch_pgs;
 	struct kvec *scratch_iov;
+	struct ksock_sched_poll poll = {
+		.ksp_window_ns	= SOCKNAL_BUSY_POLL_MIN_NS,
+	};
+	int batch;
+	int n;
 
 	sched = ksocknal_data.ksnd_schedulers[KSOCK_THREAD_CPT(id)];
 
-	LIBCFS_CPT_ALLOC(rx_scratch_pgs, lnet_cpt_table(), sched->kss_cpt,
-			 sizeof(*rx_scratch_pgs) * LNET_MAX_IOV);
-	if (!rx_scratch_pgs) {
-		CERROR("Unable to allocate scratch pages\n");
-		return -ENOMEM;
-	}
-
 	LIBCFS_CPT_ALLOC(scratch_iov, lnet_cpt_table(), sched->kss_cpt,
-			 sizeof(*scratch_iov) * LNET_MAX_IOV);
+			 KSOCK_SCRATCH_SIZE);
 	if (!scratch_iov) {
 		CERROR("Unable to allocate scratch iov\n");
 		return -ENOMEM;
@@ -1512,8 +1675,17 @@ int ksocknal_scheduler(void *arg)
 			conn->ksnc_rx_ready = 0;
 			spin_unlock_bh(&sched->kss_lock);
 
-			rc = ksocknal_process_receive(conn, rx_scratch_pgs,
-						      scratch_iov);
+			/* keep reading while whole messages are arriving
+			 * rather than paying a rotation per message; stop
+			 * if the message is being parsed, since
+			 * ksocknal_recv() needs the state change below */
+			batch = max(*ksocknal_tunables.ksnd_rx_batch, 1);
+			n = 0;
+			do {
+				rc = ksocknal_process_receive(conn,
+							      scratch_iov);
+			} while (rc == 0 && ++n < batch &&
+				 conn->ksnc_rx_state != SOCKNAL_RX_PARSE);
 
 			spin_lock_bh(&sched->kss_lock);
 
@@ -1613,6 +1785,26 @@ int ksocknal_scheduler(void *arg)
 
 			did_something = 1;
 		}
+
+		if (!list_empty(&sched->kss_zc_conns)) {
+			conn = list_entry(sched->kss_zc_conns.next,
+					  struct ksock_conn, ksnc_zc_list);
+			list_del(&conn->ksnc_zc_list);
+
+			/* clear it BEFORE reaping, so completions queued
+			 * from now on reschedule the conn */
+			LASSERT(conn->ksnc_zc_scheduled);
+			conn->ksnc_zc_scheduled = 0;
+			spin_unlock_bh(&sched->kss_lock);
+
+			ksocknal_lib_zc_msg_reap(conn);
+			/* drop my ref */
+			ksocknal_conn_decref(conn);
+
+			spin_lock_bh(&sched->kss_lock);
+			did_something = 1;
+		}
+
 		if (!did_something ||           /* nothing to do */
 		    ++nloops == SOCKNAL_RESCHED) { /* hogging CPU? */
 			spin_unlock_bh(&sched->kss_lock);
@@ -1620,6 +1812,11 @@ int ksocknal_scheduler(void *arg)
 			nloops = 0;
 
 			if (!did_something) {   /* wait for something to do */
+				if (ksocknal_sched_poll(sched, &poll)) {
+					spin_lock_bh(&sched->kss_lock);
+					continue;
+				}
+
 				rc = wait_event_interruptible_exclusive(
 					sched->kss_waitq,
 					!ksocknal_sched_cansleep(sched));
@@ -1633,10 +1830,7 @@ int ksocknal_scheduler(void *arg)
 	}
 
 	spin_unlock_bh(&sched->kss_lock);
-	LIBCFS_FREE(rx_scratch_pgs, sizeof(*rx_scratch_pgs) *
-		    LNET_MAX_IOV);
-	LIBCFS_FREE(scratch_iov, sizeof(*scratch_iov) *
-		    LNET_MAX_IOV);
+	LIBCFS_FREE(scratch_iov, KSOCK_SCRATCH_SIZE);
 	ksocknal_thread_fini();
 	return 0;
 }
@@ -1700,6 +1894,29 @@ void ksocknal_write_callback(struct ksock_conn *conn)
 	EXIT;
 }
 
+void ksocknal_zc_msg_callback(struct ksock_conn *conn)
+{
+	struct ksock_sched *sched;
+	ENTRY;
+
+	sched = conn->ksnc_scheduler;
+
+	spin_lock_bh(&sched->kss_lock);
+
+	if (!conn->ksnc_zc_scheduled) {	/* not being reaped */
+		list_add_tail(&conn->ksnc_zc_list, &sched->kss_zc_conns);
+		conn->ksnc_zc_scheduled = 1;
+		/* extra ref for scheduler */
+		ksocknal_conn_addref(conn);
+
+		wake_up(&sched->kss_waitq);
+	}
+
+	spin_unlock_bh(&sched->kss_lock);
+
+	EXIT;
+}
+
 static const struct ksock_proto *
 ksocknal_parse_proto_version(struct ksock_hello_msg *hello)
 {
@@ -112,6 +112,115 @@ ksocknal_lib_send_iov(struct ksock_conn *conn, struct ksock_tx *tx,
 	return rc;
 }
 
+int
+ksocknal_lib_zc_msg_enable(struct ksock_conn *conn)
+{
+#ifdef HAVE_SOCK_ZEROCOPY
+	int opt = 1;
+	int rc;
+
+	rc = kernel_setsockopt(conn->ksnc_sock, SOL_SOCKET, SO_ZEROCOPY,
+			       (char *)&opt, sizeof(opt));
+	if (rc != 0) {
+		CDEBUG(D_NET, "Can't set SO_ZEROCOPY: %d\n", rc);
+		return rc;
+	}
+
+	conn->ksnc_zc_msg = 1;
+	return 0;
+#else
+	return -EOPNOTSUPP;
+#endif
+}
+
+#ifdef HAVE_SOCK_ZEROCOPY
+static int
+ksocknal_lib_send_kiov_zc_msg(struct ksock_conn *conn, struct ksock_tx *tx,
+			      struct kvec *scratchiov)
+{
+	/* the pages are handed to the stack by reference, so only a bvec
+	 * iterator will do; the scheduler sizes its scratch space to hold
+	 * LNET_MAX_IOV of them (KSOCK_SCRATCH_SIZE) */
+	struct bio_vec *bvec = (struct bio_vec *)scratchiov;
+	struct socket *sock = conn->ksnc_sock;
+	struct msghdr msg = { .msg_flags = MSG_DONTWAIT | MSG_ZEROCOPY };
+	lnet_kiov_t *kiov = tx->tx_kiov;
+	unsigned int niov = tx->tx_nkiov;
+	__u32 id;
+	int nob;
+	int rc;
+	int i;
+
+	for (nob = i = 0; i < niov; i++) {
+		bvec[i].bv_page = kiov[i].kiov_page;
+		bvec[i].bv_offset = kiov[i].kiov_offset;
+		bvec[i].bv_len = kiov[i].kiov_len;
+		nob += kiov[i].kiov_len;
+	}
+
+	if (!list_empty(&conn->ksnc_tx_queue) ||
+	    nob < tx->tx_resid)
+		msg.msg_flags |= MSG_MORE;
+
+#ifdef HAVE_IOV_ITER_TYPE
+	iov_iter_bvec(&msg.msg_iter, WRITE, bvec, niov, nob);
+#else
+	iov_iter_bvec(&msg.msg_iter, ITER_BVEC | WRITE, bvec, niov, nob);
+#endif
+
+	/* I'm the only sender on this socket, so a send that queues any
+	 * data uses exactly the next completion id */
+	id = atomic_read(&sock->sk->sk_zckey);
+	ksocknal_zc_msg_prep(conn, tx, id);
+
+	rc = sock_sendmsg(sock, &msg);
+
+	if (atomic_read(&sock->sk->sk_zckey) == id)
+		ksocknal_zc_msg_unprep(conn, tx);
+
+	return rc;
+}
+
+void
+ksocknal_lib_zc_msg_reap(struct ksock_conn *conn)
+{
+	struct sock_exterr_skb *serr;
+	struct sk_buff *skb;
+	struct sock *sk;
+
+	/* a closed socket has completed (or aborted) everything */
+	if (ksocknal_connsock_addref(conn) != 0)
+		return;
+
+	sk = conn->ksnc_sock->sk;
+	while ((skb = sock_dequeue_err_skb(sk)) != NULL) {
+		serr = SKB_EXT_ERR(skb);
+
+		if (serr->ee.ee_errno == 0 &&
+		    serr->ee.ee_origin == SO_EE_ORIGIN_ZEROCOPY) {
+			if (conn->ksnc_zc_msg &&
+			    (serr->ee.ee_code & SO_EE_CODE_ZEROCOPY_COPIED)) {
+				/* the device copied the data anyway; don't
+				 * pay for completions that buy nothing */
+				CDEBUG(D_NET, "%s: MSG_ZEROCOPY fell back to copy, disabling\n",
+				       libcfs_id2str(conn->ksnc_peer->ksnp_id));
+				conn->ksnc_zc_msg = 0;
+			}
+			ksocknal_zc_msg_complete(conn, serr->ee.ee_info,
+						 serr->ee.ee_data);
+		}
+		kfree_skb(skb);
+	}
+
+	ksocknal_connsock_decref(conn);
+}
+#else /* !HAVE_SOCK_ZEROCOPY */
+void
+ksocknal_lib_zc_msg_reap(struct ksock_conn *conn)
+{
+}
+#endif /* HAVE_SOCK_ZEROCOPY */
+
 int
 ksocknal_lib_send_kiov(struct ksock_conn *conn, struct ksock_tx *tx,
 		       struct kvec *scratchiov)
@@ -124,6 +233,11 @@ ksocknal_lib_send_kiov(struct ksock_conn *conn, struct ksock_tx *tx,
 	/* Not NOOP message */
 	LASSERT(tx->tx_lnetmsg != NULL);
 
+#ifdef HAVE_SOCK_ZEROCOPY
+	if (tx->tx_zc_msg)
+		return ksocknal_lib_send_kiov_zc_msg(conn, tx, scratchiov);
+#endif
+
 	/* NB we can't trust socket ops to either consume our iovs
 	 * or leave them alone. */
 	if (tx->tx_msg.ksm_zc_cookies[0] != 0) {
@@ -252,129 +366,134 @@ ksocknal_lib_recv_iov(struct ksock_conn *conn, struct kvec *scratchiov)
         return rc;
 }
 
-static void
-ksocknal_lib_kiov_vunmap(void *addr)
+#ifdef HAVE_SOCK_RECVMSG_ITER
+int
+ksocknal_lib_recv_kiov(struct ksock_conn *conn, struct kvec *scratchiov)
 {
-        if (addr == NULL)
-                return;
+	/* receive straight into the pages with a bvec iterator; nothing
+	 * stays mapped across the call so there is no kmap() cost, and no
+	 * kmap deadlock to worry about on HIGHMEM. The scheduler sizes its
+	 * scratch space to hold LNET_MAX_IOV bvecs (KSOCK_SCRATCH_SIZE) */
+	struct bio_vec *bvec = (struct bio_vec *)scratchiov;
+#if SOCKNAL_SINGLE_FRAG_RX
+	unsigned int niov = 1;
+#else
+	unsigned int niov = conn->ksnc_rx_nkiov;
+#endif
+	lnet_kiov_t *kiov = conn->ksnc_rx_kiov;
+	struct msghdr msg = {
+		.msg_flags	= 0
+	};
+	int nob;
+	int i;
+	int rc;
+	void *base;
+	int sum;
+	int fragnob;
 
-        vunmap(addr);
-}
+	/* NB we can't trust socket ops to either consume our iovs
+	 * or leave them alone. */
+	for (nob = i = 0; i < niov; i++) {
+		bvec[i].bv_page = kiov[i].kiov_page;
+		bvec[i].bv_offset = kiov[i].kiov_offset;
+		bvec[i].bv_len = kiov[i].kiov_len;
+		nob += kiov[i].kiov_len;
+	}
 
-static void *
-ksocknal_lib_kiov_vmap(lnet_kiov_t *kiov, int niov,
-		       struct kvec *iov, struct page **pages)
-{
-        void             *addr;
-        int               nob;
-        int               i;
+	LASSERT(nob <= conn->ksnc_rx_nob_wanted);
 
-        if (!*ksocknal_tunables.ksnd_zc_recv || pages == NULL)
-                return NULL;
+#ifdef HAVE_IOV_ITER_TYPE
+	iov_iter_bvec(&msg.msg_iter, READ, bvec, niov, nob);
+#else
+	iov_iter_bvec(&msg.msg_iter, ITER_BVEC | READ, bvec, niov, nob);
+#endif
 
-        LASSERT (niov <= LNET_MAX_IOV);
+	rc = sock_recvmsg(conn->ksnc_sock, &msg, MSG_DONTWAIT);
 
-        if (niov < 2 ||
-            niov < *ksocknal_tunables.ksnd_zc_recv_min_nfrags)
-                return NULL;
+	if (conn->ksnc_msg.ksm_csum != 0) {
+		for (i = 0, sum = rc; sum > 0; i++, sum -= fragnob) {
+			LASSERT(i < niov);
 
-        for (nob = i = 0; i < niov; i++) {
-                if ((kiov[i].kiov_offset != 0 && i > 0) ||
-		    (kiov[i].kiov_offset + kiov[i].kiov_len !=
-		     PAGE_SIZE && i < niov - 1))
-                        return NULL;
+			base = kmap(kiov[i].kiov_page) + kiov[i].kiov_offset;
+			fragnob = kiov[i].kiov_len;
+			if (fragnob > sum)
+				fragnob = sum;
 
-                pages[i] = kiov[i].kiov_page;
-                nob += kiov[i].kiov_len;
-        }
+			conn->ksnc_rx_csum = ksocknal_csum(conn->ksnc_rx_csum,
+							   base, fragnob);
 
-        addr = vmap(pages, niov, VM_MAP, PAGE_KERNEL);
-        if (addr == NULL)
-                return NULL;
-
-        iov->iov_base = addr + kiov[0].kiov_offset;
-        iov->iov_len = nob;
+			kunmap(kiov[i].kiov_page);
+		}
+	}
 
-        return addr;
+	return rc;
 }
-
+#else /* !HAVE_SOCK_RECVMSG_ITER */
 int
-ksocknal_lib_recv_kiov(struct ksock_conn *conn, struct page **pages,
-		       struct kvec *scratchiov)
+ksocknal_lib_recv_kiov(struct ksock_conn *conn, struct kvec *scratchiov)
 {
 #if SOCKNAL_SINGLE_FRAG_RX || !SOCKNAL_RISK_KMAP_DEADLOCK
-	struct kvec   scratch;
-	struct kvec  *scratchiov = &scratch;
-        struct page  **pages      = NULL;
-        unsigned int   niov       = 1;
+	struct kvec scratch;
+	unsigned int niov = 1;
 #else
 #ifdef CONFIG_HIGHMEM
 #warning "XXX risk of kmap deadlock on multiple frags..."
 #endif
-	unsigned int   niov       = conn->ksnc_rx_nkiov;
+	unsigned int niov = conn->ksnc_rx_nkiov;
 #endif
-	lnet_kiov_t   *kiov = conn->ksnc_rx_kiov;
+	lnet_kiov_t *kiov = conn->ksnc_rx_kiov;
 	struct msghdr msg = {
-		.msg_flags      = 0
+		.msg_flags	= 0
 	};
-        int          nob;
-        int          i;
-        int          rc;
-        void        *base;
-        void        *addr;
-        int          sum;
-        int          fragnob;
-	int n;
-
-        /* NB we can't trust socket ops to either consume our iovs
-         * or leave them alone. */
-	if ((addr = ksocknal_lib_kiov_vmap(kiov, niov, scratchiov, pages)) != NULL) {
-		nob = scratchiov[0].iov_len;
-		n = 1;
+	int nob;
+	int i;
+	int rc;
+	void *base;
+	int sum;
+	int fragnob;
 
-	} else {
-		for (nob = i = 0; i < niov; i++) {
-			nob += scratchiov[i].iov_len = kiov[i].kiov_len;
-			scratchiov[i].iov_base = kmap(kiov[i].kiov_page) +
-						 kiov[i].kiov_offset;
-		}
-		n = niov;
+#if SOCKNAL_SINGLE_FRAG_RX || !SOCKNAL_RISK_KMAP_DEADLOCK
+	scratchiov = &scratch;
+#endif
+	/* NB we can't trust socket ops to either consume our iovs
+	 * or leave them alone. */
+	for (nob = i = 0; i < niov; i++) {
+		nob += scratchiov[i].iov_len = kiov[i].kiov_len;
+		scratchiov[i].iov_base = kmap(kiov[i].kiov_page) +
+					 kiov[i].kiov_offset;
 	}
 
-	LASSERT (nob <= conn->ksnc_rx_nob_wanted);
+	LASSERT(nob <= conn->ksnc_rx_nob_wanted);
 
-	rc = kernel_recvmsg(conn->ksnc_sock, &msg, scratchiov, n, nob,
+	rc = kernel_recvmsg(conn->ksnc_sock, &msg, scratchiov, niov, nob,
 			    MSG_DONTWAIT);
 
-        if (conn->ksnc_msg.ksm_csum != 0) {
-                for (i = 0, sum = rc; sum > 0; i++, sum -= fragnob) {
-                        LASSERT (i < niov);
+	if (conn->ksnc_msg.ksm_csum != 0) {
+		for (i = 0, sum = rc; sum > 0; i++, sum -= fragnob) {
+			LASSERT(i < niov);
 
-                        /* Dang! have to kmap again because I have nowhere to stash the
-                         * mapped address.  But by doing it while the page is still
-                         * mapped, the kernel just bumps the map count and returns me
-                         * the address it stashed. */
-                        base = kmap(kiov[i].kiov_page) + kiov[i].kiov_offset;
-                        fragnob = kiov[i].kiov_len;
-                        if (fragnob > sum)
-                                fragnob = sum;
+			/* Dang! have to kmap again because I have nowhere to
+			 * stash the mapped address.  But by doing it while the
+			 * page is still mapped, the kernel just bumps the map
+			 * count and returns me the address it stashed. */
+			base = kmap(kiov[i].kiov_page) + kiov[i].kiov_offset;
+			fragnob = kiov[i].kiov_len;
+			if (fragnob > sum)
+				fragnob = sum;
 
-                        conn->ksnc_rx_csum = ksocknal_csum(conn->ksnc_rx_csum,
-                                                           base, fragnob);
+			conn->ksnc_rx_csum = ksocknal_csum(conn->ksnc_rx_csum,
+							   base, fragnob);
 
-                        kunmap(kiov[i].kiov_page);
-                }
-        }
+			kunmap(kiov[i].kiov_page);
+		}
+	}
 
-        if (addr != NULL) {
-                ksocknal_lib_kiov_vunmap(addr);
-        } else {
-                for (i = 0; i < niov; i++)
-                        kunmap(kiov[i].kiov_page);
-        }
+	for (i = 0; i < niov; i++)
+		kunmap(kiov[i].kiov_page);
 
-        return (rc);
+	return rc;
 }
+#endif /* HAVE_SOCK_RECVMSG_ITER */
 
 void
 ksocknal_lib_csum_tx(struct ksock_tx *tx)
@@ -501,6 +620,19 @@ ksocknal_lib_setup_sock (struct socket *sock)
                 return (rc);
         }
 
+#ifdef SO_BUSY_POLL
+	/* poll the device queue from recvmsg() rather than waiting for the
+	 * interrupt; not fatal if the kernel lacks CONFIG_NET_RX_BUSY_POLL */
+	option = *ksocknal_tunables.ksnd_busy_poll;
+	if (option > 0) {
+		rc = kernel_setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL,
+				       (char *)&option, sizeof(option));
+		if (rc != 0)
+			CDEBUG(D_NET, "Can't set SO_BUSY_POLL %d: %d\n",
+			       option, rc);
+	}
+#endif
+
 /* TCP_BACKOFF_* sockopt tunables unsupported in stock kernels */
 #ifdef SOCKNAL_BACKOFF
         if (*ksocknal_tunables.ksnd_backoff_init > 0) {
@@ -688,11 +820,35 @@ ksocknal_write_space (struct sock *sk)
 	read_unlock(&ksocknal_data.ksnd_global_lock);
 }
 
+static void
+ksocknal_error_report(struct sock *sk)
+{
+	struct ksock_conn *conn;
+	void (*saved)(struct sock *sk);
+
+	/* interleave correctly with closing sockets... */
+	read_lock(&ksocknal_data.ksnd_global_lock);
+
+	conn = sk->sk_user_data;
+	if (conn == NULL) {	/* raced with ksocknal_terminate_conn */
+		LASSERT(sk->sk_error_report != &ksocknal_error_report);
+		sk->sk_error_report(sk);
+	} else {
+		/* keep waking anyone polling the socket for errors */
+		saved = conn->ksnc_saved_error_report;
+		saved(sk);
+		ksocknal_zc_msg_callback(conn);
+	}
+
+	read_unlock(&ksocknal_data.ksnd_global_lock);
+}
+
 void
 ksocknal_lib_save_callback(struct socket *sock, struct ksock_conn *conn)
 {
         conn->ksnc_saved_data_ready = sock->sk->sk_data_ready;
         conn->ksnc_saved_write_space = sock->sk->sk_write_space;
+	conn->ksnc_saved_error_report = sock->sk->sk_error_report;
 }
 
 void
@@ -701,6 +857,9 @@ ksocknal_lib_set_callback(struct socket *sock,  struct ksock_conn *conn)
         sock->sk->sk_user_data = conn;
         sock->sk->sk_data_ready = ksocknal_data_ready;
         sock->sk->sk_write_space = ksocknal_write_space;
+	/* MSG_ZEROCOPY completions are reported on the error queue */
+	if (conn->ksnc_zc_msg)
+		sock->sk->sk_error_report = ksocknal_error_report;
 }
 
 void
@@ -711,6 +870,7 @@ ksocknal_lib_reset_callback(struct socket *sock, struct ksock_conn *conn)
          * since the socket could survive past this module being unloaded!! */
         sock->sk->sk_data_ready = conn->ksnc_saved_data_ready;
         sock->sk->sk_write_space = conn->ksnc_saved_write_space;
+	sock->sk->sk_error_report = conn->ksnc_saved_error_report;
 
         /* A callback could be in progress already; they hold a read lock
          * on ksnd_global_lock (to serialise with me) and NOOP if
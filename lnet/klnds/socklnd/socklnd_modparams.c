@@ -71,6 +71,10 @@ static int typed_conns = 1;
 module_param(typed_conns, int, 0444);
 MODULE_PARM_DESC(typed_conns, "use different sockets for bulk");
 
+static int conns_per_peer = 1;
+module_param(conns_per_peer, int, 0444);
+MODULE_PARM_DESC(conns_per_peer, "# bulk sockets of each type per peer (1-127)");
+
 static int min_bulk = (1<<10);
 module_param(min_bulk, int, 0644);
 MODULE_PARM_DESC(min_bulk, "smallest 'large' message");
@@ -129,13 +133,31 @@ static unsigned int zc_min_payload = (16 << 10);
 module_param(zc_min_payload, int, 0644);
 MODULE_PARM_DESC(zc_min_payload, "minimum payload size to zero copy");
 
+/* payload is always received straight into the pages now; these are only
+ * kept so existing module option files still load */
 static unsigned int zc_recv = 0;
 module_param(zc_recv, int, 0644);
-MODULE_PARM_DESC(zc_recv, "enable ZC recv for Chelsio driver");
+MODULE_PARM_DESC(zc_recv, "enable ZC recv for Chelsio driver (obsolete)");
 
 static unsigned int zc_recv_min_nfrags = 16;
 module_param(zc_recv_min_nfrags, int, 0644);
-MODULE_PARM_DESC(zc_recv_min_nfrags, "minimum # of fragments to enable ZC recv");
+MODULE_PARM_DESC(zc_recv_min_nfrags, "minimum # of fragments to enable ZC recv (obsolete)");
+
+static int rx_batch = 8;
+module_param(rx_batch, int, 0644);
+MODULE_PARM_DESC(rx_batch, "max # of messages received from one connection before serving the next");
+
+static int busy_poll;
+module_param(busy_poll, int, 0644);
+MODULE_PARM_DESC(busy_poll, "max usecs an idle scheduler spins before sleeping, also used for socket busy polling (0 to disable)");
+
+static int busy_poll_budget = 20;
+module_param(busy_poll_budget, int, 0644);
+MODULE_PARM_DESC(busy_poll_budget, "max % of each scheduler thread's time spent busy polling");
+
+static int msg_zerocopy;
+module_param(msg_zerocopy, int, 0444);
+MODULE_PARM_DESC(msg_zerocopy, "send zero copy payload with MSG_ZEROCOPY, completed by the local stack instead of a peer ZC-ACK");
 
 #ifdef SOCKNAL_BACKOFF
 static int backoff_init = 3;
@@ -167,6 +189,7 @@ int ksocknal_tunables_init(void)
         ksocknal_tunables.ksnd_max_reconnectms    = &max_reconnectms;
         ksocknal_tunables.ksnd_eager_ack          = &eager_ack;
         ksocknal_tunables.ksnd_typed_conns        = &typed_conns;
+	ksocknal_tunables.ksnd_conns_per_peer	  = &conns_per_peer;
         ksocknal_tunables.ksnd_min_bulk           = &min_bulk;
         ksocknal_tunables.ksnd_tx_buffer_size     = &tx_buffer_size;
         ksocknal_tunables.ksnd_rx_buffer_size     = &rx_buffer_size;
@@ -184,8 +207,10 @@ int ksocknal_tunables_init(void)
         ksocknal_tunables.ksnd_inject_csum_error  = &inject_csum_error;
         ksocknal_tunables.ksnd_nonblk_zcack       = &nonblk_zcack;
         ksocknal_tunables.ksnd_zc_min_payload     = &zc_min_payload;
-        ksocknal_tunables.ksnd_zc_recv            = &zc_recv;
-        ksocknal_tunables.ksnd_zc_recv_min_nfrags = &zc_recv_min_nfrags;
+	ksocknal_tunables.ksnd_rx_batch		  = &rx_batch;
+	ksocknal_tunables.ksnd_busy_poll	  = &busy_poll;
+	ksocknal_tunables.ksnd_busy_poll_budget	  = &busy_poll_budget;
+	ksocknal_tunables.ksnd_msg_zerocopy	  = &msg_zerocopy;
 
 	if (enable_irq_affinity) {
 		CWARN("irq_affinity is removed from socklnd because modern "
@@ -204,6 +229,21 @@ int ksocknal_tunables_init(void)
         ksocknal_tunables.ksnd_protocol           = &protocol;
 #endif
 
+	if (conns_per_peer < 1 || conns_per_peer > SOCKNAL_CONNS_PER_PEER_MAX) {
+		CWARN("conns_per_peer %d out of range, using %d\n",
+		      conns_per_peer,
+		      clamp(conns_per_peer, 1, SOCKNAL_CONNS_PER_PEER_MAX));
+		conns_per_peer = clamp(conns_per_peer, 1,
+				       SOCKNAL_CONNS_PER_PEER_MAX);
+	}
+
+#ifndef HAVE_SOCK_ZEROCOPY
+	if (msg_zerocopy) {
+		CWARN("MSG_ZEROCOPY is not supported by this kernel, msg_zerocopy ignored\n");
+		msg_zerocopy = 0;
+	}
+#endif
+
         if (*ksocknal_tunables.ksnd_zc_min_payload < (2 << 10))
                 *ksocknal_tunables.ksnd_zc_min_payload = (2 << 10);
 
@@ -78,6 +78,11 @@ module_param(lnet_numa_range, uint, 0444);
 MODULE_PARM_DESC(lnet_numa_range,
 		"NUMA range to consider during Multi-Rail selection");
 
+unsigned int lnet_weighted_selection = 1;
+module_param(lnet_weighted_selection, uint, 0644);
+MODULE_PARM_DESC(lnet_weighted_selection,
+		"Share Multi-Rail traffic by interface latency and throughput");
+
 /*
  * lnet_health_sensitivity determines by how much we decrement the health
  * value on sending error. The value defaults to 100, which means health
@@ -556,6 +561,119 @@ struct kmem_cache *lnet_small_mds_cachep;  /* <= LNET_SMALL_MD_SIZE bytes
 struct kmem_cache *lnet_rspt_cachep;	   /* response tracker cache */
 struct kmem_cache *lnet_msg_cachep;
 
+struct lnet_obj_cache **lnet_me_objcache;
+struct lnet_obj_cache **lnet_small_md_objcache;
+struct lnet_obj_cache **lnet_msg_objcache;
+
+/*
+ * Allocate a zeroed object of \a size bytes from the magazine of the
+ * current CPT, going to \a slab when it is empty. An empty magazine is
+ * refilled with LNET_OBJ_CACHE_BATCH objects in one go, so that a CPT
+ * which mostly allocates does not pay for the slab on every call.
+ */
+void *lnet_obj_cache_alloc(struct lnet_obj_cache **caches,
+			   struct kmem_cache *slab, size_t size)
+{
+	void *objs[LNET_OBJ_CACHE_BATCH];
+	struct lnet_obj_cache *oc;
+	void *obj = NULL;
+	int cpt = lnet_cpt_current();
+	int n;
+
+	oc = caches[cpt];
+	spin_lock(&oc->oc_lock);
+	if (oc->oc_count > 0) {
+		obj = oc->oc_objs[--oc->oc_count];
+		oc->oc_hits++;
+	} else {
+		oc->oc_misses++;
+	}
+	spin_unlock(&oc->oc_lock);
+
+	if (obj) {
+		memset(obj, 0, size);
+		return obj;
+	}
+
+	obj = kmem_cache_alloc(slab, GFP_NOFS | __GFP_ZERO);
+	if (!obj)
+		return NULL;
+
+	for (n = 0; n < ARRAY_SIZE(objs); n++) {
+		objs[n] = kmem_cache_alloc(slab, GFP_NOFS);
+		if (!objs[n])
+			break;
+	}
+
+	spin_lock(&oc->oc_lock);
+	while (n > 0 && oc->oc_count < LNET_OBJ_CACHE_SIZE)
+		oc->oc_objs[oc->oc_count++] = objs[--n];
+	spin_unlock(&oc->oc_lock);
+
+	/* raced with frees that filled the magazine */
+	while (n > 0)
+		kmem_cache_free(slab, objs[--n]);
+
+	return obj;
+}
+
+/*
+ * Return \a obj to the magazine of the current CPT. A full magazine is
+ * drained by LNET_OBJ_CACHE_BATCH objects, leaving room for the next
+ * frees.
+ */
+void lnet_obj_cache_free(struct lnet_obj_cache **caches,
+			 struct kmem_cache *slab, void *obj)
+{
+	void *objs[LNET_OBJ_CACHE_BATCH];
+	struct lnet_obj_cache *oc;
+	int cpt = lnet_cpt_current();
+	int n = 0;
+
+	oc = caches[cpt];
+	spin_lock(&oc->oc_lock);
+	if (oc->oc_count == LNET_OBJ_CACHE_SIZE) {
+		while (n < ARRAY_SIZE(objs))
+			objs[n++] = oc->oc_objs[--oc->oc_count];
+	}
+	oc->oc_objs[oc->oc_count++] = obj;
+	spin_unlock(&oc->oc_lock);
+
+	while (n > 0)
+		kmem_cache_free(slab, objs[--n]);
+}
+
+static struct lnet_obj_cache **
+lnet_obj_caches_create(void)
+{
+	struct lnet_obj_cache **caches;
+	struct lnet_obj_cache *oc;
+	int i;
+
+	caches = cfs_percpt_alloc(lnet_cpt_table(), sizeof(*oc));
+	if (!caches)
+		return NULL;
+
+	cfs_percpt_for_each(oc, i, caches)
+		spin_lock_init(&oc->oc_lock);
+
+	return caches;
+}
+
+static void
+lnet_obj_caches_destroy(struct lnet_obj_cache **caches,
+			struct kmem_cache *slab)
+{
+	struct lnet_obj_cache *oc;
+	int i;
+
+	cfs_percpt_for_each(oc, i, caches) {
+		while (oc->oc_count > 0)
+			kmem_cache_free(slab, oc->oc_objs[--oc->oc_count]);
+	}
+	cfs_percpt_free(caches);
+}
+
 static int
 lnet_slab_setup(void)
 {
@@ -583,12 +701,40 @@ lnet_slab_setup(void)
 	if (!lnet_msg_cachep)
 		return -ENOMEM;
 
+	lnet_me_objcache = lnet_obj_caches_create();
+	if (!lnet_me_objcache)
+		return -ENOMEM;
+
+	lnet_small_md_objcache = lnet_obj_caches_create();
+	if (!lnet_small_md_objcache)
+		return -ENOMEM;
+
+	lnet_msg_objcache = lnet_obj_caches_create();
+	if (!lnet_msg_objcache)
+		return -ENOMEM;
+
 	return 0;
 }
 
 static void
 lnet_slab_cleanup(void)
 {
+	if (lnet_msg_objcache) {
+		lnet_obj_caches_destroy(lnet_msg_objcache, lnet_msg_cachep);
+		lnet_msg_objcache = NULL;
+	}
+
+	if (lnet_small_md_objcache) {
+		lnet_obj_caches_destroy(lnet_small_md_objcache,
+					lnet_small_mds_cachep);
+		lnet_small_md_objcache = NULL;
+	}
+
+	if (lnet_me_objcache) {
+		lnet_obj_caches_destroy(lnet_me_objcache, lnet_mes_cachep);
+		lnet_me_objcache = NULL;
+	}
+
 	if (lnet_msg_cachep) {
 		kmem_cache_destroy(lnet_msg_cachep);
 		lnet_msg_cachep = NULL;
@@ -2255,6 +2401,7 @@ lnet_startup_lndni(struct lnet_ni *ni, struct lnet_lnd_tunables *tun)
 	atomic_set(&ni->ni_tx_credits,
 		   lnet_ni_tq_credits(ni) * ni->ni_ncpts);
 	atomic_set(&ni->ni_healthv, LNET_MAX_HEALTH_VALUE);
+	lnet_sel_stats_init(&ni->ni_sel);
 
 	CDEBUG(D_LNI, "Added LNI %s [%d/%d/%d/%d]\n",
 		libcfs_nid2str(ni->ni_nid),
@@ -3510,6 +3657,82 @@ unlock:
 	return rc;
 }
 
+static int
+lnet_get_sel_stats(struct lnet_ioctl_sel_stats *stats)
+{
+	struct lnet_peer_ni *lpni;
+	struct lnet_ni *ni;
+	int cpt, rc = 0;
+
+	cpt = lnet_net_lock_current();
+	if (stats->iss_type == LNET_HEALTH_TYPE_LOCAL_NI) {
+		ni = lnet_nid2ni_locked(stats->iss_nid, cpt);
+		if (!ni) {
+			rc = -ENOENT;
+			goto unlock;
+		}
+		lnet_usr_translate_sel_stats(stats, &ni->ni_sel);
+	} else {
+		lpni = lnet_find_peer_ni_locked(stats->iss_nid);
+		if (!lpni) {
+			rc = -ENOENT;
+			goto unlock;
+		}
+		lnet_usr_translate_sel_stats(stats, &lpni->lpni_sel);
+		lnet_peer_ni_decref_locked(lpni);
+	}
+
+unlock:
+	lnet_net_unlock(cpt);
+
+	return rc;
+}
+
+static void
+lnet_usr_translate_lat_hist(__u32 *counts, struct lnet_lat_hist *hist)
+{
+	int i;
+
+	for (i = 0; i < LNET_LAT_BUCKETS; i++)
+		counts[i] = atomic_read(&hist->lh_count[i]);
+}
+
+static int
+lnet_get_lat_stats(struct lnet_ioctl_lat_stats *stats)
+{
+	struct lnet_peer_ni *lpni;
+	struct lnet_ni *ni;
+	int cpt, rc = 0;
+
+	cpt = lnet_net_lock_current();
+	if (stats->ils_type == LNET_HEALTH_TYPE_LOCAL_NI) {
+		ni = lnet_nid2ni_locked(stats->ils_nid, cpt);
+		if (!ni) {
+			rc = -ENOENT;
+			goto unlock;
+		}
+		lnet_usr_translate_lat_hist(stats->ils_send, &ni->ni_send_lat);
+		lnet_usr_translate_lat_hist(stats->ils_queue,
+					    &ni->ni_queue_lat);
+	} else {
+		lpni = lnet_find_peer_ni_locked(stats->ils_nid);
+		if (!lpni) {
+			rc = -ENOENT;
+			goto unlock;
+		}
+		lnet_usr_translate_lat_hist(stats->ils_send,
+					    &lpni->lpni_send_lat);
+		lnet_usr_translate_lat_hist(stats->ils_queue,
+					    &lpni->lpni_queue_lat);
+		lnet_peer_ni_decref_locked(lpni);
+	}
+
+unlock:
+	lnet_net_unlock(cpt);
+
+	return rc;
+}
+
 static int
 lnet_get_local_ni_recovery_list(struct lnet_ioctl_recovery_list *list)
 {
@@ -3775,6 +3998,32 @@ LNetCtl(unsigned int cmd, void *arg)
 		return rc;
 	}
 
+	case IOC_LIBCFS_GET_SEL_STATS: {
+		struct lnet_ioctl_sel_stats *stats = arg;
+
+		if (stats->iss_hdr.ioc_len < sizeof(*stats))
+			return -EINVAL;
+
+		mutex_lock(&the_lnet.ln_api_mutex);
+		rc = lnet_get_sel_stats(stats);
+		mutex_unlock(&the_lnet.ln_api_mutex);
+
+		return rc;
+	}
+
+	case IOC_LIBCFS_GET_LAT_STATS: {
+		struct lnet_ioctl_lat_stats *stats = arg;
+
+		if (stats->ils_hdr.ioc_len < sizeof(*stats))
+			return -EINVAL;
+
+		mutex_lock(&the_lnet.ln_api_mutex);
+		rc = lnet_get_lat_stats(stats);
+		mutex_unlock(&the_lnet.ln_api_mutex);
+
+		return rc;
+	}
+
 	case IOC_LIBCFS_GET_RECOVERY_QUEUE: {
 		struct lnet_ioctl_recovery_list *list = arg;
 		if (list->rlst_hdr.ioc_len < sizeof(*list))
@@ -231,6 +231,38 @@ lnet_eq_enqueue_event(struct lnet_eq *eq, struct lnet_event *ev)
 	lnet_eq_wait_unlock();
 }
 
+/**
+ * Deliver \a ev to \a eq, called with lnet_res_lock(\a cpt) held for the MD
+ * the event is about.
+ *
+ * Events are enqueued at once on EQs which can be polled. When the EQ only
+ * has a handler, it is returned instead, for the caller to run once it has
+ * dropped lnet_res_lock(), so handlers of different MDs on a CPT don't
+ * serialize each other or the MD and ME operations of the CPT. The caller
+ * then drops the EQ reference taken here with lnet_eq_handler_done().
+ */
+lnet_eq_handler_t
+lnet_eq_prepare_event(struct lnet_eq *eq, struct lnet_event *ev, int cpt)
+{
+	if (eq->eq_size != 0) {
+		lnet_eq_enqueue_event(eq, ev);
+		return NULL;
+	}
+
+	LASSERT(eq->eq_callback != LNET_EQ_HANDLER_NONE);
+	/* keep LNetEQFree() away until the handler has returned */
+	(*eq->eq_refs[cpt])++;
+	return eq->eq_callback;
+}
+
+void
+lnet_eq_handler_done(struct lnet_eq *eq, int cpt)
+{
+	/* MUST called with resource lock hold */
+	LASSERT(*eq->eq_refs[cpt] > 0);
+	(*eq->eq_refs[cpt])--;
+}
+
 static int
 lnet_eq_dequeue_event(struct lnet_eq *eq, struct lnet_event *ev)
 {
@@ -75,6 +75,11 @@ lnet_md_unlink(struct lnet_libmd *md)
 		(*md->md_eq->eq_refs[cpt])--;
 	}
 
+	/* wait for the EQ handler of an earlier event of the MD to return,
+	 * the caller delivers the unlink event after this */
+	spin_lock(&md->md_handler_lock);
+	spin_unlock(&md->md_handler_lock);
+
 	LASSERT(!list_empty(&md->md_list));
 	list_del_init(&md->md_list);
 	lnet_md_free(md);
@@ -527,6 +532,8 @@ LNetMDUnlink(struct lnet_handle_md mdh)
 {
 	struct lnet_event ev;
 	struct lnet_libmd *md;
+	struct lnet_eq *eq = NULL;
+	lnet_eq_handler_t handler = NULL;
 	int cpt;
 
 	LASSERT(the_lnet.ln_refcount > 0);
@@ -546,7 +553,8 @@ LNetMDUnlink(struct lnet_handle_md mdh)
 	 * unlinked. Otherwise, we enqueue an event now... */
 	if (md->md_eq != NULL && md->md_refcount == 0) {
 		lnet_build_unlink_event(md, &ev);
-		lnet_eq_enqueue_event(md->md_eq, &ev);
+		eq = md->md_eq;
+		handler = lnet_eq_prepare_event(eq, &ev, cpt);
 	}
 
 	if (md->md_rspt_ptr != NULL)
@@ -555,6 +563,14 @@ LNetMDUnlink(struct lnet_handle_md mdh)
 	lnet_md_unlink(md);
 
 	lnet_res_unlock(cpt);
+
+	if (handler != NULL) {
+		handler(&ev);
+
+		lnet_res_lock(cpt);
+		lnet_eq_handler_done(eq, cpt);
+		lnet_res_unlock(cpt);
+	}
 	return 0;
 }
 EXPORT_SYMBOL(LNetMDUnlink);
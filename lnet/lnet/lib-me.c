@@ -135,6 +135,8 @@ LNetMEUnlink(struct lnet_me *me)
 {
 	struct lnet_libmd *md;
 	struct lnet_event ev;
+	struct lnet_eq *eq = NULL;
+	lnet_eq_handler_t handler = NULL;
 	int cpt;
 
 	LASSERT(the_lnet.ln_refcount > 0);
@@ -147,13 +149,22 @@ LNetMEUnlink(struct lnet_me *me)
 		md->md_flags |= LNET_MD_FLAG_ABORTED;
 		if (md->md_eq != NULL && md->md_refcount == 0) {
 			lnet_build_unlink_event(md, &ev);
-			lnet_eq_enqueue_event(md->md_eq, &ev);
+			eq = md->md_eq;
+			handler = lnet_eq_prepare_event(eq, &ev, cpt);
 		}
 	}
 
 	lnet_me_unlink(me);
 
 	lnet_res_unlock(cpt);
+
+	if (handler != NULL) {
+		handler(&ev);
+
+		lnet_res_lock(cpt);
+		lnet_eq_handler_done(eq, cpt);
+		lnet_res_unlock(cpt);
+	}
 }
 EXPORT_SYMBOL(LNetMEUnlink);
 
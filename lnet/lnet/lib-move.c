@@ -165,6 +165,105 @@ void lnet_usr_translate_stats(struct lnet_ioctl_element_msg_stats *msg_stats,
 	assign_stats(&msg_stats->im_drop_stats, counts);
 }
 
+/* a new sample is given a weight of 1/8 in the selection averages */
+#define LNET_SEL_EWMA_SHIFT	3
+
+static inline u64
+lnet_sel_ewma(u64 avg, u64 sample)
+{
+	if (!avg)
+		return sample;
+
+	return avg - (avg >> LNET_SEL_EWMA_SHIFT) +
+	       (sample >> LNET_SEL_EWMA_SHIFT);
+}
+
+/*
+ * Account a send of \a nob bytes handed to the LND at \a sent and completed
+ * at \a now. Called under the lnet_net_lock of the message CPT, so the
+ * averages may be updated concurrently from different CPTs; losing the odd
+ * sample is harmless to a moving average.
+ */
+void lnet_sel_stats_update(struct lnet_sel_stats *ss, unsigned int nob,
+			   ktime_t sent, ktime_t now)
+{
+	s64 latency = ktime_to_ns(ktime_sub(now, sent));
+	s64 stamp = READ_ONCE(ss->ss_stamp);
+	s64 elapsed = ktime_to_ns(now) - stamp;
+	u64 total;
+	u64 rate;
+
+	if (latency <= 0)
+		latency = 1;
+	WRITE_ONCE(ss->ss_latency,
+		   lnet_sel_ewma(READ_ONCE(ss->ss_latency), latency));
+	WRITE_ONCE(ss->ss_size, lnet_sel_ewma(READ_ONCE(ss->ss_size), nob));
+
+	total = atomic64_add_return(nob, &ss->ss_total_bytes);
+	if (elapsed < NSEC_PER_SEC ||
+	    cmpxchg64(&ss->ss_stamp, stamp, ktime_to_ns(now)) != stamp)
+		return;
+
+	/* an idle period says nothing about what the interface can do */
+	if (elapsed < 2 * NSEC_PER_SEC) {
+		rate = div64_u64((total - ss->ss_last_bytes) * USEC_PER_SEC,
+				 div_u64(elapsed, NSEC_PER_USEC));
+		ss->ss_throughput = lnet_sel_ewma(ss->ss_throughput, rate);
+	}
+	ss->ss_last_bytes = total;
+}
+
+void lnet_usr_translate_sel_stats(struct lnet_ioctl_sel_stats *sel_stats,
+				  struct lnet_sel_stats *ss)
+{
+	sel_stats->iss_stride = READ_ONCE(ss->ss_stride);
+	sel_stats->iss_latency = READ_ONCE(ss->ss_latency);
+	sel_stats->iss_size = READ_ONCE(ss->ss_size);
+	sel_stats->iss_throughput = READ_ONCE(ss->ss_throughput);
+}
+
+/*
+ * Bytes per second a single send achieves on the interface. This is what
+ * weights the selection rather than ss_throughput, which depends on how
+ * much traffic the interface has been given.
+ */
+static u64
+lnet_sel_capacity(struct lnet_sel_stats *ss)
+{
+	u64 latency = READ_ONCE(ss->ss_latency);
+
+	if (!latency)
+		return 0;
+
+	return div64_u64(READ_ONCE(ss->ss_size) * NSEC_PER_SEC, latency);
+}
+
+/*
+ * Stride of an interface when the fastest of its peers has a capacity of
+ * \a max_cap, so that it is selected in proportion to its own capacity.
+ */
+static u32
+lnet_sel_stride(struct lnet_sel_stats *ss, u64 max_cap)
+{
+	u64 cap = lnet_sel_capacity(ss);
+
+	if (!lnet_weighted_selection || !cap || cap >= max_cap)
+		return LNET_SEL_STRIDE_BASE;
+
+	if (div64_u64(max_cap, cap) >=
+	    LNET_SEL_STRIDE_MAX / LNET_SEL_STRIDE_BASE)
+		return LNET_SEL_STRIDE_MAX;
+
+	return div64_u64(max_cap * LNET_SEL_STRIDE_BASE, cap);
+}
+
+/* true if round robin sequence \a seq1 is not before \a seq2 */
+static inline bool
+lnet_seq_after_eq(__u32 seq1, __u32 seq2)
+{
+	return (__s32)(seq1 - seq2) >= 0;
+}
+
 int
 lnet_fail_nid(lnet_nid_t nid, unsigned int threshold)
 {
@@ -761,6 +860,18 @@ lnet_ni_send(struct lnet_ni *ni, struct lnet_msg *msg)
 	LASSERT (LNET_NETTYP(LNET_NIDNET(ni->ni_nid)) == LOLND ||
 		 (msg->msg_txcredit && msg->msg_peertxcredit));
 
+	msg->msg_send_time = ktime_get();
+	/* msg_txpeer is not set for the LOLND */
+	if (msg->msg_txpeer) {
+		ktime_t queued = ktime_to_ns(msg->msg_txq_time) ?
+				 msg->msg_txq_time : msg->msg_send_time;
+
+		lnet_lat_hist_add(&msg->msg_txpeer->lpni_queue_lat, queued,
+				  msg->msg_send_time);
+		lnet_lat_hist_add(&ni->ni_queue_lat, queued,
+				  msg->msg_send_time);
+		msg->msg_txq_time = ktime_set(0, 0);
+	}
 	rc = (ni->ni_net->net_lnd->lnd_send)(ni, priv, msg);
 	if (rc < 0) {
 		msg->msg_no_resend = true;
@@ -926,6 +1037,8 @@ lnet_post_send_locked(struct lnet_msg *msg, int do_send)
 
 		if (lp->lpni_txcredits < 0) {
 			msg->msg_tx_delayed = 1;
+			if (!ktime_to_ns(msg->msg_txq_time))
+				msg->msg_txq_time = ktime_get();
 			list_add_tail(&msg->msg_list, &lp->lpni_txq);
 			spin_unlock(&lp->lpni_lock);
 			return LNET_CREDIT_WAIT;
@@ -946,6 +1059,8 @@ lnet_post_send_locked(struct lnet_msg *msg, int do_send)
 
 		if (tq->tq_credits < 0) {
 			msg->msg_tx_delayed = 1;
+			if (!ktime_to_ns(msg->msg_txq_time))
+				msg->msg_txq_time = ktime_get();
 			list_add_tail(&msg->msg_list, &tq->tq_delayed);
 			return LNET_CREDIT_WAIT;
 		}
@@ -1040,11 +1155,15 @@ lnet_post_routed_recv_locked(struct lnet_msg *msg, int do_recv)
 		rbp->rbp_credits--;
 		if (rbp->rbp_credits < rbp->rbp_mincredits)
 			rbp->rbp_mincredits = rbp->rbp_credits;
+		if (rbp->rbp_credits < rbp->rbp_tune_mincredits)
+			rbp->rbp_tune_mincredits = rbp->rbp_credits;
 
 		if (rbp->rbp_credits < 0) {
 			/* must have checked eager_recv before here */
 			LASSERT(msg->msg_rx_ready_delay);
 			msg->msg_rx_delayed = 1;
+			msg->msg_rtrbuf_wait = ktime_get();
+			rbp->rbp_nwaits++;
 			list_add_tail(&msg->msg_list, &rbp->rbp_msgs);
 			return LNET_CREDIT_WAIT;
 		}
@@ -1174,6 +1293,8 @@ lnet_schedule_blocked_locked(struct lnet_rtrbufpool *rbp)
 	msg = list_entry(rbp->rbp_msgs.next,
 			 struct lnet_msg, msg_list);
 	list_del(&msg->msg_list);
+	rbp->rbp_wait_ns += ktime_to_ns(ktime_sub(ktime_get(),
+						  msg->msg_rtrbuf_wait));
 
 	(void)lnet_post_routed_recv_locked(msg, 1);
 }
@@ -1342,7 +1463,8 @@ lnet_select_peer_ni(struct lnet_ni *best_ni, lnet_nid_t dst_nid,
 	 * best_ni to communicate, we use that one. If there is no
 	 * preferred peer_ni, or there are multiple preferred peer_ni,
 	 * the available transmit credits are used. If the transmit
-	 * credits are equal, we round-robin over the peer_ni.
+	 * credits are equal, we round-robin over the peer_ni, weighted
+	 * by their capacity.
 	 */
 	struct lnet_peer_ni *lpni = NULL;
 	struct lnet_peer_ni *best_lpni = NULL;
@@ -1351,8 +1473,11 @@ lnet_select_peer_ni(struct lnet_ni *best_ni, lnet_nid_t dst_nid,
 	bool ni_is_pref;
 	int best_lpni_healthv = 0;
 	int lpni_healthv;
+	u64 max_cap = 0;
 
 	while ((lpni = lnet_get_next_peer_ni_locked(peer, peer_net, lpni))) {
+		max_cap = max(max_cap, lnet_sel_capacity(&lpni->lpni_sel));
+
 		/*
 		 * if the best_ni we've chosen aleady has this lpni
 		 * preferred, then let's use it
@@ -1403,7 +1528,8 @@ lnet_select_peer_ni(struct lnet_ni *best_ni, lnet_nid_t dst_nid,
 			 * Robin
 			 */
 			if (best_lpni) {
-				if (best_lpni->lpni_seq <= lpni->lpni_seq)
+				if (lnet_seq_after_eq(lpni->lpni_seq,
+						      best_lpni->lpni_seq))
 					continue;
 			}
 		}
@@ -1421,8 +1547,12 @@ lnet_select_peer_ni(struct lnet_ni *best_ni, lnet_nid_t dst_nid,
 		return NULL;
 	}
 
-	CDEBUG(D_NET, "sd_best_lpni = %s\n",
-	       libcfs_nid2str(best_lpni->lpni_nid));
+	best_lpni->lpni_sel.ss_stride = lnet_sel_stride(&best_lpni->lpni_sel,
+							max_cap);
+
+	CDEBUG(D_NET, "sd_best_lpni = %s stride %u\n",
+	       libcfs_nid2str(best_lpni->lpni_nid),
+	       best_lpni->lpni_sel.ss_stride);
 
 	return best_lpni;
 }
@@ -1561,6 +1691,7 @@ lnet_get_best_ni(struct lnet_net *local_net, struct lnet_ni *best_ni,
 	unsigned int shortest_distance;
 	int best_credits;
 	int best_healthv;
+	u64 max_cap = 0;
 
 	/*
 	 * If there is no peer_ni that we can send to on this network,
@@ -1589,6 +1720,8 @@ lnet_get_best_ni(struct lnet_net *local_net, struct lnet_ni *best_ni,
 		ni_credits = atomic_read(&ni->ni_tx_credits);
 		ni_healthv = atomic_read(&ni->ni_healthv);
 		ni_fatal = atomic_read(&ni->ni_fatal_error_on);
+		if (!ni_fatal)
+			max_cap = max(max_cap, lnet_sel_capacity(&ni->ni_sel));
 
 		/*
 		 * calculate the distance from the CPT on which
@@ -1614,7 +1747,7 @@ lnet_get_best_ni(struct lnet_net *local_net, struct lnet_ni *best_ni,
 
 		/*
 		 * Select on health, shorter distance, available
-		 * credits, then round-robin.
+		 * credits, then round-robin weighted by capacity.
 		 */
 		if (ni_fatal) {
 			continue;
@@ -1638,13 +1771,18 @@ lnet_get_best_ni(struct lnet_net *local_net, struct lnet_ni *best_ni,
 		} else if (ni_credits < best_credits) {
 			continue;
 		} else if (ni_credits == best_credits) {
-			if (best_ni && best_ni->ni_seq <= ni->ni_seq)
+			if (best_ni &&
+			    lnet_seq_after_eq(ni->ni_seq, best_ni->ni_seq))
 				continue;
 		}
 		best_ni = ni;
 		best_credits = ni_credits;
 	}
 
+	if (best_ni && best_ni->ni_net == local_net)
+		best_ni->ni_sel.ss_stride = lnet_sel_stride(&best_ni->ni_sel,
+							    max_cap);
+
 	CDEBUG(D_NET, "selected best_ni %s\n",
 	       (best_ni) ? libcfs_nid2str(best_ni->ni_nid) : "no selection");
 
@@ -1730,7 +1868,7 @@ lnet_handle_send(struct lnet_send_data *sd)
 	 * Increment sequence number of the selected peer so that we
 	 * pick the next one in Round Robin.
 	 */
-	best_lpni->lpni_seq++;
+	best_lpni->lpni_seq += best_lpni->lpni_sel.ss_stride;
 
 	/*
 	 * grab a reference on the peer_ni so it sticks around even if
@@ -1945,7 +2083,7 @@ lnet_find_best_ni_on_spec_net(struct lnet_ni *cur_best_ni,
 				   peer, peer_net, cpt);
 
 	if (incr_seq && best_ni)
-		best_ni->ni_seq++;
+		best_ni->ni_seq += best_ni->ni_sel.ss_stride;
 
 	return best_ni;
 }
@@ -1971,6 +2109,18 @@ lnet_initiate_peer_discovery(struct lnet_peer_ni *lpni, struct lnet_msg *msg,
 		return 0;
 	}
 
+	/*
+	 * If the peer is already queued for discovery there is no need to
+	 * take the exclusive lnet_net_lock to queue it again, and stall
+	 * every sender while doing so. Discovery clears
+	 * LNET_PEER_DISCOVERING under lp_lock before it collects the
+	 * pending messages, so this message cannot be missed.
+	 */
+	spin_lock(&peer->lp_lock);
+	if (peer->lp_state & LNET_PEER_DISCOVERING)
+		goto queue;
+	spin_unlock(&peer->lp_lock);
+
 	rc = lnet_discover_peer_locked(lpni, cpt, false);
 	if (rc) {
 		lnet_peer_ni_decref_locked(lpni);
@@ -1984,6 +2134,7 @@ lnet_initiate_peer_discovery(struct lnet_peer_ni *lpni, struct lnet_msg *msg,
 		lnet_peer_ni_decref_locked(lpni);
 		return 0;
 	}
+queue:
 	/* queue message and return */
 	msg->msg_sending = 0;
 	msg->msg_txpeer = NULL;
@@ -2227,7 +2378,7 @@ lnet_find_best_ni_on_local_net(struct lnet_peer *peer, int md_cpt,
 
 	if (best_ni)
 		/* increment sequence number so we can round robin */
-		best_ni->ni_seq++;
+		best_ni->ni_seq += best_ni->ni_sel.ss_stride;
 
 	return best_ni;
 }
@@ -3502,6 +3653,8 @@ lnet_monitor_thread(void *arg)
 		if (lnet_router_checker_active())
 			lnet_check_routers();
 
+		lnet_rtrpools_tune();
+
 		lnet_resend_pending_msgs();
 
 		if (now >= rsp_timeout) {
@@ -4265,6 +4418,21 @@ lnet_parse(struct lnet_ni *ni, struct lnet_hdr *hdr, lnet_nid_t from_nid,
 		lnet_msgtyp2str(type),
 		(for_me) ? "for me" : "routed");
 
+	/* A message looped back by the lolnd was built by this node for this
+	 * node, so its header is sane and none of the routing checks below
+	 * can apply; go straight to delivery */
+	if (ni == the_lnet.ln_loni) {
+		if (!for_me) {
+			CERROR("%s, src %s: looped back %s for %s\n",
+			       libcfs_nid2str(from_nid),
+			       libcfs_nid2str(src_nid),
+			       lnet_msgtyp2str(type),
+			       libcfs_nid2str(dest_nid));
+			return -EPROTO;
+		}
+		goto checked;
+	}
+
 	switch (type) {
 	case LNET_MSG_ACK:
 	case LNET_MSG_GET:
@@ -4361,6 +4529,7 @@ lnet_parse(struct lnet_ni *ni, struct lnet_hdr *hdr, lnet_nid_t from_nid,
 		}
 	}
 
+checked:
 	/* Message looks OK; we're not going to return an error, so we MUST
 	 * call back lnd_recv() come what may... */
 
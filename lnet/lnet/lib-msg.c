@@ -232,6 +232,19 @@ incr_stats:
 		lnet_incr_stats(&msg->msg_txni->ni_stats,
 				msg->msg_type,
 				LNET_STATS_TYPE_SEND);
+	/* msg_txpeer is not set for the LOLND */
+	if (msg->msg_txpeer && ktime_to_ns(msg->msg_send_time)) {
+		ktime_t now = ktime_get();
+
+		lnet_sel_stats_update(&msg->msg_txpeer->lpni_sel, msg->msg_len,
+				      msg->msg_send_time, now);
+		lnet_sel_stats_update(&msg->msg_txni->ni_sel, msg->msg_len,
+				      msg->msg_send_time, now);
+		lnet_lat_hist_add(&msg->msg_txpeer->lpni_send_lat,
+				  msg->msg_send_time, now);
+		lnet_lat_hist_add(&msg->msg_txni->ni_send_lat,
+				  msg->msg_send_time, now);
+	}
  out:
 	lnet_return_tx_credits_locked(msg);
 	msg->msg_tx_committed = 0;
@@ -901,11 +914,15 @@ lnet_health_check(struct lnet_msg *msg)
 }
 
 static void
-lnet_msg_detach_md(struct lnet_msg *msg, int cpt, int status)
+lnet_msg_detach_md(struct lnet_msg *msg, int status)
 {
 	struct lnet_libmd *md = msg->msg_md;
+	struct lnet_eq *eq = NULL;
+	lnet_eq_handler_t handler = NULL;
+	int cpt = lnet_cpt_of_cookie(md->md_lh.lh_cookie);
 	int unlink;
 
+	lnet_res_lock(cpt);
 	/* Now it's safe to drop my caller's ref */
 	md->md_refcount--;
 	LASSERT(md->md_refcount >= 0);
@@ -919,7 +936,13 @@ lnet_msg_detach_md(struct lnet_msg *msg, int cpt, int status)
 			msg->msg_ev.status   = status;
 		}
 		msg->msg_ev.unlinked = unlink;
-		lnet_eq_enqueue_event(md->md_eq, &msg->msg_ev);
+		eq = md->md_eq;
+		handler = lnet_eq_prepare_event(eq, &msg->msg_ev, cpt);
+		/* Taken before dropping lnet_res_lock, so handlers of the MD
+		 * run in event order, and the MD can't be freed under mine;
+		 * the last event is ordered by lnet_md_unlink() instead */
+		if (handler != NULL && !unlink)
+			spin_lock(&md->md_handler_lock);
 	}
 
 	if (unlink || (md->md_refcount == 0 &&
@@ -930,6 +953,18 @@ lnet_msg_detach_md(struct lnet_msg *msg, int cpt, int status)
 		lnet_md_unlink(md);
 
 	msg->msg_md = NULL;
+	lnet_res_unlock(cpt);
+
+	if (handler == NULL)
+		return;
+
+	handler(&msg->msg_ev);
+	if (!unlink)
+		spin_unlock(&md->md_handler_lock);
+
+	lnet_res_lock(cpt);
+	lnet_eq_handler_done(eq, cpt);
+	lnet_res_unlock(cpt);
 }
 
 static bool
@@ -1065,12 +1100,8 @@ lnet_finalize(struct lnet_msg *msg, int status)
 	 * We're not going to resend this message so detach its MD and invoke
 	 * the appropriate callbacks
 	 */
-	if (msg->msg_md != NULL) {
-		cpt = lnet_cpt_of_cookie(msg->msg_md->md_lh.lh_cookie);
-		lnet_res_lock(cpt);
-		lnet_msg_detach_md(msg, cpt, status);
-		lnet_res_unlock(cpt);
-	}
+	if (msg->msg_md != NULL)
+		lnet_msg_detach_md(msg, status);
 
 again:
 	if (!msg->msg_tx_committed && !msg->msg_rx_committed) {
@@ -31,6 +31,9 @@
  */
 
 #define DEBUG_SUBSYSTEM S_LNET
+
+#include <linux/highmem.h>
+
 #include <lnet/lib-lnet.h>
 
 static int
@@ -42,6 +45,75 @@ lolnd_send(struct lnet_ni *ni, void *private, struct lnet_msg *lntmsg)
 	return lnet_parse(ni, &lntmsg->msg_hdr, ni->ni_nid, lntmsg, 0);
 }
 
+/* Copy a looped back payload between page vectors.  The sink pages belong
+ * to the receiver's MD and the source pages to the sender's, so they can't
+ * simply be handed over; instead whole pages go through copy_highpage()
+ * and partial ones through short-lived atomic mappings. */
+static void
+lolnd_copy_kiov(unsigned int ndiov, lnet_kiov_t *diov, unsigned int doffset,
+		unsigned int nsiov, lnet_kiov_t *siov, unsigned int soffset,
+		unsigned int nob)
+{
+	unsigned int this_nob;
+	char *daddr;
+	char *saddr;
+
+	if (nob == 0)
+		return;
+
+	LASSERT(ndiov > 0);
+	while (doffset >= diov->kiov_len) {
+		doffset -= diov->kiov_len;
+		diov++;
+		ndiov--;
+		LASSERT(ndiov > 0);
+	}
+
+	LASSERT(nsiov > 0);
+	while (soffset >= siov->kiov_len) {
+		soffset -= siov->kiov_len;
+		siov++;
+		nsiov--;
+		LASSERT(nsiov > 0);
+	}
+
+	do {
+		LASSERT(ndiov > 0);
+		LASSERT(nsiov > 0);
+		this_nob = min3(diov->kiov_len - doffset,
+				siov->kiov_len - soffset,
+				nob);
+
+		if (this_nob == PAGE_SIZE) {
+			copy_highpage(diov->kiov_page, siov->kiov_page);
+		} else {
+			daddr = kmap_atomic(diov->kiov_page);
+			saddr = kmap_atomic(siov->kiov_page);
+			memcpy(daddr + diov->kiov_offset + doffset,
+			       saddr + siov->kiov_offset + soffset, this_nob);
+			kunmap_atomic(saddr);
+			kunmap_atomic(daddr);
+		}
+		nob -= this_nob;
+
+		if (diov->kiov_len > doffset + this_nob) {
+			doffset += this_nob;
+		} else {
+			diov++;
+			ndiov--;
+			doffset = 0;
+		}
+
+		if (siov->kiov_len > soffset + this_nob) {
+			soffset += this_nob;
+		} else {
+			siov++;
+			nsiov--;
+			soffset = 0;
+		}
+	} while (nob > 0);
+}
+
 static int
 lolnd_recv(struct lnet_ni *ni, void *private, struct lnet_msg *lntmsg,
 	   int delayed, unsigned int niov,
@@ -69,10 +141,10 @@ lolnd_recv(struct lnet_ni *ni, void *private, struct lnet_msg *lntmsg,
 						   sendmsg->msg_kiov,
 						   sendmsg->msg_offset, mlen);
 			else
-				lnet_copy_kiov2kiov(niov, kiov, offset,
-						    sendmsg->msg_niov,
-						    sendmsg->msg_kiov,
-						    sendmsg->msg_offset, mlen);
+				lolnd_copy_kiov(niov, kiov, offset,
+						sendmsg->msg_niov,
+						sendmsg->msg_kiov,
+						sendmsg->msg_offset, mlen);
 		}
 
 		lnet_finalize(lntmsg, 0);
@@ -178,6 +178,7 @@ lnet_peer_ni_alloc(lnet_nid_t nid)
 	lpni->lpni_nid = nid;
 	lpni->lpni_cpt = cpt;
 	atomic_set(&lpni->lpni_healthv, LNET_MAX_HEALTH_VALUE);
+	lnet_sel_stats_init(&lpni->lpni_sel);
 
 	net = lnet_get_net_locked(LNET_NIDNET(nid));
 	lpni->lpni_net = net;
@@ -2270,6 +2271,7 @@ static void
 lnet_discovery_event_reply(struct lnet_peer *lp, struct lnet_event *ev)
 {
 	struct lnet_ping_buffer *pbuf;
+	int cpt;
 	int rc;
 
 	spin_lock(&lp->lp_lock);
@@ -2409,14 +2411,17 @@ out:
 	lp->lp_state &= ~LNET_PEER_PING_SENT;
 	spin_unlock(&lp->lp_lock);
 
-	lnet_net_lock(LNET_LOCK_EX);
 	/*
 	 * If this peer is a gateway, call the routing callback to
-	 * handle the ping reply
+	 * handle the ping reply. Routes and peer NIs only change under
+	 * the exclusive lnet_net_lock, so a single CPT lock keeps them
+	 * stable without stalling senders on every other CPT each time
+	 * a gateway answers a ping.
 	 */
+	cpt = lnet_net_lock_current();
 	if (lp->lp_rtr_refcount > 0)
 		lnet_router_discovery_ping_reply(lp);
-	lnet_net_unlock(LNET_LOCK_EX);
+	lnet_net_unlock(cpt);
 }
 
 /*
@@ -23,6 +23,7 @@
 #define DEBUG_SUBSYSTEM S_LNET
 
 #include <linux/random.h>
+#include <linux/swap.h>
 #include <lnet/lib-lnet.h>
 
 #define LNET_NRB_TINY_MIN	512	/* min value for each CPT */
@@ -48,6 +49,9 @@ MODULE_PARM_DESC(small_router_buffers, "# of small (1 page) messages to buffer i
 static int large_router_buffers;
 module_param(large_router_buffers, int, 0444);
 MODULE_PARM_DESC(large_router_buffers, "# of large messages to buffer in the router");
+static int auto_router_buffers;
+module_param(auto_router_buffers, int, 0644);
+MODULE_PARM_DESC(auto_router_buffers, "Max multiple of the configured size router buffer pools can grow to when messages wait for buffers (0 to disable)");
 static int peer_buffer_credits;
 module_param(peer_buffer_credits, int, 0444);
 MODULE_PARM_DESC(peer_buffer_credits, "# router buffer credits per peer");
@@ -245,7 +249,7 @@ bool lnet_is_route_alive(struct lnet_route *route)
 	 * enabled.
 	 */
 	if (lnet_is_discovery_disabled(gw))
-		return route->lr_alive;
+		return atomic_read(&route->lr_alive);
 
 	/*
 	 * check the gateway's interfaces on the local network
@@ -307,18 +311,22 @@ lnet_consolidate_routes_locked(struct lnet_peer *orig_lp,
 
 }
 
+/*
+ * Routes are updated under a single CPT lock by the gateway ping replies,
+ * so the aliveness is swapped atomically and a change is logged once.
+ */
 static inline void
 lnet_set_route_aliveness(struct lnet_route *route, bool alive)
 {
+	bool old = atomic_xchg(&route->lr_alive, alive);
+
 	/* Log when there's a state change */
-	if (route->lr_alive != alive) {
+	if (old != alive)
 		CERROR("route to %s through %s has gone from %s to %s\n",
 		       libcfs_net2str(route->lr_net),
 		       libcfs_nid2str(route->lr_gateway->lp_primary_nid),
-		       (route->lr_alive) ? "up" : "down",
+		       old ? "up" : "down",
 		       alive ? "up" : "down");
-		route->lr_alive = alive;
-	}
 }
 
 void
@@ -1273,6 +1281,7 @@ lnet_rtrpool_adjust_bufs(struct lnet_rtrbufpool *rbp, int nbufs, int cpt)
 	rbp->rbp_nbuffers += num_buffers;
 	rbp->rbp_credits += num_buffers;
 	rbp->rbp_mincredits = rbp->rbp_credits;
+	rbp->rbp_tune_mincredits = rbp->rbp_credits;
 	/* We need to schedule blocked msg using the newly
 	 * added buffers. */
 	while (!list_empty(&rbp->rbp_bufs) &&
@@ -1293,6 +1302,142 @@ failed:
 	return -ENOMEM;
 }
 
+/* Free the buffers beyond rbp_req_nbuffers which are on the free list;
+ * lnet_return_rx_credits_locked() only drops the excess buffers which are
+ * returned to the pool, and idle buffers never are. */
+static void
+lnet_rtrpool_trim_bufs(struct lnet_rtrbufpool *rbp, int cpt)
+{
+	struct lnet_rtrbuf *rb;
+	LIST_HEAD(tmp);
+
+	lnet_net_lock(cpt);
+	while (rbp->rbp_nbuffers > rbp->rbp_req_nbuffers &&
+	       rbp->rbp_credits > 0) {
+		LASSERT(!list_empty(&rbp->rbp_bufs));
+		rb = list_entry(rbp->rbp_bufs.prev, struct lnet_rtrbuf,
+				rb_list);
+		list_move(&rb->rb_list, &tmp);
+		rbp->rbp_nbuffers--;
+		rbp->rbp_credits--;
+	}
+	if (rbp->rbp_mincredits > rbp->rbp_credits)
+		rbp->rbp_mincredits = rbp->rbp_credits;
+	if (rbp->rbp_tune_mincredits > rbp->rbp_credits)
+		rbp->rbp_tune_mincredits = rbp->rbp_credits;
+	lnet_net_unlock(cpt);
+
+	while (!list_empty(&tmp)) {
+		rb = list_entry(tmp.next, struct lnet_rtrbuf, rb_list);
+		list_del(&rb->rb_list);
+		lnet_destroy_rtrbuf(rb, rbp->rbp_npages);
+	}
+}
+
+/* Set the configured size of a pool, which auto tuning starts from */
+static int
+lnet_rtrpool_config_bufs(struct lnet_rtrbufpool *rbp, int nbufs, int cpt)
+{
+	int rc;
+
+	lnet_net_lock(cpt);
+	rbp->rbp_min_nbuffers = nbufs;
+	rbp->rbp_tune_idle = 0;
+	lnet_net_unlock(cpt);
+
+	rc = lnet_rtrpool_adjust_bufs(rbp, nbufs, cpt);
+	if (rc == 0)
+		lnet_rtrpool_trim_bufs(rbp, cpt);
+
+	return rc;
+}
+
+/* # tuning intervals a pool must have idle buffers before it shrinks */
+#define LNET_RTRPOOL_SHRINK_INTERVALS	30
+
+static void
+lnet_rtrpool_tune(struct lnet_rtrbufpool *rbp, int cpt, bool pressure)
+{
+	int req;
+	int low;
+	int ceiling;
+	int nbufs;
+
+	lnet_net_lock(cpt);
+	req = rbp->rbp_req_nbuffers;
+	low = rbp->rbp_tune_mincredits;
+	rbp->rbp_tune_mincredits = rbp->rbp_credits;
+	ceiling = min_t(long, INT_MAX,
+			(long)rbp->rbp_min_nbuffers * auto_router_buffers);
+	nbufs = req;
+
+	if (pressure) {
+		/* give back all we have grown */
+		nbufs = rbp->rbp_min_nbuffers;
+		rbp->rbp_tune_idle = 0;
+	} else if (low < 0) {
+		/* messages had to wait for buffers */
+		nbufs = min(req + max(-low, req / 4), ceiling);
+		rbp->rbp_tune_idle = 0;
+	} else if (low > req / 2 && req > rbp->rbp_min_nbuffers) {
+		/* more than half of the pool stayed idle */
+		if (++rbp->rbp_tune_idle >= LNET_RTRPOOL_SHRINK_INTERVALS) {
+			nbufs = max(rbp->rbp_min_nbuffers, req - low / 2);
+			rbp->rbp_tune_idle = 0;
+		}
+	} else {
+		rbp->rbp_tune_idle = 0;
+	}
+	lnet_net_unlock(cpt);
+
+	if (nbufs == req)
+		return;
+
+	CDEBUG(D_NET, "CPT %d pool of %d pages: %d -> %d buffers (min credits %d%s)\n",
+	       cpt, rbp->rbp_npages, req, nbufs, low,
+	       pressure ? ", low memory" : "");
+
+	if (lnet_rtrpool_adjust_bufs(rbp, nbufs, cpt) == 0 && nbufs < req)
+		lnet_rtrpool_trim_bufs(rbp, cpt);
+}
+
+/*
+ * Called from the monitor thread to grow router buffer pools of a CPT when
+ * messages had to wait for buffers, and shrink them back towards their
+ * configured size when buffers stay idle or memory runs low.
+ */
+void
+lnet_rtrpools_tune(void)
+{
+	static time64_t next_tune;
+	struct lnet_rtrbufpool *rtrp;
+	time64_t now = ktime_get_seconds();
+	bool pressure;
+	int i;
+	int j;
+
+	if (auto_router_buffers <= 0 || now < next_tune)
+		return;
+	next_tune = now + 1;
+
+	/* don't race with router buffer configuration or shutdown, which
+	 * may be waiting for this thread */
+	if (!mutex_trylock(&the_lnet.ln_api_mutex))
+		return;
+
+	if (!the_lnet.ln_routing || the_lnet.ln_rtrpools == NULL)
+		goto out;
+
+	pressure = nr_free_pages() < cfs_totalram_pages() / 32;
+
+	cfs_percpt_for_each(rtrp, i, the_lnet.ln_rtrpools) {
+		for (j = 0; j < LNET_NRBPOOLS; j++)
+			lnet_rtrpool_tune(&rtrp[j], i, pressure);
+	}
+out:
+	mutex_unlock(&the_lnet.ln_api_mutex);
+}
+
 static void
 lnet_rtrpool_init(struct lnet_rtrbufpool *rbp, int npages)
 {
@@ -1430,21 +1575,21 @@ lnet_rtrpools_alloc(int im_a_router)
 
 	cfs_percpt_for_each(rtrp, i, the_lnet.ln_rtrpools) {
 		lnet_rtrpool_init(&rtrp[LNET_TINY_BUF_IDX], 0);
-		rc = lnet_rtrpool_adjust_bufs(&rtrp[LNET_TINY_BUF_IDX],
+		rc = lnet_rtrpool_config_bufs(&rtrp[LNET_TINY_BUF_IDX],
 					      nrb_tiny, i);
 		if (rc != 0)
 			goto failed;
 
 		lnet_rtrpool_init(&rtrp[LNET_SMALL_BUF_IDX],
 				  LNET_NRB_SMALL_PAGES);
-		rc = lnet_rtrpool_adjust_bufs(&rtrp[LNET_SMALL_BUF_IDX],
+		rc = lnet_rtrpool_config_bufs(&rtrp[LNET_SMALL_BUF_IDX],
 					      nrb_small, i);
 		if (rc != 0)
 			goto failed;
 
 		lnet_rtrpool_init(&rtrp[LNET_LARGE_BUF_IDX],
 				  LNET_NRB_LARGE_PAGES);
-		rc = lnet_rtrpool_adjust_bufs(&rtrp[LNET_LARGE_BUF_IDX],
+		rc = lnet_rtrpool_config_bufs(&rtrp[LNET_LARGE_BUF_IDX],
 					      nrb_large, i);
 		if (rc != 0)
 			goto failed;
@@ -1475,7 +1620,7 @@ lnet_rtrpools_adjust_helper(int tiny, int small, int large)
 		tiny_router_buffers = tiny;
 		nrb = lnet_nrb_tiny_calculate();
 		cfs_percpt_for_each(rtrp, i, the_lnet.ln_rtrpools) {
-			rc = lnet_rtrpool_adjust_bufs(&rtrp[LNET_TINY_BUF_IDX],
+			rc = lnet_rtrpool_config_bufs(&rtrp[LNET_TINY_BUF_IDX],
 						      nrb, i);
 			if (rc != 0)
 				return rc;
@@ -1485,7 +1630,7 @@ lnet_rtrpools_adjust_helper(int tiny, int small, int large)
 		small_router_buffers = small;
 		nrb = lnet_nrb_small_calculate();
 		cfs_percpt_for_each(rtrp, i, the_lnet.ln_rtrpools) {
-			rc = lnet_rtrpool_adjust_bufs(&rtrp[LNET_SMALL_BUF_IDX],
+			rc = lnet_rtrpool_config_bufs(&rtrp[LNET_SMALL_BUF_IDX],
 						      nrb, i);
 			if (rc != 0)
 				return rc;
@@ -1495,7 +1640,7 @@ lnet_rtrpools_adjust_helper(int tiny, int small, int large)
 		large_router_buffers = large;
 		nrb = lnet_nrb_large_calculate();
 		cfs_percpt_for_each(rtrp, i, the_lnet.ln_rtrpools) {
-			rc = lnet_rtrpool_adjust_bufs(&rtrp[LNET_LARGE_BUF_IDX],
+			rc = lnet_rtrpool_config_bufs(&rtrp[LNET_LARGE_BUF_IDX],
 						      nrb, i);
 			if (rc != 0)
 				return rc;
@@ -568,8 +568,8 @@ static int __proc_lnet_buffers(void *data, int write,
 	s = tmpstr; /* points to current position in tmpstr[] */
 
 	s += scnprintf(s, tmpstr + tmpsiz - s,
-		       "%5s %5s %7s %7s\n",
-		       "pages", "count", "credits", "min");
+		       "%5s %5s %7s %7s %8s %8s\n",
+		       "pages", "count", "credits", "min", "waits", "wait_ms");
 	LASSERT(tmpstr + tmpsiz - s > 0);
 
 	if (the_lnet.ln_rtrpools == NULL)
@@ -581,11 +581,14 @@ static int __proc_lnet_buffers(void *data, int write,
 		lnet_net_lock(LNET_LOCK_EX);
 		cfs_percpt_for_each(rbp, i, the_lnet.ln_rtrpools) {
 			s += scnprintf(s, tmpstr + tmpsiz - s,
-				       "%5d %5d %7d %7d\n",
+				       "%5d %5d %7d %7d %8llu %8llu\n",
 				       rbp[idx].rbp_npages,
 				       rbp[idx].rbp_nbuffers,
 				       rbp[idx].rbp_credits,
-				       rbp[idx].rbp_mincredits);
+				       rbp[idx].rbp_mincredits,
+				       rbp[idx].rbp_nwaits,
+				       div_u64(rbp[idx].rbp_wait_ns,
+					       NSEC_PER_MSEC));
 			LASSERT(tmpstr + tmpsiz - s > 0);
 		}
 		lnet_net_unlock(LNET_LOCK_EX);
@@ -612,6 +615,78 @@ proc_lnet_buffers(struct ctl_table *table, int write, void __user *buffer,
 				    __proc_lnet_buffers);
 }
 
+static char *
+lnet_obj_caches_print(char *s, char *end, const char *name,
+		      struct lnet_obj_cache **caches)
+{
+	struct lnet_obj_cache *oc;
+	int i;
+
+	cfs_percpt_for_each(oc, i, caches) {
+		spin_lock(&oc->oc_lock);
+		s += scnprintf(s, end - s, "%-6s %3d %5d %12llu %12llu\n",
+			       name, i, oc->oc_count, oc->oc_hits,
+			       oc->oc_misses);
+		spin_unlock(&oc->oc_lock);
+	}
+
+	return s;
+}
+
+static int __proc_lnet_caches(void *data, int write,
+			      loff_t pos, void __user *buffer, int nob)
+{
+	char	*s;
+	char	*tmpstr;
+	int	tmpsiz;
+	int	len;
+	int	rc;
+
+	LASSERT(!write);
+
+	/* header + 3 caches * LNET_CPT_NUMBER lines */
+	tmpsiz = 64 * (3 * LNET_CPT_NUMBER + 1);
+	LIBCFS_ALLOC(tmpstr, tmpsiz);
+	if (tmpstr == NULL)
+		return -ENOMEM;
+
+	s = tmpstr; /* points to current position in tmpstr[] */
+
+	s += scnprintf(s, tmpstr + tmpsiz - s, "%-6s %3s %5s %12s %12s\n",
+		       "object", "cpt", "count", "hits", "misses");
+
+	mutex_lock(&the_lnet.ln_api_mutex);
+	if (lnet_msg_objcache) {
+		s = lnet_obj_caches_print(s, tmpstr + tmpsiz, "msg",
+					  lnet_msg_objcache);
+		s = lnet_obj_caches_print(s, tmpstr + tmpsiz, "md",
+					  lnet_small_md_objcache);
+		s = lnet_obj_caches_print(s, tmpstr + tmpsiz, "me",
+					  lnet_me_objcache);
+	}
+	mutex_unlock(&the_lnet.ln_api_mutex);
+	LASSERT(tmpstr + tmpsiz - s > 0);
+
+	len = s - tmpstr;
+
+	if (pos >= min_t(int, len, strlen(tmpstr)))
+		rc = 0;
+	else
+		rc = cfs_trace_copyout_string(buffer, nob,
+					      tmpstr + pos, NULL);
+
+	LIBCFS_FREE(tmpstr, tmpsiz);
+	return rc;
+}
+
+static int
+proc_lnet_caches(struct ctl_table *table, int write, void __user *buffer,
+		 size_t *lenp, loff_t *ppos)
+{
+	return lprocfs_call_handler(table->data, write, ppos, buffer, lenp,
+				    __proc_lnet_caches);
+}
+
 static int
 proc_lnet_nis(struct ctl_table *table, int write, void __user *buffer,
 	      size_t *lenp, loff_t *ppos)
@@ -892,6 +967,11 @@ static struct ctl_table lnet_table[] = {
 		.mode		= 0444,
 		.proc_handler	= &proc_lnet_buffers,
 	},
+	{
+		.procname	= "caches",
+		.mode		= 0444,
+		.proc_handler	= &proc_lnet_caches,
+	},
 	{
 		.procname	= "nis",
 		.mode		= 0644,
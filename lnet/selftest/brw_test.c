@@ -97,13 +97,17 @@ brw_client_init(struct sfw_test_instance *tsi)
 
 		/* I should never get this step if it's unknown feature
 		 * because make_session will reject unknown feature */
-		LASSERT((sn->sn_features & ~LST_FEATS_MASK) == 0);
+		LASSERT((sn->sn_features & ~LST_FEATS_ALL) == 0);
 
 		opc   = breq->blk_opc;
 		flags = breq->blk_flags;
 		len   = breq->blk_len;
 		off   = breq->blk_offset & ~PAGE_MASK;
 		npg   = (off + len + PAGE_SIZE - 1) >> PAGE_SHIFT;
+
+		if (opc == LST_BRW_MIX &&
+		    tsi->tsi_u.bulk_mix.blk_write_pct > 100)
+			return -EINVAL;
 	}
 
 	if (off % BRW_MSIZE != 0)
@@ -112,7 +116,8 @@ brw_client_init(struct sfw_test_instance *tsi)
 	if (npg > LNET_MAX_IOV || npg <= 0)
 		return -EINVAL;
 
-	if (opc != LST_BRW_READ && opc != LST_BRW_WRITE)
+	if (opc != LST_BRW_READ && opc != LST_BRW_WRITE &&
+	    (opc != LST_BRW_MIX || (sn->sn_features & LST_FEAT_BULK_LEN) == 0))
 		return -EINVAL;
 
 	if (flags != LST_BRW_CHECK_NONE &&
@@ -299,13 +304,20 @@ brw_client_prep_rpc(struct sfw_test_unit *tsu, struct lnet_process_id dest,
 
 		/* I should never get this step if it's unknown feature
 		 * because make_session will reject unknown feature */
-		LASSERT((sn->sn_features & ~LST_FEATS_MASK) == 0);
+		LASSERT((sn->sn_features & ~LST_FEATS_ALL) == 0);
 
 		opc   = breq->blk_opc;
 		flags = breq->blk_flags;
 		len   = breq->blk_len;
 		off   = breq->blk_offset;
 		npg   = (off + len + PAGE_SIZE - 1) >> PAGE_SHIFT;
+
+		/* pick the direction of each RPC, the bulk pages of the
+		 * unit serve as source or sink alike */
+		if (opc == LST_BRW_MIX)
+			opc = prandom_u32_max(100) <
+			      tsi->tsi_u.bulk_mix.blk_write_pct ?
+			      LST_BRW_WRITE : LST_BRW_READ;
 	}
 
 	rc = sfw_create_test_rpc(tsu, dest, sn->sn_features, npg, len, &rpc);
@@ -313,6 +325,7 @@ brw_client_prep_rpc(struct sfw_test_unit *tsu, struct lnet_process_id dest,
 		return rc;
 
 	memcpy(&rpc->crpc_bulk, bulk, offsetof(struct srpc_bulk, bk_iovs[npg]));
+	rpc->crpc_bulk.bk_sink = opc == LST_BRW_READ;
 	if (opc == LST_BRW_WRITE)
 		brw_fill_bulk(&rpc->crpc_bulk, flags, BRW_MAGIC);
 	else
@@ -464,8 +477,8 @@ brw_server_handle(struct srpc_server_rpc *rpc)
                 return 0;
         }
 
-	if ((reqstmsg->msg_ses_feats & ~LST_FEATS_MASK) != 0) {
-		replymsg->msg_ses_feats = LST_FEATS_MASK;
+	if ((reqstmsg->msg_ses_feats & ~LST_FEATS_ALL) != 0) {
+		replymsg->msg_ses_feats = LST_FEATS_ALL;
 		reply->brw_status = EPROTO;
 		return 0;
 	}
@@ -664,7 +664,7 @@ lst_batch_info_ioctl(struct lstio_batch_info_args *args)
 }
 
 static int
-lst_stat_query_ioctl(struct lstio_stat_args *args)
+lst_stat_query_ioctl(struct lstio_stat_args *args, bool latency)
 {
 	int rc;
 	char *name = NULL;
@@ -681,7 +681,7 @@ lst_stat_query_ioctl(struct lstio_stat_args *args)
 			return -EINVAL;
 
 		rc = lstcon_nodes_stat(args->lstio_sta_count,
-				       args->lstio_sta_idsp,
+				       args->lstio_sta_idsp, latency,
 				       args->lstio_sta_timeout,
 				       args->lstio_sta_resultp);
 	} else if (args->lstio_sta_namep != NULL) {
@@ -696,7 +696,8 @@ lst_stat_query_ioctl(struct lstio_stat_args *args)
 		rc = copy_from_user(name, args->lstio_sta_namep,
 				    args->lstio_sta_nmlen);
 		if (rc == 0)
-			rc = lstcon_group_stat(name, args->lstio_sta_timeout,
+			rc = lstcon_group_stat(name, latency,
+					       args->lstio_sta_timeout,
 					       args->lstio_sta_resultp);
 		else
 			rc = -EFAULT;
@@ -710,6 +711,20 @@ lst_stat_query_ioctl(struct lstio_stat_args *args)
 	return rc;
 }
 
+/* blk_write_pct is newer than the rest of lst_test_bulk_param, older lst
+ * pass a shorter parameter but never ask for LST_BRW_MIX */
+static bool lst_bulk_param_invalid(struct lst_test_bulk_param *bulk, int len)
+{
+	if (len < sizeof(bulk->blk_opc))
+		return true;
+
+	if (bulk->blk_opc != LST_BRW_MIX)
+		return false;
+
+	return len < sizeof(*bulk) ||
+	       bulk->blk_write_pct < 0 || bulk->blk_write_pct > 100;
+}
+
 static int lst_test_add_ioctl(struct lstio_test_args *args)
 {
 	char *batch_name;
@@ -766,6 +781,12 @@ static int lst_test_add_ioctl(struct lstio_test_args *args)
 			rc = -EFAULT;
 			goto out;
 		}
+
+		if (args->lstio_tes_type == LST_TEST_BULK &&
+		    lst_bulk_param_invalid(param, args->lstio_tes_param_len)) {
+			rc = -EINVAL;
+			goto out;
+		}
 	}
 
 	rc = -EFAULT;
@@ -912,7 +933,10 @@ lstcon_ioctl_entry(struct notifier_block *nb,
 		rc = lst_test_add_ioctl((struct lstio_test_args *)buf);
 		break;
 	case LSTIO_STAT_QUERY:
-		rc = lst_stat_query_ioctl((struct lstio_stat_args *)buf);
+		rc = lst_stat_query_ioctl((struct lstio_stat_args *)buf, false);
+		break;
+	case LSTIO_LAT_QUERY:
+		rc = lst_stat_query_ioctl((struct lstio_stat_args *)buf, true);
 		break;
 	default:
 		rc = -EINVAL;
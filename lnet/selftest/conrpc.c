@@ -224,6 +224,9 @@ lstcon_rpc_trans_name(int transop)
         if (transop == LST_TRANS_STATQRY)
                 return "STATQRY";
 
+	if (transop == LST_TRANS_LATQRY)
+		return "LATQRY";
+
         return "Unknown";
 }
 
@@ -695,6 +698,23 @@ lstcon_statrpc_prep(struct lstcon_node *nd, unsigned int feats,
         return 0;
 }
 
+int
+lstcon_latrpc_prep(struct lstcon_node *nd, unsigned int feats,
+		   struct lstcon_rpc **crpc)
+{
+	struct srpc_lat_reqst *lrq;
+	int rc;
+
+	rc = lstcon_rpc_prep(nd, SRPC_SERVICE_QUERY_LAT, feats, 0, 0, crpc);
+	if (rc != 0)
+		return rc;
+
+	lrq = &(*crpc)->crp_rpc->crpc_reqstmsg.msg_body.lat_reqst;
+	lrq->lat_sid = console_session.ses_id;
+
+	return 0;
+}
+
 static struct lnet_process_id_packed *
 lstcon_next_id(int idx, int nkiov, lnet_kiov_t *kiov)
 {
@@ -782,6 +802,10 @@ lstcon_bulkrpc_v0_prep(struct lst_test_bulk_param *param,
 {
 	struct test_bulk_req *brq = &req->tsr_u.bulk_v0;
 
+	/* nodes without LST_FEAT_BULK_LEN don't know mixed tests */
+	if (param->blk_opc == LST_BRW_MIX)
+		return -EINVAL;
+
 	brq->blk_opc    = param->blk_opc;
 	brq->blk_npg    = (param->blk_size + PAGE_SIZE - 1) /
 			   PAGE_SIZE;
@@ -801,6 +825,9 @@ lstcon_bulkrpc_v1_prep(struct lst_test_bulk_param *param, bool is_client,
 	brq->blk_len	= param->blk_size;
 	brq->blk_offset	= is_client ? param->blk_cli_off : param->blk_srv_off;
 
+	if (param->blk_opc == LST_BRW_MIX)
+		req->tsr_u.bulk_mix.blk_write_pct = param->blk_write_pct;
+
 	return 0;
 }
 
@@ -920,7 +947,7 @@ lstcon_sesnew_stat_reply(struct lstcon_rpc_trans *trans,
 	int status = mksn_rep->mksn_status;
 
 	if (status == 0 &&
-	    (reply->msg_ses_feats & ~LST_FEATS_MASK) != 0) {
+	    (reply->msg_ses_feats & ~LST_FEATS_ALL) != 0) {
 		mksn_rep->mksn_status = EPROTO;
 		status = EPROTO;
 	}
@@ -968,6 +995,7 @@ lstcon_rpc_stat_reply(struct lstcon_rpc_trans *trans, struct srpc_msg *msg,
 	struct srpc_batch_reply *bat_rep;
 	struct srpc_test_reply *test_rep;
 	struct srpc_stat_reply *stat_rep;
+	struct srpc_lat_reply *lat_rep;
 	int rc = 0;
 
 	switch (trans->tas_opc) {
@@ -1069,6 +1097,18 @@ lstcon_rpc_stat_reply(struct lstcon_rpc_trans *trans, struct srpc_msg *msg,
                 rc = stat_rep->str_status;
                 break;
 
+	case LST_TRANS_LATQRY:
+		lat_rep = &msg->msg_body.lat_reply;
+
+		if (lat_rep->lat_status == 0) {
+			lstcon_statqry_stat_success(stat, 1);
+			return;
+		}
+
+		lstcon_statqry_stat_failure(stat, 1);
+		rc = lat_rep->lat_status;
+		break;
+
         default:
                 LBUG();
         }
@@ -1140,6 +1180,9 @@ lstcon_rpc_trans_ndlist(struct list_head *ndlist,
 		case LST_TRANS_STATQRY:
 			rc = lstcon_statrpc_prep(nd, feats, &rpc);
                         break;
+		case LST_TRANS_LATQRY:
+			rc = lstcon_latrpc_prep(nd, feats, &rpc);
+			break;
                 default:
                         rc = -EINVAL;
                         break;
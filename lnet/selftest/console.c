@@ -1488,15 +1488,39 @@ lstcon_statrpc_readent(int transop, struct srpc_msg *msg,
 }
 
 static int
-lstcon_ndlist_stat(struct list_head *ndlist,
+lstcon_latrpc_readent(int transop, struct srpc_msg *msg,
+		      struct lstcon_rpc_ent __user *ent_up)
+{
+	struct srpc_lat_reply *rep = &msg->msg_body.lat_reply;
+
+	if (rep->lat_status != 0)
+		return 0;
+
+	if (copy_to_user(&ent_up->rpe_payload[0], &rep->lat_hist,
+			 sizeof(rep->lat_hist)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static int
+lstcon_ndlist_stat(struct list_head *ndlist, bool latency,
 		   int timeout, struct list_head __user *result_up)
 {
 	LIST_HEAD(head);
 	struct lstcon_rpc_trans *trans;
 	int rc;
 
-        rc = lstcon_rpc_trans_ndlist(ndlist, &head,
-                                     LST_TRANS_STATQRY, NULL, NULL, &trans);
+	/* nodes which don't know about latency histograms have been kept
+	 * out of the session by its features */
+	if (latency &&
+	    (console_session.ses_features & LST_FEAT_LATENCY) == 0)
+		return -EOPNOTSUPP;
+
+	rc = lstcon_rpc_trans_ndlist(ndlist, &head,
+				     latency ? LST_TRANS_LATQRY :
+					       LST_TRANS_STATQRY,
+				     NULL, NULL, &trans);
         if (rc != 0) {
                 CERROR("Can't create transaction: %d\n", rc);
                 return rc;
@@ -1504,15 +1528,16 @@ lstcon_ndlist_stat(struct list_head *ndlist,
 
         lstcon_rpc_trans_postwait(trans, LST_VALIDATE_TIMEOUT(timeout));
 
-        rc = lstcon_rpc_trans_interpreter(trans, result_up,
-                                          lstcon_statrpc_readent);
+	rc = lstcon_rpc_trans_interpreter(trans, result_up,
+					  latency ? lstcon_latrpc_readent :
+						    lstcon_statrpc_readent);
         lstcon_rpc_trans_destroy(trans);
 
         return rc;
 }
 
 int
-lstcon_group_stat(char *grp_name, int timeout,
+lstcon_group_stat(char *grp_name, bool latency, int timeout,
 		  struct list_head __user *result_up)
 {
 	struct lstcon_group *grp;
@@ -1524,7 +1549,8 @@ lstcon_group_stat(char *grp_name, int timeout,
                 return rc;
         }
 
-        rc = lstcon_ndlist_stat(&grp->grp_ndl_list, timeout, result_up);
+	rc = lstcon_ndlist_stat(&grp->grp_ndl_list, latency, timeout,
+				result_up);
 
 	lstcon_group_decref(grp);
 
@@ -1533,7 +1559,8 @@ lstcon_group_stat(char *grp_name, int timeout,
 
 int
 lstcon_nodes_stat(int count, struct lnet_process_id __user *ids_up,
-		  int timeout, struct list_head __user *result_up)
+		  bool latency, int timeout,
+		  struct list_head __user *result_up)
 {
 	struct lstcon_ndlink *ndl;
 	struct lstcon_group *tmp;
@@ -1568,7 +1595,8 @@ lstcon_nodes_stat(int count, struct lnet_process_id __user *ids_up,
                 return rc;
         }
 
-        rc = lstcon_ndlist_stat(&tmp->grp_ndl_list, timeout, result_up);
+	rc = lstcon_ndlist_stat(&tmp->grp_ndl_list, latency, timeout,
+				result_up);
 
 	lstcon_group_decref(tmp);
 
@@ -1727,9 +1755,9 @@ lstcon_session_new(char *name, int key, unsigned feats,
                         return rc;
         }
 
-	if ((feats & ~LST_FEATS_MASK) != 0) {
+	if ((feats & ~LST_FEATS_ALL) != 0) {
 		CNETERR("Unknown session features %x\n",
-			(feats & ~LST_FEATS_MASK));
+			(feats & ~LST_FEATS_ALL));
 		return -EINVAL;
 	}
 
@@ -1876,9 +1904,9 @@ lstcon_session_feats_check(unsigned feats)
 {
 	int rc = 0;
 
-	if ((feats & ~LST_FEATS_MASK) != 0) {
+	if ((feats & ~LST_FEATS_ALL) != 0) {
 		CERROR("Can't support these features: %x\n",
-		       (feats & ~LST_FEATS_MASK));
+		       (feats & ~LST_FEATS_ALL));
 		return -EPROTO;
 	}
 
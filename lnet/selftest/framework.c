@@ -408,6 +408,44 @@ sfw_get_stats(struct srpc_stat_reqst *request, struct srpc_stat_reply *reply)
 	return 0;
 }
 
+static int
+sfw_get_latency(struct srpc_lat_reqst *request, struct srpc_lat_reply *reply)
+{
+	struct sfw_session *sn = sfw_data.fw_session;
+	int i;
+
+	reply->lat_sid = (sn == NULL) ? LST_INVALID_SID : sn->sn_id;
+
+	if (request->lat_sid.ses_nid == LNET_NID_ANY) {
+		reply->lat_status = EINVAL;
+		return 0;
+	}
+
+	if (sn == NULL || !sfw_sid_equal(request->lat_sid, sn->sn_id)) {
+		reply->lat_status = ESRCH;
+		return 0;
+	}
+
+	for (i = 0; i < LST_LAT_BUCKETS; i++)
+		reply->lat_hist.lat_count[i] = atomic_read(&sn->sn_latency[i]);
+
+	reply->lat_status = 0;
+	return 0;
+}
+
+static void
+sfw_account_latency(struct sfw_session *sn, ktime_t posted)
+{
+	s64 usecs = ktime_us_delta(ktime_get(), posted);
+	int bucket;
+
+	bucket = usecs <= 0 ? 0 : fls64(usecs);
+	if (bucket >= LST_LAT_BUCKETS)
+		bucket = LST_LAT_BUCKETS - 1;
+
+	atomic_inc(&sn->sn_latency[bucket]);
+}
+
 int
 sfw_make_session(struct srpc_mksn_reqst *request, struct srpc_mksn_reply *reply)
 {
@@ -448,7 +486,7 @@ sfw_make_session(struct srpc_mksn_reqst *request, struct srpc_mksn_reply *reply)
 	 * harmless because it will return zero feature to console, and it's
 	 * console's responsibility to make sure all nodes in a session have
 	 * same feature mask. */
-	if ((msg->msg_ses_feats & ~LST_FEATS_MASK) != 0) {
+	if ((msg->msg_ses_feats & ~LST_FEATS_ALL) != 0) {
 		reply->mksn_status = EPROTO;
 		return 0;
 	}
@@ -714,6 +752,9 @@ sfw_unpack_addtest_req(struct srpc_msg *msg)
 			__swab16s(&bulk->blk_flags);
 			__swab32s(&bulk->blk_offset);
 			__swab32s(&bulk->blk_len);
+
+			if (bulk->blk_opc == LST_BRW_MIX)
+				__swab32s(&req->tsr_u.bulk_mix.blk_write_pct);
 		}
 
 		return;
@@ -876,6 +917,10 @@ sfw_test_rpc_done(struct srpc_client_rpc *rpc)
 
         tsi->tsi_ops->tso_done_rpc(tsu, rpc);
 
+	if (rpc->crpc_status == 0)
+		sfw_account_latency(tsi->tsi_batch->bat_session,
+				    rpc->crpc_posted);
+
 	spin_lock(&tsi->tsi_lock);
 
 	LASSERT(sfw_test_active(tsi));
@@ -977,6 +1022,7 @@ sfw_run_test(struct swi_workitem *wi)
 
 	spin_lock(&rpc->crpc_lock);
 	rpc->crpc_timeout = rpc_timeout;
+	rpc->crpc_posted = ktime_get();
 	srpc_post_rpc(rpc);
 	spin_unlock(&rpc->crpc_lock);
 	return 0;
@@ -1235,7 +1281,7 @@ sfw_handle_server_rpc(struct srpc_server_rpc *rpc)
 	struct srpc_service	*sv = rpc->srpc_scd->scd_svc;
 	struct srpc_msg     *reply	= &rpc->srpc_replymsg;
 	struct srpc_msg     *request	= &rpc->srpc_reqstbuf->buf_msg;
-	unsigned	features = LST_FEATS_MASK;
+	unsigned	features = LST_FEATS_ALL;
 	int		rc = 0;
 
 	LASSERT(sfw_data.fw_active_srpc == NULL);
@@ -1279,7 +1325,7 @@ sfw_handle_server_rpc(struct srpc_server_rpc *rpc)
 			goto out;
 		}
 
-	} else if ((request->msg_ses_feats & ~LST_FEATS_MASK) != 0) {
+	} else if ((request->msg_ses_feats & ~LST_FEATS_ALL) != 0) {
 		/* NB: at this point, old version will ignore features and
 		 * create new session anyway, so console should be able
 		 * to handle this */
@@ -1304,6 +1350,11 @@ sfw_handle_server_rpc(struct srpc_server_rpc *rpc)
                                    &reply->msg_body.stat_reply);
                 break;
 
+	case SRPC_SERVICE_QUERY_LAT:
+		rc = sfw_get_latency(&request->msg_body.lat_reqst,
+				     &reply->msg_body.lat_reply);
+		break;
+
         case SRPC_SERVICE_DEBUG:
                 rc = sfw_debug_session(&request->msg_body.dbg_reqst,
                                        &reply->msg_body.dbg_reply);
@@ -1449,6 +1500,25 @@ sfw_unpack_message(struct srpc_msg *msg)
                 return;
         }
 
+	if (msg->msg_type == SRPC_MSG_LAT_REQST) {
+		struct srpc_lat_reqst *req = &msg->msg_body.lat_reqst;
+
+		__swab64s(&req->lat_rpyid);
+		sfw_unpack_sid(req->lat_sid);
+		return;
+	}
+
+	if (msg->msg_type == SRPC_MSG_LAT_REPLY) {
+		struct srpc_lat_reply *rep = &msg->msg_body.lat_reply;
+		int i;
+
+		__swab32s(&rep->lat_status);
+		sfw_unpack_sid(rep->lat_sid);
+		for (i = 0; i < LST_LAT_BUCKETS; i++)
+			__swab32s(&rep->lat_hist.lat_count[i]);
+		return;
+	}
+
         if (msg->msg_type == SRPC_MSG_MKSN_REQST) {
 		struct srpc_mksn_reqst *req = &msg->msg_body.mksn_reqst;
 
@@ -1593,6 +1663,7 @@ sfw_post_rpc(struct srpc_client_rpc *rpc)
 static struct srpc_service sfw_services[] = {
 	{ .sv_id = SRPC_SERVICE_DEBUG,		.sv_name = "debug", },
 	{ .sv_id = SRPC_SERVICE_QUERY_STAT,	.sv_name = "query stats", },
+	{ .sv_id = SRPC_SERVICE_QUERY_LAT,	.sv_name = "query latency", },
 	{ .sv_id = SRPC_SERVICE_MAKE_SESSION,	.sv_name = "make session", },
 	{ .sv_id = SRPC_SERVICE_REMOVE_SESSION,	.sv_name = "remove session", },
 	{ .sv_id = SRPC_SERVICE_BATCH,		.sv_name = "batch service", },
@@ -91,13 +91,18 @@ void
 lnet_selftest_structure_assertion(void)
 {
 	BUILD_BUG_ON(sizeof(struct srpc_msg) != 160);
-	BUILD_BUG_ON(sizeof(struct srpc_test_reqst) != 70);
+	BUILD_BUG_ON(sizeof(struct srpc_test_reqst) != 74);
 	BUILD_BUG_ON(offsetof(struct srpc_msg, msg_body.tes_reqst.tsr_concur) !=
 		     72);
 	BUILD_BUG_ON(offsetof(struct srpc_msg, msg_body.tes_reqst.tsr_ndest) !=
 			      78);
+	BUILD_BUG_ON(offsetof(struct srpc_msg,
+			      msg_body.tes_reqst.tsr_u.bulk_mix.blk_write_pct) !=
+		     94);
 	BUILD_BUG_ON(sizeof(struct srpc_stat_reply) != 136);
 	BUILD_BUG_ON(sizeof(struct srpc_stat_reqst) != 28);
+	BUILD_BUG_ON(sizeof(struct srpc_lat_reply) != 132);
+	BUILD_BUG_ON(sizeof(struct srpc_lat_reqst) != 24);
 }
 
 static int __init
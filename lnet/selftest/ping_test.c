@@ -57,7 +57,7 @@ ping_client_init(struct sfw_test_instance *tsi)
 	struct sfw_session *sn = tsi->tsi_batch->bat_session;
 
 	LASSERT(tsi->tsi_is_client);
-	LASSERT(sn != NULL && (sn->sn_features & ~LST_FEATS_MASK) == 0);
+	LASSERT(sn != NULL && (sn->sn_features & ~LST_FEATS_ALL) == 0);
 
 	spin_lock_init(&lst_ping_data.pnd_lock);
 	lst_ping_data.pnd_counter = 0;
@@ -92,7 +92,7 @@ ping_client_prep_rpc(struct sfw_test_unit *tsu, struct lnet_process_id dest,
 	int rc;
 
 	LASSERT(sn != NULL);
-	LASSERT((sn->sn_features & ~LST_FEATS_MASK) == 0);
+	LASSERT((sn->sn_features & ~LST_FEATS_ALL) == 0);
 
 	rc = sfw_create_test_rpc(tsu, dest, sn->sn_features, 0, 0, rpc);
         if (rc != 0)
@@ -193,8 +193,8 @@ ping_server_handle(struct srpc_server_rpc *rpc)
         rep->pnr_seq   = req->pnr_seq;
         rep->pnr_magic = LST_PING_TEST_MAGIC;
 
-	if ((reqstmsg->msg_ses_feats & ~LST_FEATS_MASK) != 0) {
-		replymsg->msg_ses_feats = LST_FEATS_MASK;
+	if ((reqstmsg->msg_ses_feats & ~LST_FEATS_ALL) != 0) {
+		replymsg->msg_ses_feats = LST_FEATS_ALL;
 		rep->pnr_status = EPROTO;
 		return 0;
 	}
@@ -59,6 +59,8 @@ enum srpc_msg_type {
         SRPC_MSG_PING_REPLY     = 15,
         SRPC_MSG_JOIN_REQST     = 16,
         SRPC_MSG_JOIN_REPLY     = 17,
+	SRPC_MSG_LAT_REQST	= 18,
+	SRPC_MSG_LAT_REPLY	= 19,
 };
 
 /* CAVEAT EMPTOR:
@@ -164,6 +166,17 @@ struct srpc_stat_reply {
 	struct lnet_counters_common str_lnet;
 } WIRE_ATTR;
 
+struct srpc_lat_reqst {
+	__u64			lat_rpyid;	/* reply buffer matchbits */
+	struct lst_sid		lat_sid;	/* session id */
+} WIRE_ATTR;
+
+struct srpc_lat_reply {
+	__u32			lat_status;
+	struct lst_sid		lat_sid;
+	struct sfw_latency	lat_hist;	/* RPC round trip times */
+} WIRE_ATTR;
+
 struct test_bulk_req {
         __u32                   blk_opc;        /* bulk operation code */
         __u32                   blk_npg;        /* # of pages */
@@ -181,6 +194,14 @@ struct test_bulk_req_v1 {
 	__u32                   blk_offset;
 } WIRE_ATTR;
 
+/* LST_BRW_MIX: the v1 request is followed by the share of writes, older
+ * nodes reject the opcode before looking at it */
+struct test_bulk_req_mix {
+	struct test_bulk_req_v1	blk_v1;
+	/** percentage of RPCs which write */
+	__u32			blk_write_pct;
+} WIRE_ATTR;
+
 struct test_ping_req {
 	__u32			png_size;       /* size of ping message */
 	__u32			png_flags;      /* reserved flags */
@@ -203,6 +224,7 @@ struct srpc_test_reqst {
 		struct test_ping_req	ping;
 		struct test_bulk_req	bulk_v0;
 		struct test_bulk_req_v1	bulk_v1;
+		struct test_bulk_req_mix bulk_mix;
 	} tsr_u;
 } WIRE_ATTR;
 
@@ -266,6 +288,8 @@ struct srpc_msg {
 		struct srpc_batch_reply		bat_reply;
 		struct srpc_stat_reqst		stat_reqst;
 		struct srpc_stat_reply		stat_reply;
+		struct srpc_lat_reqst		lat_reqst;
+		struct srpc_lat_reply		lat_reply;
 		struct srpc_test_reqst		tes_reqst;
 		struct srpc_test_reply		tes_reply;
 		struct srpc_join_reqst		join_reqst;
@@ -77,6 +77,7 @@ struct sfw_test_instance;
 #define SRPC_SERVICE_TEST               4
 #define SRPC_SERVICE_QUERY_STAT         5
 #define SRPC_SERVICE_JOIN               6
+#define SRPC_SERVICE_QUERY_LAT		7
 #define SRPC_FRAMEWORK_SERVICE_MAX_ID   10
 /* other services start from SRPC_FRAMEWORK_SERVICE_MAX_ID+1 */
 #define SRPC_SERVICE_BRW                11
@@ -121,6 +122,9 @@ srpc_service2request (int service)
 
         case SRPC_SERVICE_JOIN:
                 return SRPC_MSG_JOIN_REQST;
+
+	case SRPC_SERVICE_QUERY_LAT:
+		return SRPC_MSG_LAT_REQST;
         }
 }
 
@@ -216,6 +220,7 @@ struct srpc_client_rpc {
         /* state flags */
         unsigned int         crpc_aborted:1; /* being given up */
         unsigned int         crpc_closed:1;  /* completed */
+	ktime_t			crpc_posted;	/* when the RPC was posted */
 
 	/* RPC events */
 	struct srpc_event	crpc_bulkev;	/* bulk event */
@@ -334,6 +339,8 @@ struct sfw_session {
 	atomic_t		sn_brw_errors;
 	atomic_t		sn_ping_errors;
 	ktime_t			sn_started;
+	/* round trip times of completed test RPCs, see struct sfw_latency */
+	atomic_t		sn_latency[LST_LAT_BUCKETS];
 };
 
 #define sfw_sid_equal(sid0, sid1)     ((sid0).ses_nid == (sid1).ses_nid && \
@@ -382,6 +389,7 @@ struct sfw_test_instance {
 		struct test_ping_req	ping;	  /* ping parameter */
 		struct test_bulk_req	bulk_v0;  /* bulk parameter */
 		struct test_bulk_req_v1	bulk_v1;  /* bulk v1 parameter */
+		struct test_bulk_req_mix bulk_mix; /* mixed bulk parameter */
 	} tsi_u;
 };
 
@@ -1921,6 +1921,96 @@ add_msg_stats_to_yaml_blk(struct cYAML *yaml,
 	return true;
 }
 
+/*
+ * Add the Multi-Rail selection averages of a local or peer NI. Kernels
+ * without them are not an error, the block is just left out.
+ */
+static bool
+add_sel_stats_to_yaml_blk(struct cYAML *yaml, lnet_nid_t nid,
+			  enum lnet_health_type type)
+{
+	struct lnet_ioctl_sel_stats sel_stats;
+	struct cYAML *ysel;
+
+	LIBCFS_IOC_INIT_V2(sel_stats, iss_hdr);
+	sel_stats.iss_nid = nid;
+	sel_stats.iss_type = type;
+	if (l_ioctl(LNET_DEV_ID, IOC_LIBCFS_GET_SEL_STATS, &sel_stats) != 0)
+		return true;
+
+	ysel = cYAML_create_object(yaml, "selection stats");
+	if (!ysel)
+		return false;
+	if (cYAML_create_number(ysel, "stride",
+				sel_stats.iss_stride) == NULL)
+		return false;
+	if (cYAML_create_number(ysel, "latency_us",
+				sel_stats.iss_latency / 1000) == NULL)
+		return false;
+	if (cYAML_create_number(ysel, "avg_size",
+				sel_stats.iss_size) == NULL)
+		return false;
+	if (cYAML_create_number(ysel, "throughput_kBps",
+				sel_stats.iss_throughput / 1024) == NULL)
+		return false;
+
+	return true;
+}
+
+static bool
+add_lat_hist_to_yaml_blk(struct cYAML *yaml, const char *name, __u32 *counts)
+{
+	struct cYAML *yhist;
+	char key[32];
+	int i;
+
+	yhist = cYAML_create_object(yaml, (char *)name);
+	if (!yhist)
+		return false;
+
+	/* only print the buckets in use, labelled by their upper bound */
+	for (i = 0; i < LNET_LAT_BUCKETS; i++) {
+		if (!counts[i])
+			continue;
+		if (i < LNET_LAT_BUCKETS - 1)
+			snprintf(key, sizeof(key), "<%uus", 1U << i);
+		else
+			snprintf(key, sizeof(key), ">=%uus", 1U << (i - 1));
+		if (cYAML_create_number(yhist, key, counts[i]) == NULL)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Add the latency histograms of a local or peer NI. As with the
+ * selection stats, kernels without them just leave the block out.
+ */
+static bool
+add_lat_stats_to_yaml_blk(struct cYAML *yaml, lnet_nid_t nid,
+			  enum lnet_health_type type)
+{
+	struct lnet_ioctl_lat_stats lat_stats;
+	struct cYAML *ylat;
+
+	LIBCFS_IOC_INIT_V2(lat_stats, ils_hdr);
+	lat_stats.ils_nid = nid;
+	lat_stats.ils_type = type;
+	if (l_ioctl(LNET_DEV_ID, IOC_LIBCFS_GET_LAT_STATS, &lat_stats) != 0)
+		return true;
+
+	ylat = cYAML_create_object(yaml, "latency stats");
+	if (!ylat)
+		return false;
+	if (!add_lat_hist_to_yaml_blk(ylat, "send", lat_stats.ils_send))
+		return false;
+	if (!add_lat_hist_to_yaml_blk(ylat, "queue", lat_stats.ils_queue))
+		return false;
+
+	return true;
+}
+
 static struct lnet_ioctl_comm_count *
 get_counts(struct lnet_ioctl_element_msg_stats *msg_stats, int idx)
 {
@@ -2185,6 +2275,13 @@ int lustre_lnet_show_net(char *nw, int detail, int seq_no,
 							== NULL)
 				goto out;
 
+			if (!add_sel_stats_to_yaml_blk(item, ni_data->lic_nid,
+						       LNET_HEALTH_TYPE_LOCAL_NI))
+				goto out;
+			if (!add_lat_stats_to_yaml_blk(item, ni_data->lic_nid,
+						       LNET_HEALTH_TYPE_LOCAL_NI))
+				goto out;
+
 continue_without_msg_stats:
 			tunables = cYAML_create_object(item, "tunables");
 			if (!tunables)
@@ -3019,6 +3116,13 @@ int lustre_lnet_show_peer(char *knid, int detail, int seq_no,
 						hstats->hlpni_network_timeout)
 							== NULL)
 				goto out;
+
+			if (!add_sel_stats_to_yaml_blk(peer_ni, *nidp,
+						       LNET_HEALTH_TYPE_PEER_NI))
+				goto out;
+			if (!add_lat_stats_to_yaml_blk(peer_ni, *nidp,
+						       LNET_HEALTH_TYPE_PEER_NI))
+				goto out;
 		}
 	}
 
@@ -58,7 +58,9 @@ static struct lst_sid session_id;
 static int                 session_key;
 static int lst_list_commands(int argc, char **argv);
 
-/* All nodes running 2.6.50 or later understand feature LST_FEAT_BULK_LEN */
+/* All nodes running 2.6.50 or later understand feature LST_FEAT_BULK_LEN,
+ * LST_FEAT_LATENCY needs this release on all nodes so it's only enabled
+ * through LST_FEATURES */
 static unsigned		session_features = LST_FEATS_MASK;
 static struct lstcon_trans_stat	trans_stat;
 
@@ -1486,7 +1488,7 @@ jt_lst_list_group(int argc, char **argv)
 
 int
 lst_stat_ioctl(char *name, int count, struct lnet_process_id *idsp,
-	       int timeout, struct list_head *resultp)
+	       int latency, int timeout, struct list_head *resultp)
 {
 	struct lstio_stat_args args = { 0 };
 
@@ -1498,7 +1500,8 @@ lst_stat_ioctl(char *name, int count, struct lnet_process_id *idsp,
 	args.lstio_sta_idsp    = idsp;
 	args.lstio_sta_resultp = resultp;
 
-	return lst_ioctl(LSTIO_STAT_QUERY, &args, sizeof(args));
+	return lst_ioctl(latency ? LSTIO_LAT_QUERY : LSTIO_STAT_QUERY,
+			 &args, sizeof(args));
 }
 
 typedef struct {
@@ -1507,6 +1510,7 @@ typedef struct {
         char                   *srp_name;
 	struct lnet_process_id      *srp_ids;
 	struct list_head              srp_result[2];
+	struct list_head	      srp_lat[2];
 } lst_stat_req_param_t;
 
 static void
@@ -1514,8 +1518,10 @@ lst_stat_req_param_free(lst_stat_req_param_t *srp)
 {
         int     i;
 
-        for (i = 0; i < 2; i++)
-                lst_free_rpcent(&srp->srp_result[i]);
+	for (i = 0; i < 2; i++) {
+		lst_free_rpcent(&srp->srp_result[i]);
+		lst_free_rpcent(&srp->srp_lat[i]);
+	}
 
         if (srp->srp_ids != NULL)
                 free(srp->srp_ids);
@@ -1524,7 +1530,8 @@ lst_stat_req_param_free(lst_stat_req_param_t *srp)
 }
 
 static int
-lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old)
+lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old,
+			 int latency)
 {
         lst_stat_req_param_t *srp = NULL;
         int                   count = save_old ? 2 : 1;
@@ -1538,6 +1545,8 @@ lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old)
         memset(srp, 0, sizeof(*srp));
 	INIT_LIST_HEAD(&srp->srp_result[0]);
 	INIT_LIST_HEAD(&srp->srp_result[1]);
+	INIT_LIST_HEAD(&srp->srp_lat[0]);
+	INIT_LIST_HEAD(&srp->srp_lat[1]);
 
         rc = lst_get_node_count(LST_OPC_GROUP, name,
                                 &srp->srp_count, NULL);
@@ -1562,6 +1571,9 @@ lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old)
 				      sizeof(struct sfw_counters)  +
 				      sizeof(struct srpc_counters) +
 				      sizeof(struct lnet_counters_common));
+		if (rc == 0 && latency)
+			rc = lst_alloc_rpcent(&srp->srp_lat[i], srp->srp_count,
+					      sizeof(struct sfw_latency));
 		if (rc != 0) {
 			fprintf(stderr, "Out of memory\n");
 			break;
@@ -1870,6 +1882,93 @@ lst_print_stat(char *name, struct list_head *resultp,
 	lst_print_lnet_stat(name, bwrt, rdwr, type, mbs);
 }
 
+static void
+lst_print_lat_value(const char *label, int bucket)
+{
+	unsigned long long usecs = 1ULL << bucket;
+
+	if (usecs < 1000)
+		fprintf(stdout, "%s: <%-6lluus ", label, usecs);
+	else if (usecs < 1000000)
+		fprintf(stdout, "%s: <%-6llums ", label, usecs / 1000);
+	else
+		fprintf(stdout, "%s: <%-7llus ", label, usecs / 1000000);
+}
+
+/* Merge the RPC round trip times reported by all nodes in the last interval,
+ * and print the latency under which the given share of RPCs completed. The
+ * values are upper bounds of power-of-2 histogram buckets. */
+static void
+lst_print_lat_stat(char *name, struct list_head *resultp, int idx)
+{
+	static const struct {
+		const char	*label;
+		double		 fraction;
+	} pcts[] = {
+		{ "p50",   0.5 },
+		{ "p90",   0.9 },
+		{ "p99",   0.99 },
+		{ "p99.9", 0.999 },
+	};
+	unsigned long long hist[LST_LAT_BUCKETS] = { 0 };
+	unsigned long long total = 0;
+	unsigned long long sum;
+	struct lstcon_rpc_ent *new;
+	struct lstcon_rpc_ent *old;
+	struct sfw_latency *lat_new;
+	struct sfw_latency *lat_old;
+	int max = 0;
+	int i;
+	int j;
+
+	old = list_entry(resultp[1 - idx].next, struct lstcon_rpc_ent,
+			 rpe_link);
+	list_for_each_entry(new, &resultp[idx], rpe_link) {
+		if (&old->rpe_link == &resultp[1 - idx])
+			break;
+
+		/* first time get stats result, can't calculate diff */
+		if (old->rpe_peer.nid == LNET_NID_ANY)
+			return;
+
+		if (new->rpe_rpc_errno == 0 && new->rpe_fwk_errno == 0 &&
+		    old->rpe_rpc_errno == 0 && old->rpe_fwk_errno == 0 &&
+		    new->rpe_peer.nid == old->rpe_peer.nid &&
+		    new->rpe_peer.pid == old->rpe_peer.pid) {
+			lat_new = (struct sfw_latency *)&new->rpe_payload[0];
+			lat_old = (struct sfw_latency *)&old->rpe_payload[0];
+
+			for (i = 0; i < LST_LAT_BUCKETS; i++)
+				hist[i] += (__u32)(lat_new->lat_count[i] -
+						   lat_old->lat_count[i]);
+		}
+
+		old = list_entry(old->rpe_link.next, struct lstcon_rpc_ent,
+				 rpe_link);
+	}
+
+	for (i = 0; i < LST_LAT_BUCKETS; i++) {
+		total += hist[i];
+		if (hist[i] != 0)
+			max = i;
+	}
+
+	if (total == 0)
+		return;
+
+	fprintf(stdout, "[RPC Latency of %s]\n", name);
+	fprintf(stdout, "RPCs: %-8llu ", total);
+
+	for (j = 0, i = 0, sum = hist[0];
+	     j < sizeof(pcts) / sizeof(pcts[0]); j++) {
+		while (sum < pcts[j].fraction * total && i < max)
+			sum += hist[++i];
+		lst_print_lat_value(pcts[j].label, i);
+	}
+	lst_print_lat_value("Max", max);
+	fprintf(stdout, "\n");
+}
+
 int
 jt_lst_stat(int argc, char **argv)
 {
@@ -1888,6 +1987,7 @@ jt_lst_stat(int argc, char **argv)
 	int		      rc;
 	int		      c;
 	int		      mbs     = 0; /* report as MB/s */
+	int		      latency = 0;
 
 	static const struct option stat_opts[] = {
 		{ .name = "timeout", .has_arg = required_argument, .val = 't' },
@@ -1903,6 +2003,7 @@ jt_lst_stat(int argc, char **argv)
 		{ .name = "min",     .has_arg = no_argument,       .val = 'n' },
 		{ .name = "max",     .has_arg = no_argument,       .val = 'x' },
 		{ .name = "mbs",     .has_arg = no_argument,       .val = 'm' },
+		{ .name = "lat",     .has_arg = no_argument,	   .val = 'L' },
 		{ .name = NULL } };
 
         if (session_key == 0) {
@@ -1912,7 +2013,7 @@ jt_lst_stat(int argc, char **argv)
         }
 
         while (1) {
-		c = getopt_long(argc, argv, "t:d:lcbarwgnxm", stat_opts,
+		c = getopt_long(argc, argv, "t:d:lcbarwgnxmL", stat_opts,
 				&optidx);
 
                 if (c == -1)
@@ -1970,6 +2071,9 @@ jt_lst_stat(int argc, char **argv)
 		case 'm':
 			mbs = 1;
 			break;
+		case 'L':
+			latency = 1;
+			break;
 
 		default:
 			lst_print_usage(argv[0]);
@@ -1999,7 +2103,8 @@ jt_lst_stat(int argc, char **argv)
 	INIT_LIST_HEAD(&head);
 
         while (optind < argc) {
-                rc = lst_stat_req_param_alloc(argv[optind++], &srp, 1);
+		rc = lst_stat_req_param_alloc(argv[optind++], &srp, 1,
+					      latency);
                 if (rc != 0)
                         goto out;
 
@@ -2016,9 +2121,9 @@ jt_lst_stat(int argc, char **argv)
 		last = now;
 
 		list_for_each_entry(srp, &head, srp_link) {
-                        rc = lst_stat_ioctl(srp->srp_name,
-                                            srp->srp_count, srp->srp_ids,
-                                            timeout, &srp->srp_result[idx]);
+			rc = lst_stat_ioctl(srp->srp_name,
+					    srp->srp_count, srp->srp_ids,
+					    0, timeout, &srp->srp_result[idx]);
                         if (rc == -1) {
                                 lst_print_error("stat", "Failed to stat %s: %s\n",
                                                 srp->srp_name, strerror(errno));
@@ -2029,6 +2134,26 @@ jt_lst_stat(int argc, char **argv)
 				       idx, lnet, bwrt, rdwr, type, mbs);
 
 			lst_reset_rpcent(&srp->srp_result[1 - idx]);
+
+			if (!latency)
+				continue;
+
+			rc = lst_stat_ioctl(srp->srp_name,
+					    srp->srp_count, srp->srp_ids,
+					    1, timeout, &srp->srp_lat[idx]);
+			if (rc == -1) {
+				lst_print_error("stat",
+						"Failed to get latency of %s: %s\n",
+						srp->srp_name,
+						errno == EOPNOTSUPP ?
+						"not enabled by LST_FEATURES" :
+						strerror(errno));
+				goto out;
+			}
+
+			lst_print_lat_stat(srp->srp_name, srp->srp_lat, idx);
+
+			lst_reset_rpcent(&srp->srp_lat[1 - idx]);
 		}
 
                 idx = 1 - idx;
@@ -2097,7 +2222,7 @@ jt_lst_show_error(int argc, char **argv)
 	INIT_LIST_HEAD(&head);
 
         while (optind < argc) {
-                rc = lst_stat_req_param_alloc(argv[optind++], &srp, 0);
+		rc = lst_stat_req_param_alloc(argv[optind++], &srp, 0, 0);
                 if (rc != 0)
                         goto out;
 
@@ -2105,8 +2230,8 @@ jt_lst_show_error(int argc, char **argv)
         }
 
 	list_for_each_entry(srp, &head, srp_link) {
-                rc = lst_stat_ioctl(srp->srp_name, srp->srp_count,
-                                    srp->srp_ids, 10, &srp->srp_result[0]);
+		rc = lst_stat_ioctl(srp->srp_name, srp->srp_count,
+				    srp->srp_ids, 0, 10, &srp->srp_result[0]);
 
                 if (rc == -1) {
                         lst_print_error(srp->srp_name, "Failed to show errors of %s: %s\n",
@@ -3003,6 +3128,19 @@ lst_get_bulk_param(int argc, char **argv, struct lst_test_bulk_param *bulk)
                            strcasecmp(argv[i], "w") == 0) {
                         bulk->blk_opc = LST_BRW_WRITE;
 
+		} else if (strcasestr(argv[i], "mix=") == argv[i]) {
+			/* percentage of writes, the other RPCs read */
+			tok = strchr(argv[i], '=') + 1;
+
+			bulk->blk_write_pct = strtol(tok, &end, 0);
+			if (*end != '\0' || bulk->blk_write_pct < 0 ||
+			    bulk->blk_write_pct > 100) {
+				fprintf(stderr,
+					"Invalid write percentage %s\n", tok);
+				return -1;
+			}
+			bulk->blk_opc = LST_BRW_MIX;
+
                 } else {
                         fprintf(stderr, "Unknow parameter: %s\n", argv[i]);
                         return -1;
@@ -3259,7 +3397,7 @@ static command_t lst_cmdlist[] = {
           "Usage: lst list_group [--active] [--busy] [--down] [--unknown] GROUP ..."    },
 	{"stat",                jt_lst_stat,            NULL,
 	 "Usage: lst stat [--bw] [--rate] [--read] [--write] [--max] [--min] [--avg] "
-	 " [--mbs] [--timeout #] [--delay #] [--count #] GROUP [GROUP]"                 },
+	 " [--mbs] [--lat] [--timeout #] [--delay #] [--count #] GROUP [GROUP]"         },
         {"show_error",          jt_lst_show_error,      NULL,
          "Usage: lst show_error NAME | IDS ..."                                         },
         {"add_batch",           jt_lst_add_batch,       NULL,
@@ -3290,11 +3428,11 @@ lst_initialize(void)
 	if (feats != NULL)
 		session_features = strtol(feats, NULL, 16);
 
-	if ((session_features & ~LST_FEATS_MASK) != 0) {
+	if ((session_features & ~LST_FEATS_ALL) != 0) {
 		fprintf(stderr,
 			"Unsupported session features %x, "
 			"only support these features so far: %x\n",
-			(session_features & ~LST_FEATS_MASK), LST_FEATS_MASK);
+			(session_features & ~LST_FEATS_ALL), LST_FEATS_ALL);
 		return -1;
 	}
 
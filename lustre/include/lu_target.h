@@ -502,6 +502,7 @@ int tgt_mk_reply_data(const struct lu_env *env, struct lu_target *tgt,
 		      __u64 transno);
 struct tg_reply_data *tgt_lookup_reply_by_xid(struct tg_export_data *ted,
 					       __u64 xid);
+void tgt_mult_trans_enable(const struct lu_env *env);
 int tgt_tunables_init(struct lu_target *lut);
 void tgt_tunables_fini(struct lu_target *lut);
 
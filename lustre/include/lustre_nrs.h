@@ -676,6 +676,7 @@ enum {
 #include <lustre_nrs_crr.h>
 #include <lustre_nrs_orr.h>
 #include <lustre_nrs_delay.h>
+#include <lustre_nrs_codel.h>
 
 /**
  * NRS request
@@ -726,6 +727,10 @@ struct ptlrpc_nrs_request {
 		 * Fields for the delay policy
 		 */
 		struct nrs_delay_req	delay;
+		/**
+		 * Fields for the CoDel policy
+		 */
+		struct nrs_codel_req	codel;
 	} nr_u;
 	/**
 	 * Externally-registering policies may want to use this to allocate
@@ -0,0 +1,148 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ *
+ * Network Request Scheduler (NRS) CoDel policy
+ *
+ */
+
+#ifndef _LUSTRE_NRS_CODEL_H
+#define _LUSTRE_NRS_CODEL_H
+
+#include <libcfs/linux/linux-hash.h>
+
+/* \name codel
+ *
+ * CoDel (latency target) policy
+ * @{
+ */
+
+/**
+ * What requests are grouped into scheduling classes by.
+ */
+enum nrs_codel_class_type {
+	NRS_CODEL_CLASS_NID	= 0,
+	NRS_CODEL_CLASS_JOBID,
+	NRS_CODEL_CLASS_OPCODE,
+};
+
+/**
+ * Private data structure for the CoDel policy
+ */
+struct nrs_codel_head {
+	struct ptlrpc_nrs_resource	 ch_res;
+	/**
+	 * Scheduling classes, hashed by nrs_codel_class::cc_key.
+	 */
+	struct rhashtable		 ch_class_hash;
+	/**
+	 * Classes with queued requests that are meeting the latency target,
+	 * served round-robin.
+	 */
+	struct list_head		 ch_fast;
+	/**
+	 * Classes with queued requests that have been kept above the latency
+	 * target for longer than ch_interval; only served when ch_fast is
+	 * empty or to guarantee forward progress.
+	 */
+	struct list_head		 ch_slow;
+	enum nrs_codel_class_type	 ch_type;
+	/**
+	 * Target queueing delay, in milliseconds.
+	 */
+	__u32				 ch_target;
+	/**
+	 * Time a class may stay above the target before being penalized, in
+	 * milliseconds.
+	 */
+	__u32				 ch_interval;
+	/**
+	 * Requests served from ch_fast since the last one from ch_slow.
+	 */
+	__u32				 ch_fast_served;
+	/**
+	 * Number of classes currently on the ch_slow list.
+	 */
+	__u32				 ch_slow_count;
+	/**
+	 * Number of times a class has been penalized.
+	 */
+	__u64				 ch_penalties;
+};
+
+/**
+ * A CoDel scheduling class; a NID, JobID or opcode depending on
+ * nrs_codel_head::ch_type.
+ */
+struct nrs_codel_class {
+	struct ptlrpc_nrs_resource	 cc_res;
+	struct rhash_head		 cc_rhead;
+	__u64				 cc_key;
+	/**
+	 * Linkage into nrs_codel_head::ch_fast or nrs_codel_head::ch_slow
+	 * while the class has queued requests.
+	 */
+	struct list_head		 cc_list;
+	/**
+	 * Requests of this class, in arrival order.
+	 */
+	struct list_head		 cc_reqs;
+	/**
+	 * When the queueing delay of this class first went above the target,
+	 * plus nrs_codel_head::ch_interval; zero while below target.
+	 */
+	ktime_t				 cc_first_above;
+	/**
+	 * Held by each request of the class, which is freed on the last put.
+	 */
+	atomic_t			 cc_ref;
+	__u32				 cc_queued;
+	bool				 cc_slow;
+	struct rcu_head			 cc_rcu;
+};
+
+struct nrs_codel_req {
+	struct list_head		 cr_list;
+	/**
+	 * The time the request was enqueued in the policy.
+	 */
+	ktime_t				 cr_enqueue_time;
+};
+
+enum nrs_ctl_codel {
+	NRS_CTL_CODEL_RD_TARGET = PTLRPC_NRS_CTL_1ST_POL_SPEC,
+	NRS_CTL_CODEL_WR_TARGET,
+	NRS_CTL_CODEL_RD_INTERVAL,
+	NRS_CTL_CODEL_WR_INTERVAL,
+	NRS_CTL_CODEL_RD_STATS,
+};
+
+/**
+ * Argument of NRS_CTL_CODEL_RD_STATS
+ */
+struct nrs_codel_stats {
+	__u64				 cs_penalties;
+	__u32				 cs_slow_classes;
+};
+
+/** @} codel */
+
+#endif
@@ -198,6 +198,7 @@ extern struct req_format RQF_OST_CREATE;
 extern struct req_format RQF_OST_PUNCH;
 extern struct req_format RQF_OST_SYNC;
 extern struct req_format RQF_OST_DESTROY;
+extern struct req_format RQF_OST_DESTROY_BATCH;
 extern struct req_format RQF_OST_BRW_READ;
 extern struct req_format RQF_OST_BRW_WRITE;
 extern struct req_format RQF_OST_STATFS;
@@ -321,6 +322,7 @@ extern struct req_msg_field RMF_RCS;
 extern struct req_msg_field RMF_FIEMAP_KEY;
 extern struct req_msg_field RMF_FIEMAP_VAL;
 extern struct req_msg_field RMF_OST_ID;
+extern struct req_msg_field RMF_OST_ID_ARRAY;
 extern struct req_msg_field RMF_SHORT_IO;
 
 /* MGS config read message format */
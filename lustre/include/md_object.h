@@ -168,7 +168,8 @@ struct md_op_spec {
 		     sp_cr_lookup:1, /* do lookup sanity check or not. */
 		     sp_rm_entry:1,  /* only remove name entry */
 		     sp_permitted:1, /* do not check permission */
-		     sp_migrate_close:1; /* close the file during migrate */
+		     sp_migrate_close:1, /* close the file during migrate */
+		     sp_migrate_nsonly:1; /* migrate name entry only */
 	/** Current lock mode for parent dir where create is performing. */
 	mdl_mode_t sp_cr_mode;
 
@@ -277,6 +277,7 @@ extern char obd_jobid_var[];
 #define OBD_FAIL_OSD_TXN_START				0x19a
 
 #define OBD_FAIL_OSD_DUPLICATE_MAP			0x19b
+#define OBD_FAIL_OSD_OI_CACHE_RACE			0x19c
 
 #define OBD_FAIL_OFD_SET_OID				0x1e0
 
@@ -645,6 +646,7 @@ extern char obd_jobid_var[];
 
 /* MIGRATE */
 #define OBD_FAIL_MIGRATE_ENTRIES		0x1801
+#define OBD_FAIL_MIGRATE_SPLIT_STOP		0x1802
 
 /* LMV */
 #define OBD_FAIL_UNKNOWN_LMV_STRIPE		0x1901
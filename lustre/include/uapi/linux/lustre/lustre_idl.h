@@ -841,6 +841,7 @@ struct ptlrpc_body_v2 {
 #define OBD_CONNECT2_CRUSH		0x2000ULL /* crush hash striped directory */
 #define OBD_CONNECT2_ASYNC_DISCARD	0x4000ULL /* support async DoM data discard */
 #define OBD_CONNECT2_ENCRYPT		0x8000ULL /* client-to-disk encrypt */
+#define OBD_CONNECT2_DESTROY_BATCH	0x10000ULL /* OST_DESTROY of object array */
 /* XXX README XXX:
  * Please DO NOT add flag values here before first ensuring that this same
  * flag value is not in use on some other branch.  Please clear any such
@@ -923,7 +924,8 @@ struct ptlrpc_body_v2 {
 				OBD_CONNECT_GRANT_PARAM | \
 				OBD_CONNECT_SHORTIO | OBD_CONNECT_FLAGS2)
 
-#define OST_CONNECT_SUPPORTED2 (OBD_CONNECT2_LOCKAHEAD | OBD_CONNECT2_INC_XID)
+#define OST_CONNECT_SUPPORTED2 (OBD_CONNECT2_LOCKAHEAD | OBD_CONNECT2_INC_XID | \
+				OBD_CONNECT2_DESTROY_BATCH)
 
 #define ECHO_CONNECT_SUPPORTED (OBD_CONNECT_FID)
 #define ECHO_CONNECT_SUPPORTED2 0
@@ -2723,6 +2725,7 @@ enum llog_op_type {
 	/* LLOG_JOIN_REC	= LLOG_OP_MAGIC | 0x50000, obsolete  1.8.0 */
 	CHANGELOG_REC		= LLOG_OP_MAGIC | 0x60000,
 	CHANGELOG_USER_REC	= LLOG_OP_MAGIC | 0x70000,
+	CHANGELOG_USER_REC2	= LLOG_OP_MAGIC | 0x70002,
 	HSM_AGENT_REC		= LLOG_OP_MAGIC | 0x80000,
 	UPDATE_REC		= LLOG_OP_MAGIC | 0xa0000,
 	LLOG_HDR_MAGIC		= LLOG_OP_MAGIC | 0x45539,
@@ -2863,6 +2866,17 @@ struct llog_changelog_user_rec {
 	struct llog_rec_tail  cur_tail;
 } __attribute__((packed));
 
+/* changelog user registered with a filter, same leading fields as
+ * llog_changelog_user_rec */
+struct llog_changelog_user_rec2 {
+	struct llog_rec_hdr		cur_hdr;
+	__u32				cur_id;
+	__u32				cur_time;
+	__u64				cur_endrec;
+	struct changelog_user_filter	cur_filter;
+	struct llog_rec_tail		cur_tail;
+} __attribute__((packed));
+
 enum agent_req_status {
 	ARS_WAITING,
 	ARS_STARTED,
@@ -3147,6 +3161,10 @@ struct ost_body {
 	struct obdo oa;
 };
 
+/* Maximum number of objects in the ost_id array of a batched OST_DESTROY,
+ * see OBD_CONNECT2_DESTROY_BATCH */
+#define OST_DESTROY_BATCH_MAX	256
+
 /* Key for FIEMAP to be used in get_info calls */
 struct ll_fiemap_info_key {
 	char		lfik_name[8];
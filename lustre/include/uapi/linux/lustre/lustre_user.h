@@ -1027,6 +1027,10 @@ static inline bool lmv_is_known_hash_type(__u32 type)
 #define LMV_HASH_FLAG_LOST_LMV	0x10000000
 
 #define LMV_HASH_FLAG_BAD_TYPE	0x20000000
+/* The directory is being split in place, its last stripe is the source stripe,
+ * whose names are still in the index of the master, see mdt_restriper.c. It's
+ * always set together with LMV_HASH_FLAG_MIGRATION. */
+#define LMV_HASH_FLAG_SPLIT	0x40000000
 #define LMV_HASH_FLAG_MIGRATION	0x80000000
 
 extern char *mdt_hash_name[LMV_HASH_TYPE_MAX];
@@ -1626,6 +1630,25 @@ enum changelog_send_extra_flag {
 /* 31 usable bytes string + null terminator. */
 #define LUSTRE_JOBID_SIZE	32
 
+/* Which of the changelog_user_filter fields are in use. */
+enum changelog_user_filter_flags {
+	CLUF_PROJID	= 0x00000001, /* only records of files in cuf_projid */
+	CLUF_PFID	= 0x00000002, /* only records in directory cuf_pfid */
+	CLUF_JOBID	= 0x00000004, /* only records generated by cuf_jobid */
+	CLUF_SUPPORTED	= CLUF_PROJID | CLUF_PFID | CLUF_JOBID,
+};
+
+/* Records wanted by a changelog user, given at registration time. Records
+ * nobody wants are not written to the changelog at all. */
+struct changelog_user_filter {
+	__u32		cuf_mask;	/* 1 << changelog_rec_type, 0 is all */
+	__u32		cuf_flags;	/* \a changelog_user_filter_flags */
+	__u32		cuf_projid;
+	__u32		cuf_padding;
+	struct lu_fid	cuf_pfid;
+	char		cuf_jobid[LUSTRE_JOBID_SIZE];
+};
+
 /* This is the minimal changelog record. It can contain extensions
  * such as rename fields or process jobid. Its exact content is described
  * by the cr_flags and cr_extra_flags.
@@ -258,6 +258,18 @@ static int lfsck_load_stripe_lmv(const struct lu_env *env,
 	if (rc < 0)
 		RETURN(rc);
 
+	/* The names of a directory being split stay in the index of the
+	 * master until they are migrated to the stripes, they would be taken
+	 * as bad shards. The split is resumed by 'lfs migrate -m' if it was
+	 * interrupted, the directory is checked by the next LFSCK run. */
+	if (lmv->lmv_magic == LMV_MAGIC &&
+	    lmv->lmv_hash_type & LMV_HASH_FLAG_SPLIT) {
+		CDEBUG(D_LFSCK, "%s: skip splitting dir "DFID"\n",
+		       lfsck_lfsck2name(lfsck), PFID(lfsck_dto2fid(obj)));
+
+		RETURN(1);
+	}
+
 	OBD_ALLOC_PTR(llmv);
 	if (llmv == NULL)
 		RETURN(-ENOMEM);
@@ -495,6 +507,9 @@ static int lfsck_prep(const struct lu_env *env, struct lfsck_instance *lfsck,
 		if (rc > 0)
 			/* The end of the directory. */
 			rc = 0;
+	} else if (rc > 0) {
+		/* The directory is skipped. */
+		rc = 0;
 	}
 
 	GOTO(out, rc);
@@ -1552,6 +1567,289 @@ again:
 	RETURN(rc != 0 ? rc : rc1);
 }
 
+static int lfsck_assistant_worker_main(void *args)
+{
+	struct lfsck_assistant_worker	  *law	 = args;
+	struct lu_env			  *env	 = &law->law_lta->lta_env;
+	struct lfsck_component		  *com	 = law->law_lta->lta_com;
+	struct lfsck_instance		  *lfsck = law->law_lta->lta_lfsck;
+	struct lfsck_bookmark		  *bk	 = &lfsck->li_bookmark_ram;
+	struct lfsck_assistant_data	  *lad	 = com->lc_data;
+	struct lfsck_assistant_operations *lao	 = lad->lad_ops;
+	struct lfsck_assistant_req	  *lar;
+	bool				   wakeup;
+	int				   rc;
+
+	while (1) {
+		wait_event_idle(law->law_waitq,
+				!list_empty(&law->law_req_list) ||
+				kthread_should_stop());
+		if (kthread_should_stop())
+			break;
+
+		spin_lock(&lad->lad_lock);
+		lar = list_entry(law->law_req_list.next,
+				 struct lfsck_assistant_req, lar_work_list);
+		list_del_init(&lar->lar_work_list);
+		spin_unlock(&lad->lad_lock);
+
+		rc = lao->la_handler_p1(env, com, lar);
+
+		wakeup = false;
+		spin_lock(&lad->lad_lock);
+		/* The "lar" may be in the middle of the list, the position
+		 * for checkpoint is still taken from the head of the list,
+		 * that is the oldest unfinished request. */
+		list_del_init(&lar->lar_list);
+		lad->lad_prefetched--;
+		lad->lad_inflight--;
+		if (rc < 0 && bk->lb_param & LPF_FAILOUT &&
+		    lad->lad_workers_rc == 0)
+			lad->lad_workers_rc = rc;
+		if (lad->lad_prefetched <= (bk->lb_async_windows / 2))
+			wakeup = true;
+		spin_unlock(&lad->lad_lock);
+		if (wakeup)
+			wake_up_all(&lfsck->li_thread.t_ctl_waitq);
+		wake_up_all(&lad->lad_thread.t_ctl_waitq);
+
+		lao->la_req_fini(env, lar);
+	}
+
+	return 0;
+}
+
+static void lfsck_assistant_workers_stop(struct lfsck_component *com)
+{
+	struct lfsck_assistant_data	*lad	 = com->lc_data;
+	struct lfsck_assistant_worker	*workers = lad->lad_workers;
+	struct lfsck_assistant_req	*lar;
+	struct lfsck_assistant_req	*next;
+	int				 count	 = lad->lad_workers_count;
+	int				 i;
+
+	if (workers == NULL)
+		return;
+
+	for (i = 0; i < count; i++) {
+		if (workers[i].law_task != NULL)
+			kthread_stop(workers[i].law_task);
+	}
+
+	/* The requests that have not been handled by the workers are still
+	 * on the lad_req_list, they will be handled or released by the
+	 * assistant thread itself. */
+	spin_lock(&lad->lad_lock);
+	for (i = 0; i < count; i++) {
+		list_for_each_entry_safe(lar, next, &workers[i].law_req_list,
+					 lar_work_list) {
+			list_del_init(&lar->lar_work_list);
+			lar->lar_dispatched = 0;
+			lad->lad_inflight--;
+		}
+	}
+	LASSERT(lad->lad_inflight == 0);
+
+	lad->lad_workers = NULL;
+	lad->lad_workers_count = 0;
+	spin_unlock(&lad->lad_lock);
+
+	for (i = 0; i < count; i++) {
+		if (workers[i].law_lta != NULL)
+			lfsck_thread_args_fini(workers[i].law_lta);
+	}
+
+	OBD_FREE(workers, sizeof(*workers) * count);
+}
+
+static int lfsck_assistant_workers_start(struct lfsck_component *com,
+					 int count)
+{
+	struct lfsck_instance		*lfsck = com->lc_lfsck;
+	struct lfsck_assistant_data	*lad   = com->lc_data;
+	struct lfsck_assistant_worker	*workers;
+	struct lfsck_assistant_worker	*law;
+	struct lfsck_thread_args	*lta;
+	struct task_struct		*task;
+	int				 rc    = 0;
+	int				 i;
+
+	OBD_ALLOC(workers, sizeof(*workers) * count);
+	if (workers == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++) {
+		INIT_LIST_HEAD(&workers[i].law_req_list);
+		init_waitqueue_head(&workers[i].law_waitq);
+	}
+
+	spin_lock(&lad->lad_lock);
+	lad->lad_workers = workers;
+	lad->lad_workers_count = count;
+	lad->lad_inflight = 0;
+	lad->lad_workers_rc = 0;
+	spin_unlock(&lad->lad_lock);
+
+	for (i = 0; i < count; i++) {
+		law = &workers[i];
+		lta = lfsck_thread_args_init(lfsck, com, NULL);
+		if (IS_ERR(lta))
+			GOTO(out, rc = PTR_ERR(lta));
+
+		law->law_lta = lta;
+		task = kthread_run(lfsck_assistant_worker_main, law,
+				   "lfsck_aw_%02d", i);
+		if (IS_ERR(task))
+			GOTO(out, rc = PTR_ERR(task));
+
+		law->law_task = task;
+	}
+
+out:
+	if (rc != 0)
+		lfsck_assistant_workers_stop(com);
+
+	return rc;
+}
+
+/* Whether the assistant can dispatch or handle the next request, or there
+ * is nothing left to be done for the requests on the lad_req_list. */
+static bool lfsck_assistant_dispatch_ready(struct lfsck_assistant_data *lad)
+{
+	struct lfsck_assistant_operations *lao	 = lad->lad_ops;
+	struct lfsck_assistant_req	  *lar;
+	bool				   ready = false;
+	__u32				   key;
+
+	if (test_bit(LAD_EXIT, &lad->lad_flags))
+		return true;
+
+	spin_lock(&lad->lad_lock);
+	if (list_empty(&lad->lad_req_list) || lad->lad_workers_rc < 0) {
+		ready = true;
+	} else if (lad->lad_inflight <
+		   lad->lad_workers_count * LFSCK_ASSISTANT_WORKER_DEPTH) {
+		list_for_each_entry(lar, &lad->lad_req_list, lar_list) {
+			if (lar->lar_dispatched)
+				continue;
+
+			ready = lao->la_req_key(lar, &key) ||
+				lad->lad_req_list.next == &lar->lar_list;
+			break;
+		}
+	}
+	spin_unlock(&lad->lad_lock);
+
+	return ready;
+}
+
+/**
+ * Hand the phase1 requests to the assistant workers.
+ *
+ * The requests are partitioned by the key from la_req_key(), so that the
+ * requests with the same key are always handled by the same worker in
+ * order. A request that cannot be partitioned is handled by the assistant
+ * thread itself after all the former requests have been done.
+ *
+ * The requests stay on the lad_req_list until they are done, so the head
+ * of the list is always the oldest unfinished request for checkpoint.
+ *
+ * \retval	0 if the lad_req_list is empty or the assistant is exiting
+ * \retval	negative error number on failure with LPF_FAILOUT
+ */
+static int lfsck_assistant_dispatch(const struct lu_env *env,
+				    struct lfsck_component *com)
+{
+	struct lfsck_instance		  *lfsck   = com->lc_lfsck;
+	struct lfsck_bookmark		  *bk	   = &lfsck->li_bookmark_ram;
+	struct lfsck_assistant_data	  *lad     = com->lc_data;
+	struct ptlrpc_thread		  *mthread = &lfsck->li_thread;
+	struct ptlrpc_thread		  *athread = &lad->lad_thread;
+	struct lfsck_assistant_operations *lao     = lad->lad_ops;
+	struct lfsck_assistant_worker	  *law;
+	struct lfsck_assistant_req	  *lar;
+	struct lfsck_assistant_req	  *tmp;
+	bool				   wakeup;
+	__u32				   key;
+	int				   rc;
+
+	while (1) {
+		if (unlikely(test_bit(LAD_EXIT, &lad->lad_flags) ||
+			     !thread_is_running(mthread)))
+			return 0;
+
+		lar = NULL;
+		law = NULL;
+		spin_lock(&lad->lad_lock);
+		if (lad->lad_workers_rc < 0) {
+			rc = lad->lad_workers_rc;
+			spin_unlock(&lad->lad_lock);
+
+			return rc;
+		}
+
+		if (list_empty(&lad->lad_req_list)) {
+			spin_unlock(&lad->lad_lock);
+
+			return 0;
+		}
+
+		if (lad->lad_inflight <
+		    lad->lad_workers_count * LFSCK_ASSISTANT_WORKER_DEPTH) {
+			list_for_each_entry(tmp, &lad->lad_req_list, lar_list) {
+				if (!tmp->lar_dispatched) {
+					lar = tmp;
+					break;
+				}
+			}
+		}
+
+		if (lar != NULL) {
+			if (lao->la_req_key(lar, &key)) {
+				law = &lad->lad_workers[key %
+						lad->lad_workers_count];
+				lar->lar_dispatched = 1;
+				lad->lad_inflight++;
+				list_add_tail(&lar->lar_work_list,
+					      &law->law_req_list);
+			} else if (lad->lad_req_list.next != &lar->lar_list) {
+				/* Wait for the former requests. */
+				lar = NULL;
+			}
+		}
+		spin_unlock(&lad->lad_lock);
+
+		if (lar == NULL) {
+			wait_event_idle(athread->t_ctl_waitq,
+					lfsck_assistant_dispatch_ready(lad) ||
+					!thread_is_running(mthread));
+			continue;
+		}
+
+		if (law != NULL) {
+			wake_up(&law->law_waitq);
+			continue;
+		}
+
+		/* All the former requests have been done, and no worker
+		 * will touch the head of the list. */
+		rc = lao->la_handler_p1(env, com, lar);
+		wakeup = false;
+		spin_lock(&lad->lad_lock);
+		list_del_init(&lar->lar_list);
+		lad->lad_prefetched--;
+		if (lad->lad_prefetched <= (bk->lb_async_windows / 2))
+			wakeup = true;
+		spin_unlock(&lad->lad_lock);
+		if (wakeup)
+			wake_up_all(&mthread->t_ctl_waitq);
+
+		lao->la_req_fini(env, lar);
+		if (rc < 0 && bk->lb_param & LPF_FAILOUT)
+			return rc;
+	}
+}
+
 /**
  * The LFSCK assistant thread is triggered by the LFSCK main engine.
  * They co-work together as an asynchronous pipeline: the LFSCK main
@@ -1612,8 +1910,31 @@ int lfsck_assistant_engine(void *args)
 	spin_unlock(&lad->lad_lock);
 	wake_up_all(&mthread->t_ctl_waitq);
 
+	if (lao->la_req_key != NULL && lfsck->li_assistant_threads > 1) {
+		rc = lfsck_assistant_workers_start(com,
+						   lfsck->li_assistant_threads);
+		if (rc != 0) {
+			CDEBUG(D_LFSCK, "%s: %s LFSCK assistant fail to start "
+			       "%u workers, handle requests by itself: "
+			       "rc = %d\n", lfsck_lfsck2name(lfsck),
+			       lad->lad_name, lfsck->li_assistant_threads, rc);
+			rc = 0;
+		}
+	}
+
 	while (1) {
-		while (!list_empty(&lad->lad_req_list)) {
+		if (lad->lad_workers != NULL) {
+			rc = lfsck_assistant_dispatch(env, com);
+			if (unlikely(test_bit(LAD_EXIT, &lad->lad_flags) ||
+				     !thread_is_running(mthread)))
+				GOTO(cleanup, rc = lad->lad_post_result);
+
+			if (rc < 0)
+				GOTO(cleanup, rc);
+		}
+
+		while (lad->lad_workers == NULL &&
+		       !list_empty(&lad->lad_req_list)) {
 			bool wakeup = false;
 
 			if (unlikely(test_bit(LAD_EXIT, &lad->lad_flags) ||
@@ -1669,6 +1990,9 @@ int lfsck_assistant_engine(void *args)
 			clear_bit(LAD_TO_POST, &lad->lad_flags);
 			LASSERT(lad->lad_post_result > 0);
 
+			/* The phase1 requests have all been handled. */
+			lfsck_assistant_workers_stop(com);
+
 			/* Wakeup the master engine to go ahead. */
 			wake_up_all(&mthread->t_ctl_waitq);
 
@@ -1754,6 +2078,8 @@ p2_next:
 	}
 
 cleanup:
+	lfsck_assistant_workers_stop(com);
+
 	/* Cleanup the unfinished requests. */
 	spin_lock(&lad->lad_lock);
 	if (rc < 0)
@@ -737,6 +737,9 @@ struct lfsck_instance {
 	/* How many objects have been scanned since last sleep. */
 	__u32			  li_new_scanned;
 
+	/* Threads to handle the assistant phase1 requests per component. */
+	__u32			  li_assistant_threads;
+
 	/* The status when the LFSCK stopped or paused. */
 	__u32			  li_status;
 
@@ -771,7 +774,11 @@ struct lfsck_thread_args {
 
 struct lfsck_assistant_req {
 	struct list_head		 lar_list;
+	/* link into lfsck_assistant_worker::law_req_list */
+	struct list_head		 lar_work_list;
 	struct lfsck_assistant_object	*lar_parent;
+	/* handed to some assistant worker thread */
+	unsigned int			 lar_dispatched:1;
 };
 
 struct lfsck_namespace_req {
@@ -816,6 +823,24 @@ struct lfsck_assistant_operations {
 	void (*la_sync_failures)(const struct lu_env *env,
 				 struct lfsck_component *com,
 				 struct lfsck_request *lr);
+
+	/* Return the partition key for the request, the requests with the
+	 * same key are handled by the same assistant worker in order. If
+	 * it returns false, the request has to be handled after all former
+	 * requests have been done. NULL means no worker is used at all. */
+	bool (*la_req_key)(const struct lfsck_assistant_req *lar, __u32 *key);
+};
+
+#define LFSCK_ASSISTANT_THREADS_MAX	32
+/* Requests queued on each worker before the assistant stops dispatching. */
+#define LFSCK_ASSISTANT_WORKER_DEPTH	16
+
+/* The helper threads that handle the phase1 requests for the assistant. */
+struct lfsck_assistant_worker {
+	struct lfsck_thread_args		*law_lta;
+	struct task_struct			*law_task;
+	struct list_head			 law_req_list;
+	wait_queue_head_t			 law_waitq;
 };
 
 struct lfsck_assistant_data {
@@ -848,6 +873,13 @@ struct lfsck_assistant_data {
 
 	struct cfs_bitmap				*lad_bitmap;
 
+	/* workers for the phase1 requests, NULL if handled serially. */
+	struct lfsck_assistant_worker		*lad_workers;
+	int					 lad_workers_count;
+	/* requests dispatched to the workers but not finished yet. */
+	int					 lad_inflight;
+	int					 lad_workers_rc;
+
 	__u32					 lad_touch_gen;
 	int					 lad_prefetched;
 	int					 lad_assistant_status;
@@ -2868,6 +2868,65 @@ int lfsck_set_windows(struct dt_device *key, unsigned int val)
 }
 EXPORT_SYMBOL(lfsck_set_windows);
 
+int lfsck_get_assistant_threads(char *buf, struct dt_device *key)
+{
+	struct lu_env		env;
+	struct lfsck_instance  *lfsck;
+	int			rc;
+	ENTRY;
+
+	rc = lu_env_init(&env, LCT_MD_THREAD | LCT_DT_THREAD);
+	if (rc != 0)
+		RETURN(rc);
+
+	lfsck = lfsck_instance_find(key, true, false);
+	if (likely(lfsck != NULL)) {
+		rc = sprintf(buf, "%u\n", lfsck->li_assistant_threads);
+		lfsck_instance_put(&env, lfsck);
+	} else {
+		rc = -ENXIO;
+	}
+
+	lu_env_fini(&env);
+
+	RETURN(rc);
+}
+EXPORT_SYMBOL(lfsck_get_assistant_threads);
+
+/* The new value takes effect when the LFSCK is started next time. */
+int lfsck_set_assistant_threads(struct dt_device *key, unsigned int val)
+{
+	struct lu_env		env;
+	struct lfsck_instance  *lfsck;
+	int			rc;
+	ENTRY;
+
+	rc = lu_env_init(&env, LCT_MD_THREAD | LCT_DT_THREAD);
+	if (rc != 0)
+		RETURN(rc);
+
+	lfsck = lfsck_instance_find(key, true, false);
+	if (likely(lfsck != NULL)) {
+		if (val < 1 || val > LFSCK_ASSISTANT_THREADS_MAX) {
+			CWARN("%s: invalid assistant threads count. The valid "
+			      "range is [1 - %u].\n",
+			      lfsck_lfsck2name(lfsck),
+			      LFSCK_ASSISTANT_THREADS_MAX);
+			rc = -EINVAL;
+		} else {
+			lfsck->li_assistant_threads = val;
+		}
+		lfsck_instance_put(&env, lfsck);
+	} else {
+		rc = -ENXIO;
+	}
+
+	lu_env_fini(&env);
+
+	RETURN(rc);
+}
+EXPORT_SYMBOL(lfsck_set_assistant_threads);
+
 int lfsck_dump(struct seq_file *m, struct dt_device *key, enum lfsck_type type)
 {
 	struct lu_env		env;
@@ -3687,6 +3746,7 @@ int lfsck_register(const struct lu_env *env, struct dt_device *key,
 	lfsck->li_next = next;
 	lfsck->li_bottom = key;
 	lfsck->li_obd = obd;
+	lfsck->li_assistant_threads = 1;
 
 	rc = lfsck_tgt_descs_init(&lfsck->li_ost_descs);
 	if (rc != 0)
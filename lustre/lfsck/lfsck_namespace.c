@@ -733,7 +733,9 @@ log:
 	if (rc == 0) {
 		struct lfsck_namespace *ns = com->lc_file_ram;
 
+		down_write(&com->lc_sem);
 		ns->ln_flags |= LF_INCONSISTENT;
+		up_write(&com->lc_sem);
 	}
 
 	return rc;
@@ -1107,7 +1109,9 @@ log:
 	if (rc != 0) {
 		struct lfsck_namespace *ns = com->lc_file_ram;
 
+		down_write(&com->lc_sem);
 		ns->ln_flags |= LF_INCONSISTENT;
+		up_write(&com->lc_sem);
 	}
 
 	return rc;
@@ -1407,9 +1411,11 @@ log:
 	if (rc != 0) {
 		struct lfsck_namespace *ns = com->lc_file_ram;
 
+		down_write(&com->lc_sem);
 		ns->ln_flags |= LF_INCONSISTENT;
 		if (rc > 0)
 			ns->ln_lost_dirent_repaired++;
+		up_write(&com->lc_sem);
 	}
 
 	return rc;
@@ -1674,8 +1680,11 @@ log:
 	if (parent != NULL && !IS_ERR(parent) && parent != lfsck->li_lpf_obj)
 		lfsck_object_put(env, parent);
 
-	if (rc != 0)
+	if (rc != 0) {
+		down_write(&com->lc_sem);
 		ns->ln_flags |= LF_INCONSISTENT;
+		up_write(&com->lc_sem);
+	}
 
 	return rc;
 }
@@ -1817,7 +1826,9 @@ log:
 	if (rc != 0) {
 		struct lfsck_namespace *ns = com->lc_file_ram;
 
+		down_write(&com->lc_sem);
 		ns->ln_flags |= LF_INCONSISTENT;
+		up_write(&com->lc_sem);
 	}
 
 	return rc;
@@ -2181,7 +2192,9 @@ log:
 	if (rc != 0) {
 		struct lfsck_namespace *ns = com->lc_file_ram;
 
+		down_write(&com->lc_sem);
 		ns->ln_flags |= LF_INCONSISTENT;
+		up_write(&com->lc_sem);
 	}
 
 	return rc;
@@ -2344,7 +2357,9 @@ log:
 	if (rc != 0) {
 		struct lfsck_namespace *ns = com->lc_file_ram;
 
+		down_write(&com->lc_sem);
 		ns->ln_flags |= LF_INCONSISTENT;
+		up_write(&com->lc_sem);
 	}
 
 	return rc;
@@ -2452,7 +2467,9 @@ log:
 	if (rc != 0) {
 		struct lfsck_namespace *ns = com->lc_file_ram;
 
+		down_write(&com->lc_sem);
 		ns->ln_flags |= LF_INCONSISTENT;
+		up_write(&com->lc_sem);
 	}
 
 	return rc;
@@ -3167,8 +3184,11 @@ log:
 	       "nlink count from %u to %u: rc = %d\n",
 	       lfsck_lfsck2name(lfsck), PFID(cfid), old, la->la_nlink, rc);
 
-	if (rc != 0)
+	if (rc != 0) {
+		down_write(&com->lc_sem);
 		ns->ln_flags |= LF_INCONSISTENT;
+		up_write(&com->lc_sem);
+	}
 
 	return rc;
 }
@@ -4381,7 +4401,9 @@ static int lfsck_namespace_open_dir(const struct lu_env *env,
 		if (lmv->lmv_master_mdt_index != lfsck_dev_idx(lfsck)) {
 			lmv->lmv_master_mdt_index =
 				lfsck_dev_idx(lfsck);
+			down_write(&com->lc_sem);
 			ns->ln_flags |= LF_INCONSISTENT;
+			up_write(&com->lc_sem);
 			llmv->ll_lmv_updated = 1;
 		}
 	} else {
@@ -5545,7 +5567,9 @@ log:
 	if (rc <= 0) {
 		struct lfsck_namespace *ns = com->lc_file_ram;
 
+		down_write(&com->lc_sem);
 		ns->ln_flags |= LF_INCONSISTENT;
+		up_write(&com->lc_sem);
 	}
 
 	return rc;
@@ -5579,6 +5603,8 @@ static int lfsck_namespace_assistant_handler_p1(const struct lu_env *env,
 	bool			    log      = false;
 	bool			    bad_hash = false;
 	bool			    bad_linkea = false;
+	bool			    linkea_repaired = false;
+	__u32			    flags    = 0;
 	int			    idx      = 0;
 	int			    count    = 0;
 	int			    rc	     = 0;
@@ -5589,13 +5615,16 @@ static int lfsck_namespace_assistant_handler_p1(const struct lu_env *env,
 		RETURN(0);
 
 	la->la_nlink = 0;
-	if (lnr->lnr_attr & LUDA_UPGRADE) {
-		ns->ln_flags |= LF_UPGRADE;
-		ns->ln_dirent_repaired++;
-		repaired = true;
-	} else if (lnr->lnr_attr & LUDA_REPAIR) {
-		ns->ln_flags |= LF_INCONSISTENT;
+	/* The requests may be handled by several assistant workers at the
+	 * same time, so the statistics are updated under lc_sem. */
+	if (lnr->lnr_attr & (LUDA_UPGRADE | LUDA_REPAIR)) {
+		down_write(&com->lc_sem);
+		if (lnr->lnr_attr & LUDA_UPGRADE)
+			ns->ln_flags |= LF_UPGRADE;
+		else
+			ns->ln_flags |= LF_INCONSISTENT;
 		ns->ln_dirent_repaired++;
+		up_write(&com->lc_sem);
 		repaired = true;
 	}
 
@@ -5760,7 +5789,7 @@ again:
 		    (count == 1 || !S_ISDIR(lfsck_object_type(obj)))) {
 			if ((lfsck_object_type(obj) & S_IFMT) !=
 			    lnr->lnr_type) {
-				ns->ln_flags |= LF_INCONSISTENT;
+				flags |= LF_INCONSISTENT;
 				type = LNIT_BAD_TYPE;
 			}
 
@@ -5772,7 +5801,7 @@ again:
 		 * it is quite possible that name entry is corrupted. */
 		if (!lfsck_is_valid_slave_name_entry(env, lnr->lnr_lmv,
 					lnr->lnr_name, lnr->lnr_namelen)) {
-			ns->ln_flags |= LF_INCONSISTENT;
+			flags |= LF_INCONSISTENT;
 			type = LNIT_BAD_DIRENT;
 
 			GOTO(stop, rc = 0);
@@ -5783,7 +5812,7 @@ again:
 		 * not recognize the name entry, then it is quite possible
 		 * that the name entry is corrupted. */
 		if ((lfsck_object_type(obj) & S_IFMT) != lnr->lnr_type) {
-			ns->ln_flags |= LF_INCONSISTENT;
+			flags |= LF_INCONSISTENT;
 			type = LNIT_BAD_DIRENT;
 
 			GOTO(stop, rc = 0);
@@ -5822,10 +5851,10 @@ again:
 nodata:
 		if (bk->lb_param & LPF_DRYRUN) {
 			if (rc == -ENODATA)
-				ns->ln_flags |= LF_UPGRADE;
+				flags |= LF_UPGRADE;
 			else
-				ns->ln_flags |= LF_INCONSISTENT;
-			ns->ln_linkea_repaired++;
+				flags |= LF_INCONSISTENT;
+			linkea_repaired = true;
 			repaired = true;
 			log = true;
 			goto stop;
@@ -5856,9 +5885,9 @@ nodata:
 
 		bad_linkea = true;
 		if (!remove && newdata)
-			ns->ln_flags |= LF_UPGRADE;
-		else if (remove || !(ns->ln_flags & LF_UPGRADE))
-			ns->ln_flags |= LF_INCONSISTENT;
+			flags |= LF_UPGRADE;
+		else if (remove || !((ns->ln_flags | flags) & LF_UPGRADE))
+			flags |= LF_INCONSISTENT;
 
 		if (remove) {
 			LASSERT(newdata);
@@ -5884,7 +5913,7 @@ nodata:
 		count = ldata.ld_leh->leh_reccount;
 		if (!S_ISDIR(lfsck_object_type(obj)) ||
 		    !dt_object_remote(obj)) {
-			ns->ln_linkea_repaired++;
+			linkea_repaired = true;
 			repaired = true;
 			log = true;
 		}
@@ -5906,7 +5935,7 @@ out:
 	    !lfsck_is_valid_slave_name_entry(env, lnr->lnr_lmv,
 					     lnr->lnr_name, lnr->lnr_namelen) &&
 	    type != LNIT_BAD_DIRENT) {
-		ns->ln_flags |= LF_INCONSISTENT;
+		flags |= LF_INCONSISTENT;
 
 		log = false;
 		if (dir == NULL) {
@@ -5966,6 +5995,9 @@ out:
 
 trace:
 	down_write(&com->lc_sem);
+	ns->ln_flags |= flags;
+	if (linkea_repaired)
+		ns->ln_linkea_repaired++;
 	if (rc < 0) {
 		CDEBUG(D_LFSCK, "%s: namespace LFSCK assistant fail to handle "
 		       "the entry: "DFID", parent "DFID", name %.*s: rc = %d\n",
@@ -6829,6 +6861,32 @@ out:
 	EXIT;
 }
 
+/**
+ * Partition the namespace requests by the child FID, so the name entries
+ * that reference the same object are verified by the same worker in order.
+ *
+ * The dummy request for the striped directory rescan and the request for
+ * the striped master directory check the whole directory, they are handled
+ * after all the former requests have been done.
+ */
+static bool
+lfsck_namespace_assistant_req_key(const struct lfsck_assistant_req *lar,
+				  __u32 *key)
+{
+	const struct lfsck_namespace_req *lnr =
+			container_of0(lar, struct lfsck_namespace_req, lnr_lar);
+
+	if (unlikely(lnr->lnr_dir_cookie == MDS_DIR_END_OFF))
+		return false;
+
+	if (lnr->lnr_lmv != NULL && lnr->lnr_lmv->ll_lmv_master)
+		return false;
+
+	*key = fid_flatten32(&lnr->lnr_fid);
+
+	return true;
+}
+
 struct lfsck_assistant_operations lfsck_namespace_assistant_ops = {
 	.la_handler_p1		= lfsck_namespace_assistant_handler_p1,
 	.la_handler_p2		= lfsck_namespace_assistant_handler_p2,
@@ -6836,6 +6894,7 @@ struct lfsck_assistant_operations lfsck_namespace_assistant_ops = {
 	.la_double_scan_result	= lfsck_namespace_double_scan_result,
 	.la_req_fini		= lfsck_namespace_assistant_req_fini,
 	.la_sync_failures	= lfsck_namespace_assistant_sync_failures,
+	.la_req_key		= lfsck_namespace_assistant_req_key,
 };
 
 /**
@@ -264,9 +264,11 @@ log:
 	if (rc <= 0) {
 		struct lfsck_namespace *ns = com->lc_file_ram;
 
+		down_write(&com->lc_sem);
 		ns->ln_flags |= LF_INCONSISTENT;
 		if (rc == 0)
 			ns->ln_striped_dirs_disabled++;
+		up_write(&com->lc_sem);
 	}
 
 	return rc;
@@ -1510,7 +1512,9 @@ log:
 	if (rc <= 0) {
 		struct lfsck_namespace *ns = com->lc_file_ram;
 
+		down_write(&com->lc_sem);
 		ns->ln_flags |= LF_INCONSISTENT;
+		up_write(&com->lc_sem);
 	}
 
 	return rc;
@@ -1683,7 +1687,9 @@ int lfsck_namespace_scan_shard(const struct lu_env *env,
 
 		if (!lfsck_is_valid_slave_name_entry(env, llmv, ent->lde_name,
 						     ent->lde_namelen)) {
+			down_write(&com->lc_sem);
 			ns->ln_flags |= LF_INCONSISTENT;
+			up_write(&com->lc_sem);
 			rc = lfsck_namespace_repair_bad_name_hash(env, com,
 						child, llmv, ent->lde_name);
 			if (rc == 0)
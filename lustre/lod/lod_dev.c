@@ -2132,6 +2132,48 @@ static int lod_obd_set_info_async(const struct lu_env *env,
 	RETURN(rc);
 }
 
+/**
+ * Implementation of obd_ops::o_fid_alloc() for LOD
+ *
+ * Allocate FID on the MDT specified by op_mds of \a op_data, or locally if
+ * \a op_data is NULL.
+ *
+ * \param[in] env		LU environment provided by the caller
+ * \param[in] exp		export of the caller
+ * \param[out] fid		allocated FID
+ * \param[in] op_data		specifies the MDT
+ *
+ * \retval			0 or 1 (new sequence) on success
+ * \retval			-ENODEV if the MDT is not set up
+ * \retval			negative errno if allocation fails
+ **/
+static int lod_obd_fid_alloc(const struct lu_env *env, struct obd_export *exp,
+			     struct lu_fid *fid, struct md_op_data *op_data)
+{
+	struct lod_device *lod = lu2lod_dev(exp->exp_obd->obd_lu_dev);
+	struct lod_tgt_descs *ltd = &lod->lod_mdt_descs;
+	struct lod_tgt_desc *tgt;
+	u32 idx;
+	int rc;
+
+	idx = lod2lu_dev(lod)->ld_site->ld_seq_site->ss_node_id;
+	if (!op_data || op_data->op_mds == idx)
+		return obd_fid_alloc(env, lod->lod_child_exp, fid, NULL);
+
+	idx = op_data->op_mds;
+	lod_getref(ltd);
+	if (idx < ltd->ltd_tgts_size &&
+	    cfs_bitmap_check(ltd->ltd_tgt_bitmap, idx) &&
+	    (tgt = LTD_TGT(ltd, idx)) != NULL) {
+		rc = obd_fid_alloc(env, tgt->ltd_exp, fid, NULL);
+	} else {
+		rc = -ENODEV;
+	}
+	lod_putref(lod, ltd);
+
+	return rc;
+}
+
 static const struct obd_ops lod_obd_device_ops = {
 	.o_owner        = THIS_MODULE,
 	.o_connect      = lod_obd_connect,
@@ -2142,6 +2184,7 @@ static const struct obd_ops lod_obd_device_ops = {
 	.o_pool_rem     = lod_pool_remove,
 	.o_pool_add     = lod_pool_add,
 	.o_pool_del     = lod_pool_del,
+	.o_fid_alloc	= lod_obd_fid_alloc,
 };
 
 static int __init lod_init(void)
@@ -221,6 +221,9 @@ struct lod_object {
 					ldo_dir_striped:1,
 					/* the stripe has been loaded */
 					ldo_dir_stripe_loaded:1,
+					/* source stripe of a directory being
+					 * split, see lod_split_index_ops */
+					ldo_dir_split_source:1,
 					/* foreign directory */
 					ldo_dir_is_foreign;
 			/*
@@ -366,6 +366,393 @@ static struct dt_index_operations lod_index_ops = {
 	}
 };
 
+/*
+ * A plain directory is split in place by lod_dir_layout_split(): it keeps its
+ * FID and becomes the master of a migrating striped directory, whose last
+ * stripe is the source stripe. The names are not moved to the source stripe,
+ * which would take a huge transaction, but stay in the index of the master,
+ * and the source stripe accesses that index for all names but dot and dotdot,
+ * with the stripe entries of the master hidden. The names are then migrated
+ * to the target stripes one by one, and the source stripe is dropped by
+ * layout shrink. Namespace LFSCK skips the master while the directory is
+ * split, because it would take the names in the master index as bad shards.
+ */
+
+/**
+ * Check whether \a ent is a stripe entry in the index of a striped directory,
+ * which is named "FID:index" after the stripe FID.
+ */
+static bool lod_dirent_is_stripe(const struct lu_dirent *ent)
+{
+	struct lu_fid fid;
+	char name[FID_LEN + 2];
+	int len;
+
+	fid_le_to_cpu(&fid, &ent->lde_fid);
+	len = snprintf(name, sizeof(name), DFID":", PFID(&fid));
+
+	return le16_to_cpu(ent->lde_namelen) > len &&
+	       strncmp(ent->lde_name, name, len) == 0;
+}
+
+/* dot and dotdot of the source stripe are in its own index */
+static inline bool lod_split_own_key(const struct dt_key *key)
+{
+	return strcmp((const char *)key, dot) == 0 ||
+	       strcmp((const char *)key, dotdot) == 0;
+}
+
+/**
+ * Get the master of source stripe \a dt, whose index stores the names of the
+ * source stripe. The master is not cached in \a dt, because it holds \a dt
+ * in its stripes.
+ *
+ * \param[in] env	execution environment
+ * \param[in] dt	source stripe
+ *
+ * \retval		master object from the layer below
+ * \retval		ERR_PTR on failure
+ */
+static struct dt_object *lod_split_master(const struct lu_env *env,
+					  struct dt_object *dt)
+{
+	struct lod_device *lod = lu2lod_dev(dt->do_lu.lo_dev);
+	struct dt_object *master;
+	struct lu_fid fid;
+	int rc;
+
+	rc = dt_lookup(env, dt_object_child(dt), (struct dt_rec *)&fid,
+		       (const struct dt_key *)dotdot);
+	if (rc)
+		return ERR_PTR(rc);
+
+	master = dt_locate_at(env, lod->lod_child, &fid,
+			      dt->do_lu.lo_dev->ld_site->ls_top_dev, NULL);
+	if (IS_ERR(master))
+		return master;
+
+	if (!dt_object_exists(master) || !dt_try_as_dir(env, master)) {
+		dt_object_put(env, master);
+		return ERR_PTR(-ENOTDIR);
+	}
+
+	return master;
+}
+
+/**
+ * Implementation of dt_index_operations::dio_lookup.
+ *
+ * Used with the source stripe of a directory being split.
+ *
+ * \see dt_index_operations::dio_lookup() in the API description for details.
+ */
+static int lod_split_lookup(const struct lu_env *env, struct dt_object *dt,
+			    struct dt_rec *rec, const struct dt_key *key)
+{
+	struct dt_object *master;
+	int rc;
+
+	if (lod_split_own_key(key))
+		return lod_lookup(env, dt, rec, key);
+
+	master = lod_split_master(env, dt);
+	if (IS_ERR(master))
+		return PTR_ERR(master);
+
+	rc = master->do_index_ops->dio_lookup(env, master, rec, key);
+	dt_object_put(env, master);
+
+	return rc;
+}
+
+/**
+ * Implementation of dt_index_operations::dio_declare_insert.
+ *
+ * Used with the source stripe of a directory being split.
+ *
+ * \see dt_index_operations::dio_declare_insert() in the API description
+ * for details.
+ */
+static int lod_split_declare_insert(const struct lu_env *env,
+				    struct dt_object *dt,
+				    const struct dt_rec *rec,
+				    const struct dt_key *key,
+				    struct thandle *th)
+{
+	struct dt_object *master;
+	int rc;
+
+	if (lod_split_own_key(key))
+		return lod_declare_insert(env, dt, rec, key, th);
+
+	master = lod_split_master(env, dt);
+	if (IS_ERR(master))
+		return PTR_ERR(master);
+
+	rc = lod_sub_declare_insert(env, master, rec, key, th);
+	dt_object_put(env, master);
+
+	return rc;
+}
+
+/**
+ * Implementation of dt_index_operations::dio_insert.
+ *
+ * Used with the source stripe of a directory being split.
+ *
+ * \see dt_index_operations::dio_insert() in the API description for details.
+ */
+static int lod_split_insert(const struct lu_env *env, struct dt_object *dt,
+			    const struct dt_rec *rec, const struct dt_key *key,
+			    struct thandle *th)
+{
+	struct dt_object *master;
+	int rc;
+
+	if (lod_split_own_key(key))
+		return lod_insert(env, dt, rec, key, th);
+
+	master = lod_split_master(env, dt);
+	if (IS_ERR(master))
+		return PTR_ERR(master);
+
+	rc = lod_sub_insert(env, master, rec, key, th);
+	dt_object_put(env, master);
+
+	return rc;
+}
+
+/**
+ * Implementation of dt_index_operations::dio_declare_delete.
+ *
+ * Used with the source stripe of a directory being split.
+ *
+ * \see dt_index_operations::dio_declare_delete() in the API description
+ * for details.
+ */
+static int lod_split_declare_delete(const struct lu_env *env,
+				    struct dt_object *dt,
+				    const struct dt_key *key,
+				    struct thandle *th)
+{
+	struct dt_object *master;
+	int rc;
+
+	if (lod_split_own_key(key))
+		return lod_declare_delete(env, dt, key, th);
+
+	master = lod_split_master(env, dt);
+	if (IS_ERR(master))
+		return PTR_ERR(master);
+
+	rc = lod_sub_declare_delete(env, master, key, th);
+	dt_object_put(env, master);
+
+	return rc;
+}
+
+/**
+ * Implementation of dt_index_operations::dio_delete.
+ *
+ * Used with the source stripe of a directory being split.
+ *
+ * \see dt_index_operations::dio_delete() in the API description for details.
+ */
+static int lod_split_delete(const struct lu_env *env, struct dt_object *dt,
+			    const struct dt_key *key, struct thandle *th)
+{
+	struct dt_object *master;
+	int rc;
+
+	if (lod_split_own_key(key))
+		return lod_delete(env, dt, key, th);
+
+	master = lod_split_master(env, dt);
+	if (IS_ERR(master))
+		return PTR_ERR(master);
+
+	rc = lod_sub_delete(env, master, key, th);
+	dt_object_put(env, master);
+
+	return rc;
+}
+
+/**
+ * Implementation of dt_it_ops::init.
+ *
+ * Used with the source stripe of a directory being split, iterates the index
+ * of the master, which is held until lod_split_it_fini().
+ *
+ * \see dt_it_ops::init() in the API description for details.
+ */
+static struct dt_it *lod_split_it_init(const struct lu_env *env,
+				       struct dt_object *dt, __u32 attr)
+{
+	struct lod_it *it = &lod_env_info(env)->lti_it;
+	struct dt_object *master;
+	struct dt_it *it_next;
+
+	master = lod_split_master(env, dt);
+	if (IS_ERR(master))
+		return ERR_CAST(master);
+
+	it_next = master->do_index_ops->dio_it.init(env, master, attr);
+	if (IS_ERR(it_next)) {
+		dt_object_put(env, master);
+		return it_next;
+	}
+
+	LASSERT(it->lit_obj == NULL);
+
+	it->lit_it = it_next;
+	it->lit_obj = master;
+	it->lit_attr = attr;
+
+	return (struct dt_it *)it;
+}
+
+/**
+ * Implementation of dt_it_ops::fini.
+ *
+ * Used with the source stripe of a directory being split.
+ *
+ * \see dt_it_ops::fini() in the API description for details.
+ */
+static void lod_split_it_fini(const struct lu_env *env, struct dt_it *di)
+{
+	struct lod_it *it = (struct lod_it *)di;
+	struct dt_object *master = it->lit_obj;
+
+	lod_it_fini(env, di);
+	dt_object_put(env, master);
+}
+
+/*
+ * skip stripe entries from the current position of \a it, which iterates the
+ * index of a striped directory.
+ *
+ * \retval	0 if positioned on a name
+ * \retval	1 at the end
+ * \retval	-errno on failure
+ */
+static int lod_split_it_skip(const struct lu_env *env, struct lod_it *it)
+{
+	const struct dt_it_ops *iops = &it->lit_obj->do_index_ops->dio_it;
+	struct lu_dirent *ent = (struct lu_dirent *)lod_env_info(env)->lti_key;
+	int rc;
+
+	do {
+		rc = iops->rec(env, it->lit_it, (struct dt_rec *)ent,
+			       it->lit_attr);
+		if (rc || !lod_dirent_is_stripe(ent))
+			return rc;
+
+		rc = iops->next(env, it->lit_it);
+	} while (rc == 0);
+
+	return rc;
+}
+
+/**
+ * Implementation of dt_it_ops::get.
+ *
+ * Used with the source stripe of a directory being split.
+ *
+ * \see dt_it_ops::get() in the API description for details.
+ */
+static int lod_split_it_get(const struct lu_env *env, struct dt_it *di,
+			    const struct dt_key *key)
+{
+	int rc;
+	int rc2;
+
+	rc = lod_it_get(env, di, key);
+	if (rc > 0) {
+		rc2 = lod_split_it_skip(env, (struct lod_it *)di);
+		if (rc2)
+			rc = rc2 < 0 ? rc2 : 0;
+	}
+
+	return rc;
+}
+
+/**
+ * Implementation of dt_it_ops::next.
+ *
+ * Used with the source stripe of a directory being split.
+ *
+ * \see dt_it_ops::next() in the API description for details.
+ */
+static int lod_split_it_next(const struct lu_env *env, struct dt_it *di)
+{
+	int rc;
+
+	rc = lod_it_next(env, di);
+	if (rc == 0)
+		rc = lod_split_it_skip(env, (struct lod_it *)di);
+
+	return rc;
+}
+
+/**
+ * Implementation of dt_it_ops::load.
+ *
+ * Used with the source stripe of a directory being split.
+ *
+ * \see dt_it_ops::load() in the API description for details.
+ */
+static int lod_split_it_load(const struct lu_env *env, const struct dt_it *di,
+			     __u64 hash)
+{
+	int rc;
+	int rc2;
+
+	rc = lod_it_load(env, di, hash);
+	if (rc > 0) {
+		rc2 = lod_split_it_skip(env, (struct lod_it *)di);
+		if (rc2)
+			rc = rc2 < 0 ? rc2 : 0;
+	}
+
+	return rc;
+}
+
+static struct dt_index_operations lod_split_index_ops = {
+	.dio_lookup		= lod_split_lookup,
+	.dio_declare_insert	= lod_split_declare_insert,
+	.dio_insert		= lod_split_insert,
+	.dio_declare_delete	= lod_split_declare_delete,
+	.dio_delete		= lod_split_delete,
+	.dio_it	= {
+		.init		= lod_split_it_init,
+		.fini		= lod_split_it_fini,
+		.get		= lod_split_it_get,
+		.put		= lod_it_put,
+		.next		= lod_split_it_next,
+		.key		= lod_it_key,
+		.key_size	= lod_it_key_size,
+		.rec		= lod_it_rec,
+		.rec_size	= lod_it_rec_size,
+		.store		= lod_it_store,
+		.load		= lod_split_it_load,
+		.key_rec	= lod_it_key_rec,
+	}
+};
+
+/*
+ * the stripe \a index of striped directory \a lo to iterate, which is the
+ * master itself for the source stripe of a directory being split.
+ */
+static inline struct dt_object *lod_striped_it_stripe(struct lod_object *lo,
+						       __u32 index)
+{
+	if (lo->ldo_dir_hash_type & LMV_HASH_FLAG_SPLIT &&
+	    index >= lo->ldo_dir_migrate_offset && lo->ldo_stripe[index])
+		return dt_object_child(&lo->ldo_obj);
+
+	return lo->ldo_stripe[index];
+}
+
 /**
  * Implementation of dt_it_ops::init.
  *
@@ -386,7 +773,7 @@ static struct dt_it *lod_striped_it_init(const struct lu_env *env,
 	LASSERT(lo->ldo_dir_stripe_count > 0);
 
 	do {
-		next = lo->ldo_stripe[index];
+		next = lod_striped_it_stripe(lo, index);
 		if (next && dt_object_exists(next))
 			break;
 	} while (++index < lo->ldo_dir_stripe_count);
@@ -441,7 +828,7 @@ static void lod_striped_it_fini(const struct lu_env *env, struct dt_it *di)
 	if (it->lit_it != NULL) {
 		LOD_CHECK_STRIPED_IT(env, it, lo);
 
-		next = lo->ldo_stripe[it->lit_stripe_index];
+		next = lod_striped_it_stripe(lo, it->lit_stripe_index);
 		if (next) {
 			LASSERT(next->do_index_ops != NULL);
 			next->do_index_ops->dio_it.fini(env, it->lit_it);
@@ -472,7 +859,7 @@ static int lod_striped_it_get(const struct lu_env *env, struct dt_it *di,
 
 	LOD_CHECK_STRIPED_IT(env, it, lo);
 
-	next = lo->ldo_stripe[it->lit_stripe_index];
+	next = lod_striped_it_stripe(lo, it->lit_stripe_index);
 	LASSERT(next != NULL);
 	LASSERT(dt_object_exists(next));
 	LASSERT(next->do_index_ops != NULL);
@@ -502,7 +889,7 @@ static void lod_striped_it_put(const struct lu_env *env, struct dt_it *di)
 
 	LOD_CHECK_STRIPED_IT(env, it, lo);
 
-	next = lo->ldo_stripe[it->lit_stripe_index];
+	next = lod_striped_it_stripe(lo, it->lit_stripe_index);
 	LASSERT(next != NULL);
 	LASSERT(next->do_index_ops != NULL);
 
@@ -530,7 +917,7 @@ static int lod_striped_it_next(const struct lu_env *env, struct dt_it *di)
 
 	LOD_CHECK_STRIPED_IT(env, it, lo);
 
-	next = lo->ldo_stripe[it->lit_stripe_index];
+	next = lod_striped_it_stripe(lo, it->lit_stripe_index);
 	LASSERT(next != NULL);
 	LASSERT(dt_object_exists(next));
 	LASSERT(next->do_index_ops != NULL);
@@ -562,6 +949,11 @@ again:
 		     le16_to_cpu(ent->lde_namelen) == 2))
 			goto again;
 
+		/* the source stripe of a split directory is the master */
+		if (next == dt_object_child(&lo->ldo_obj) &&
+		    lod_dirent_is_stripe(ent))
+			goto again;
+
 		RETURN(rc);
 	}
 
@@ -572,7 +964,7 @@ again:
 	/* go to next stripe */
 	index = it->lit_stripe_index;
 	while (++index < lo->ldo_dir_stripe_count) {
-		next = lo->ldo_stripe[index];
+		next = lod_striped_it_stripe(lo, index);
 		if (!next)
 			continue;
 
@@ -621,7 +1013,7 @@ static struct dt_key *lod_striped_it_key(const struct lu_env *env,
 
 	LOD_CHECK_STRIPED_IT(env, it, lo);
 
-	next = lo->ldo_stripe[it->lit_stripe_index];
+	next = lod_striped_it_stripe(lo, it->lit_stripe_index);
 	LASSERT(next != NULL);
 	LASSERT(next->do_index_ops != NULL);
 
@@ -644,7 +1036,7 @@ static int lod_striped_it_key_size(const struct lu_env *env,
 
 	LOD_CHECK_STRIPED_IT(env, it, lo);
 
-	next = lo->ldo_stripe[it->lit_stripe_index];
+	next = lod_striped_it_stripe(lo, it->lit_stripe_index);
 	LASSERT(next != NULL);
 	LASSERT(next->do_index_ops != NULL);
 
@@ -667,7 +1059,7 @@ static int lod_striped_it_rec(const struct lu_env *env, const struct dt_it *di,
 
 	LOD_CHECK_STRIPED_IT(env, it, lo);
 
-	next = lo->ldo_stripe[it->lit_stripe_index];
+	next = lod_striped_it_stripe(lo, it->lit_stripe_index);
 	LASSERT(next != NULL);
 	LASSERT(next->do_index_ops != NULL);
 
@@ -690,7 +1082,7 @@ static int lod_striped_it_rec_size(const struct lu_env *env,
 
 	LOD_CHECK_STRIPED_IT(env, it, lo);
 
-	next = lo->ldo_stripe[it->lit_stripe_index];
+	next = lod_striped_it_stripe(lo, it->lit_stripe_index);
 	LASSERT(next != NULL);
 	LASSERT(next->do_index_ops != NULL);
 
@@ -713,7 +1105,7 @@ static __u64 lod_striped_it_store(const struct lu_env *env,
 
 	LOD_CHECK_STRIPED_IT(env, it, lo);
 
-	next = lo->ldo_stripe[it->lit_stripe_index];
+	next = lod_striped_it_stripe(lo, it->lit_stripe_index);
 	LASSERT(next != NULL);
 	LASSERT(next->do_index_ops != NULL);
 
@@ -736,7 +1128,7 @@ static int lod_striped_it_load(const struct lu_env *env,
 
 	LOD_CHECK_STRIPED_IT(env, it, lo);
 
-	next = lo->ldo_stripe[it->lit_stripe_index];
+	next = lod_striped_it_stripe(lo, it->lit_stripe_index);
 	LASSERT(next != NULL);
 	LASSERT(next->do_index_ops != NULL);
 
@@ -996,6 +1388,8 @@ static int lod_index_try(const struct lu_env *env, struct dt_object *dt,
 				RETURN(rc);
 		}
 		dt->do_index_ops = &lod_striped_index_ops;
+	} else if (lo->ldo_dir_split_source) {
+		dt->do_index_ops = &lod_split_index_ops;
 	} else {
 		dt->do_index_ops = &lod_index_ops;
 	}
@@ -1735,12 +2129,20 @@ int lod_parse_dir_striping(const struct lu_env *env, struct lod_object *lo,
 
 	if (le32_to_cpu(lmv1->lmv_magic) == LMV_MAGIC_STRIPE) {
 		lo->ldo_dir_slave_stripe = 1;
+		if (le32_to_cpu(lmv1->lmv_hash_type) & LMV_HASH_FLAG_SPLIT &&
+		    le32_to_cpu(lmv1->lmv_master_mdt_index) >=
+		    le32_to_cpu(lmv1->lmv_migrate_offset))
+			lo->ldo_dir_split_source = 1;
 		RETURN(0);
 	}
 
 	if (le32_to_cpu(lmv1->lmv_magic) != LMV_MAGIC_V1)
 		RETURN(-EINVAL);
 
+	lo->ldo_dir_hash_type = le32_to_cpu(lmv1->lmv_hash_type);
+	lo->ldo_dir_migrate_offset = le32_to_cpu(lmv1->lmv_migrate_offset);
+	lo->ldo_dir_migrate_hash = le32_to_cpu(lmv1->lmv_migrate_hash);
+
 	if (le32_to_cpu(lmv1->lmv_stripe_count) < 1)
 		RETURN(0);
 
@@ -2565,6 +2967,146 @@ static int lod_dir_layout_delete(const struct lu_env *env,
 	RETURN(rc);
 }
 
+/**
+ * Declare splitting a plain directory in place.
+ *
+ * The directory keeps its FID and becomes the master of a migrating striped
+ * directory with \a buf lum_stripe_count target stripes allocated on MDTs
+ * like for a new striped directory, and one more local stripe as the source
+ * stripe, which has no names of its own but aliases the index of the master,
+ * see lod_split_index_ops. The names are migrated to the target stripes
+ * later, and the source stripe is dropped by layout shrink.
+ *
+ * \param[in] env	execution environment
+ * \param[in] dt	directory to split
+ * \param[in] buf	lmv_user_md of the target layout
+ * \param[in] th	transaction handle
+ *
+ * \retval		0 on success
+ * \retval		-EALREADY if \a dt is not a plain directory
+ * \retval		negative if failed
+ */
+static int lod_dir_declare_layout_split(const struct lu_env *env,
+					struct dt_object *dt,
+					const struct lu_buf *buf,
+					struct thandle *th)
+{
+	struct lod_thread_info *info = lod_env_info(env);
+	struct lod_device *lod = lu2lod_dev(dt->do_lu.lo_dev);
+	struct lod_object *lo = lod_dt_obj(dt);
+	struct lu_attr *attr = &info->lti_attr;
+	struct dt_object_format *dof = &info->lti_format;
+	struct lmv_user_md *lmu = buf->lb_buf;
+	struct lu_object_conf conf = { .loc_flags = LOC_F_NEW };
+	struct dt_object **stripes;
+	struct lu_fid fid = { 0 };
+	__u32 stripe_count;
+	int i;
+	int rc;
+
+	ENTRY;
+
+	if (!lmu || le32_to_cpu(lmu->lum_magic) != LMV_USER_MAGIC)
+		RETURN(-EINVAL);
+
+	stripe_count = le32_to_cpu(lmu->lum_stripe_count);
+	if (stripe_count < 2 || stripe_count > LMV_MAX_STRIPE_COUNT)
+		RETURN(-EINVAL);
+
+	rc = lod_striping_load(env, lo);
+	if (rc)
+		RETURN(rc);
+
+	if (lo->ldo_dir_stripe_count || lo->ldo_dir_slave_stripe ||
+	    lo->ldo_dir_is_foreign)
+		RETURN(-EALREADY);
+
+	rc = dt_attr_get(env, dt_object_child(dt), attr);
+	if (rc)
+		RETURN(rc);
+
+	/* one more slot for the source stripe */
+	OBD_ALLOC(stripes, sizeof(stripes[0]) * (stripe_count + 1));
+	if (!stripes)
+		RETURN(-ENOMEM);
+
+	rc = obd_fid_alloc(env, lod->lod_child_exp, &fid, NULL);
+	if (rc < 0)
+		GOTO(out, rc);
+
+	stripes[0] = dt_locate_at(env, lod->lod_child, &fid,
+				  dt->do_lu.lo_dev->ld_site->ls_top_dev, &conf);
+	if (IS_ERR(stripes[0]))
+		GOTO(out, rc = PTR_ERR(stripes[0]));
+
+	lo->ldo_dir_stripe_count = stripe_count;
+	lod_qos_statfs_update(env, lod, &lod->lod_mdt_descs);
+	rc = lod_mdt_alloc_qos(env, lo, stripes);
+	if (rc == -EAGAIN)
+		rc = lod_mdt_alloc_rr(env, lo, stripes);
+	lo->ldo_dir_stripe_count = 0;
+	if (rc < 0)
+		GOTO(out, rc);
+
+	/* there is nothing to spread on one MDT */
+	if (rc < 2)
+		GOTO(out, rc = -ENOSPC);
+	stripe_count = rc;
+
+	rc = obd_fid_alloc(env, lod->lod_child_exp, &fid, NULL);
+	if (rc < 0)
+		GOTO(out, rc);
+
+	stripes[stripe_count] = dt_locate_at(env, lod->lod_child, &fid,
+				  dt->do_lu.lo_dev->ld_site->ls_top_dev, &conf);
+	if (IS_ERR(stripes[stripe_count]))
+		GOTO(out, rc = PTR_ERR(stripes[stripe_count]));
+
+	lo->ldo_dir_striped = 1;
+	lo->ldo_stripe = stripes;
+	lo->ldo_dir_stripe_count = stripe_count + 1;
+	lo->ldo_dir_stripes_allocated = le32_to_cpu(lmu->lum_stripe_count) + 1;
+	lo->ldo_dir_hash_type = le32_to_cpu(lmu->lum_hash_type) |
+				LMV_HASH_FLAG_MIGRATION | LMV_HASH_FLAG_SPLIT;
+	lo->ldo_dir_migrate_offset = stripe_count;
+	lo->ldo_dir_migrate_hash = LMV_HASH_TYPE_DEFAULT;
+	smp_mb();
+	lo->ldo_dir_stripe_loaded = 1;
+
+	attr->la_valid = LA_ATIME | LA_MTIME | LA_CTIME |
+			 LA_MODE | LA_UID | LA_GID | LA_TYPE | LA_PROJID;
+	dof->dof_type = DFT_DIR;
+
+	rc = lod_dir_declare_create_stripes(env, dt, attr, dof, th);
+	if (rc)
+		GOTO(out_free, rc);
+
+	/* the subdirectories stay with the source stripe until migrated */
+	rc = lod_sub_declare_attr_set(env, stripes[stripe_count], attr, th);
+	if (rc)
+		GOTO(out_free, rc);
+
+	rc = lod_sub_declare_attr_set(env, dt_object_child(dt), attr, th);
+	if (rc)
+		GOTO(out_free, rc);
+
+	RETURN(0);
+
+out_free:
+	lod_striping_free(env, lo);
+	lo->ldo_dir_striped = 0;
+	lo->ldo_dir_hash_type = 0;
+	RETURN(rc);
+out:
+	LASSERT(rc < 0);
+	for (i = 0; i <= le32_to_cpu(lmu->lum_stripe_count); i++)
+		if (!IS_ERR_OR_NULL(stripes[i]))
+			dt_object_put(env, stripes[i]);
+	OBD_FREE(stripes,
+		 sizeof(stripes[0]) * (le32_to_cpu(lmu->lum_stripe_count) + 1));
+	RETURN(rc);
+}
+
 /**
  * Implementation of dt_object_operations::do_declare_xattr_set.
  *
@@ -3605,6 +4147,8 @@ static int lod_declare_xattr_set(const struct lu_env *env,
 			rc = lod_dir_declare_layout_add(env, dt, buf, th);
 		else if (strcmp(op, ".del") == 0)
 			rc = lod_dir_declare_layout_delete(env, dt, buf, th);
+		else if (strcmp(op, ".split") == 0)
+			rc = lod_dir_declare_layout_split(env, dt, buf, th);
 		else if (strcmp(op, ".set") == 0)
 			rc = lod_sub_declare_xattr_set(env, next, buf,
 						       XATTR_NAME_LMV, fl, th);
@@ -3948,8 +4492,10 @@ static int lod_xattr_set_lmv(const struct lu_env *env, struct dt_object *dt,
 		if (i && OBD_FAIL_CHECK(OBD_FAIL_MDS_STRIPE_CREATE))
 			continue;
 
-		/* if it's source stripe of migrating directory, don't create */
+		/* if it's source stripe of migrating directory, don't create,
+		 * unless the directory is being split in place */
 		if (!((lo->ldo_dir_hash_type & LMV_HASH_FLAG_MIGRATION) &&
+		      !(lo->ldo_dir_hash_type & LMV_HASH_FLAG_SPLIT) &&
 		      i >= lo->ldo_dir_migrate_offset)) {
 			dt_write_lock(env, dto, DT_TGT_CHILD);
 			rc = lod_sub_create(env, dto, attr, NULL, dof, th);
@@ -4036,6 +4582,65 @@ out:
 	RETURN(rc);
 }
 
+/**
+ * Split a plain directory in place, see lod_dir_declare_layout_split().
+ *
+ * The stripes are created by lod_xattr_set_lmv(), then the link count of the
+ * master is taken by its stripes, and that of the source stripe by the
+ * subdirectories, which are still in the index of the master.
+ *
+ * \param[in] env	execution environment
+ * \param[in] dt	directory to split
+ * \param[in] th	transaction handle
+ *
+ * \retval		0 on success
+ * \retval		negative if failed
+ */
+static int lod_dir_layout_split(const struct lu_env *env, struct dt_object *dt,
+				struct thandle *th)
+{
+	struct lod_object *lo = lod_dt_obj(dt);
+	struct lu_attr *attr = &lod_env_info(env)->lti_attr;
+	struct dt_object *source;
+	__u32 nlink;
+	int rc;
+
+	ENTRY;
+
+	if (!(lo->ldo_dir_hash_type & LMV_HASH_FLAG_SPLIT) ||
+	    lo->ldo_dir_stripe_count <= lo->ldo_dir_migrate_offset)
+		RETURN(-EINVAL);
+
+	source = lo->ldo_stripe[lo->ldo_dir_migrate_offset];
+
+	rc = dt_attr_get(env, dt_object_child(dt), attr);
+	if (rc)
+		GOTO(out, rc);
+	nlink = attr->la_nlink;
+
+	rc = lod_xattr_set_lmv(env, dt, NULL, XATTR_NAME_LMV, 0, th);
+	if (rc)
+		GOTO(out, rc);
+
+	attr->la_valid = LA_NLINK;
+	attr->la_nlink = nlink;
+	rc = lod_sub_attr_set(env, source, attr, th);
+	if (rc)
+		GOTO(out, rc);
+
+	attr->la_nlink = 2 + lo->ldo_dir_stripe_count;
+	rc = lod_sub_attr_set(env, dt_object_child(dt), attr, th);
+	if (rc)
+		GOTO(out, rc);
+
+	rc = dt->do_ops->do_index_try(env, dt, &dt_directory_features);
+out:
+	if (rc)
+		lod_striping_free(env, lo);
+
+	RETURN(rc);
+}
+
 /**
  * Helper function to declare/execute creation of a striped directory
  *
@@ -4629,6 +5234,8 @@ static int lod_xattr_set(const struct lu_env *env,
 		 */
 		if (strcmp(op, ".del") == 0)
 			rc = lod_dir_layout_delete(env, dt, buf, th);
+		else if (strcmp(op, ".split") == 0)
+			rc = lod_dir_layout_split(env, dt, th);
 		else if (strcmp(op, ".set") == 0)
 			rc = lod_sub_xattr_set(env, next, buf, XATTR_NAME_LMV,
 					       fl, th);
@@ -201,6 +201,81 @@ static int changelog_init_cb(const struct lu_env *env, struct llog_handle *llh,
 	return LLOG_PROC_BREAK;
 }
 
+/* recompute the union of the record types wanted by changelog users */
+static void mdd_changelog_user_mask_update(struct mdd_changelog *mc)
+{
+	struct mdd_changelog_user *mcu;
+	__u32 mask = 0;
+
+	assert_spin_locked(&mc->mc_user_lock);
+
+	if (mc->mc_unfiltered_users > 0 || list_empty(&mc->mc_user_filters))
+		mask = CHANGELOG_ALLMASK;
+	list_for_each_entry(mcu, &mc->mc_user_filters, mcu_list)
+		mask |= mcu->mcu_filter.cuf_mask ?: CHANGELOG_ALLMASK;
+	/* marks are always wanted, see mdd_changelog_wanted() */
+	mask |= 1 << CL_MARK;
+
+	WRITE_ONCE(mc->mc_user_mask, mask);
+}
+
+/* account a changelog user, and its filter if \a cuf is not NULL */
+static int mdd_changelog_user_add(struct mdd_changelog *mc, __u32 id,
+				  const struct changelog_user_filter *cuf)
+{
+	struct mdd_changelog_user *mcu = NULL;
+
+	if (cuf != NULL) {
+		OBD_ALLOC_PTR(mcu);
+		if (mcu == NULL)
+			return -ENOMEM;
+		mcu->mcu_id = id;
+		mcu->mcu_filter = *cuf;
+	}
+
+	spin_lock(&mc->mc_user_lock);
+	if (mcu != NULL) {
+		list_add_tail(&mcu->mcu_list, &mc->mc_user_filters);
+		if (cuf->cuf_flags & CLUF_PROJID)
+			mc->mc_projid_filters++;
+	} else {
+		mc->mc_unfiltered_users++;
+	}
+	mdd_changelog_user_mask_update(mc);
+	spin_unlock(&mc->mc_user_lock);
+
+	return 0;
+}
+
+static void mdd_changelog_user_del(struct mdd_changelog *mc, __u32 id,
+				   bool filtered)
+{
+	struct mdd_changelog_user *mcu;
+	struct mdd_changelog_user *tmp;
+	struct mdd_changelog_user *found = NULL;
+
+	spin_lock(&mc->mc_user_lock);
+	if (filtered) {
+		list_for_each_entry_safe(mcu, tmp, &mc->mc_user_filters,
+					 mcu_list) {
+			if (mcu->mcu_id != id)
+				continue;
+			list_del(&mcu->mcu_list);
+			if (mcu->mcu_filter.cuf_flags & CLUF_PROJID)
+				mc->mc_projid_filters--;
+			found = mcu;
+			break;
+		}
+	} else if (mc->mc_unfiltered_users > 0) {
+		mc->mc_unfiltered_users--;
+	}
+	mdd_changelog_user_mask_update(mc);
+	spin_unlock(&mc->mc_user_lock);
+
+	if (found != NULL)
+		OBD_FREE_PTR(found);
+}
+
 static int changelog_user_init_cb(const struct lu_env *env,
 				  struct llog_handle *llh,
 				  struct llog_rec_hdr *hdr, void *data)
@@ -210,7 +285,8 @@ static int changelog_user_init_cb(const struct lu_env *env,
 		(struct llog_changelog_user_rec *)hdr;
 
 	LASSERT(llh->lgh_hdr->llh_flags & LLOG_F_IS_PLAIN);
-	LASSERT(rec->cur_hdr.lrh_type == CHANGELOG_USER_REC);
+	LASSERT(rec->cur_hdr.lrh_type == CHANGELOG_USER_REC ||
+		rec->cur_hdr.lrh_type == CHANGELOG_USER_REC2);
 
 	CDEBUG(D_INFO, "seeing user at index %d/%d id=%d endrec=%llu"
 	       " in log "DFID"\n", hdr->lrh_index, rec->cur_hdr.lrh_index,
@@ -263,7 +339,7 @@ static int changelog_detect_orphan_cb(const struct lu_env *env,
 	return LLOG_PROC_BREAK;
 }
 
-/* find oldest changelog user index */
+/* find oldest changelog user index, and load the user filters */
 static int changelog_user_detect_orphan_cb(const struct lu_env *env,
 					   struct llog_handle *llh,
 					   struct llog_rec_hdr *hdr, void *data)
@@ -272,10 +348,12 @@ static int changelog_user_detect_orphan_cb(const struct lu_env *env,
 	struct llog_changelog_user_rec *rec = container_of(hdr,
 						struct llog_changelog_user_rec,
 						cur_hdr);
+	struct llog_changelog_user_rec2 *rec2 = NULL;
 
 	LASSERT(llh->lgh_hdr->llh_flags & LLOG_F_IS_PLAIN);
 
-	if (rec->cur_hdr.lrh_type != CHANGELOG_USER_REC) {
+	if (rec->cur_hdr.lrh_type != CHANGELOG_USER_REC &&
+	    rec->cur_hdr.lrh_type != CHANGELOG_USER_REC2) {
 		CWARN("%s: invalid user at index %d in log "DFID"\n",
 		      mdd2obd_dev(mdd)->obd_name, hdr->lrh_index,
 		      PFID(&llh->lgh_id.lgl_oi.oi_fid));
@@ -294,7 +372,12 @@ static int changelog_user_detect_orphan_cb(const struct lu_env *env,
 	    rec->cur_endrec < ((struct changelog_orphan_data *)data)->index)
 		((struct changelog_orphan_data *)data)->index = rec->cur_endrec;
 
-	return 0;
+	if (rec->cur_hdr.lrh_type == CHANGELOG_USER_REC2)
+		rec2 = container_of(hdr, struct llog_changelog_user_rec2,
+				    cur_hdr);
+
+	return mdd_changelog_user_add(&mdd->mdd_cl, rec->cur_id,
+				      rec2 != NULL ? &rec2->cur_filter : NULL);
 }
 
 struct changelog_cancel_cookie {
@@ -577,6 +660,10 @@ static int mdd_changelog_init(const struct lu_env *env, struct mdd_device *mdd)
 	mdd->mdd_cl.mc_starttime = ktime_get();
 	spin_lock_init(&mdd->mdd_cl.mc_user_lock);
 	mdd->mdd_cl.mc_lastuser = 0;
+	INIT_LIST_HEAD(&mdd->mdd_cl.mc_user_filters);
+	mdd->mdd_cl.mc_unfiltered_users = 0;
+	mdd->mdd_cl.mc_projid_filters = 0;
+	mdd->mdd_cl.mc_user_mask = CHANGELOG_ALLMASK;
 
 	/* ensure a GC check will, and a thread run may, occur upon start */
 	mdd->mdd_cl.mc_gc_time = 0;
@@ -643,6 +730,18 @@ again:
 		llog_cat_close(env, ctxt->loc_handle);
 		llog_cleanup(env, ctxt);
 	}
+
+	while (!list_empty(&mdd->mdd_cl.mc_user_filters)) {
+		struct mdd_changelog_user *mcu;
+
+		mcu = list_first_entry(&mdd->mdd_cl.mc_user_filters,
+				       struct mdd_changelog_user, mcu_list);
+		list_del(&mcu->mcu_list);
+		OBD_FREE_PTR(mcu);
+	}
+	mdd->mdd_cl.mc_unfiltered_users = 0;
+	mdd->mdd_cl.mc_projid_filters = 0;
+	mdd->mdd_cl.mc_user_mask = CHANGELOG_ALLMASK;
 }
 
 /** Remove entries with indicies up to and including \a endrec from the
@@ -1498,37 +1597,74 @@ static int mdd_obd_set_info_async(const struct lu_env *env,
 	RETURN(rc);
 }
 
+/*
+ * allocate FID on the MDT specified by \a op_data, which is used by directory
+ * split to create the migrated objects on the MDTs of the new stripes.
+ */
+static int mdd_obd_fid_alloc(const struct lu_env *env, struct obd_export *exp,
+			     struct lu_fid *fid, struct md_op_data *op_data)
+{
+	struct mdd_device *mdd = lu2mdd_dev(exp->exp_obd->obd_lu_dev);
+
+	return obd_fid_alloc(env, mdd->mdd_child_exp, fid, op_data);
+}
+
 static const struct obd_ops mdd_obd_device_ops = {
 	.o_owner	= THIS_MODULE,
 	.o_connect	= mdd_obd_connect,
 	.o_disconnect	= mdd_obd_disconnect,
 	.o_get_info     = mdd_obd_get_info,
 	.o_set_info_async = mdd_obd_set_info_async,
+	.o_fid_alloc	= mdd_obd_fid_alloc,
 };
 
 static int mdd_changelog_user_register(const struct lu_env *env,
-				       struct mdd_device *mdd, int *id)
+				       struct mdd_device *mdd, int *id,
+				       struct changelog_user_filter *cuf)
 {
-        struct llog_ctxt *ctxt;
-        struct llog_changelog_user_rec *rec;
-        int rc;
-        ENTRY;
+	struct llog_ctxt *ctxt;
+	struct llog_changelog_user_rec2 *rec;
+	int rc;
+	ENTRY;
 
-        ctxt = llog_get_context(mdd2obd_dev(mdd),
+	/* A user without a filter is registered as an old style
+	 * CHANGELOG_USER_REC, which older MDTs can still read after a
+	 * downgrade. They LBUG on a CHANGELOG_USER_REC2 record instead, so
+	 * only filtered users get one, and they have to be deregistered
+	 * before a downgrade. A mask of all types filters nothing. */
+	if (cuf != NULL && cuf->cuf_mask == (1U << CL_LAST) - 1)
+		cuf->cuf_mask = 0;
+	if (cuf != NULL && cuf->cuf_mask == 0 && cuf->cuf_flags == 0)
+		cuf = NULL;
+	if (cuf != NULL) {
+		if (cuf->cuf_flags & ~CLUF_SUPPORTED ||
+		    (cuf->cuf_flags & CLUF_PFID &&
+		     !fid_is_sane(&cuf->cuf_pfid)))
+			RETURN(-EINVAL);
+		cuf->cuf_jobid[LUSTRE_JOBID_SIZE - 1] = '\0';
+	}
+
+	ctxt = llog_get_context(mdd2obd_dev(mdd),
 				LLOG_CHANGELOG_USER_ORIG_CTXT);
-        if (ctxt == NULL)
-                RETURN(-ENXIO);
+	if (ctxt == NULL)
+		RETURN(-ENXIO);
 
-        OBD_ALLOC_PTR(rec);
-        if (rec == NULL) {
-                llog_ctxt_put(ctxt);
-                RETURN(-ENOMEM);
-        }
+	OBD_ALLOC_PTR(rec);
+	if (rec == NULL) {
+		llog_ctxt_put(ctxt);
+		RETURN(-ENOMEM);
+	}
 
 	CFS_RACE(CFS_FAIL_CHLOG_USER_REG_UNREG_RACE);
 
-        rec->cur_hdr.lrh_len = sizeof(*rec);
-        rec->cur_hdr.lrh_type = CHANGELOG_USER_REC;
+	if (cuf != NULL) {
+		rec->cur_hdr.lrh_len = sizeof(*rec);
+		rec->cur_hdr.lrh_type = CHANGELOG_USER_REC2;
+		rec->cur_filter = *cuf;
+	} else {
+		rec->cur_hdr.lrh_len = sizeof(struct llog_changelog_user_rec);
+		rec->cur_hdr.lrh_type = CHANGELOG_USER_REC;
+	}
 	spin_lock(&mdd->mdd_cl.mc_user_lock);
 	if (mdd->mdd_cl.mc_lastuser == (unsigned int)(-1)) {
 		spin_unlock(&mdd->mdd_cl.mc_user_lock);
@@ -1545,7 +1681,14 @@ static int mdd_changelog_user_register(const struct lu_env *env,
 
 	spin_unlock(&mdd->mdd_cl.mc_user_lock);
 
-	rc = llog_cat_add(env, ctxt->loc_handle, &rec->cur_hdr, NULL);
+	/* account the user before its record is visible, so that records
+	 * it wants are not dropped in between */
+	rc = mdd_changelog_user_add(&mdd->mdd_cl, *id, cuf);
+	if (rc == 0) {
+		rc = llog_cat_add(env, ctxt->loc_handle, &rec->cur_hdr, NULL);
+		if (rc)
+			mdd_changelog_user_del(&mdd->mdd_cl, *id, cuf != NULL);
+	}
 	if (rc) {
 		CWARN("%s: Failed to register changelog user %d: rc=%d\n",
 		      mdd2obd_dev(mdd)->obd_name, *id, rc);
@@ -1555,7 +1698,7 @@ static int mdd_changelog_user_register(const struct lu_env *env,
 		GOTO(out, rc);
 	}
 
-        CDEBUG(D_IOCTL, "Registered changelog user %d\n", *id);
+	CDEBUG(D_IOCTL, "Registered changelog user %d\n", *id);
 
 	/* Assume we want it on since somebody registered */
 	rc = mdd_changelog_on(env, mdd);
@@ -1563,9 +1706,9 @@ static int mdd_changelog_user_register(const struct lu_env *env,
 		GOTO(out, rc);
 
 out:
-        OBD_FREE_PTR(rec);
-        llog_ctxt_put(ctxt);
-        RETURN(rc);
+	OBD_FREE_PTR(rec);
+	llog_ctxt_put(ctxt);
+	RETURN(rc);
 }
 
 struct mdd_changelog_user_purge {
@@ -1622,6 +1765,8 @@ static int mdd_changelog_user_purge_cb(const struct lu_env *env,
 		spin_lock(&mcup->mcup_mdd->mdd_cl.mc_user_lock);
 		mcup->mcup_mdd->mdd_cl.mc_users--;
 		spin_unlock(&mcup->mcup_mdd->mdd_cl.mc_user_lock);
+		mdd_changelog_user_del(&mcup->mcup_mdd->mdd_cl, mcup->mcup_id,
+				       hdr->lrh_type == CHANGELOG_USER_REC2);
 	}
 
 	RETURN(rc);
@@ -1893,13 +2038,24 @@ static int mdd_iocontrol(const struct lu_env *env, struct md_device *m,
 	}
 
 	switch (cmd) {
-	case OBD_IOC_CHANGELOG_REG:
+	case OBD_IOC_CHANGELOG_REG: {
+		struct changelog_user_filter *cuf = NULL;
+
+		if (data->ioc_inllen1 != 0) {
+			if (data->ioc_inllen1 != sizeof(*cuf) ||
+			    data->ioc_inlbuf1 == NULL)
+				RETURN(-EINVAL);
+			cuf = (struct changelog_user_filter *)data->ioc_inlbuf1;
+		}
+
 		if (unlikely(!barrier_entry(mdd->mdd_bottom)))
 			RETURN(-EINPROGRESS);
 
-		rc = mdd_changelog_user_register(env, mdd, &data->ioc_u32_1);
+		rc = mdd_changelog_user_register(env, mdd, &data->ioc_u32_1,
+						 cuf);
 		barrier_exit(mdd->mdd_bottom);
 		break;
+	}
 	case OBD_IOC_CHANGELOG_DEREG:
 		if (unlikely(!barrier_entry(mdd->mdd_bottom)))
 			RETURN(-EINPROGRESS);
@@ -802,9 +802,13 @@ int mdd_changelog_write_rec(const struct lu_env *env,
 		mdd = lu2mdd_dev(loghandle->lgh_ctxt->loc_obd->obd_lu_dev);
 		rec = container_of0(r, struct llog_changelog_rec, cr_hdr);
 
-		spin_lock(&mdd->mdd_cl.mc_lock);
-		rec->cr.cr_index = mdd->mdd_cl.mc_index + 1;
-		spin_unlock(&mdd->mdd_cl.mc_lock);
+		/*
+		 * Appends to the changelog are serialized by the lock of
+		 * the current plain llog, which also orders the records in
+		 * the log, so index assignment doesn't need mc_lock; readers
+		 * of mc_index only need to see a whole value.
+		 */
+		rec->cr.cr_index = READ_ONCE(mdd->mdd_cl.mc_index) + 1;
 
 		rc = llog_osd_ops.lop_write_rec(env, loghandle, r,
 						cookie, idx, th);
@@ -815,11 +819,8 @@ int mdd_changelog_write_rec(const struct lu_env *env,
 		 * avoid increasing index so that userspace apps
 		 * should not see a gap in the changelog sequence
 		 */
-		if (!(rc == -ENOSPC && llog_is_full(loghandle))) {
-			spin_lock(&mdd->mdd_cl.mc_lock);
-			++mdd->mdd_cl.mc_index;
-			spin_unlock(&mdd->mdd_cl.mc_lock);
-		}
+		if (!(rc == -ENOSPC && llog_is_full(loghandle)))
+			WRITE_ONCE(mdd->mdd_cl.mc_index, rec->cr.cr_index);
 	} else {
 		rc = llog_osd_ops.lop_write_rec(env, loghandle, r,
 						cookie, idx, th);
@@ -828,11 +829,107 @@ int mdd_changelog_write_rec(const struct lu_env *env,
 	return rc;
 }
 
+/* project ID of the record target, or of its parent if already gone */
+static __u32 mdd_changelog_rec_projid(const struct lu_env *env,
+				      struct mdd_device *mdd,
+				      const struct changelog_rec *rec)
+{
+	struct lu_attr *la = &mdd_env_info(env)->mti_la_for_changelog;
+	const struct lu_fid *fids[] = { &rec->cr_tfid, &rec->cr_pfid };
+	struct mdd_object *obj;
+	__u32 projid = 0;
+	int rc = -ENOENT;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(fids) && rc != 0; i++) {
+		if (!fid_is_sane(fids[i]))
+			continue;
+		obj = mdd_object_find(env, mdd, fids[i]);
+		if (IS_ERR(obj))
+			continue;
+		if (mdd_object_exists(obj))
+			rc = mdd_la_get(env, obj, la);
+		if (rc == 0)
+			projid = la->la_projid;
+		mdd_object_put(env, obj);
+	}
+
+	return projid;
+}
+
+static bool mdd_changelog_user_wants(const struct changelog_user_filter *cuf,
+				     const struct changelog_rec *rec,
+				     __u32 projid)
+{
+	if (cuf->cuf_mask != 0 && !(cuf->cuf_mask & (1 << rec->cr_type)))
+		return false;
+
+	if ((cuf->cuf_flags & CLUF_PROJID) && cuf->cuf_projid != projid)
+		return false;
+
+	/* a rename is wanted from either the source or target directory */
+	if ((cuf->cuf_flags & CLUF_PFID) &&
+	    !lu_fid_eq(&rec->cr_pfid, &cuf->cuf_pfid) &&
+	    !((rec->cr_flags & CLF_RENAME) &&
+	      lu_fid_eq(&changelog_rec_rename(rec)->cr_spfid,
+			&cuf->cuf_pfid)))
+		return false;
+
+	if ((cuf->cuf_flags & CLUF_JOBID) &&
+	    (!(rec->cr_flags & CLF_JOBID) ||
+	     strncmp(changelog_rec_jobid(rec)->cr_jobid, cuf->cuf_jobid,
+		     LUSTRE_JOBID_SIZE) != 0))
+		return false;
+
+	return true;
+}
+
+/**
+ * Whether any registered changelog user wants record \a rec.
+ *
+ * Records are only dropped when every user registered with a filter, and
+ * none of those filters match.
+ */
+static bool mdd_changelog_wanted(const struct lu_env *env,
+				 struct mdd_device *mdd,
+				 const struct changelog_rec *rec)
+{
+	struct mdd_changelog *mc = &mdd->mdd_cl;
+	struct mdd_changelog_user *mcu;
+	__u32 projid = 0;
+	bool wanted;
+
+	if (rec->cr_type == CL_MARK || READ_ONCE(mc->mc_unfiltered_users) > 0)
+		return true;
+
+	if (READ_ONCE(mc->mc_projid_filters) > 0)
+		projid = mdd_changelog_rec_projid(env, mdd, rec);
+
+	spin_lock(&mc->mc_user_lock);
+	wanted = mc->mc_unfiltered_users > 0 ||
+		 list_empty(&mc->mc_user_filters);
+	list_for_each_entry(mcu, &mc->mc_user_filters, mcu_list) {
+		if (wanted)
+			break;
+		wanted = mdd_changelog_user_wants(&mcu->mcu_filter, rec,
+						  projid);
+	}
+	spin_unlock(&mc->mc_user_lock);
+
+	return wanted;
+}
+
 /** Add a changelog entry \a rec to the changelog llog
+ *
+ * The record is appended in the transaction of the operation it describes,
+ * so a crash never keeps an operation and loses its record, and the record
+ * order in the llog is the order the operations hold the llog lock in.
+ * Records are therefore not staged per CPU nor appended in batches: one
+ * thread can't write another thread's records into its own transaction.
+ *
  * \param mdd
  * \param rec
- * \param handle - currently ignored since llogs start their own transaction;
- *		this will hopefully be fixed in llog rewrite
+ * \param th - transaction of the operation, the record is written in it
  * \retval 0 ok
  */
 int mdd_changelog_store(const struct lu_env *env, struct mdd_device *mdd,
@@ -843,6 +940,9 @@ int mdd_changelog_store(const struct lu_env *env, struct mdd_device *mdd,
 	struct thandle		*llog_th;
 	int			 rc;
 
+	if (!mdd_changelog_wanted(env, mdd, &rec->cr))
+		return 0;
+
 	rec->cr_hdr.lrh_len = llog_data_len(sizeof(*rec) +
 					    changelog_rec_varsize(&rec->cr));
 
@@ -1137,6 +1237,40 @@ static int __mdd_links_del(const struct lu_env *env,
 	return 0;
 }
 
+/*
+ * The names in the source stripe of a directory being split are in the index
+ * of the master, and their linkEA still refers to the master, see
+ * lod_split_index_ops. Get the master FID if \a pfid is such a stripe.
+ */
+static int mdd_split_master_fid(const struct lu_env *env,
+				struct mdd_device *mdd,
+				const struct lu_fid *pfid,
+				struct lu_fid *fid)
+{
+	struct lmv_mds_md_v1 lmv;
+	struct lu_buf buf = { .lb_buf = &lmv, .lb_len = sizeof(lmv) };
+	struct mdd_object *pobj;
+	int rc;
+
+	pobj = mdd_object_find(env, mdd, pfid);
+	if (IS_ERR(pobj))
+		return PTR_ERR(pobj);
+
+	rc = -ENOENT;
+	if (mdd_object_exists(pobj) && !mdd_object_remote(pobj) &&
+	    S_ISDIR(mdd_object_type(pobj)) &&
+	    mdo_xattr_get(env, pobj, &buf, XATTR_NAME_LMV) == sizeof(lmv) &&
+	    le32_to_cpu(lmv.lmv_magic) == LMV_MAGIC_STRIPE &&
+	    le32_to_cpu(lmv.lmv_hash_type) & LMV_HASH_FLAG_SPLIT &&
+	    le32_to_cpu(lmv.lmv_master_mdt_index) >=
+	    le32_to_cpu(lmv.lmv_migrate_offset))
+		rc = __mdd_lookup(env, &pobj->mod_obj, NULL, &lname_dotdot,
+				  fid, 0);
+	mdd_object_put(env, pobj);
+
+	return rc;
+}
+
 static int mdd_linkea_prepare(const struct lu_env *env,
 			      struct mdd_object *mdd_obj,
 			      const struct lu_fid *oldpfid,
@@ -1160,6 +1294,14 @@ static int mdd_linkea_prepare(const struct lu_env *env,
 
 	if (oldpfid != NULL) {
 		rc = __mdd_links_del(env, mdd_obj, ldata, oldlname, oldpfid);
+		if (rc == -ENOENT) {
+			struct lu_fid fid;
+
+			if (!mdd_split_master_fid(env, mdo2mdd(&mdd_obj->mod_obj),
+						  oldpfid, &fid))
+				rc = __mdd_links_del(env, mdd_obj, ldata,
+						     oldlname, &fid);
+		}
 		if (rc) {
 			if ((check == 1) || (rc != -ENODATA && rc != -ENOENT))
 				RETURN(rc);
@@ -4221,6 +4363,18 @@ static int mdd_declare_migrate_update(const struct lu_env *env,
 		rc = mdo_declare_ref_add(env, tpobj, handle);
 		if (rc)
 			return rc;
+
+		if (!do_create) {
+			rc = mdo_declare_index_delete(env, sobj, dotdot,
+						      handle);
+			if (rc)
+				return rc;
+
+			rc = mdo_declare_index_insert(env, sobj, mdo2fid(tpobj),
+						      S_IFDIR, dotdot, handle);
+			if (rc)
+				return rc;
+		}
 	}
 
 	la->la_valid = LA_CTIME | LA_MTIME;
@@ -4291,6 +4445,18 @@ static int mdd_migrate_update(const struct lu_env *env,
 	if (rc)
 		RETURN(rc);
 
+	/* directory whose name entry is moved only, update its ".." */
+	if (S_ISDIR(attr->la_mode) && !do_create) {
+		mdd_write_lock(env, sobj, DT_SRC_CHILD);
+		rc = __mdd_index_delete_only(env, sobj, dotdot, handle);
+		if (!rc)
+			rc = __mdd_index_insert_only(env, sobj, mdo2fid(tpobj),
+						     S_IFDIR, dotdot, handle);
+		mdd_write_unlock(env, sobj);
+		if (rc)
+			RETURN(rc);
+	}
+
 	la->la_ctime = la->la_mtime = ma->ma_attr.la_ctime;
 	la->la_valid = LA_CTIME | LA_MTIME;
 	mdd_write_lock(env, spobj, DT_SRC_PARENT);
@@ -4344,6 +4510,9 @@ static int mdd_migrate_update(const struct lu_env *env,
  *   2. update namespace: migrate dirent from source parent to target parent,
  *      update file linkea, and destroy source if it's not needed any more.
  *
+ * if \a spec has sp_migrate_nsonly set, step 1 is skipped and source keeps
+ * its FID and location, only its name entry is moved.
+ *
  * \param[in] env	execution environment
  * \param[in] md_pobj	parent master object
  * \param[in] md_sobj	source object
@@ -4460,7 +4629,10 @@ static int mdd_migrate(const struct lu_env *env, struct md_object *md_pobj,
 	if (rc)
 		GOTO(out, rc);
 
-	if (S_ISDIR(attr->la_mode)) {
+	if (spec->sp_migrate_nsonly) {
+		/* only the name entry is moved, source stays where it is */
+		do_create = false;
+	} else if (S_ISDIR(attr->la_mode)) {
 		struct lmv_user_md_v1 *lmu = spec->u.sp_ea.eadata;
 
 		LASSERT(lmu);
@@ -4572,12 +4744,17 @@ static int mdd_migrate(const struct lu_env *env, struct md_object *md_pobj,
 	else if (rc)
 		GOTO(out, rc);
 
-	rc = mdd_migrate_sanity_check(env, mdd, spobj, tpobj, sobj, tobj,
-				      spattr, tpattr, attr);
+	if (spec->sp_migrate_nsonly)
+		rc = mdd_rename_sanity_check(env, spobj, spattr, tpobj, tpattr,
+					     sobj, attr, NULL, NULL);
+	else
+		rc = mdd_migrate_sanity_check(env, mdd, spobj, tpobj, sobj,
+					      tobj, spattr, tpattr, attr);
 	if (rc)
 		GOTO(out, rc);
 
-	mdd_object_make_hint(env, tpobj, tobj, attr, spec, hint);
+	if (do_create)
+		mdd_object_make_hint(env, tpobj, tobj, attr, spec, hint);
 
 	handle = mdd_trans_create(env, mdd);
 	if (IS_ERR(handle))
@@ -4787,7 +4964,8 @@ static int __mdd_dir_layout_shrink(const struct lu_env *env,
 	if (le32_to_cpu(lmu->lum_stripe_count) > 1) {
 		/* update dir LMV, that's all if it's still striped. */
 		lmv->lmv_stripe_count = lmu->lum_stripe_count;
-		lmv->lmv_hash_type &= ~cpu_to_le32(LMV_HASH_FLAG_MIGRATION);
+		lmv->lmv_hash_type &= ~cpu_to_le32(LMV_HASH_FLAG_MIGRATION |
+						   LMV_HASH_FLAG_SPLIT);
 		lmv->lmv_migrate_offset = 0;
 		lmv->lmv_migrate_hash = 0;
 		lmv->lmv_layout_version = cpu_to_le32(++version);
@@ -4992,6 +5170,68 @@ out:
 	return rc;
 }
 
+/*
+ * split plain directory \a md_obj in place to the striped layout specified by
+ * \a lmu_buf, the directory keeps its FID, and its names are migrated to the
+ * new stripes afterwards, see lod_dir_declare_layout_split().
+ */
+int mdd_dir_layout_split(const struct lu_env *env, struct md_object *md_obj,
+			 const struct lu_buf *lmu_buf)
+{
+	struct mdd_device *mdd = mdo2mdd(md_obj);
+	struct mdd_object *obj = md2mdd_obj(md_obj);
+	struct lu_attr *attr = &mdd_env_info(env)->mti_pattr;
+	struct thandle *handle;
+	int rc;
+
+	ENTRY;
+
+	rc = mdd_la_get(env, obj, attr);
+	if (rc)
+		RETURN(rc);
+
+	if (!S_ISDIR(attr->la_mode))
+		RETURN(-ENOTDIR);
+
+	handle = mdd_trans_create(env, mdd);
+	if (IS_ERR(handle))
+		RETURN(PTR_ERR(handle));
+
+	rc = mdo_declare_xattr_set(env, obj, lmu_buf, XATTR_NAME_LMV".split", 0,
+				   handle);
+	if (rc)
+		GOTO(stop_trans, rc);
+
+	rc = mdd_declare_changelog_store(env, mdd, CL_LAYOUT, NULL, NULL,
+					 handle);
+	if (rc)
+		GOTO(stop_trans, rc);
+
+	rc = mdd_trans_start(env, mdd, handle);
+	if (rc)
+		GOTO(stop_trans, rc);
+
+	mdd_write_lock(env, obj, DT_TGT_CHILD);
+	rc = mdo_xattr_set(env, obj, lmu_buf, XATTR_NAME_LMV".split", 0,
+			   handle);
+	mdd_write_unlock(env, obj);
+	if (rc)
+		GOTO(stop_trans, rc);
+
+	rc = mdd_changelog_data_store_xattr(env, mdd, CL_LAYOUT, 0, obj,
+					    XATTR_NAME_LMV, handle);
+	GOTO(stop_trans, rc);
+
+stop_trans:
+	rc = mdd_trans_stop(env, mdd, rc, handle);
+	/* the declared striping is cached, don't keep it if not written */
+	if (rc)
+		set_bit(LU_OBJECT_HEARD_BANSHEE,
+			&obj->mod_obj.mo_lu.lo_header->loh_flags);
+
+	return rc;
+}
+
 const struct md_dir_operations mdd_dir_ops = {
 	.mdo_is_subdir     = mdd_is_subdir,
 	.mdo_lookup        = mdd_lookup,
@@ -93,7 +93,7 @@
 /** else the started task_struct address when running **/
 
 struct mdd_changelog {
-	spinlock_t		mc_lock;	/* for index */
+	spinlock_t		mc_lock;	/* for flags and GC state */
 	int			mc_flags;
 	int			mc_mask;
 	__u64			mc_index;
@@ -101,6 +101,14 @@ struct mdd_changelog {
 	spinlock_t		mc_user_lock;
 	int			mc_lastuser;
 	int			mc_users;      /* registered users number */
+	/* users registered with a filter, struct mdd_changelog_user */
+	struct list_head	mc_user_filters;
+	/* users registered without a filter, they want every record */
+	int			mc_unfiltered_users;
+	/* users filtering on a project ID */
+	int			mc_projid_filters;
+	/* union of the types wanted by users */
+	__u32			mc_user_mask;
 	struct task_struct	*mc_gc_task;
 	time64_t		mc_gc_time;    /* last GC check or run time */
 	unsigned int		mc_deniednext; /* interval for recording denied
@@ -108,6 +116,13 @@ struct mdd_changelog {
 						*/
 };
 
+/* in-memory copy of a filtered changelog user, to drop unwanted records */
+struct mdd_changelog_user {
+	struct list_head		mcu_list;
+	__u32				mcu_id;
+	struct changelog_user_filter	mcu_filter;
+};
+
 static inline __u64 cl_time(void)
 {
 	struct timespec64 time;
@@ -190,6 +205,8 @@ struct mdd_thread_info {
 	struct lu_attr            mti_la_for_fix;
 	/* Only used in mdd_object_start */
 	struct lu_attr		  mti_la_for_start;
+	/* Only used to filter changelog records on project ID */
+	struct lu_attr		  mti_la_for_changelog;
 	/* mti_ent and mti_key must be conjoint,
 	* then mti_ent::lde_name will be mti_key. */
 	struct lu_dirent	  mti_ent;
@@ -278,6 +295,8 @@ int mdd_links_rename(const struct lu_env *env,
 int mdd_dir_layout_shrink(const struct lu_env *env,
 			  struct md_object *md_obj,
 			  const struct lu_buf *lmu_buf);
+int mdd_dir_layout_split(const struct lu_env *env, struct md_object *md_obj,
+			 const struct lu_buf *lmu_buf);
 
 int mdd_changelog_write_rec(const struct lu_env *env,
 			    struct llog_handle *loghandle,
@@ -782,7 +801,8 @@ static inline bool mdd_changelog_enabled(const struct lu_env *env,
 	const struct lu_ucred *uc;
 
 	if ((mdd->mdd_cl.mc_flags & CLM_ON) &&
-	    (mdd->mdd_cl.mc_mask & (1 << type))) {
+	    (mdd->mdd_cl.mc_mask & READ_ONCE(mdd->mdd_cl.mc_user_mask) &
+	     (1 << type))) {
 		uc = lu_ucred_check(env);
 
 		return uc != NULL ? uc->uc_enable_audit : true;
@@ -138,9 +138,23 @@ static int lprocfs_changelog_users_cb(const struct lu_env *env,
 
 	rec = (struct llog_changelog_user_rec *)hdr;
 
-	seq_printf(m, CHANGELOG_USER_PREFIX"%-3d %llu (%u)\n",
+	seq_printf(m, CHANGELOG_USER_PREFIX"%-3d %llu (%u)",
 		   rec->cur_id, rec->cur_endrec, (__u32)get_seconds() -
 						 rec->cur_time);
+	if (rec->cur_hdr.lrh_type == CHANGELOG_USER_REC2) {
+		struct changelog_user_filter *cuf =
+			&((struct llog_changelog_user_rec2 *)hdr)->cur_filter;
+
+		if (cuf->cuf_mask != 0)
+			seq_printf(m, " mask=%#x", cuf->cuf_mask);
+		if (cuf->cuf_flags & CLUF_PROJID)
+			seq_printf(m, " projid=%u", cuf->cuf_projid);
+		if (cuf->cuf_flags & CLUF_PFID)
+			seq_printf(m, " parent="DFID, PFID(&cuf->cuf_pfid));
+		if (cuf->cuf_flags & CLUF_JOBID)
+			seq_printf(m, " jobid=%s", cuf->cuf_jobid);
+	}
+	seq_putc(m, '\n');
 	return 0;
 }
 
@@ -513,6 +527,34 @@ static ssize_t lfsck_async_windows_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(lfsck_async_windows);
 
+static ssize_t lfsck_assistant_threads_show(struct kobject *kobj,
+					    struct attribute *attr, char *buf)
+{
+	struct mdd_device *mdd = container_of(kobj, struct mdd_device,
+					      mdd_kobj);
+
+	return lfsck_get_assistant_threads(buf, mdd->mdd_bottom);
+}
+
+static ssize_t lfsck_assistant_threads_store(struct kobject *kobj,
+					     struct attribute *attr,
+					     const char *buffer, size_t count)
+{
+	struct mdd_device *mdd = container_of(kobj, struct mdd_device,
+					      mdd_kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 10, &val);
+	if (rc)
+		return rc;
+
+	rc = lfsck_set_assistant_threads(mdd->mdd_bottom, val);
+
+	return rc != 0 ? rc : count;
+}
+LUSTRE_RW_ATTR(lfsck_assistant_threads);
+
 static int mdd_lfsck_namespace_seq_show(struct seq_file *m, void *data)
 {
 	struct mdd_device *mdd = m->private;
@@ -667,6 +709,7 @@ static struct attribute *mdd_attrs[] = {
 	&lustre_attr_changelog_min_free_cat_entries.attr,
 	&lustre_attr_changelog_deniednext.attr,
 	&lustre_attr_lfsck_async_windows.attr,
+	&lustre_attr_lfsck_assistant_threads.attr,
 	&lustre_attr_lfsck_speed_limit.attr,
 	&lustre_attr_sync_permission.attr,
 	&lustre_attr_append_stripe_count.attr,
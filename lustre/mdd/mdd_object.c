@@ -1927,6 +1927,11 @@ static int mdd_xattr_set(const struct lu_env *env, struct md_object *obj,
 		RETURN(rc);
 	}
 
+	if (strcmp(name, XATTR_NAME_LMV".split") == 0) {
+		rc = mdd_dir_layout_split(env, obj, buf);
+		RETURN(rc);
+	}
+
 	if (strcmp(name, XATTR_NAME_ACL_ACCESS) == 0 ||
 	    strcmp(name, XATTR_NAME_ACL_DEFAULT) == 0) {
 		struct posix_acl *acl;
@@ -3521,20 +3521,20 @@ static void mdt_save_remote_lock(struct mdt_thread_info *info,
 
 	if (lustre_handle_is_used(h)) {
 		struct ldlm_lock *lock = ldlm_handle2lock(h);
+		struct ptlrpc_request *req = mdt_info_req(info);
 
 		if (o != NULL &&
 		    (lock->l_policy_data.l_inodebits.bits &
 		     (MDS_INODELOCK_XATTR | MDS_INODELOCK_UPDATE)))
 			mo_invalidate(info->mti_env, mdt_object_child(o));
 
-		if (decref || !info->mti_has_trans ||
+		/* there is no request for operations started by MDT itself,
+		 * e.g. directory auto split, release the lock immediately */
+		if (decref || !info->mti_has_trans || req == NULL ||
 		    !(mode & (LCK_PW | LCK_EX))) {
 			ldlm_lock_decref_and_cancel(h, mode);
 			LDLM_LOCK_PUT(lock);
 		} else {
-			struct ptlrpc_request *req = mdt_info_req(info);
-
-			LASSERT(req != NULL);
 			tgt_save_slc_lock(&info->mti_mdt->mdt_lut, lock,
 					  req->rq_transno);
 			ldlm_lock_decref(h, mode);
@@ -3750,6 +3750,7 @@ void mdt_thread_info_init(struct ptlrpc_request *req,
 	info->mti_spec.sp_rm_entry = 0;
 	info->mti_spec.sp_permitted = 0;
 	info->mti_spec.sp_migrate_close = 0;
+	info->mti_spec.sp_migrate_nsonly = 0;
 
 	info->mti_spec.u.sp_ea.eadata = NULL;
 	info->mti_spec.u.sp_ea.eadatalen = 0;
@@ -5300,6 +5301,7 @@ static void mdt_fini(const struct lu_env *env, struct mdt_device *m)
 	 * restarted by a user while it's shutting down.
 	 */
 	mdt_hsm_cdt_stop(m);
+	mdt_restriper_stop(m);
 
 	mdt_llog_ctxt_unclone(env, m, LLOG_AGENT_ORIG_CTXT);
 	mdt_llog_ctxt_unclone(env, m, LLOG_CHANGELOG_ORIG_CTXT);
@@ -5438,6 +5440,8 @@ static int mdt_init0(const struct lu_env *env, struct mdt_device *m,
 	m->mdt_enable_remote_dir_gid = 0;
 	m->mdt_enable_chprojid_gid = 0;
 	m->mdt_enable_remote_rename = 1;
+	m->mdt_dir_split_count = 50000;
+	m->mdt_dir_split_delta = 4;
 
 	atomic_set(&m->mdt_mds_mds_conns, 0);
 	atomic_set(&m->mdt_async_commit_count, 0);
@@ -5536,6 +5540,8 @@ static int mdt_init0(const struct lu_env *env, struct mdt_device *m,
 		GOTO(err_los_fini, rc);
 	}
 
+	mdt_restriper_init(m);
+
 	tgt_adapt_sptlrpc_conf(&m->mdt_lut);
 
 	next = m->mdt_child;
@@ -5566,7 +5572,7 @@ static int mdt_init0(const struct lu_env *env, struct mdt_device *m,
 	if (IS_ERR(m->mdt_identity_cache)) {
 		rc = PTR_ERR(m->mdt_identity_cache);
 		m->mdt_identity_cache = NULL;
-		GOTO(err_free_hsm, rc);
+		GOTO(err_restriper, rc);
 	}
 
 	rc = mdt_tunables_init(m, dev);
@@ -5601,7 +5607,8 @@ err_procfs:
 err_recovery:
 	upcall_cache_cleanup(m->mdt_identity_cache);
 	m->mdt_identity_cache = NULL;
-err_free_hsm:
+err_restriper:
+	mdt_restriper_stop(m);
 	mdt_hsm_cdt_fini(m);
 err_los_fini:
 	local_oid_storage_fini(env, m->mdt_los);
@@ -6926,6 +6933,11 @@ static int mdt_postrecov(const struct lu_env *env, struct mdt_device *mdt)
 			      mdt_obd_name(mdt), rc);
 	}
 
+	rc = mdt_restriper_start(mdt);
+	if (rc != 0)
+		CWARN("%s: directory auto split is disabled: rc = %d\n",
+		      mdt_obd_name(mdt), rc);
+
 	rc = ld->ld_ops->ldo_recovery_complete(env, ld);
 	RETURN(rc);
 }
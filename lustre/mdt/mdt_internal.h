@@ -188,6 +188,19 @@ struct coordinator {
 	bool			 cdt_wakeup_coordinator;
 };
 
+/* directory auto split */
+struct mdt_dir_restriper {
+	spinlock_t		 mdr_lock;
+	/* directories queued to split, struct mdt_restripe_item */
+	struct list_head	 mdr_list;
+	unsigned int		 mdr_queued;
+	struct task_struct	*mdr_task;
+	struct lu_env		 mdr_env;
+	/* for mdt_ucred(), lu_ucred stored in lu_ucred_key */
+	struct lu_context	 mdr_session;
+	struct lmv_user_md	 mdr_lmu;
+};
+
 /* mdt state flag bits */
 #define MDT_FL_CFGLOG 0
 #define MDT_FL_SYNCED 1
@@ -256,6 +269,7 @@ struct mdt_device {
 				   mdt_enable_striped_dir:1,
 				   mdt_enable_dir_migration:1,
 				   mdt_enable_remote_rename:1,
+				   mdt_enable_dir_auto_split:1,
 				   mdt_skip_lfsck:1,
 				   mdt_readonly:1;
 
@@ -285,6 +299,12 @@ struct mdt_device {
 
 	struct coordinator	   mdt_coordinator;
 
+	/* split plain directory with at least this many entries */
+	__u32			   mdt_dir_split_count;
+	/* count of stripes added to the directory on split */
+	__u32			   mdt_dir_split_delta;
+	struct mdt_dir_restriper   mdt_restriper;
+
 	/* inter-MDT connection count */
 	atomic_t		   mdt_mds_mds_conns;
 
@@ -318,6 +338,8 @@ struct mdt_object {
 	struct rw_semaphore	mot_open_sem;
 	atomic_t		mot_lease_count;
 	atomic_t		mot_open_count;
+	/* directory size to check again for auto split */
+	__u64			mot_split_size;
 };
 
 struct mdt_lock_handle {
@@ -844,6 +866,9 @@ int mdt_pack_size2body(struct mdt_thread_info *info,
 int mdt_getxattr(struct mdt_thread_info *info);
 int mdt_reint_setxattr(struct mdt_thread_info *info,
                        struct mdt_lock_handle *lh);
+int mdt_dir_layout_shrink(struct mdt_thread_info *info);
+int mdt_reint_migrate(struct mdt_thread_info *info,
+		      struct mdt_lock_handle *unused);
 
 void mdt_lock_handle_init(struct mdt_lock_handle *lh);
 void mdt_lock_handle_fini(struct mdt_lock_handle *lh);
@@ -988,6 +1013,13 @@ __u32 mdt_identity_get_perm(struct md_identity *, lnet_nid_t);
 /* mdt/mdt_recovery.c */
 __u64 mdt_req_from_lrd(struct ptlrpc_request *req, struct tg_reply_data *trd);
 
+/* mdt/mdt_restriper.c */
+void mdt_restriper_init(struct mdt_device *mdt);
+int mdt_restriper_start(struct mdt_device *mdt);
+void mdt_restriper_stop(struct mdt_device *mdt);
+void mdt_auto_split_check(struct mdt_thread_info *info,
+			  struct mdt_object *pobj);
+
 /* mdt/mdt_hsm.c */
 int mdt_hsm_state_get(struct tgt_session_info *tsi);
 int mdt_hsm_state_set(struct tgt_session_info *tsi);
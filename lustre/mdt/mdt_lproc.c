@@ -1044,6 +1044,109 @@ static ssize_t enable_remote_rename_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(enable_remote_rename);
 
+/**
+ * Show if plain directory is split automatically when it grows large.
+ */
+static ssize_t enable_dir_auto_split_show(struct kobject *kobj,
+					  struct attribute *attr, char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct mdt_device *mdt = mdt_dev(obd->obd_lu_dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			 mdt->mdt_enable_dir_auto_split);
+}
+
+static ssize_t enable_dir_auto_split_store(struct kobject *kobj,
+					   struct attribute *attr,
+					   const char *buffer, size_t count)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct mdt_device *mdt = mdt_dev(obd->obd_lu_dev);
+	bool val;
+	int rc;
+
+	rc = kstrtobool(buffer, &val);
+	if (rc)
+		return rc;
+
+	mdt->mdt_enable_dir_auto_split = val;
+	return count;
+}
+LUSTRE_RW_ATTR(enable_dir_auto_split);
+
+/**
+ * Show entry count at which plain directory is split.
+ */
+static ssize_t dir_split_count_show(struct kobject *kobj,
+				    struct attribute *attr, char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct mdt_device *mdt = mdt_dev(obd->obd_lu_dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", mdt->mdt_dir_split_count);
+}
+
+static ssize_t dir_split_count_store(struct kobject *kobj,
+				     struct attribute *attr,
+				     const char *buffer, size_t count)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct mdt_device *mdt = mdt_dev(obd->obd_lu_dev);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 10, &val);
+	if (rc)
+		return rc;
+
+	if (val < 1 || val > INT_MAX)
+		return -ERANGE;
+
+	mdt->mdt_dir_split_count = val;
+	return count;
+}
+LUSTRE_RW_ATTR(dir_split_count);
+
+/**
+ * Show count of stripes added to plain directory when it's split.
+ */
+static ssize_t dir_split_delta_show(struct kobject *kobj,
+				    struct attribute *attr, char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct mdt_device *mdt = mdt_dev(obd->obd_lu_dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", mdt->mdt_dir_split_delta);
+}
+
+static ssize_t dir_split_delta_store(struct kobject *kobj,
+				     struct attribute *attr,
+				     const char *buffer, size_t count)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct mdt_device *mdt = mdt_dev(obd->obd_lu_dev);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 10, &val);
+	if (rc)
+		return rc;
+
+	if (val < 1 || val >= LMV_MAX_STRIPE_COUNT)
+		return -ERANGE;
+
+	mdt->mdt_dir_split_delta = val;
+	return count;
+}
+LUSTRE_RW_ATTR(dir_split_delta);
+
 LPROC_SEQ_FOPS_RO_TYPE(mdt, hash);
 LPROC_SEQ_FOPS_WR_ONLY(mdt, mds_evict_client);
 LUSTRE_RW_ATTR(job_cleanup_interval);
@@ -1084,6 +1187,9 @@ static struct attribute *mdt_attrs[] = {
 	&lustre_attr_enable_striped_dir.attr,
 	&lustre_attr_enable_dir_migration.attr,
 	&lustre_attr_enable_remote_rename.attr,
+	&lustre_attr_enable_dir_auto_split.attr,
+	&lustre_attr_dir_split_count.attr,
+	&lustre_attr_dir_split_delta.attr,
 	&lustre_attr_commit_on_sharing.attr,
 	&lustre_attr_async_commit_count.attr,
 	&lustre_attr_sync_count.attr,
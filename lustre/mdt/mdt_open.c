@@ -1529,6 +1529,7 @@ again:
                 }
 		created = 1;
 		mdt_counter_incr(req, LPROC_MDT_MKNOD);
+		mdt_auto_split_check(info, parent);
         } else {
                 /*
                  * The object is on remote node, return its FID for remote open.
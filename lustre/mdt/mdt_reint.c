@@ -159,9 +159,12 @@ void mdt_version_get_save(struct mdt_thread_info *info,
 int mdt_version_get_check(struct mdt_thread_info *info,
                           struct mdt_object *mto, int idx)
 {
-        /* only check versions during replay */
-        if (!req_is_replay(mdt_info_req(info)))
-                return 0;
+	struct ptlrpc_request *req = mdt_info_req(info);
+
+	/* only check versions during replay, and there is no request for
+	 * operations started by MDT itself */
+	if (!req || !req_is_replay(req))
+		return 0;
 
         mdt_obj_version_get(info, mto, &info->mti_ver[idx]);
         return mdt_version_check(mdt_info_req(info), info->mti_ver[idx], idx);
@@ -515,6 +518,8 @@ static int mdt_create(struct mdt_thread_info *info)
 	if (ma->ma_valid & MA_INODE)
 		mdt_pack_attr2body(info, repbody, &ma->ma_attr,
 				   mdt_object_fid(child));
+
+	mdt_auto_split_check(info, parent);
 put_child:
 	mdt_object_put(info->mti_env, child);
 unlock_parent:
@@ -1255,10 +1260,11 @@ static int mdt_pdir_hash_lock(struct mdt_thread_info *info,
 }
 
 /**
- * Get BFL lock for rename or migrate process.
+ * Get BFL lock for rename or migrate process, in LCK_EX mode to move a
+ * directory, or in LCK_PR mode to keep directories from being moved.
  **/
 static int mdt_rename_lock(struct mdt_thread_info *info,
-			   struct lustre_handle *lh)
+			   struct lustre_handle *lh, enum ldlm_mode mode)
 {
 	int	rc;
 	ENTRY;
@@ -1276,8 +1282,7 @@ static int mdt_rename_lock(struct mdt_thread_info *info,
 			RETURN(PTR_ERR(obj));
 
 		rc = mdt_remote_object_lock(info, obj,
-					    &LUSTRE_BFL_FID, lh,
-					    LCK_EX,
+					    &LUSTRE_BFL_FID, lh, mode,
 					    MDS_INODELOCK_UPDATE, false);
 		mdt_object_put(info->mti_env, obj);
 	} else {
@@ -1291,23 +1296,24 @@ static int mdt_rename_lock(struct mdt_thread_info *info,
 		policy->l_inodebits.bits = MDS_INODELOCK_UPDATE;
 		flags = LDLM_FL_LOCAL_ONLY | LDLM_FL_ATOMIC_CB;
 		rc = ldlm_cli_enqueue_local(info->mti_env, ns, res_id,
-					    LDLM_IBITS, policy, LCK_EX, &flags,
+					    LDLM_IBITS, policy, mode, &flags,
 					    ldlm_blocking_ast,
 					    ldlm_completion_ast, NULL, NULL, 0,
 					    LVB_T_NONE,
-					    &info->mti_exp->exp_handle.h_cookie,
-					    lh);
+					    info->mti_exp ?
+					    &info->mti_exp->exp_handle.h_cookie :
+					    NULL, lh);
 		RETURN(rc);
 	}
 	RETURN(rc);
 }
 
-static void mdt_rename_unlock(struct lustre_handle *lh)
+static void mdt_rename_unlock(struct lustre_handle *lh, enum ldlm_mode mode)
 {
 	ENTRY;
 	LASSERT(lustre_handle_is_used(lh));
 	/* Cancel the single rename lock right away */
-	ldlm_lock_decref_and_cancel(lh, LCK_EX);
+	ldlm_lock_decref_and_cancel(lh, mode);
 	EXIT;
 }
 
@@ -1972,8 +1978,8 @@ close:
  *  9. unlock above locks
  * 10. sync device if source has links
  */
-static int mdt_reint_migrate(struct mdt_thread_info *info,
-			     struct mdt_lock_handle *unused)
+int mdt_reint_migrate(struct mdt_thread_info *info,
+		      struct mdt_lock_handle *unused)
 {
 	const struct lu_env *env = info->mti_env;
 	struct mdt_device *mdt = info->mti_mdt;
@@ -1990,11 +1996,12 @@ static int mdt_reint_migrate(struct mdt_thread_info *info,
 	struct lustre_handle rename_lh = { 0 };
 	struct mdt_lock_handle *lhp;
 	struct mdt_lock_handle *lhs;
-	struct mdt_lock_handle *lht;
+	struct mdt_lock_handle *lht = NULL;
 	LIST_HEAD(parent_slave_locks);
 	LIST_HEAD(child_slave_locks);
 	LIST_HEAD(link_locks);
 	int lock_retries = 5;
+	bool nsonly = info->mti_spec.sp_migrate_nsonly;
 	bool open_sem_locked = false;
 	bool do_sync = false;
 	int rc;
@@ -2007,7 +2014,7 @@ static int mdt_reint_migrate(struct mdt_thread_info *info,
 		ldlm_request_cancel(req, info->mti_dlm_req, 0, LATF_SKIP);
 
 	if (!fid_is_md_operative(rr->rr_fid1) ||
-	    !fid_is_md_operative(rr->rr_fid2))
+	    (!nsonly && !fid_is_md_operative(rr->rr_fid2)))
 		RETURN(-EPERM);
 
 	/* don't allow migrate . or .. */
@@ -2028,8 +2035,8 @@ static int mdt_reint_migrate(struct mdt_thread_info *info,
 	 * this MDT to finish its recovery, and the failover MDT can not
 	 * get rename lock, which will cause deadlock.
 	 */
-	if (!req_is_replay(req)) {
-		rc = mdt_rename_lock(info, &rename_lh);
+	if (!req || !req_is_replay(req)) {
+		rc = mdt_rename_lock(info, &rename_lh, LCK_EX);
 		if (rc != 0) {
 			CERROR("%s: can't lock FS for rename: rc = %d\n",
 			       mdt_obd_name(info->mti_mdt), rc);
@@ -2074,9 +2081,13 @@ lock_parent:
 	if (rc)
 		GOTO(unlock_parent, rc);
 
-	/* lock parents of source links, and revoke LOOKUP lock of links */
-	rc = mdt_link_parents_lock(info, pobj, ma, sobj, lhp, peinfo,
-				   &parent_slave_locks, &link_locks);
+	/*
+	 * lock parents of source links, and revoke LOOKUP lock of links, which
+	 * are left untouched if only the name entry is moved.
+	 */
+	if (!nsonly)
+		rc = mdt_link_parents_lock(info, pobj, ma, sobj, lhp, peinfo,
+					   &parent_slave_locks, &link_locks);
 	if (rc == -EBUSY && lock_retries-- > 0) {
 		mdt_object_put(env, sobj);
 		mdt_object_put(env, spobj);
@@ -2094,7 +2105,7 @@ lock_parent:
 	do_sync = rc;
 
 	/* TODO: DoM migration is not supported yet */
-	if (S_ISREG(lu_object_attr(&sobj->mot_obj))) {
+	if (!nsonly && S_ISREG(lu_object_attr(&sobj->mot_obj))) {
 		ma->ma_lmm = info->mti_big_lmm;
 		ma->ma_lmm_size = info->mti_big_lmmsize;
 		ma->ma_valid = 0;
@@ -2108,7 +2119,7 @@ lock_parent:
 	}
 
 	/* if migration HSM is allowed */
-	if (!mdt->mdt_opts.mo_migrate_hsm_allowed) {
+	if (!nsonly && !mdt->mdt_opts.mo_migrate_hsm_allowed) {
 		ma->ma_need = MA_HSM;
 		ma->ma_valid = 0;
 		rc = mdt_attr_get_complex(info, sobj, ma);
@@ -2142,16 +2153,22 @@ lock_parent:
 	if (rc)
 		GOTO(unlock_open_sem, rc);
 
-	/* lock target */
-	tobj = mdt_object_find(env, mdt, rr->rr_fid2);
-	if (IS_ERR(tobj))
-		GOTO(unlock_source, rc = PTR_ERR(tobj));
-
-	lht = &info->mti_lh[MDT_LH_NEW];
-	mdt_lock_reg_init(lht, LCK_EX);
-	rc = mdt_reint_object_lock(info, tobj, lht, MDS_INODELOCK_FULL, true);
-	if (rc)
-		GOTO(put_target, rc);
+	/* lock target, which is source itself if only name entry is moved */
+	if (nsonly) {
+		tobj = sobj;
+		mdt_object_get(env, tobj);
+	} else {
+		tobj = mdt_object_find(env, mdt, rr->rr_fid2);
+		if (IS_ERR(tobj))
+			GOTO(unlock_source, rc = PTR_ERR(tobj));
+
+		lht = &info->mti_lh[MDT_LH_NEW];
+		mdt_lock_reg_init(lht, LCK_EX);
+		rc = mdt_reint_object_lock(info, tobj, lht, MDS_INODELOCK_FULL,
+					   true);
+		if (rc)
+			GOTO(put_target, rc);
+	}
 
 	/* Don't do lookup sanity check. We know name doesn't exist. */
 	info->mti_spec.sp_cr_lookup = 0;
@@ -2162,7 +2179,8 @@ lock_parent:
 			 mdt_object_child(tobj), &info->mti_spec, ma);
 	EXIT;
 
-	mdt_object_unlock(info, tobj, lht, rc);
+	if (lht)
+		mdt_object_unlock(info, tobj, lht, rc);
 put_target:
 	mdt_object_put(env, tobj);
 unlock_source:
@@ -2187,7 +2205,7 @@ put_parent:
 	mdt_object_put(env, pobj);
 unlock_rename:
 	if (lustre_handle_is_used(&rename_lh))
-		mdt_rename_unlock(&rename_lh);
+		mdt_rename_unlock(&rename_lh, LCK_EX);
 
 	return rc;
 }
@@ -2213,10 +2231,16 @@ static int mdt_object_lock_save(struct mdt_thread_info *info,
 /*
  * determine lock order of sobj and tobj
  *
- * there are two situations we need to lock tobj before sobj:
+ * there are three situations we need to lock tobj before sobj:
  * 1. sobj is child of tobj
  * 2. sobj and tobj are stripes of a directory, and stripe index of sobj is
  *    larger than that of tobj
+ * 3. sobj and tobj are unrelated, and the FID of sobj is larger than that of
+ *    tobj; file renames hold the BFL lock in shared mode, so two of them may
+ *    lock the same pair of directories concurrently
+ *
+ * The BFL lock is held in either mode, so that the ancestry checked here
+ * can't change until the parents are locked.
  *
  * \retval	1 lock tobj before sobj
  * \retval	0 lock sobj before tobj
@@ -2253,6 +2277,15 @@ static int mdt_rename_determine_lock_order(struct mdt_thread_info *info,
 	if (rc == 1)
 		return 1;
 
+	/* check whether tobj is child of sobj */
+	rc = mdo_is_subdir(info->mti_env, mdt_object_child(tobj),
+			   mdt_object_fid(sobj));
+	if (rc < 0)
+		return rc;
+
+	if (rc == 1)
+		return 0;
+
 	/* check whether sobj and tobj are children of the same parent */
 	rc = mdt_attr_get_pfid(info, sobj, spfid);
 	if (rc)
@@ -2263,7 +2296,7 @@ static int mdt_rename_determine_lock_order(struct mdt_thread_info *info,
 		return rc;
 
 	if (!lu_fid_eq(spfid, tpfid))
-		return 0;
+		goto fid_order;
 
 	/* check whether sobj and tobj are sibling stripes */
 	ma->ma_need = MA_LMV;
@@ -2275,11 +2308,11 @@ static int mdt_rename_determine_lock_order(struct mdt_thread_info *info,
 		return rc;
 
 	if (!(ma->ma_valid & MA_LMV))
-		return 0;
+		goto fid_order;
 
 	lmv = &ma->ma_lmv->lmv_md_v1;
 	if (!(le32_to_cpu(lmv->lmv_magic) & LMV_MAGIC_STRIPE))
-		return 0;
+		goto fid_order;
 	sindex = le32_to_cpu(lmv->lmv_master_mdt_index);
 
 	ma->ma_valid = 0;
@@ -2300,6 +2333,90 @@ static int mdt_rename_determine_lock_order(struct mdt_thread_info *info,
 		return -EINVAL;
 
 	return sindex < tindex ? 0 : 1;
+
+fid_order:
+	return lu_fid_cmp(mdt_object_fid(sobj), mdt_object_fid(tobj)) > 0;
+}
+
+/*
+ * Check whether \a obj is a stripe of a striped directory.
+ *
+ * \retval	1 obj is a stripe
+ * \retval	0 obj is not a stripe
+ * \retval	-ev negative errno upon error
+ */
+static int mdt_rename_parent_is_stripe(struct mdt_thread_info *info,
+				       struct mdt_object *obj)
+{
+	struct md_attr *ma = &info->mti_attr;
+	int rc;
+
+	ma->ma_need = MA_LMV;
+	ma->ma_valid = 0;
+	ma->ma_lmv = (union lmv_mds_md *)info->mti_xattr_buf;
+	ma->ma_lmv_size = sizeof(info->mti_xattr_buf);
+	rc = mdt_stripe_get(info, obj, ma, XATTR_NAME_LMV);
+	if (rc)
+		return rc;
+
+	return (ma->ma_valid & MA_LMV) &&
+	       (le32_to_cpu(ma->ma_lmv->lmv_md_v1.lmv_magic) &
+		LMV_MAGIC_STRIPE);
+}
+
+/*
+ * Check whether a cross-directory rename needs the BFL lock in exclusive mode.
+ *
+ * Only moving a directory to another parent can create a loop in the
+ * namespace.  Other cross-directory renames take the BFL lock in shared
+ * mode, so that they run concurrently while no directory is moved under
+ * them.  Renames between stripes are kept exclusive, because other
+ * operations lock sibling stripes in stripe index order.
+ * This is checked before any lock is taken, because the BFL lock must be
+ * taken first; whether the source is a directory is checked again once the
+ * parents are locked.
+ *
+ * \retval	1 BFL lock is needed in exclusive mode
+ * \retval	0 BFL lock is needed in shared mode
+ * \retval	-ev negative errno upon error
+ */
+static int mdt_rename_need_bfl(struct mdt_thread_info *info,
+			       struct mdt_object *msrcdir,
+			       struct mdt_object *mtgtdir,
+			       const struct lu_name *lname)
+{
+	struct lu_fid *fid = &info->mti_tmp_fid1;
+	struct mdt_object *mobj;
+	int rc;
+
+	rc = mdt_rename_parent_is_stripe(info, msrcdir);
+	if (rc)
+		return rc;
+
+	rc = mdt_rename_parent_is_stripe(info, mtgtdir);
+	if (rc)
+		return rc;
+
+	fid_zero(fid);
+	rc = mdo_lookup(info->mti_env, mdt_object_child(msrcdir), lname, fid,
+			&info->mti_spec);
+	if (rc == -ENOENT)
+		return 0;
+	if (rc == -EREMOTE)
+		return 1;
+	if (rc)
+		return rc;
+
+	mobj = mdt_object_find(info->mti_env, info->mti_mdt, fid);
+	if (IS_ERR(mobj))
+		return PTR_ERR(mobj);
+
+	rc = mdt_object_remote(mobj) ||
+	     (mdt_object_exists(mobj) &&
+	      S_ISDIR(lu_object_attr(&mobj->mot_obj)));
+	mdt_object_put(info->mti_env, mobj);
+
+	return rc;
 }
 
 /*
@@ -2319,6 +2436,7 @@ static int mdt_reint_rename(struct mdt_thread_info *info,
 	struct mdt_object *mold;
 	struct mdt_object *mnew = NULL;
 	struct lustre_handle rename_lh = { 0 };
+	enum ldlm_mode rename_mode = LCK_MINMODE;
 	struct mdt_lock_handle *lh_srcdirp;
 	struct mdt_lock_handle *lh_tgtdirp;
 	struct mdt_lock_handle *lh_oldp = NULL;
@@ -2377,7 +2495,21 @@ static int mdt_reint_rename(struct mdt_thread_info *info,
 		    mdt_object_remote(msrcdir))
 			GOTO(out_put_tgtdir, rc = -EXDEV);
 
-		rc = mdt_rename_lock(info, &rename_lh);
+		/* Renames within a directory can't create a loop, so they
+		 * only need the parent locks below, and renames of files
+		 * between directories only share the BFL lock. */
+		if (msrcdir != mtgtdir) {
+			rc = mdt_rename_need_bfl(info, msrcdir, mtgtdir,
+						 &rr->rr_name);
+			if (rc < 0)
+				GOTO(out_put_tgtdir, rc);
+			rename_mode = rc > 0 ? LCK_EX : LCK_PR;
+		}
+	}
+
+lock_rename:
+	if (rename_mode != LCK_MINMODE) {
+		rc = mdt_rename_lock(info, &rename_lh, rename_mode);
 		if (rc != 0) {
 			CERROR("%s: can't lock FS for rename: rc = %d\n",
 			       mdt_obd_name(mdt), rc);
@@ -2476,9 +2608,27 @@ relock:
 	if (mdt_object_remote(mold) && !mdt->mdt_enable_remote_rename)
 		GOTO(out_put_old, rc = -EXDEV);
 
+	/* The source was replaced by a directory since it was checked
+	 * unlocked; the BFL lock has to be taken in exclusive mode before
+	 * the parent locks, so drop all of them and start over. */
+	if (rename_mode == LCK_PR &&
+	    (mdt_object_remote(mold) ||
+	     S_ISDIR(lu_object_attr(&mold->mot_obj)))) {
+		mdt_object_put(info->mti_env, mold);
+		mdt_object_unlock(info, mtgtdir, lh_tgtdirp, -EAGAIN);
+		mdt_object_unlock(info, msrcdir, lh_srcdirp, -EAGAIN);
+		mdt_rename_unlock(&rename_lh, rename_mode);
+		rename_lh.cookie = 0;
+		rename_mode = LCK_EX;
+		goto lock_rename;
+	}
+
 	/* Check if @mtgtdir is subdir of @mold, before locking child
-	 * to avoid reverse locking. */
-	if (mtgtdir != msrcdir) {
+	 * to avoid reverse locking.  Only a directory can be an ancestor,
+	 * and only a directory may replace one. */
+	if (mtgtdir != msrcdir &&
+	    (mdt_object_remote(mold) ||
+	     S_ISDIR(lu_object_attr(&mold->mot_obj)))) {
 		rc = mdo_is_subdir(info->mti_env, mdt_object_child(mtgtdir),
 				   old_fid);
 		if (rc) {
@@ -2572,7 +2722,8 @@ relock:
 
 		/* Check if @msrcdir is subdir of @mnew, before locking child
 		 * to avoid reverse locking. */
-		if (mtgtdir != msrcdir) {
+		if (mtgtdir != msrcdir &&
+		    S_ISDIR(lu_object_attr(&mnew->mot_obj))) {
 			rc = mdo_is_subdir(info->mti_env,
 					   mdt_object_child(msrcdir), new_fid);
 			if (rc) {
@@ -2669,7 +2820,7 @@ out_unlock_parents:
 	mdt_object_unlock(info, msrcdir, lh_srcdirp, rc);
 out_unlock_rename:
 	if (lustre_handle_is_used(&rename_lh))
-		mdt_rename_unlock(&rename_lh);
+		mdt_rename_unlock(&rename_lh, rename_mode);
 out_put_tgtdir:
 	mdt_object_put(info->mti_env, mtgtdir);
 out_put_srcdir:
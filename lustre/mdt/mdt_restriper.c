@@ -0,0 +1,682 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * lustre/mdt/mdt_restriper.c
+ *
+ * Directory auto split.
+ *
+ * A plain directory whose size crosses mdt_dir_split_count after a create is
+ * queued, and the restriper thread splits it in the background:
+ *  1. split the directory in place to a striped directory of
+ *     mdt_dir_split_delta + 1 target stripes on different MDTs plus a local
+ *     source stripe, the directory keeps its FID, and the source stripe
+ *     accesses the names left in the index of the master, the same layout as
+ *     an unfinished 'lfs migrate -m', see lod_dir_declare_layout_split().
+ *  2. migrate the entries in the source stripe to the target stripes they
+ *     hash to, files are moved to the MDTs of the target stripes, sub
+ *     directories and files which can't be migrated have only their names
+ *     moved.
+ *  3. shrink the layout to drop the emptied source stripe.
+ * Clients keep using the directory meanwhile, because LMV looks up and
+ * creates names in a migrating directory in both source and target stripes.
+ */
+
+#define DEBUG_SUBSYSTEM S_MDS
+
+#include <linux/kthread.h>
+#include <obd_support.h>
+#include <lustre_fid.h>
+#include <lustre_lmv.h>
+#include "mdt_internal.h"
+
+/* max count of directories waiting to be split */
+#define MDT_RESTRIPE_QUEUE_MAX	64
+/* max count of names collected in one scan of the source stripe */
+#define MDT_RESTRIPE_BATCH	64
+
+struct mdt_restripe_item {
+	struct list_head	mri_list;
+	struct lu_fid		mri_fid;
+};
+
+/**
+ * Queue \a pobj to split if it's large enough, called after a name is
+ * inserted into it.
+ *
+ * Directory size is not less than its entry count on both ldiskfs and ZFS, so
+ * it's used as a cheap check here, and the restriper thread counts entries
+ * before the split. mot_split_size is doubled each time, so that a directory
+ * below the threshold is not scanned again on every create.
+ *
+ * \param[in] info	mdt thread info
+ * \param[in] pobj	parent directory
+ */
+void mdt_auto_split_check(struct mdt_thread_info *info,
+			  struct mdt_object *pobj)
+{
+	struct mdt_device *mdt = info->mti_mdt;
+	struct mdt_dir_restriper *mdr = &mdt->mdt_restriper;
+	struct lu_attr *la = &info->mti_attr2.ma_attr;
+	struct mdt_restripe_item *mri;
+
+	/* replayed creates must not restripe directories under recovery */
+	if (!mdt->mdt_enable_dir_auto_split ||
+	    mdt2obd_dev(mdt)->obd_recovering || mdt_object_remote(pobj) ||
+	    !fid_is_norm(mdt_object_fid(pobj)))
+		return;
+
+	if (dt_attr_get(info->mti_env, mdt_obj2dt(pobj), la))
+		return;
+
+	if (la->la_size < mdt->mdt_dir_split_count ||
+	    la->la_size < READ_ONCE(pobj->mot_split_size))
+		return;
+
+	WRITE_ONCE(pobj->mot_split_size, la->la_size * 2);
+
+	OBD_ALLOC_PTR(mri);
+	if (!mri)
+		return;
+
+	mri->mri_fid = *mdt_object_fid(pobj);
+
+	spin_lock(&mdr->mdr_lock);
+	if (!mdr->mdr_task || mdr->mdr_queued >= MDT_RESTRIPE_QUEUE_MAX) {
+		spin_unlock(&mdr->mdr_lock);
+		OBD_FREE_PTR(mri);
+		return;
+	}
+	list_add_tail(&mri->mri_list, &mdr->mdr_list);
+	mdr->mdr_queued++;
+	wake_up_process(mdr->mdr_task);
+	spin_unlock(&mdr->mdr_lock);
+}
+
+/* reset fields used by reint handlers, see mdt_thread_info_init() */
+static void mdt_restripe_info_init(struct mdt_thread_info *info)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(info->mti_lh); i++)
+		mdt_lock_handle_init(&info->mti_lh[i]);
+
+	memset(&info->mti_attr, 0, sizeof(info->mti_attr));
+	memset(&info->mti_spec, 0, sizeof(info->mti_spec));
+	memset(&info->mti_rr, 0, sizeof(info->mti_rr));
+	info->mti_has_trans = 0;
+	info->mti_cross_ref = 0;
+	info->mti_big_lmm_used = 0;
+
+	info->mti_attr.ma_attr.la_ctime = ktime_get_real_seconds();
+	info->mti_attr.ma_attr.la_mtime = info->mti_attr.ma_attr.la_ctime;
+	info->mti_attr.ma_attr.la_valid = LA_CTIME | LA_MTIME;
+}
+
+/* whether \a name is the name of a stripe of \a lmv in the master index */
+static bool mdt_restripe_is_stripe(const struct lmv_mds_md_v1 *lmv,
+				   const char *name, int namelen)
+{
+	char stripe_name[FID_LEN + 12];
+	struct lu_fid fid;
+	int len;
+	int i;
+
+	if (!lmv || name[0] != '[')
+		return false;
+
+	for (i = 0; i < le32_to_cpu(lmv->lmv_stripe_count); i++) {
+		fid_le_to_cpu(&fid, &lmv->lmv_stripe_fids[i]);
+		len = snprintf(stripe_name, sizeof(stripe_name), DFID":%d",
+			       PFID(&fid), i);
+		if (len == namelen && !strncmp(stripe_name, name, len))
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * Scan directory \a fid on this MDT, and save the names in it.
+ *
+ * \param[in] env	execution environment
+ * \param[in] mdt	mdt device
+ * \param[in] fid	directory FID
+ * \param[in] lmv	LMV of \a fid if it's striped, whose stripe names are
+ *			skipped
+ * \param[out] names	buffer of \a max names, each NAME_MAX + 1 long, or
+ *			NULL to count names only
+ * \param[in] max	max count of names to scan
+ *
+ * \retval		count of names, which doesn't exceed \a max
+ * \retval		-errno on failure
+ */
+static int mdt_restripe_names(const struct lu_env *env, struct mdt_device *mdt,
+			      const struct lu_fid *fid,
+			      const struct lmv_mds_md_v1 *lmv,
+			      char *names, int max)
+{
+	const struct dt_it_ops *iops;
+	struct dt_object *obj;
+	struct dt_it *it;
+	int count = 0;
+	int rc;
+
+	obj = dt_locate(env, mdt->mdt_bottom, fid);
+	if (IS_ERR(obj))
+		return PTR_ERR(obj);
+
+	if (!dt_try_as_dir(env, obj))
+		GOTO(put, rc = -ENOTDIR);
+
+	iops = &obj->do_index_ops->dio_it;
+	it = iops->init(env, obj, LUDA_64BITHASH);
+	if (IS_ERR(it))
+		GOTO(put, rc = PTR_ERR(it));
+
+	rc = iops->get(env, it, (const struct dt_key *)"");
+	if (rc > 0)
+		rc = iops->next(env, it);
+	else if (rc == 0)
+		rc = 1;
+
+	while (rc == 0 && count < max) {
+		const char *key = (const char *)iops->key(env, it);
+		int len = iops->key_size(env, it);
+
+		if (len > 0 && len <= NAME_MAX &&
+		    !(key[0] == '.' &&
+		      (len == 1 || (len == 2 && key[1] == '.'))) &&
+		    !mdt_restripe_is_stripe(lmv, key, len)) {
+			if (names) {
+				char *name = names + count * (NAME_MAX + 1);
+
+				memcpy(name, key, len);
+				name[len] = '\0';
+			}
+			count++;
+		}
+
+		rc = iops->next(env, it);
+	}
+
+	iops->put(env, it);
+	iops->fini(env, it);
+
+	if (rc >= 0)
+		rc = count;
+put:
+	dt_object_put(env, obj);
+
+	return rc;
+}
+
+/* split plain directory \a obj in place with the layout of \a lmu */
+static int mdt_restripe_split(struct mdt_thread_info *info,
+			      struct mdt_object *obj, struct lmv_user_md *lmu)
+{
+	struct md_attr *ma = &info->mti_attr;
+	struct mdt_lock_handle *lh = &info->mti_lh[MDT_LH_PARENT];
+	struct lu_buf *buf = &info->mti_buf;
+	int rc;
+
+	/* revoke all client locks, clients will fetch the new layout */
+	mdt_lock_reg_init(lh, LCK_EX);
+	rc = mdt_reint_object_lock(info, obj, lh, MDS_INODELOCK_FULL, true);
+	if (rc)
+		return rc;
+
+	ma->ma_lmv = info->mti_big_lmm;
+	ma->ma_lmv_size = info->mti_big_lmmsize;
+	ma->ma_valid = 0;
+	rc = mdt_stripe_get(info, obj, ma, XATTR_NAME_LMV);
+	if (!rc && ma->ma_valid & MA_LMV)
+		rc = -EALREADY;
+
+	if (!rc) {
+		buf->lb_buf = lmu;
+		buf->lb_len = sizeof(*lmu);
+		rc = mo_xattr_set(info->mti_env, mdt_object_child(obj), buf,
+				  XATTR_NAME_LMV".split", 0);
+	}
+	mdt_object_unlock(info, obj, lh, rc);
+
+	return rc;
+}
+
+/*
+ * move name \a name in directory \a fid being split to the target stripe it
+ * hashes to, \a mdts are the MDT indices of the target stripes.
+ */
+static int mdt_restripe_entry(struct mdt_thread_info *info,
+			      struct mdt_object *obj,
+			      const struct lmv_mds_md_v1 *lmv, const __u32 *mdts,
+			      struct md_op_data *op_data, const char *name)
+{
+	const struct lu_env *env = info->mti_env;
+	struct mdt_device *mdt = info->mti_mdt;
+	struct mdt_reint_record *rr = &info->mti_rr;
+	struct lu_fid *cfid = &info->mti_tmp_fid1;
+	struct lu_fid *tfid = &info->mti_tmp_fid2;
+	struct lu_name lname = { .ln_name = name,
+				 .ln_namelen = strlen(name) };
+	struct mdt_object *child;
+	bool nsonly = true;
+	int index;
+	int rc;
+
+	mdt_restripe_info_init(info);
+	rc = mdo_lookup(env, mdt_object_child(obj), &lname, cfid,
+			&info->mti_spec);
+	if (rc)
+		return rc;
+
+	child = mdt_object_find(env, mdt, cfid);
+	if (IS_ERR(child))
+		return PTR_ERR(child);
+
+	/* sub directories are moved like 'lfs migrate -m -d' */
+	if (mdt_object_exists(child) &&
+	    !S_ISDIR(lu_object_attr(&child->mot_obj))) {
+		index = lmv_name_to_stripe_index(le32_to_cpu(lmv->lmv_hash_type),
+				le32_to_cpu(lmv->lmv_migrate_offset),
+				lname.ln_name, lname.ln_namelen);
+		if (index >= 0) {
+			op_data->op_mds = mdts[index];
+			rc = obd_fid_alloc(env, mdt->mdt_child_exp, tfid,
+					   op_data);
+			nsonly = rc < 0;
+		}
+	}
+	mdt_object_put(env, child);
+
+again:
+	mdt_restripe_info_init(info);
+	rr->rr_fid1 = mdt_object_fid(obj);
+	rr->rr_fid2 = nsonly ? mdt_object_fid(obj) : tfid;
+	rr->rr_name = lname;
+	info->mti_spec.sp_migrate_nsonly = nsonly;
+	rc = mdt_reint_migrate(info, NULL);
+	/* open, DoM or HSM files can't be migrated, just move the name */
+	if (rc && rc != -EALREADY && rc != -ENOENT && !nsonly) {
+		nsonly = true;
+		goto again;
+	}
+
+	return rc;
+}
+
+/*
+ * move the names left in the index of directory \a obj, which is being split,
+ * to its target stripes, the stripe names in the index are skipped.
+ */
+static int mdt_restripe_entries(struct mdt_thread_info *info,
+				struct mdt_object *obj)
+{
+	const struct lu_env *env = info->mti_env;
+	struct mdt_device *mdt = info->mti_mdt;
+	struct md_attr *ma = &info->mti_attr;
+	struct lu_seq_range range;
+	struct md_op_data *op_data = NULL;
+	struct lmv_mds_md_v1 *lmv = NULL;
+	struct lu_fid fid;
+	__u32 *mdts = NULL;
+	__u32 offset = 0;
+	char *names;
+	char *name;
+	int lmv_size = 0;
+	int moved;
+	int count;
+	int rc;
+	int i;
+
+	OBD_ALLOC_LARGE(names, MDT_RESTRIPE_BATCH * (NAME_MAX + 1));
+	if (!names)
+		return -ENOMEM;
+
+	/* mti_big_lmm is reused by migration, keep a copy of LMV */
+	ma->ma_lmv = info->mti_big_lmm;
+	ma->ma_lmv_size = info->mti_big_lmmsize;
+	ma->ma_valid = 0;
+	rc = mdt_stripe_get(info, obj, ma, XATTR_NAME_LMV);
+	if (rc)
+		GOTO(out, rc);
+
+	if (!(ma->ma_valid & MA_LMV) ||
+	    le32_to_cpu(ma->ma_lmv->lmv_md_v1.lmv_magic) != LMV_MAGIC_V1 ||
+	    !(le32_to_cpu(ma->ma_lmv->lmv_md_v1.lmv_hash_type) &
+	      LMV_HASH_FLAG_SPLIT))
+		GOTO(out, rc = -EINVAL);
+
+	lmv_size = ma->ma_lmv_size;
+	OBD_ALLOC_LARGE(lmv, lmv_size);
+	OBD_ALLOC_PTR(op_data);
+	offset = le32_to_cpu(ma->ma_lmv->lmv_md_v1.lmv_migrate_offset);
+	OBD_ALLOC(mdts, sizeof(*mdts) * offset);
+	if (!lmv || !op_data || !mdts)
+		GOTO(out, rc = -ENOMEM);
+
+	memcpy(lmv, ma->ma_lmv, lmv_size);
+	for (i = 0; i < offset; i++) {
+		fid_le_to_cpu(&fid, &lmv->lmv_stripe_fids[i]);
+		fld_range_set_mdt(&range);
+		rc = fld_server_lookup(env, mdt_seq_site(mdt)->ss_server_fld,
+				       fid_seq(&fid), &range);
+		if (rc)
+			GOTO(out, rc);
+		mdts[i] = range.lsr_index;
+	}
+
+	do {
+		count = mdt_restripe_names(env, mdt, mdt_object_fid(obj), lmv,
+					   names, MDT_RESTRIPE_BATCH);
+		if (count <= 0) {
+			rc = count;
+			break;
+		}
+
+		moved = 0;
+		for (i = 0; i < count; i++) {
+			if (kthread_should_stop())
+				GOTO(out, rc = -ESHUTDOWN);
+
+			if (moved > 0 &&
+			    OBD_FAIL_CHECK(OBD_FAIL_MIGRATE_SPLIT_STOP))
+				GOTO(out, rc = -EINTR);
+
+			name = names + i * (NAME_MAX + 1);
+			rc = mdt_restripe_entry(info, obj, lmv, mdts, op_data,
+						name);
+			/* name may be moved or removed by others */
+			if (!rc || rc == -EALREADY || rc == -ENOENT)
+				moved++;
+			else
+				CDEBUG(D_INFO, "%s: move "DFID"/%s failed: "
+				       "rc = %d\n", mdt_obd_name(mdt),
+				       PFID(mdt_object_fid(obj)), name, rc);
+			cond_resched();
+		}
+		/* stop if no progress, or it would loop forever */
+	} while (moved > 0);
+out:
+	if (mdts)
+		OBD_FREE(mdts, sizeof(*mdts) * offset);
+	if (op_data)
+		OBD_FREE_PTR(op_data);
+	if (lmv)
+		OBD_FREE_LARGE(lmv, lmv_size);
+	OBD_FREE_LARGE(names, MDT_RESTRIPE_BATCH * (NAME_MAX + 1));
+
+	return rc;
+}
+
+/* split directory \a fid if it has more than mdt_dir_split_count entries */
+static int mdt_auto_split(struct mdt_thread_info *info,
+			  const struct lu_fid *fid)
+{
+	const struct lu_env *env = info->mti_env;
+	struct mdt_device *mdt = info->mti_mdt;
+	struct mdt_dir_restriper *mdr = &mdt->mdt_restriper;
+	struct lmv_user_md *lmu = &mdr->mdr_lmu;
+	struct mdt_reint_record *rr = &info->mti_rr;
+	struct md_attr *ma = &info->mti_attr;
+	struct mdt_object *obj;
+	__u32 stripe_count = mdt->mdt_dir_split_delta + 1;
+	int rc;
+
+	ENTRY;
+
+	obj = mdt_object_find(env, mdt, fid);
+	if (IS_ERR(obj))
+		RETURN(PTR_ERR(obj));
+
+	if (!mdt_object_exists(obj) || mdt_object_remote(obj) ||
+	    !S_ISDIR(lu_object_attr(&obj->mot_obj)))
+		GOTO(out, rc = 0);
+
+	mdt_restripe_info_init(info);
+	ma->ma_lmv = info->mti_big_lmm;
+	ma->ma_lmv_size = info->mti_big_lmmsize;
+	rc = mdt_stripe_get(info, obj, ma, XATTR_NAME_LMV);
+	if (rc)
+		GOTO(out, rc);
+
+	/* striped directory or stripe, never check it again */
+	if (ma->ma_valid & MA_LMV) {
+		WRITE_ONCE(obj->mot_split_size, U64_MAX);
+		GOTO(out, rc = 0);
+	}
+
+	rc = mdt_restripe_names(env, mdt, fid, NULL, NULL,
+				mdt->mdt_dir_split_count);
+	if (rc < 0)
+		GOTO(out, rc);
+
+	if (rc < mdt->mdt_dir_split_count)
+		GOTO(out, rc = 0);
+
+	memset(lmu, 0, sizeof(*lmu));
+	lmu->lum_magic = cpu_to_le32(LMV_USER_MAGIC);
+	lmu->lum_stripe_count = cpu_to_le32(stripe_count);
+	lmu->lum_stripe_offset = cpu_to_le32(mdt_seq_site(mdt)->ss_node_id);
+	lmu->lum_hash_type = cpu_to_le32(LMV_HASH_TYPE_FNV_1A_64);
+
+	CDEBUG(D_INFO, "%s: split "DFID" to %u stripes\n", mdt_obd_name(mdt),
+	       PFID(fid), stripe_count);
+
+	mdt_restripe_info_init(info);
+	rc = mdt_restripe_split(info, obj, lmu);
+	if (rc == -EALREADY || rc == -ENOSPC)
+		GOTO(out, rc = 0);
+	if (rc)
+		GOTO(out, rc);
+
+	rc = mdt_restripe_entries(info, obj);
+	if (!rc) {
+		/* lod may have allocated fewer stripes than asked */
+		ma->ma_lmv = info->mti_big_lmm;
+		ma->ma_lmv_size = info->mti_big_lmmsize;
+		ma->ma_valid = 0;
+		rc = mdt_stripe_get(info, obj, ma, XATTR_NAME_LMV);
+		if (!rc && !(ma->ma_valid & MA_LMV))
+			rc = -ENODATA;
+	}
+	if (!rc) {
+		stripe_count =
+			le32_to_cpu(ma->ma_lmv->lmv_md_v1.lmv_migrate_offset);
+		lmu->lum_stripe_count = cpu_to_le32(stripe_count);
+
+		mdt_restripe_info_init(info);
+		rr->rr_fid1 = fid;
+		rr->rr_eadata = lmu;
+		rr->rr_eadatalen = sizeof(*lmu);
+		rc = mdt_dir_layout_shrink(info);
+	}
+	if (rc)
+		CERROR("%s: split of "DFID" was interrupted, run 'lfs migrate "
+		       "-m %u -c %u -H "LMV_HASH_NAME_FNV_1A_64"' on it to "
+		       "finish: rc = %d\n", mdt_obd_name(mdt), PFID(fid),
+		       mdt_seq_site(mdt)->ss_node_id, stripe_count, rc);
+	EXIT;
+out:
+	mdt_object_put(env, obj);
+
+	return rc;
+}
+
+static int mdt_restriper_main(void *args)
+{
+	struct mdt_thread_info *info = args;
+	struct mdt_dir_restriper *mdr = &info->mti_mdt->mdt_restriper;
+	struct mdt_restripe_item *mri;
+	int rc;
+
+	ENTRY;
+
+	while (1) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (kthread_should_stop())
+			break;
+
+		spin_lock(&mdr->mdr_lock);
+		mri = list_first_entry_or_null(&mdr->mdr_list,
+					       struct mdt_restripe_item,
+					       mri_list);
+		if (mri) {
+			list_del(&mri->mri_list);
+			mdr->mdr_queued--;
+		}
+		spin_unlock(&mdr->mdr_lock);
+
+		if (!mri) {
+			schedule();
+			continue;
+		}
+		__set_current_state(TASK_RUNNING);
+
+		rc = mdt_auto_split(info, &mri->mri_fid);
+		if (rc)
+			CDEBUG(D_INFO, "%s: split "DFID" failed: rc = %d\n",
+			       mdt_obd_name(info->mti_mdt),
+			       PFID(&mri->mri_fid), rc);
+		OBD_FREE_PTR(mri);
+	}
+	__set_current_state(TASK_RUNNING);
+
+	RETURN(0);
+}
+
+/**
+ * Initialize directory restriper, which is started once recovery is done.
+ *
+ * \param[in] mdt	mdt device
+ */
+void mdt_restriper_init(struct mdt_device *mdt)
+{
+	struct mdt_dir_restriper *mdr = &mdt->mdt_restriper;
+
+	spin_lock_init(&mdr->mdr_lock);
+	INIT_LIST_HEAD(&mdr->mdr_list);
+	mdr->mdr_queued = 0;
+	mdr->mdr_task = NULL;
+}
+
+/**
+ * Start directory restriper thread, which splits directories queued by
+ * mdt_auto_split_check(). It's started after recovery, so that directories
+ * are not restriped while requests are replayed.
+ *
+ * \param[in] mdt	mdt device
+ *
+ * \retval		0 on success
+ * \retval		-errno on failure
+ */
+int mdt_restriper_start(struct mdt_device *mdt)
+{
+	struct mdt_dir_restriper *mdr = &mdt->mdt_restriper;
+	struct mdt_thread_info *info;
+	struct task_struct *task;
+	int rc;
+
+	ENTRY;
+
+	if (mdt->mdt_bottom->dd_rdonly || mdr->mdr_task)
+		RETURN(0);
+
+	rc = lu_env_init(&mdr->mdr_env, LCT_MD_THREAD);
+	if (rc < 0)
+		RETURN(rc);
+
+	rc = lu_context_init(&mdr->mdr_session, LCT_SERVER_SESSION);
+	if (rc < 0)
+		GOTO(fini_env, rc);
+
+	lu_context_enter(&mdr->mdr_session);
+	mdr->mdr_env.le_ses = &mdr->mdr_session;
+
+	info = lu_context_key_get(&mdr->mdr_env.le_ctx, &mdt_thread_key);
+	LASSERT(info != NULL);
+
+	info->mti_env = &mdr->mdr_env;
+	info->mti_mdt = mdt;
+	hsm_init_ucred(mdt_ucred(info));
+
+	info->mti_big_lmmsize = lmv_mds_md_size(64, LMV_MAGIC);
+	OBD_ALLOC_LARGE(info->mti_big_lmm, info->mti_big_lmmsize);
+	if (!info->mti_big_lmm)
+		GOTO(fini_session, rc = -ENOMEM);
+
+	task = kthread_run(mdt_restriper_main, info, "mdt_restriper_%u",
+			   mdt_seq_site(mdt)->ss_node_id);
+	if (IS_ERR(task)) {
+		rc = PTR_ERR(task);
+		CERROR("%s: error starting restriper thread: rc = %d\n",
+		       mdt_obd_name(mdt), rc);
+		GOTO(fini_session, rc);
+	}
+
+	spin_lock(&mdr->mdr_lock);
+	mdr->mdr_task = task;
+	spin_unlock(&mdr->mdr_lock);
+
+	RETURN(0);
+
+fini_session:
+	lu_context_exit(&mdr->mdr_session);
+	lu_context_fini(&mdr->mdr_session);
+fini_env:
+	lu_env_fini(&mdr->mdr_env);
+
+	return rc;
+}
+
+/**
+ * Stop directory restriper thread, directories in queue are dropped.
+ *
+ * \param[in] mdt	mdt device
+ */
+void mdt_restriper_stop(struct mdt_device *mdt)
+{
+	struct mdt_dir_restriper *mdr = &mdt->mdt_restriper;
+	struct mdt_restripe_item *mri;
+	struct mdt_restripe_item *tmp;
+	struct task_struct *task;
+
+	spin_lock(&mdr->mdr_lock);
+	task = mdr->mdr_task;
+	mdr->mdr_task = NULL;
+	spin_unlock(&mdr->mdr_lock);
+
+	if (!task)
+		return;
+
+	kthread_stop(task);
+
+	list_for_each_entry_safe(mri, tmp, &mdr->mdr_list, mri_list) {
+		list_del(&mri->mri_list);
+		OBD_FREE_PTR(mri);
+	}
+	mdr->mdr_queued = 0;
+
+	lu_context_exit(&mdr->mdr_session);
+	lu_context_fini(&mdr->mdr_session);
+	lu_env_fini(&mdr->mdr_env);
+}
@@ -317,7 +317,7 @@ out:
 }
 
 /* shrink dir layout after migration */
-static int mdt_dir_layout_shrink(struct mdt_thread_info *info)
+int mdt_dir_layout_shrink(struct mdt_thread_info *info)
 {
 	const struct lu_env *env = info->mti_env;
 	struct mdt_device *mdt = info->mti_mdt;
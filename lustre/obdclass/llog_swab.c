@@ -221,6 +221,22 @@ void lustre_swab_llog_rec(struct llog_rec_hdr *rec)
 		break;
 	}
 
+	case CHANGELOG_USER_REC2:
+	{
+		struct llog_changelog_user_rec2 *cur =
+			(struct llog_changelog_user_rec2 *)rec;
+
+		__swab32s(&cur->cur_id);
+		__swab64s(&cur->cur_endrec);
+		__swab32s(&cur->cur_time);
+		__swab32s(&cur->cur_filter.cuf_mask);
+		__swab32s(&cur->cur_filter.cuf_flags);
+		__swab32s(&cur->cur_filter.cuf_projid);
+		lustre_swab_lu_fid(&cur->cur_filter.cuf_pfid);
+		tail = &cur->cur_tail;
+		break;
+	}
+
 	case HSM_AGENT_REC: {
 		struct llog_agent_req_rec *arr =
 			(struct llog_agent_req_rec *)rec;
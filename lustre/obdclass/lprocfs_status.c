@@ -780,6 +780,7 @@ static const char *obd_connect_names[] = {
 	"crush",		/* 0x2000 */
 	"async_discard",	/* 0x4000 */
 	"client_encryption",	/* 0x8000 */
+	"destroy_batch",	/* 0x10000 */
 	NULL
 };
 
@@ -1747,6 +1747,56 @@ out_sem:
 	return rc;
 }
 
+/**
+ * Handle OST_DESTROY request carrying an array of objects.
+ *
+ * The array is sent by the MDT sync thread when OBD_CONNECT2_DESTROY_BATCH
+ * is negotiated, the number of leading objects which are gone is returned
+ * in o_misc of the reply, so the MDT can cancel their llog records.
+ *
+ * \param[in] tsi	target session environment for this request
+ * \param[in] repbody	reply OST body
+ *
+ * \retval		0 if successful
+ * \retval		negative value on error
+ */
+static int ofd_destroy_batch_hdl(struct tgt_session_info *tsi,
+				 struct ost_body *repbody)
+{
+	struct req_capsule *pill = tsi->tsi_pill;
+	struct ofd_device *ofd = ofd_exp(tsi->tsi_exp);
+	const struct ost_id *oids;
+	int processed = 0;
+	int count;
+	int rc;
+
+	ENTRY;
+
+	oids = req_capsule_client_get(pill, &RMF_OST_ID_ARRAY);
+	count = req_capsule_get_size(pill, &RMF_OST_ID_ARRAY, RCL_CLIENT) /
+		sizeof(*oids);
+	if (oids == NULL || count <= 0 || count > OST_DESTROY_BATCH_MAX)
+		RETURN(-EPROTO);
+
+	CDEBUG(D_HA, "%s: Destroy %d objects from "DOSTID"\n", ofd_name(ofd),
+	       count, POSTID(&oids[0]));
+
+	/* each group of objects has its own transaction */
+	if (!req_is_replay(tgt_ses_req(tsi)))
+		tgt_mult_trans_enable(tsi->tsi_env);
+
+	rc = ofd_destroy_batch(tsi->tsi_env, ofd, oids, count, &processed);
+
+	ofd_counter_incr(tsi->tsi_exp, LPROC_OFD_STATS_DESTROY,
+			 tsi->tsi_jobid, 1);
+
+	repbody->oa.o_oi = oids[0];
+	repbody->oa.o_misc = processed;
+	repbody->oa.o_valid = OBD_MD_FLGROUP | OBD_MD_FLID | OBD_MD_FLOBJCOUNT;
+
+	RETURN(rc);
+}
+
 /**
  * OFD request handler for OST_DESTROY RPC.
  *
@@ -1792,6 +1842,16 @@ static int ofd_destroy_hdl(struct tgt_session_info *tsi)
 
 	repbody = req_capsule_server_get(tsi->tsi_pill, &RMF_OST_BODY);
 
+	/* array of objects released by the MDT, see osp_sync_batch_send() */
+	if (exp_connect_destroy_batch(tsi->tsi_exp)) {
+		req_capsule_extend(tsi->tsi_pill, &RQF_OST_DESTROY_BATCH);
+		if (req_capsule_field_present(tsi->tsi_pill, &RMF_OST_ID_ARRAY,
+					      RCL_CLIENT)) {
+			rc = ofd_destroy_batch_hdl(tsi, repbody);
+			RETURN(rc);
+		}
+	}
+
 	/* check that o_misc makes sense */
 	if (body->oa.o_valid & OBD_MD_FLOBJCOUNT)
 		count = body->oa.o_misc;
@@ -53,6 +53,9 @@
 
 #define OFD_SOFT_SYNC_LIMIT_DEFAULT 16
 
+/* number of objects of a batched OST_DESTROY sharing one transaction */
+#define OFD_DESTROY_BATCH_TXN		16
+
 /* request stats */
 enum {
 	LPROC_OFD_STATS_READ = 0,
@@ -291,6 +294,8 @@ int ofd_fiemap_get(const struct lu_env *env, struct ofd_device *ofd,
 extern const struct obd_ops ofd_obd_ops;
 int ofd_destroy_by_fid(const struct lu_env *env, struct ofd_device *ofd,
 		       const struct lu_fid *fid, int orphan);
+int ofd_destroy_batch(const struct lu_env *env, struct ofd_device *ofd,
+		      const struct ost_id *oids, int count, int *processed);
 int ofd_statfs(const struct lu_env *env,  struct obd_export *exp,
 	       struct obd_statfs *osfs, time64_t max_age, __u32 flags);
 int ofd_obd_disconnect(struct obd_export *exp);
@@ -369,6 +374,8 @@ int ofd_object_punch(const struct lu_env *env, struct ofd_object *fo,
 		     __u64 start, __u64 end, struct lu_attr *la,
 		     struct obdo *oa);
 int ofd_destroy(const struct lu_env *, struct ofd_object *, int);
+int ofd_destroy_list(const struct lu_env *env, struct ofd_device *ofd,
+		     struct ofd_object **fos, int count, int *destroyed);
 int ofd_attr_get(const struct lu_env *env, struct ofd_object *fo,
 		 struct lu_attr *la);
 int ofd_attr_handle_id(const struct lu_env *env, struct ofd_object *fo,
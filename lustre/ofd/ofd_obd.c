@@ -247,8 +247,12 @@ static int ofd_parse_connect_data(const struct lu_env *env,
 
 	data->ocd_connect_flags &= OST_CONNECT_SUPPORTED;
 
-	if (data->ocd_connect_flags & OBD_CONNECT_FLAGS2)
+	if (data->ocd_connect_flags & OBD_CONNECT_FLAGS2) {
 		data->ocd_connect_flags2 &= OST_CONNECT_SUPPORTED2;
+		/* batched destroy is only sent by the MDT sync thread */
+		if (!(data->ocd_connect_flags & OBD_CONNECT_MDS))
+			data->ocd_connect_flags2 &= ~OBD_CONNECT2_DESTROY_BATCH;
+	}
 
 	/* Kindly make sure the SKIP_ORPHAN flag is from MDS. */
 	if (data->ocd_connect_flags & OBD_CONNECT_MDS)
@@ -970,6 +974,37 @@ out:
 	return rc;
 }
 
+/**
+ * Discard cached data of an object being destroyed.
+ *
+ * Tell the clients that the object is gone now and that they should
+ * throw away any cached pages.
+ *
+ * \param[in] env	execution environment
+ * \param[in] ofd	OFD device
+ * \param[in] fid	FID of object
+ */
+static void ofd_destroy_discard_locks(const struct lu_env *env,
+				      struct ofd_device *ofd,
+				      const struct lu_fid *fid)
+{
+	struct ofd_thread_info *info = ofd_info(env);
+	struct lustre_handle lockh;
+	union ldlm_policy_data policy = { .l_extent = { 0, OBD_OBJECT_EOF } };
+	__u64 flags = LDLM_FL_AST_DISCARD_DATA;
+	int rc;
+
+	ost_fid_build_resid(fid, &info->fti_resid);
+	rc = ldlm_cli_enqueue_local(env, ofd->ofd_namespace, &info->fti_resid,
+				    LDLM_EXTENT, &policy, LCK_PW, &flags,
+				    ldlm_blocking_ast, ldlm_completion_ast,
+				    NULL, NULL, 0, LVB_T_NONE, NULL, &lockh);
+
+	/* We only care about the side-effects, just drop the lock. */
+	if (rc == ELDLM_OK)
+		ldlm_lock_decref(&lockh, LCK_PW);
+}
+
 /**
  * Destroy OFD object by its FID.
  *
@@ -988,11 +1023,7 @@ out:
 int ofd_destroy_by_fid(const struct lu_env *env, struct ofd_device *ofd,
 		       const struct lu_fid *fid, int orphan)
 {
-	struct ofd_thread_info *info = ofd_info(env);
-	struct lustre_handle lockh;
-	union ldlm_policy_data policy = { .l_extent = { 0, OBD_OBJECT_EOF } };
 	struct ofd_object *fo;
-	__u64 flags = LDLM_FL_AST_DISCARD_DATA;
 	__u64 rc = 0;
 
 	ENTRY;
@@ -1001,19 +1032,7 @@ int ofd_destroy_by_fid(const struct lu_env *env, struct ofd_device *ofd,
 	if (IS_ERR(fo))
 		RETURN(PTR_ERR(fo));
 
-	/*
-	 * Tell the clients that the object is gone now and that they should
-	 * throw away any cached pages.
-	 */
-	ost_fid_build_resid(fid, &info->fti_resid);
-	rc = ldlm_cli_enqueue_local(env, ofd->ofd_namespace, &info->fti_resid,
-				    LDLM_EXTENT, &policy, LCK_PW, &flags,
-				    ldlm_blocking_ast, ldlm_completion_ast,
-				    NULL, NULL, 0, LVB_T_NONE, NULL, &lockh);
-
-	/* We only care about the side-effects, just drop the lock. */
-	if (rc == ELDLM_OK)
-		ldlm_lock_decref(&lockh, LCK_PW);
+	ofd_destroy_discard_locks(env, ofd, fid);
 
 	LASSERT(fo != NULL);
 
@@ -1024,6 +1043,105 @@ int ofd_destroy_by_fid(const struct lu_env *env, struct ofd_device *ofd,
 	RETURN(rc);
 }
 
+/**
+ * Destroy an array of OFD objects released by the MDT.
+ *
+ * Serves the batched OST_DESTROY request, see OBD_CONNECT2_DESTROY_BATCH.
+ * Objects are destroyed in groups of OFD_DESTROY_BATCH_TXN sharing one
+ * transaction, the locks of a group are discarded before the transaction
+ * is started. The caller lets the request run several transactions, so the
+ * reply carries the transno of the last group. Missing objects, and invalid
+ * ones which can never be destroyed, are counted as processed and skipped.
+ * Processing stops at the first other error, the MDT sends the rest again.
+ * The error is only returned if nothing was processed, otherwise the MDT
+ * learns from \a processed which records it can cancel once the reply is
+ * committed.
+ *
+ * \param[in] env	execution environment
+ * \param[in] ofd	OFD device
+ * \param[in] oids	array of object IDs
+ * \param[in] count	number of entries in \a oids
+ * \param[out] processed	number of leading \a oids which are gone now
+ *
+ * \retval		0 if any object was processed
+ * \retval		-ENOENT if all \a oids were processed, none destroyed
+ * \retval		negative value on error before any was processed
+ */
+int ofd_destroy_batch(const struct lu_env *env, struct ofd_device *ofd,
+		      const struct ost_id *oids, int count, int *processed)
+{
+	struct ofd_object *fos[OFD_DESTROY_BATCH_TXN];
+	struct lu_fid *fid = &ofd_info(env)->fti_fid;
+	int destroyed = 0;
+	int rc = 0;
+	int i, n;
+
+	ENTRY;
+
+	*processed = 0;
+	while (*processed < count && rc == 0) {
+		int done;
+
+		for (n = 0; n < OFD_DESTROY_BATCH_TXN &&
+			    *processed + n < count; n++) {
+			const struct ost_id *oi = &oids[*processed + n];
+
+			fos[n] = NULL;
+			rc = ofd_validate_seq(ofd_info(env)->fti_exp,
+					      ostid_seq(oi));
+			if (rc == 0)
+				rc = ostid_to_fid(fid, oi,
+					ofd->ofd_lut.lut_lsd.lsd_osd_index);
+			if (rc == 0 && ostid_id(oi) == 0)
+				rc = -EBADF;
+			if (rc != 0) {
+				/* it would fail the same way next time */
+				CERROR("%s: skip invalid object "DOSTID" in destroy batch: rc = %d\n",
+				       ofd_name(ofd), POSTID(oi), rc);
+				rc = 0;
+				continue;
+			}
+
+			fos[n] = ofd_object_find_exists(env, ofd, fid);
+			if (IS_ERR(fos[n])) {
+				rc = PTR_ERR(fos[n]);
+				fos[n] = NULL;
+				if (rc != -ENOENT)
+					break;
+				CDEBUG(D_INODE,
+				       "%s: destroying non-existent object "DFID"\n",
+				       ofd_name(ofd), PFID(fid));
+				rc = 0;
+				continue;
+			}
+			ofd_destroy_discard_locks(env, ofd, fid);
+		}
+
+		if (rc == 0) {
+			rc = ofd_destroy_list(env, ofd, fos, n, &done);
+			if (rc == 0) {
+				destroyed += done;
+				*processed += n;
+			} else {
+				CERROR("%s: error destroying objects from "DOSTID": rc = %d\n",
+				       ofd_name(ofd),
+				       POSTID(&oids[*processed]), rc);
+			}
+		}
+
+		for (i = 0; i < n; i++)
+			if (fos[i] != NULL)
+				ofd_object_put(env, fos[i]);
+	}
+
+	if (*processed == count && destroyed == 0)
+		rc = -ENOENT;
+	else if (*processed > 0)
+		rc = 0;
+
+	RETURN(rc);
+}
+
 /**
  * Implementation of obd_ops::o_destroy.
  *
@@ -944,6 +944,96 @@ out:
 	RETURN(rc);
 }
 
+/**
+ * Destroy a group of OFD objects in a single transaction.
+ *
+ * This is used by the batched OST_DESTROY handler to amortize the journal
+ * commit over several objects released by the MDT sync thread. Objects
+ * which were destroyed by somebody else meanwhile are skipped silently,
+ * same as the NULL entries set by the caller for missing objects. If all of
+ * them are gone, the transaction is aborted so that no transno is assigned,
+ * as the request is then replied with -ENOENT.
+ *
+ * \param[in] env	execution environment
+ * \param[in] ofd	OFD device
+ * \param[in] fos	array of OFD objects, may contain NULL entries
+ * \param[in] count	number of entries in \a fos
+ * \param[out] destroyed	number of objects actually destroyed
+ *
+ * \retval		0 if successful
+ * \retval		negative value on error
+ */
+int ofd_destroy_list(const struct lu_env *env, struct ofd_device *ofd,
+		     struct ofd_object **fos, int count, int *destroyed)
+{
+	struct thandle *th;
+	int aborted = 0;
+	int rc = 0;
+	int rc2;
+	int i;
+
+	ENTRY;
+
+	*destroyed = 0;
+	for (i = 0; i < count; i++)
+		if (fos[i] != NULL && ofd_object_exists(fos[i]))
+			break;
+	if (i == count)
+		RETURN(0);
+
+	th = ofd_trans_create(env, ofd);
+	if (IS_ERR(th))
+		RETURN(PTR_ERR(th));
+
+	for (i = 0; i < count; i++) {
+		if (fos[i] == NULL || !ofd_object_exists(fos[i]))
+			continue;
+
+		rc = dt_declare_ref_del(env, ofd_object_child(fos[i]), th);
+		if (rc < 0)
+			GOTO(stop, rc);
+
+		rc = dt_declare_destroy(env, ofd_object_child(fos[i]), th);
+		if (rc < 0)
+			GOTO(stop, rc);
+	}
+
+	rc = ofd_trans_start(env, ofd, NULL, th);
+	if (rc)
+		GOTO(stop, rc);
+
+	for (i = 0; i < count; i++) {
+		struct ofd_object *fo = fos[i];
+
+		if (fo == NULL)
+			continue;
+
+		ofd_write_lock(env, fo);
+		if (ofd_object_exists(fo)) {
+			tgt_fmd_drop(ofd_info(env)->fti_exp,
+				     &fo->ofo_header.loh_fid);
+			dt_ref_del(env, ofd_object_child(fo), th);
+			dt_destroy(env, ofd_object_child(fo), th);
+			(*destroyed)++;
+		}
+		ofd_write_unlock(env, fo);
+	}
+
+	/* nothing changed, abort not to assign a transno */
+	if (*destroyed == 0)
+		aborted = -ENOENT;
+stop:
+	rc2 = ofd_trans_stop(env, ofd, th, rc != 0 ? rc : aborted);
+	if (rc2)
+		CERROR("%s failed to stop transaction: %d\n",
+		       ofd_name(ofd), rc2);
+	if (!rc)
+		rc = rc2;
+	if (rc)
+		*destroyed = 0;
+	RETURN(rc);
+}
+
 /**
  * Get OFD object attributes.
  *
@@ -6440,6 +6440,9 @@ static struct dt_it *osd_it_ea_init(const struct lu_env *env,
 	oie->oie_rd_dirent       = 0;
 	oie->oie_it_dirent       = 0;
 	oie->oie_dirent          = NULL;
+	oie->oie_ra_block	 = 0;
+	/* LFSCK scans the whole directory, read its blocks in advance. */
+	oie->oie_prefetch	 = !!(attr & (LUDA_VERIFY | LUDA_VERIFY_DRYRUN));
 	if (unlikely(!info->oti_it_ea_buf_used)) {
 		oie->oie_buf = info->oti_it_ea_buf;
 		info->oti_it_ea_buf_used = 1;
@@ -6592,6 +6595,50 @@ static int osd_ldiskfs_filldir(void *buf,
 	RETURN(0);
 }
 
+/**
+ * Submit read-ahead for the next OSD_IT_EA_RA_BLOCKS directory blocks.
+ *
+ * The htree directory is read in hash order, and every leaf block is read
+ * synchronously, so the LFSCK scanning a large directory waits for the disk
+ * for every block. Prefetch the blocks in logical order ahead of the reader
+ * instead, then the iteration will mostly find them in the buffer cache.
+ */
+static void osd_it_ea_prefetch(struct osd_it_ea *it)
+{
+	struct inode *inode = it->oie_obj->oo_inode;
+	struct super_block *sb = inode->i_sb;
+	struct blk_plug plug;
+	__u32 end;
+	int rc;
+	int i;
+
+	end = (i_size_read(inode) + sb->s_blocksize - 1) >>
+	      sb->s_blocksize_bits;
+	end = min_t(__u32, end, it->oie_ra_block + OSD_IT_EA_RA_BLOCKS);
+
+	blk_start_plug(&plug);
+	while (it->oie_ra_block < end) {
+		struct ldiskfs_map_blocks map = { 0 };
+
+		map.m_lblk = it->oie_ra_block;
+		map.m_len = end - it->oie_ra_block;
+		rc = ldiskfs_map_blocks(NULL, inode, &map, 0);
+		if (rc < 0)
+			break;
+
+		if (rc == 0) {
+			/* skip the hole */
+			it->oie_ra_block++;
+			continue;
+		}
+
+		for (i = 0; i < rc; i++)
+			sb_breadahead(sb, map.m_pblk + i);
+		it->oie_ra_block += rc;
+	}
+	blk_finish_plug(&plug);
+}
+
 /**
  * Calls ->iterate*() to load a directory entry at a time
  * and stored it in iterator's in-memory data structure.
@@ -6620,6 +6667,9 @@ static int osd_ldiskfs_it_fill(const struct lu_env *env,
 	it->oie_dirent = it->oie_buf;
 	it->oie_rd_dirent = 0;
 
+	if (it->oie_prefetch)
+		osd_it_ea_prefetch(it);
+
 	if (obj->oo_hl_head != NULL) {
 		hlock = osd_oti_get(env)->oti_hlock;
 		ldiskfs_htree_lock(hlock, obj->oo_hl_head,
@@ -7514,6 +7564,7 @@ static int osd_shutdown(const struct lu_env *env, struct osd_device *o)
 		qsd_fini(env, qsd);
 	}
 
+	osd_rcache_detach(o);
 	osd_fid_fini(env, o);
 	osd_scrub_cleanup(env, o);
 
@@ -7775,6 +7826,8 @@ static int osd_device_init0(const struct lu_env *env,
 	INIT_LIST_HEAD(&o->od_index_backup_list);
 	INIT_LIST_HEAD(&o->od_index_restore_list);
 	spin_lock_init(&o->od_lock);
+	spin_lock_init(&o->od_rcache_lock);
+	init_waitqueue_head(&o->od_rcache_waitq);
 	o->od_index_backup_policy = LIBP_NONE;
 	o->od_t10_type = 0;
 
@@ -7783,6 +7836,9 @@ static int osd_device_init0(const struct lu_env *env,
 	o->od_readcache_max_filesize = OSD_MAX_CACHE_SIZE;
 	o->od_readcache_max_iosize = OSD_READCACHE_MAX_IO_MB << 20;
 	o->od_writethrough_max_iosize = OSD_WRITECACHE_MAX_IO_MB << 20;
+	o->od_write_pipeline_pages =
+		OSD_WRITE_PIPELINE_KB >> (PAGE_SHIFT - 10);
+	o->od_rcache_admit = OSD_RCACHE_ADMIT_DEFAULT;
 	o->od_auto_scrub_interval = AS_DEFAULT;
 
 	cplen = strlcpy(o->od_svname, lustre_cfg_string(cfg, 4),
@@ -7870,6 +7926,7 @@ static int osd_device_init0(const struct lu_env *env,
 
 out_procfs:
 	osd_procfs_fini(o);
+	osd_rcache_detach(o);
 out_scrub:
 	osd_scrub_cleanup(env, o);
 out_site:
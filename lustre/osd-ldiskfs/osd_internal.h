@@ -297,6 +297,10 @@ struct osd_device {
 	 * served bypassing pagecache unless already cached */
 	unsigned long		od_writethrough_max_iosize;
 
+	/* the pages of a write are mapped and submitted by this many pages,
+	 * so the bios are in flight while the rest is being allocated */
+	unsigned int		od_write_pipeline_pages;
+
 	int			od_read_cache;
 	int			od_writethrough_cache;
 
@@ -342,6 +346,21 @@ struct osd_device {
 	int			 od_index_backup_stop;
 	/* T10PI type, zero if not supported  */
 	enum osd_t10_type	 od_t10_type;
+
+	/* FID to inode cache in front of OI files shared by all threads,
+	 * NULL if disabled */
+	struct osd_oi_cache_slot *od_oi_cache;
+	unsigned int		 od_oi_cache_bits;
+	struct percpu_counter	 od_oi_cache_hits;
+	struct percpu_counter	 od_oi_cache_misses;
+
+	/* second level read cache on a local block device, NULL if none,
+	 * see osd_rcache.c */
+	struct osd_rcache	*od_rcache;
+	spinlock_t		 od_rcache_lock;
+	wait_queue_head_t	 od_rcache_waitq;
+	/* reads of a chunk before it is admitted in the read cache */
+	unsigned int		 od_rcache_admit;
 };
 
 static inline struct qsd_instance *osd_def_qsd(struct osd_device *osd)
@@ -514,8 +533,14 @@ struct osd_it_ea {
 	/** buffer to hold entries, size == OSD_IT_EA_BUFSIZE */
 	void			*oie_buf;
 	struct dentry		oie_dentry;
+	/** next directory block to be prefetched for LFSCK scanning */
+	__u32			oie_ra_block;
+	unsigned int		oie_prefetch:1;
 };
 
+/* Directory blocks to be prefetched each time the iterator is refilled. */
+#define OSD_IT_EA_RA_BLOCKS	16
+
 /**
  * Iterator's in-memory data structure for IAM mode.
  */
@@ -588,6 +613,21 @@ static inline struct osd_timespec osd_inode_time(struct inode *inode,
 	return osd_timespec_trunc(ts, inode->i_sb->s_time_gran);
 }
 
+/* osd_rcache.c */
+#define OSD_RCACHE_ADMIT_DEFAULT	2
+
+int osd_rcache_attach(struct osd_device *osd, const char *path);
+void osd_rcache_detach(struct osd_device *osd);
+void osd_rcache_read(struct osd_device *osd, struct inode *inode,
+		     struct osd_iobuf *iobuf);
+void osd_rcache_admit(struct osd_device *osd, struct inode *inode,
+		      struct osd_iobuf *iobuf);
+void osd_rcache_invalidate(struct osd_device *osd, struct inode *inode,
+			   loff_t start, loff_t end);
+ssize_t osd_rcache_dev_show(struct osd_device *osd, char *buf);
+void osd_rcache_dump(struct seq_file *m, struct osd_device *osd);
+void osd_submit_bio(int rw, struct bio *bio);
+
 #define OSD_INS_CACHE_SIZE	8
 
 struct osd_thread_info {
@@ -992,6 +1032,7 @@ static inline int osd_invariant(const struct osd_object *obj)
 #define OSD_MAX_CACHE_SIZE OBD_OBJECT_EOF
 #define OSD_READCACHE_MAX_IO_MB		8
 #define OSD_WRITECACHE_MAX_IO_MB	8
+#define OSD_WRITE_PIPELINE_KB		1024
 
 extern const struct dt_index_operations osd_otable_ops;
 
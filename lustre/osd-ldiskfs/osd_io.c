@@ -253,7 +253,7 @@ static void record_start_io(struct osd_iobuf *iobuf, int size)
 	}
 }
 
-static void osd_submit_bio(int rw, struct bio *bio)
+void osd_submit_bio(int rw, struct bio *bio)
 {
 	LASSERTF(rw == 0 || rw == 1, "%x\n", rw);
 #ifdef HAVE_SUBMIT_BIO_2ARGS
@@ -445,14 +445,18 @@ static int osd_bio_init(struct bio *bio, struct osd_iobuf *iobuf,
 	RETURN(0);
 }
 
+/**
+ * Build and submit the bios for the pages [start, start + npages) of the
+ * iobuf. The write path may call it several times for the consecutive
+ * ranges of the same iobuf, the page indices are always absolute.
+ */
 static int osd_do_bio(struct osd_device *osd, struct inode *inode,
-                      struct osd_iobuf *iobuf)
+		      struct osd_iobuf *iobuf, int start, int npages)
 {
 	int blocks_per_page = PAGE_SIZE >> inode->i_blkbits;
 	struct page **pages = iobuf->dr_pages;
-	int npages = iobuf->dr_npages;
 	sector_t *blocks = iobuf->dr_blocks;
-	int total_blocks = npages * blocks_per_page;
+	int total_blocks = (start + npages) * blocks_per_page;
 	struct super_block *sb = inode->i_sb;
 	int sector_bits = sb->s_blocksize_bits - 9;
 	unsigned int blocksize = sb->s_blocksize;
@@ -474,17 +478,20 @@ static int osd_do_bio(struct osd_device *osd, struct inode *inode,
 	ENTRY;
 
 	fault_inject = OBD_FAIL_CHECK(OBD_FAIL_OST_INTEGRITY_FAULT);
-        LASSERT(iobuf->dr_npages == npages);
+	LASSERT(start + npages <= iobuf->dr_npages);
 
 	integrity_enabled = bdev_integrity_enabled(bdev, iobuf->dr_rw);
 
-	osd_brw_stats_update(osd, iobuf);
-	iobuf->dr_start_time = ktime_get();
+	/* all the blocks of the iobuf are mapped for the last range */
+	if (start + npages == iobuf->dr_npages)
+		osd_brw_stats_update(osd, iobuf);
+	if (start == 0)
+		iobuf->dr_start_time = ktime_get();
 
 	blk_start_plug(&plug);
-        for (page_idx = 0, block_idx = 0;
-             page_idx < npages;
-             page_idx++, block_idx += blocks_per_page) {
+	for (page_idx = start, block_idx = start * blocks_per_page;
+	     page_idx < start + npages;
+	     page_idx++, block_idx += blocks_per_page) {
 
                 page = pages[page_idx];
                 LASSERT(block_idx + blocks_per_page <= total_blocks);
@@ -546,12 +553,15 @@ static int osd_do_bio(struct osd_device *osd, struct inode *inode,
 			bio_start_page_idx = page_idx;
 			/* allocate new bio */
 			bio = bio_alloc(GFP_NOIO, min(BIO_MAX_PAGES,
-						      (npages - page_idx) *
+						      (start + npages -
+						       page_idx) *
 						      blocks_per_page));
-                        if (bio == NULL) {
-                                CERROR("Can't allocate bio %u*%u = %u pages\n",
-                                       (npages - page_idx), blocks_per_page,
-                                       (npages - page_idx) * blocks_per_page);
+			if (bio == NULL) {
+				CERROR("Can't allocate bio %u*%u = %u pages\n",
+				       (start + npages - page_idx),
+				       blocks_per_page,
+				       (start + npages - page_idx) *
+				       blocks_per_page);
                                 rc = -ENOMEM;
                                 goto out;
                         }
@@ -1052,7 +1062,8 @@ static int osd_write_prep(const struct lu_env *env, struct dt_object *dt,
 						 iobuf->dr_npages,
 						 iobuf->dr_blocks, 0);
                 if (likely(rc == 0)) {
-                        rc = osd_do_bio(osd, inode, iobuf);
+			rc = osd_do_bio(osd, inode, iobuf, 0,
+					iobuf->dr_npages);
                         /* do IO stats for preparation reads */
                         osd_fini_iobuf(osd, iobuf);
                 }
@@ -1232,6 +1243,40 @@ static int osd_declare_write_commit(const struct lu_env *env,
 	RETURN(rc);
 }
 
+/**
+ * Map the pages of the iobuf to blocks and submit the bios for them.
+ *
+ * Block allocation for a large RPC on a fragmented or busy filesystem can
+ * take a while, and the device used to be idle until all the pages of the
+ * RPC had been mapped. Map and submit the pages by chunks instead, so that
+ * the bios for the first chunks are in flight while the rest of the RPC is
+ * being allocated. The completion is still waited for in osd_trans_stop()
+ * once the transaction has been submitted to the journal.
+ */
+static int osd_write_pipeline(struct osd_device *osd, struct inode *inode,
+			      struct osd_iobuf *iobuf)
+{
+	int blocks_per_page = PAGE_SIZE >> inode->i_blkbits;
+	int chunk = osd->od_write_pipeline_pages;
+	int start;
+	int count;
+	int rc = 0;
+
+	if (chunk == 0 || chunk >= iobuf->dr_npages)
+		chunk = iobuf->dr_npages;
+
+	for (start = 0; start < iobuf->dr_npages && rc == 0; start += count) {
+		count = min(chunk, iobuf->dr_npages - start);
+		rc = osd_ldiskfs_map_inode_pages(inode,
+				iobuf->dr_pages + start, count,
+				iobuf->dr_blocks + start * blocks_per_page, 1);
+		if (rc == 0)
+			rc = osd_do_bio(osd, inode, iobuf, start, count);
+	}
+
+	return rc;
+}
+
 /* Check if a block is allocated or not */
 static int osd_write_commit(const struct lu_env *env, struct dt_object *dt,
                             struct niobuf_local *lnb, int npages,
@@ -1242,6 +1287,8 @@ static int osd_write_commit(const struct lu_env *env, struct dt_object *dt,
         struct inode *inode = osd_dt_obj(dt)->oo_inode;
         struct osd_device  *osd = osd_obj2dev(osd_dt_obj(dt));
         loff_t isize;
+	loff_t wstart = LLONG_MAX;
+	loff_t wend = 0;
         int rc = 0, i;
 
         LASSERT(inode);
@@ -1276,6 +1323,11 @@ static int osd_write_commit(const struct lu_env *env, struct dt_object *dt,
 		if (lnb[i].lnb_file_offset + lnb[i].lnb_len > isize)
 			isize = lnb[i].lnb_file_offset + lnb[i].lnb_len;
 
+		if (lnb[i].lnb_file_offset < wstart)
+			wstart = lnb[i].lnb_file_offset;
+		if (lnb[i].lnb_file_offset + lnb[i].lnb_len > wend)
+			wend = lnb[i].lnb_file_offset + lnb[i].lnb_len;
+
 		/*
 		 * Since write and truncate are serialized by oo_sem, even
 		 * partial-page truncate should not leave dirty pages in the
@@ -1290,16 +1342,16 @@ static int osd_write_commit(const struct lu_env *env, struct dt_object *dt,
 
 	osd_trans_exec_op(env, thandle, OSD_OT_WRITE);
 
-        if (OBD_FAIL_CHECK(OBD_FAIL_OST_MAPBLK_ENOSPC)) {
-                rc = -ENOSPC;
-        } else if (iobuf->dr_npages > 0) {
-		rc = osd_ldiskfs_map_inode_pages(inode, iobuf->dr_pages,
-						 iobuf->dr_npages,
-						 iobuf->dr_blocks, 1);
-        } else {
-                /* no pages to write, no transno is needed */
-                thandle->th_local = 1;
-        }
+	osd_rcache_invalidate(osd, inode, wstart, wend);
+
+	if (OBD_FAIL_CHECK(OBD_FAIL_OST_MAPBLK_ENOSPC)) {
+		rc = -ENOSPC;
+	} else if (iobuf->dr_npages > 0) {
+		rc = osd_write_pipeline(osd, inode, iobuf);
+	} else {
+		/* no pages to write, no transno is needed */
+		thandle->th_local = 1;
+	}
 
 	if (likely(rc == 0)) {
 		spin_lock(&inode->i_lock);
@@ -1312,10 +1364,13 @@ static int osd_write_commit(const struct lu_env *env, struct dt_object *dt,
 			spin_unlock(&inode->i_lock);
 		}
 
-		rc = osd_do_bio(osd, inode, iobuf);
 		/* we don't do stats here as in read path because
 		 * write is async: we'll do this in osd_put_bufs() */
 	} else {
+		/* some bios may have been submitted already, the pages
+		 * cannot be dropped from the cache before they are done */
+		wait_event(iobuf->dr_wait,
+			   atomic_read(&iobuf->dr_numreqs) == 0);
 		osd_fini_iobuf(osd, iobuf);
 	}
 
@@ -1400,11 +1455,18 @@ static int osd_read_prep(const struct lu_env *env, struct dt_object *dt,
 		lprocfs_counter_add(osd->od_stats, LPROC_OSD_CACHE_ACCESS,
 				    cache_hits + cache_misses);
 
+	/* the pages found on the read cache device are read from there
+	 * and dropped from the iobuf */
+	if (iobuf->dr_npages)
+		osd_rcache_read(osd, inode, iobuf);
+
 	if (iobuf->dr_npages) {
 		rc = osd_ldiskfs_map_inode_pages(inode, iobuf->dr_pages,
 						 iobuf->dr_npages,
 						 iobuf->dr_blocks, 0);
-		rc = osd_do_bio(osd, inode, iobuf);
+		rc = osd_do_bio(osd, inode, iobuf, 0, iobuf->dr_npages);
+		if (rc == 0)
+			osd_rcache_admit(osd, inode, iobuf);
 
 		/* IO stats will be done in osd_bufs_put() */
 
@@ -1831,6 +1893,7 @@ static ssize_t osd_write(const struct lu_env *env, struct dt_object *dt,
 {
 	struct inode		*inode = osd_dt_obj(dt)->oo_inode;
 	struct osd_thandle	*oh;
+	loff_t			offset = *pos;
 	ssize_t			result;
 	int			is_link;
 
@@ -1858,8 +1921,11 @@ static ssize_t osd_write(const struct lu_env *env, struct dt_object *dt,
 	else
 		result = osd_ldiskfs_write_record(dt, buf->lb_buf, buf->lb_len,
 						  is_link, pos, oh->ot_handle);
-	if (result == 0)
+	if (result == 0) {
 		result = buf->lb_len;
+		osd_rcache_invalidate(osd_obj2dev(osd_dt_obj(dt)), inode,
+				      offset, offset + buf->lb_len);
+	}
 
 	osd_trans_exec_check(env, handle, OSD_OT_WRITE);
 
@@ -1909,6 +1975,7 @@ static int osd_punch(const struct lu_env *env, struct dt_object *dt,
 	struct inode *inode = obj->oo_inode;
 	struct osd_access_lock *al;
 	struct osd_thandle *oh;
+	loff_t isize;
 	int rc = 0, found = 0;
 	bool grow = false;
 	ENTRY;
@@ -1936,11 +2003,15 @@ static int osd_punch(const struct lu_env *env, struct dt_object *dt,
 	osd_trans_exec_op(env, th, OSD_OT_PUNCH);
 
 	spin_lock(&inode->i_lock);
-	if (i_size_read(inode) < start)
+	isize = i_size_read(inode);
+	if (isize < start)
 		grow = true;
 	i_size_write(inode, start);
 	spin_unlock(&inode->i_lock);
 	ll_truncate_pagecache(inode, start);
+	/* on grow, the page cached with the old EOF is dropped as well */
+	osd_rcache_invalidate(osd, inode, min_t(loff_t, isize, start),
+			      max_t(loff_t, isize, start));
 
 	/* optimize grow case */
 	if (grow) {
@@ -528,6 +528,190 @@ static ssize_t full_scrub_threshold_rate_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(full_scrub_threshold_rate);
 
+static ssize_t scrub_threads_show(struct kobject *kobj, struct attribute *attr,
+				  char *buf)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osd_device *dev = osd_dt_dev(dt);
+
+	LASSERT(dev);
+	if (unlikely(!dev->od_mnt))
+		return -EINPROGRESS;
+
+	return sprintf(buf, "%u\n", dev->od_scrub.os_threads);
+}
+
+static ssize_t scrub_threads_store(struct kobject *kobj,
+				   struct attribute *attr,
+				   const char *buffer, size_t count)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osd_device *dev = osd_dt_dev(dt);
+	unsigned int val;
+	int rc;
+
+	LASSERT(dev);
+	if (unlikely(!dev->od_mnt))
+		return -EINPROGRESS;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val < 1 || val > OSD_SCRUB_THREADS_MAX)
+		return -ERANGE;
+
+	/* it takes effect when the OI scrub starts next time */
+	dev->od_scrub.os_threads = val;
+	return count;
+}
+LUSTRE_RW_ATTR(scrub_threads);
+
+static ssize_t write_pipeline_kb_show(struct kobject *kobj,
+				      struct attribute *attr, char *buf)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osd_device *osd = osd_dt_dev(dt);
+
+	LASSERT(osd);
+	if (unlikely(!osd->od_mnt))
+		return -EINPROGRESS;
+
+	return sprintf(buf, "%u\n",
+		       osd->od_write_pipeline_pages << (PAGE_SHIFT - 10));
+}
+
+static ssize_t write_pipeline_kb_store(struct kobject *kobj,
+				       struct attribute *attr,
+				       const char *buffer, size_t count)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osd_device *osd = osd_dt_dev(dt);
+	unsigned int val;
+	int rc;
+
+	LASSERT(osd);
+	if (unlikely(!osd->od_mnt))
+		return -EINPROGRESS;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val > PTLRPC_MAX_BRW_SIZE >> 10)
+		return -ERANGE;
+
+	/* 0 means to map and submit the whole RPC at once */
+	osd->od_write_pipeline_pages = val >> (PAGE_SHIFT - 10);
+	return count;
+}
+LUSTRE_RW_ATTR(write_pipeline_kb);
+
+static ssize_t read_cache_dev_show(struct kobject *kobj,
+				   struct attribute *attr, char *buf)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osd_device *osd = osd_dt_dev(dt);
+
+	LASSERT(osd);
+	if (unlikely(!osd->od_mnt))
+		return -EINPROGRESS;
+
+	return osd_rcache_dev_show(osd, buf);
+}
+
+static ssize_t read_cache_dev_store(struct kobject *kobj,
+				    struct attribute *attr,
+				    const char *buffer, size_t count)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osd_device *osd = osd_dt_dev(dt);
+	char *path;
+	int rc = 0;
+
+	LASSERT(osd);
+	if (unlikely(!osd->od_mnt))
+		return -EINPROGRESS;
+
+	OBD_ALLOC(path, count + 1);
+	if (!path)
+		return -ENOMEM;
+	memcpy(path, buffer, count);
+
+	/* "none" stops using the current cache device, another device
+	 * replaces it only if it can be used */
+	if (strcmp(strim(path), "none") == 0)
+		osd_rcache_detach(osd);
+	else
+		rc = osd_rcache_attach(osd, strim(path));
+
+	OBD_FREE(path, count + 1);
+	return rc ?: count;
+}
+LUSTRE_RW_ATTR(read_cache_dev);
+
+static ssize_t read_cache_admit_show(struct kobject *kobj,
+				     struct attribute *attr, char *buf)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osd_device *osd = osd_dt_dev(dt);
+
+	LASSERT(osd);
+	if (unlikely(!osd->od_mnt))
+		return -EINPROGRESS;
+
+	return sprintf(buf, "%u\n", osd->od_rcache_admit);
+}
+
+static ssize_t read_cache_admit_store(struct kobject *kobj,
+				      struct attribute *attr,
+				      const char *buffer, size_t count)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osd_device *osd = osd_dt_dev(dt);
+	unsigned int val;
+	int rc;
+
+	LASSERT(osd);
+	if (unlikely(!osd->od_mnt))
+		return -EINPROGRESS;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	/* the access frequency of a chunk saturates at 255 */
+	if (val > U8_MAX)
+		return -ERANGE;
+
+	osd->od_rcache_admit = val;
+	return count;
+}
+LUSTRE_RW_ATTR(read_cache_admit);
+
+static int ldiskfs_osd_read_cache_stats_seq_show(struct seq_file *m,
+						 void *data)
+{
+	struct osd_device *dev = osd_dt_dev((struct dt_device *)m->private);
+
+	LASSERT(dev != NULL);
+	if (unlikely(dev->od_mnt == NULL))
+		return -EINPROGRESS;
+
+	osd_rcache_dump(m, dev);
+	return 0;
+}
+
+LDEBUGFS_SEQ_FOPS_RO(ldiskfs_osd_read_cache_stats);
+
 static int ldiskfs_osd_oi_scrub_seq_show(struct seq_file *m, void *data)
 {
 	struct osd_device *dev = osd_dt_dev((struct dt_device *)m->private);
@@ -542,6 +726,20 @@ static int ldiskfs_osd_oi_scrub_seq_show(struct seq_file *m, void *data)
 
 LDEBUGFS_SEQ_FOPS_RO(ldiskfs_osd_oi_scrub);
 
+static int ldiskfs_osd_oi_cache_seq_show(struct seq_file *m, void *data)
+{
+	struct osd_device *dev = osd_dt_dev((struct dt_device *)m->private);
+
+	LASSERT(dev != NULL);
+	if (unlikely(dev->od_mnt == NULL))
+		return -EINPROGRESS;
+
+	osd_oi_cache_dump(m, dev);
+	return 0;
+}
+
+LDEBUGFS_SEQ_FOPS_RO(ldiskfs_osd_oi_cache);
+
 static int ldiskfs_osd_readcache_seq_show(struct seq_file *m, void *data)
 {
 	struct osd_device *osd = osd_dt_dev((struct dt_device *)m->private);
@@ -795,6 +993,10 @@ LUSTRE_RW_ATTR(index_backup);
 struct lprocfs_vars lprocfs_osd_obd_vars[] = {
 	{ .name	=	"oi_scrub",
 	  .fops	=	&ldiskfs_osd_oi_scrub_fops	},
+	{ .name	=	"oi_cache",
+	  .fops	=	&ldiskfs_osd_oi_cache_fops	},
+	{ .name	=	"read_cache_stats",
+	  .fops	=	&ldiskfs_osd_read_cache_stats_fops	},
 	{ .name	=	"readcache_max_filesize",
 	  .fops	=	&ldiskfs_osd_readcache_fops	},
 	{ .name	=	"readcache_max_io_mb",
@@ -816,6 +1018,10 @@ static struct attribute *ldiskfs_attrs[] = {
 	&lustre_attr_pdo.attr,
 	&lustre_attr_full_scrub_ratio.attr,
 	&lustre_attr_full_scrub_threshold_rate.attr,
+	&lustre_attr_scrub_threads.attr,
+	&lustre_attr_write_pipeline_kb.attr,
+	&lustre_attr_read_cache_dev.attr,
+	&lustre_attr_read_cache_admit.attr,
 	NULL,
 };
 
@@ -60,6 +60,13 @@ unsigned int osd_oi_count = OSD_OI_FID_NR;
 module_param(osd_oi_count, int, 0444);
 MODULE_PARM_DESC(osd_oi_count, "Number of Object Index containers to be created, it's only valid for new filesystem.");
 
+static int osd_oi_cache_mb = -1;
+module_param(osd_oi_cache_mb, int, 0444);
+MODULE_PARM_DESC(osd_oi_cache_mb, "Memory of the shared OI cache per MDT in MiB, 0 to disable it, -1 (default) to use 1/1024 of RAM.");
+
+/* upper limit of the auto sized shared OI cache */
+#define OSD_OI_CACHE_MAX_MB	256
+
 static struct dt_index_features oi_feat = {
         .dif_flags       = DT_IND_UPDATE,
         .dif_recsize_min = sizeof(struct osd_inode_id),
@@ -384,6 +391,172 @@ static int osd_remove_ois(struct osd_thread_info *info, struct osd_device *osd)
 	return rc;
 }
 
+/*
+ * The shared OI cache is a direct mapped table of FID to inode mappings
+ * found in OI files, used by all threads of the device, which saves OI
+ * lookups for FIDs whose objects were dropped from the lu_site cache.
+ *
+ * It only caches the mappings in OI files, and is invalidated after each
+ * change of OI files, so it always agrees with OI files. A lookup saves
+ * ocs_gen of the slot on miss, and the mapping found in OI files is not
+ * cached if the slot was invalidated meanwhile, because the mapping may have
+ * been removed from OI files by race.
+ *
+ * It's enabled on MDT only, where OI files can be much larger than RAM.
+ */
+static void osd_oi_cache_init(struct osd_device *osd)
+{
+	struct osd_oi_cache_slot *cache;
+	unsigned long size;
+	unsigned int bits;
+	unsigned int i;
+	int rc;
+
+	if (osd->od_is_ost || osd_oi_cache_mb == 0)
+		return;
+
+	if (osd_oi_cache_mb > 0)
+		size = (unsigned long)osd_oi_cache_mb << 20;
+	else
+		size = min((cfs_totalram_pages() << PAGE_SHIFT) >> 10,
+			   (unsigned long)OSD_OI_CACHE_MAX_MB << 20);
+
+	size /= sizeof(*cache);
+	if (size < 2)
+		return;
+
+	bits = ilog2(size);
+	OBD_ALLOC_LARGE(cache, sizeof(*cache) << bits);
+	if (!cache) {
+		CWARN("%s: cannot allocate OI cache of %u slots, disable it\n",
+		      osd_dev2name(osd), 1U << bits);
+		return;
+	}
+
+#ifdef HAVE_PERCPU_COUNTER_INIT_GFP_FLAG
+	rc = percpu_counter_init(&osd->od_oi_cache_hits, 0, GFP_KERNEL);
+#else
+	rc = percpu_counter_init(&osd->od_oi_cache_hits, 0);
+#endif
+	if (rc)
+		goto free;
+
+#ifdef HAVE_PERCPU_COUNTER_INIT_GFP_FLAG
+	rc = percpu_counter_init(&osd->od_oi_cache_misses, 0, GFP_KERNEL);
+#else
+	rc = percpu_counter_init(&osd->od_oi_cache_misses, 0);
+#endif
+	if (rc) {
+		percpu_counter_destroy(&osd->od_oi_cache_hits);
+		goto free;
+	}
+
+	for (i = 0; i < 1U << bits; i++)
+		spin_lock_init(&cache[i].ocs_lock);
+
+	osd->od_oi_cache_bits = bits;
+	osd->od_oi_cache = cache;
+	return;
+
+free:
+	OBD_FREE_LARGE(cache, sizeof(*cache) << bits);
+}
+
+static void osd_oi_cache_fini(struct osd_device *osd)
+{
+	if (!osd->od_oi_cache)
+		return;
+
+	percpu_counter_destroy(&osd->od_oi_cache_misses);
+	percpu_counter_destroy(&osd->od_oi_cache_hits);
+	OBD_FREE_LARGE(osd->od_oi_cache,
+		       sizeof(*osd->od_oi_cache) << osd->od_oi_cache_bits);
+	osd->od_oi_cache = NULL;
+}
+
+static inline struct osd_oi_cache_slot *
+osd_oi_cache_slot(struct osd_device *osd, const struct lu_fid *fid)
+{
+	return &osd->od_oi_cache[fid_hash(fid, osd->od_oi_cache_bits)];
+}
+
+/*
+ * Find \a fid in the shared OI cache, on miss save the slot generation in
+ * \a gen for osd_oi_cache_add().
+ */
+static bool osd_oi_cache_lookup(struct osd_device *osd,
+				const struct lu_fid *fid,
+				struct osd_inode_id *id, __u32 *gen)
+{
+	struct osd_oi_cache_slot *slot;
+	bool found;
+
+	if (!osd->od_oi_cache)
+		return false;
+
+	slot = osd_oi_cache_slot(osd, fid);
+	spin_lock(&slot->ocs_lock);
+	found = lu_fid_eq(&slot->ocs_fid, fid);
+	if (found)
+		*id = slot->ocs_id;
+	else
+		*gen = slot->ocs_gen;
+	spin_unlock(&slot->ocs_lock);
+
+	if (found)
+		percpu_counter_inc(&osd->od_oi_cache_hits);
+	else
+		percpu_counter_inc(&osd->od_oi_cache_misses);
+
+	return found;
+}
+
+static void osd_oi_cache_add(struct osd_device *osd, const struct lu_fid *fid,
+			     const struct osd_inode_id *id, __u32 gen)
+{
+	struct osd_oi_cache_slot *slot;
+
+	if (!osd->od_oi_cache)
+		return;
+
+	slot = osd_oi_cache_slot(osd, fid);
+	spin_lock(&slot->ocs_lock);
+	if (slot->ocs_gen == gen) {
+		slot->ocs_fid = *fid;
+		slot->ocs_id = *id;
+	}
+	spin_unlock(&slot->ocs_lock);
+}
+
+/* called after the OI mapping of \a fid is changed or removed */
+static void osd_oi_cache_del(struct osd_device *osd, const struct lu_fid *fid)
+{
+	struct osd_oi_cache_slot *slot;
+
+	if (!osd->od_oi_cache)
+		return;
+
+	slot = osd_oi_cache_slot(osd, fid);
+	spin_lock(&slot->ocs_lock);
+	slot->ocs_gen++;
+	if (lu_fid_eq(&slot->ocs_fid, fid))
+		fid_zero(&slot->ocs_fid);
+	spin_unlock(&slot->ocs_lock);
+}
+
+void osd_oi_cache_dump(struct seq_file *m, struct osd_device *osd)
+{
+	if (!osd->od_oi_cache) {
+		seq_puts(m, "slots: 0\n");
+		return;
+	}
+
+	seq_printf(m, "slots: %u\nhits: %lld\nmisses: %lld\n",
+		   1U << osd->od_oi_cache_bits,
+		   percpu_counter_sum_positive(&osd->od_oi_cache_hits),
+		   percpu_counter_sum_positive(&osd->od_oi_cache_misses));
+}
+
 int osd_oi_init(struct osd_thread_info *info, struct osd_device *osd,
 		bool restored)
 {
@@ -508,6 +681,9 @@ out:
 		}
 	}
 
+	if (rc == 0)
+		osd_oi_cache_init(osd);
+
 	return rc;
 }
 
@@ -516,6 +692,7 @@ void osd_oi_fini(struct osd_thread_info *info, struct osd_device *osd)
 	if (unlikely(!osd->od_oi_table))
 		return;
 
+	osd_oi_cache_fini(osd);
 	osd_oi_table_put(info, osd->od_oi_table, osd->od_oi_count);
 
 	OBD_FREE(osd->od_oi_table,
@@ -613,13 +790,20 @@ static int __osd_oi_lookup(struct osd_thread_info *info, struct osd_device *osd,
 			   const struct lu_fid *fid, struct osd_inode_id *id)
 {
 	struct lu_fid *oi_fid = &info->oti_fid2;
+	__u32	       gen;
 	int	       rc;
 
+	if (osd_oi_cache_lookup(osd, fid, id, &gen))
+		return 0;
+
 	fid_cpu_to_be(oi_fid, fid);
 	rc = osd_oi_iam_lookup(info, osd_fid2oi(osd, fid), (struct dt_rec *)id,
 			       (const struct dt_key *)oi_fid);
 	if (rc > 0) {
 		osd_id_unpack(id, id);
+		/* let a destroy race with the cache fill */
+		OBD_FAIL_TIMEOUT(OBD_FAIL_OSD_OI_CACHE_RACE, cfs_fail_val);
+		osd_oi_cache_add(osd, fid, id, gen);
 		rc = 0;
 	} else if (rc == 0) {
 		rc = -ENOENT;
@@ -766,6 +950,7 @@ update:
 		rc = osd_oi_iam_refresh(info, osd_fid2oi(osd, fid),
 					(const struct dt_rec *)oi_id,
 					(const struct dt_key *)oi_fid, th, false);
+		osd_oi_cache_del(osd, fid);
 		if (rc != 0)
 			return rc;
 
@@ -809,6 +994,7 @@ int osd_oi_delete(struct osd_thread_info *info,
 		  handle_t *th, enum oi_check_flags flags)
 {
 	struct lu_fid *oi_fid = &info->oti_fid2;
+	int	       rc;
 
 	/* clear idmap cache */
 	if (lu_fid_eq(fid, &info->oti_cache.oic_fid))
@@ -821,8 +1007,11 @@ int osd_oi_delete(struct osd_thread_info *info,
 		return osd_obj_map_delete(info, osd, fid, th);
 
 	fid_cpu_to_be(oi_fid, fid);
-	return osd_oi_iam_delete(info, osd_fid2oi(osd, fid),
-				 (const struct dt_key *)oi_fid, th);
+	rc = osd_oi_iam_delete(info, osd_fid2oi(osd, fid),
+			       (const struct dt_key *)oi_fid, th);
+	osd_oi_cache_del(osd, fid);
+
+	return rc;
 }
 
 int osd_oi_update(struct osd_thread_info *info, struct osd_device *osd,
@@ -844,6 +1033,7 @@ int osd_oi_update(struct osd_thread_info *info, struct osd_device *osd,
 	rc = osd_oi_iam_refresh(info, osd_fid2oi(osd, fid),
 			       (const struct dt_rec *)oi_id,
 			       (const struct dt_key *)oi_fid, th, false);
+	osd_oi_cache_del(osd, fid);
 	if (rc != 0)
 		return rc;
 
@@ -86,6 +86,15 @@ struct osd_idmap_cache {
 	__u16			oic_remote:1;	/* FID isn't local */
 };
 
+/* slot of the shared OI cache, see osd_oi_cache_lookup() */
+struct osd_oi_cache_slot {
+	spinlock_t		ocs_lock;
+	/* changed on each invalidation of this slot */
+	__u32			ocs_gen;
+	struct lu_fid		ocs_fid;
+	struct osd_inode_id	ocs_id;
+};
+
 static inline void osd_id_pack(struct osd_inode_id *tgt,
 			       const struct osd_inode_id *src)
 {
@@ -155,4 +164,5 @@ int  osd_oi_update(struct osd_thread_info *info, struct osd_device *osd,
 
 int fid_is_on_ost(struct osd_thread_info *info, struct osd_device *osd,
 		  const struct lu_fid *fid, enum oi_check_flags flags);
+void osd_oi_cache_dump(struct seq_file *m, struct osd_device *osd);
 #endif /* _OSD_OI_H */
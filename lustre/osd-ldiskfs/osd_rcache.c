@@ -0,0 +1,969 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/osd-ldiskfs/osd_rcache.c
+ *
+ * Second level read cache of object data on a local block device.
+ *
+ * The pages read from the OST device for bulk reads are copied to a faster
+ * local device (typically NVMe) once the chunk of the object they belong to
+ * has been read often enough, and later reads of these pages which miss the
+ * page cache are served from the cache device instead of the OST device.
+ *
+ * The cache device is divided in slots, each of them caching the pages of
+ * one chunk of OSD_RCACHE_CHUNK_SIZE bytes of an object, with a bitmap of the
+ * pages which are valid on the device. Slots are reused in CLOCK order, and
+ * a chunk is admitted in the cache after it has been read osd_device::
+ * od_rcache_admit times according to a small frequency sketch, so that
+ * streaming reads do not flush the cache.
+ *
+ * The index is kept in memory only, the cache is empty after each attach.
+ * Writes and punches invalidate the cached pages in their range, a destroyed
+ * object cannot be hit as the inode generation is part of the key. Only the
+ * first OSD_RCACHE_SLOTS_MAX chunks of a larger device are used, to bound the
+ * memory used by the index.
+ *
+ * The hash chains are split in groups of chains, each with its own lock
+ * protecting the chains and the slots on them, so that the reads of different
+ * chunks seldom contend. A slot moves from a chain to another one with the
+ * locks of both held, the lock of a busy slot does not change.
+ */
+
+#define DEBUG_SUBSYSTEM S_OSD
+
+#include <linux/bio.h>
+#include <linux/blkdev.h>
+#include <linux/hash.h>
+#include <linux/highmem.h>
+
+#include <obd.h>
+#include <obd_support.h>
+
+#include "osd_internal.h"
+
+#define OSD_RCACHE_CHUNK_SHIFT		20
+#define OSD_RCACHE_CHUNK_SIZE		(1UL << OSD_RCACHE_CHUNK_SHIFT)
+#define OSD_RCACHE_CHUNK_PAGE_BITS	(OSD_RCACHE_CHUNK_SHIFT - PAGE_SHIFT)
+#define OSD_RCACHE_CHUNK_PAGES		(1U << OSD_RCACHE_CHUNK_PAGE_BITS)
+#define OSD_RCACHE_SECTOR_BITS		(OSD_RCACHE_CHUNK_SHIFT - 9)
+
+/* 1M chunks, i.e. 1TB of cache device and about 128MB of slots */
+#define OSD_RCACHE_SLOTS_MAX		(1U << 20)
+/* max number of slots checked by the CLOCK hand for each new chunk */
+#define OSD_RCACHE_SCAN_MAX		64
+/* number of chain locks per CPU */
+#define OSD_RCACHE_LOCKS_PER_CPU	4
+
+/* 64K counters of 8 bits for the admission sketch, halved when the number
+ * of accesses since the last aging reaches 4 times the number of counters */
+#define OSD_RCACHE_SKETCH_BITS		16
+#define OSD_RCACHE_SKETCH_AGING		(4U << OSD_RCACHE_SKETCH_BITS)
+
+/* osd_rcache_read() marks the pages not on the cache device with this */
+#define OSD_RCACHE_NONE			((sector_t)~0ULL)
+
+struct osd_rcache_slot {
+	struct hlist_node	ors_hash;
+	/* the chunk cached in the slot, valid if ors_used is set */
+	__u64			ors_ino;
+	__u32			ors_igen;
+	pgoff_t			ors_chunk;
+	/* the hash chain of the slot, changed with the locks of both the
+	 * old and the new chains held */
+	unsigned int		ors_bucket;
+	/* bumped on each invalidation, the pages written to the slot are
+	 * only marked valid if it did not change meanwhile */
+	__u32			ors_gen;
+	/* number of bios in flight for the slot, it cannot be reused before
+	 * they are done */
+	int			ors_busy;
+	unsigned int		ors_used:1,
+				ors_ref:1;
+	DECLARE_BITMAP(ors_valid, OSD_RCACHE_CHUNK_PAGES);
+	/* pages being written to the slot */
+	DECLARE_BITMAP(ors_pending, OSD_RCACHE_CHUNK_PAGES);
+};
+
+/* lock of a group of hash chains, with the statistics of their slots */
+struct osd_rcache_lock {
+	/* taken from bio completion */
+	spinlock_t		orl_lock;
+	__u64			orl_hits;
+	__u64			orl_misses;
+	__u64			orl_admits;
+	__u64			orl_evictions;
+	__u64			orl_invalidations;
+} ____cacheline_aligned_in_smp;
+
+struct osd_rcache {
+	struct osd_device	*orc_osd;
+	struct block_device	*orc_bdev;
+	char			*orc_path;
+	int			 orc_path_len;
+	/* one for osd_device::od_rcache, one per user and per bio in flight */
+	atomic_t		 orc_refs;
+	struct osd_rcache_slot	*orc_slots;
+	unsigned int		 orc_nslots;
+	/* CLOCK hand, modulo orc_nslots */
+	atomic_t		 orc_hand;
+	struct hlist_head	*orc_hash;
+	unsigned int		 orc_hash_bits;
+	struct osd_rcache_lock	*orc_locks;
+	unsigned int		 orc_lock_mask;
+	/* updated without lock, losing an access now and then is harmless */
+	__u8			*orc_sketch;
+	atomic_t		 orc_sketch_ops;
+};
+
+/* completion of the reads from the cache device */
+struct osd_rcache_rio {
+	atomic_t		 orr_numreqs;
+	wait_queue_head_t	 orr_wait;
+	int			 orr_error;
+};
+
+/* a write of the pages [orw_first, orw_first + orw_count) of a slot */
+struct osd_rcache_wio {
+	struct osd_rcache	*orw_cache;
+	unsigned int		 orw_slot;
+	__u32			 orw_gen;
+	unsigned int		 orw_first;
+	unsigned int		 orw_count;
+};
+
+static struct osd_rcache *osd_rcache_get(struct osd_device *osd)
+{
+	struct osd_rcache *cache;
+
+	if (likely(!READ_ONCE(osd->od_rcache)))
+		return NULL;
+
+	spin_lock(&osd->od_rcache_lock);
+	cache = osd->od_rcache;
+	if (cache)
+		atomic_inc(&cache->orc_refs);
+	spin_unlock(&osd->od_rcache_lock);
+
+	return cache;
+}
+
+static void osd_rcache_put(struct osd_rcache *cache)
+{
+	struct osd_device *osd = cache->orc_osd;
+
+	if (atomic_dec_and_test(&cache->orc_refs))
+		wake_up(&osd->od_rcache_waitq);
+}
+
+static inline __u64 osd_rcache_key(struct inode *inode, pgoff_t chunk)
+{
+	return ((__u64)inode->i_ino << 24) ^ ((__u64)inode->i_generation << 48) ^
+	       chunk;
+}
+
+static inline unsigned int osd_rcache_bucket(struct osd_rcache *cache,
+					     struct inode *inode,
+					     pgoff_t chunk)
+{
+	return hash_64(osd_rcache_key(inode, chunk), cache->orc_hash_bits);
+}
+
+static inline struct osd_rcache_lock *
+osd_rcache_lock(struct osd_rcache *cache, unsigned int bucket)
+{
+	return &cache->orc_locks[bucket & cache->orc_lock_mask];
+}
+
+/* the caller has to check it again after locking if the slot is not busy */
+static inline struct osd_rcache_lock *
+osd_rcache_slot_lock(struct osd_rcache *cache, struct osd_rcache_slot *slot)
+{
+	return osd_rcache_lock(cache, READ_ONCE(slot->ors_bucket));
+}
+
+static inline sector_t osd_rcache_sector(struct osd_rcache *cache,
+					 struct osd_rcache_slot *slot,
+					 unsigned int page)
+{
+	return ((sector_t)(slot - cache->orc_slots) << OSD_RCACHE_SECTOR_BITS) +
+	       ((sector_t)page << (PAGE_SHIFT - 9));
+}
+
+static inline pgoff_t osd_rcache_index(struct osd_iobuf *iobuf, int i)
+{
+	return iobuf->dr_lnbs[i]->lnb_file_offset >> PAGE_SHIFT;
+}
+
+/* called with the lock of \a bucket held */
+static struct osd_rcache_slot *osd_rcache_find(struct osd_rcache *cache,
+					       unsigned int bucket,
+					       struct inode *inode,
+					       pgoff_t chunk)
+{
+	struct osd_rcache_slot *slot;
+
+	hlist_for_each_entry(slot, &cache->orc_hash[bucket], ors_hash) {
+		if (slot->ors_chunk == chunk && slot->ors_ino == inode->i_ino &&
+		    slot->ors_igen == inode->i_generation)
+			return slot;
+	}
+
+	return NULL;
+}
+
+/*
+ * Take the next slot not in use in CLOCK order for \a chunk, with the lock
+ * \a orl of \a bucket held. The lock of the slot is only tried as it may be
+ * taken in the reverse order by another thread, and at most
+ * OSD_RCACHE_SCAN_MAX slots are checked, the chunk is not cached if none of
+ * them can be reused.
+ */
+static struct osd_rcache_slot *osd_rcache_alloc(struct osd_rcache *cache,
+						struct osd_rcache_lock *orl,
+						unsigned int bucket,
+						struct inode *inode,
+						pgoff_t chunk)
+{
+	struct osd_rcache_slot *slot = NULL;
+	struct osd_rcache_lock *victim = NULL;
+	unsigned int i;
+
+	for (i = 0; i < OSD_RCACHE_SCAN_MAX; i++) {
+		slot = &cache->orc_slots[(unsigned int)atomic_inc_return(
+				&cache->orc_hand) % cache->orc_nslots];
+		victim = osd_rcache_slot_lock(cache, slot);
+		if (victim != orl) {
+			if (!spin_trylock(&victim->orl_lock))
+				continue;
+
+			/* moved to another chain meanwhile */
+			if (victim != osd_rcache_slot_lock(cache, slot)) {
+				spin_unlock(&victim->orl_lock);
+				continue;
+			}
+		}
+
+		if (!slot->ors_busy && !slot->ors_ref)
+			break;
+
+		if (!slot->ors_busy)
+			slot->ors_ref = 0;
+		if (victim != orl)
+			spin_unlock(&victim->orl_lock);
+	}
+
+	if (i == OSD_RCACHE_SCAN_MAX)
+		return NULL;
+
+	if (slot->ors_used) {
+		hlist_del(&slot->ors_hash);
+		if (!bitmap_empty(slot->ors_valid, OSD_RCACHE_CHUNK_PAGES))
+			victim->orl_evictions++;
+	}
+
+	slot->ors_ino = inode->i_ino;
+	slot->ors_igen = inode->i_generation;
+	slot->ors_chunk = chunk;
+	slot->ors_gen++;
+	slot->ors_used = 1;
+	bitmap_zero(slot->ors_valid, OSD_RCACHE_CHUNK_PAGES);
+	LASSERT(bitmap_empty(slot->ors_pending, OSD_RCACHE_CHUNK_PAGES));
+	WRITE_ONCE(slot->ors_bucket, bucket);
+	hlist_add_head(&slot->ors_hash, &cache->orc_hash[bucket]);
+	if (victim != orl)
+		spin_unlock(&victim->orl_lock);
+
+	return slot;
+}
+
+/* count an access to \a chunk, return how often it was accessed recently */
+static unsigned int osd_rcache_sketch(struct osd_rcache *cache,
+				      struct inode *inode, pgoff_t chunk)
+{
+	__u8 *freq;
+	unsigned int val;
+	unsigned int i;
+
+	freq = &cache->orc_sketch[hash_64(osd_rcache_key(inode, chunk),
+					  OSD_RCACHE_SKETCH_BITS)];
+	val = READ_ONCE(*freq);
+	if (val < U8_MAX)
+		WRITE_ONCE(*freq, ++val);
+
+	if (atomic_inc_return(&cache->orc_sketch_ops) ==
+	    OSD_RCACHE_SKETCH_AGING) {
+		for (i = 0; i < 1U << OSD_RCACHE_SKETCH_BITS; i++)
+			WRITE_ONCE(cache->orc_sketch[i],
+				   READ_ONCE(cache->orc_sketch[i]) >> 1);
+		atomic_set(&cache->orc_sketch_ops, 0);
+	}
+
+	return val;
+}
+
+#ifdef HAVE_BIO_ENDIO_USES_ONE_ARG
+static void osd_rcache_read_end_io(struct bio *bio)
+{
+	int error = bio->bi_status;
+#else
+static void osd_rcache_read_end_io(struct bio *bio, int error)
+{
+#endif
+	struct osd_rcache_rio *rio = bio->bi_private;
+
+	if (error != 0 && rio->orr_error == 0)
+		rio->orr_error = -EIO;
+
+	if (atomic_dec_and_test(&rio->orr_numreqs))
+		wake_up(&rio->orr_wait);
+
+	bio_put(bio);
+}
+
+#ifdef HAVE_BIO_ENDIO_USES_ONE_ARG
+static void osd_rcache_write_end_io(struct bio *bio)
+{
+	int error = bio->bi_status;
+#else
+static void osd_rcache_write_end_io(struct bio *bio, int error)
+{
+#endif
+	struct osd_rcache_wio *wio = bio->bi_private;
+	struct osd_rcache *cache = wio->orw_cache;
+	struct osd_rcache_slot *slot = &cache->orc_slots[wio->orw_slot];
+	struct osd_rcache_lock *orl = osd_rcache_slot_lock(cache, slot);
+	struct bio_vec *bvl;
+	unsigned long flags;
+	DECLARE_BVEC_ITER_ALL(iter_all);
+
+	/* CAVEAT EMPTOR: possibly in IRQ context */
+	spin_lock_irqsave(&orl->orl_lock, flags);
+	bitmap_clear(slot->ors_pending, wio->orw_first, wio->orw_count);
+	if (error == 0 && slot->ors_gen == wio->orw_gen) {
+		bitmap_set(slot->ors_valid, wio->orw_first, wio->orw_count);
+		orl->orl_admits += wio->orw_count;
+	}
+	slot->ors_busy--;
+	spin_unlock_irqrestore(&orl->orl_lock, flags);
+
+	bio_for_each_segment_all(bvl, bio, iter_all)
+		__free_page(bvl_to_page(bvl));
+
+	OBD_FREE_PTR(wio);
+	bio_put(bio);
+	osd_rcache_put(cache);
+}
+
+static void osd_rcache_submit_write(struct osd_rcache *cache, struct bio *bio)
+{
+	struct osd_rcache_wio *wio = bio->bi_private;
+	struct osd_rcache_slot *slot = &cache->orc_slots[wio->orw_slot];
+	struct osd_rcache_lock *orl = osd_rcache_slot_lock(cache, slot);
+
+	spin_lock_irq(&orl->orl_lock);
+	slot->ors_busy++;
+	spin_unlock_irq(&orl->orl_lock);
+	atomic_inc(&cache->orc_refs);
+
+	osd_submit_bio(1, bio);
+}
+
+/**
+ * Read the pages of \a iobuf which are valid on the cache device from it.
+ *
+ * The pages read from the cache device are marked uptodate, unlocked and
+ * removed from the iobuf, the remaining pages have to be read from the OST
+ * device. dr_blocks is used as scratch space for the sectors to read, it is
+ * filled by the block mapping of the remaining pages afterwards.
+ */
+void osd_rcache_read(struct osd_device *osd, struct inode *inode,
+		     struct osd_iobuf *iobuf)
+{
+	struct osd_rcache *cache;
+	struct osd_rcache_slot *slot = NULL;
+	struct osd_rcache_slot *next;
+	struct osd_rcache_lock *orl = NULL;
+	struct osd_rcache_rio rio;
+	sector_t *sectors = iobuf->dr_blocks;
+	struct bio *bio = NULL;
+	struct blk_plug plug;
+	unsigned int bucket;
+	pgoff_t chunk = 0;
+	pgoff_t index;
+	int hits = 0;
+	int rc = 0;
+	int i;
+	int j;
+
+	cache = osd_rcache_get(osd);
+	if (!cache)
+		return;
+
+	/* the pages are sorted by offset, look up each chunk once */
+	for (i = 0; i < iobuf->dr_npages; i++) {
+		index = osd_rcache_index(iobuf, i);
+		sectors[i] = OSD_RCACHE_NONE;
+
+		if (!orl || index >> OSD_RCACHE_CHUNK_PAGE_BITS != chunk) {
+			if (orl)
+				spin_unlock_irq(&orl->orl_lock);
+			chunk = index >> OSD_RCACHE_CHUNK_PAGE_BITS;
+			bucket = osd_rcache_bucket(cache, inode, chunk);
+			orl = osd_rcache_lock(cache, bucket);
+			spin_lock_irq(&orl->orl_lock);
+			slot = osd_rcache_find(cache, bucket, inode, chunk);
+		}
+
+		if (!slot ||
+		    !test_bit(index & (OSD_RCACHE_CHUNK_PAGES - 1),
+			      slot->ors_valid)) {
+			orl->orl_misses++;
+			continue;
+		}
+
+		slot->ors_busy++;
+		slot->ors_ref = 1;
+		sectors[i] = osd_rcache_sector(cache, slot,
+				index & (OSD_RCACHE_CHUNK_PAGES - 1));
+		orl->orl_hits++;
+		hits++;
+	}
+	if (orl)
+		spin_unlock_irq(&orl->orl_lock);
+
+	if (hits == 0)
+		goto out;
+
+	atomic_set(&rio.orr_numreqs, 0);
+	init_waitqueue_head(&rio.orr_wait);
+	rio.orr_error = 0;
+
+	blk_start_plug(&plug);
+	for (i = 0; i < iobuf->dr_npages; i++) {
+		if (sectors[i] == OSD_RCACHE_NONE)
+			continue;
+
+		if (bio && bio_end_sector(bio) == sectors[i] &&
+		    bio_add_page(bio, iobuf->dr_pages[i], PAGE_SIZE, 0) ==
+		    PAGE_SIZE)
+			continue;
+
+		if (bio) {
+			atomic_inc(&rio.orr_numreqs);
+			osd_submit_bio(0, bio);
+		}
+
+		bio = bio_alloc(GFP_NOIO, min(BIO_MAX_PAGES, hits));
+		if (!bio) {
+			rc = -ENOMEM;
+			break;
+		}
+
+		bio_set_dev(bio, cache->orc_bdev);
+		bio_set_sector(bio, sectors[i]);
+		bio->bi_opf = READ;
+		bio->bi_end_io = osd_rcache_read_end_io;
+		bio->bi_private = &rio;
+		bio_add_page(bio, iobuf->dr_pages[i], PAGE_SIZE, 0);
+	}
+	if (bio) {
+		atomic_inc(&rio.orr_numreqs);
+		osd_submit_bio(0, bio);
+	}
+	blk_finish_plug(&plug);
+
+	wait_event(rio.orr_wait, atomic_read(&rio.orr_numreqs) == 0);
+	if (rc == 0)
+		rc = rio.orr_error;
+
+	slot = NULL;
+	orl = NULL;
+	for (i = 0; i < iobuf->dr_npages; i++) {
+		if (sectors[i] == OSD_RCACHE_NONE)
+			continue;
+
+		/* the slots are still busy, their locks cannot change */
+		next = &cache->orc_slots[sectors[i] >> OSD_RCACHE_SECTOR_BITS];
+		if (next != slot) {
+			if (orl)
+				spin_unlock_irq(&orl->orl_lock);
+			slot = next;
+			orl = osd_rcache_slot_lock(cache, slot);
+			spin_lock_irq(&orl->orl_lock);
+		}
+
+		slot->ors_busy--;
+		if (rc != 0) {
+			/* don't trust the slot anymore */
+			bitmap_zero(slot->ors_valid, OSD_RCACHE_CHUNK_PAGES);
+			slot->ors_gen++;
+		}
+	}
+	if (orl)
+		spin_unlock_irq(&orl->orl_lock);
+
+	if (rc != 0) {
+		CDEBUG_LIMIT(D_ERROR,
+			     "%s: cannot read %d pages from read cache %s, read them from OST device: rc = %d\n",
+			     osd_name(osd), hits, cache->orc_path, rc);
+		goto out;
+	}
+
+	for (i = 0, j = 0; i < iobuf->dr_npages; i++) {
+		if (sectors[i] != OSD_RCACHE_NONE) {
+			SetPageUptodate(iobuf->dr_pages[i]);
+			unlock_page(iobuf->dr_pages[i]);
+			continue;
+		}
+		iobuf->dr_pages[j] = iobuf->dr_pages[i];
+		iobuf->dr_lnbs[j] = iobuf->dr_lnbs[i];
+		j++;
+	}
+	iobuf->dr_npages = j;
+
+out:
+	osd_rcache_put(cache);
+}
+
+/*
+ * Copy the pages [first, last) of \a iobuf, which belong to the same chunk,
+ * to the cache device if the chunk is accessed often enough.
+ */
+static void osd_rcache_admit_chunk(struct osd_device *osd,
+				   struct osd_rcache *cache,
+				   struct inode *inode,
+				   struct osd_iobuf *iobuf, int first,
+				   int last)
+{
+	pgoff_t chunk = osd_rcache_index(iobuf, first) >>
+			OSD_RCACHE_CHUNK_PAGE_BITS;
+	DECLARE_BITMAP(admit, OSD_RCACHE_CHUNK_PAGES);
+	unsigned int bucket = osd_rcache_bucket(cache, inode, chunk);
+	struct osd_rcache_lock *orl = osd_rcache_lock(cache, bucket);
+	struct osd_rcache_slot *slot;
+	struct osd_rcache_wio *wio = NULL;
+	struct bio *bio = NULL;
+	struct page *page;
+	unsigned int slotno;
+	unsigned int pg;
+	sector_t sector;
+	__u32 gen;
+	int i;
+
+	if (osd_rcache_sketch(cache, inode, chunk) < osd->od_rcache_admit)
+		return;
+
+	bitmap_zero(admit, OSD_RCACHE_CHUNK_PAGES);
+
+	spin_lock_irq(&orl->orl_lock);
+	slot = osd_rcache_find(cache, bucket, inode, chunk);
+	if (!slot)
+		slot = osd_rcache_alloc(cache, orl, bucket, inode, chunk);
+	if (!slot) {
+		spin_unlock_irq(&orl->orl_lock);
+		return;
+	}
+
+	for (i = first; i < last; i++) {
+		pg = osd_rcache_index(iobuf, i) & (OSD_RCACHE_CHUNK_PAGES - 1);
+		if (test_bit(pg, slot->ors_valid) ||
+		    test_bit(pg, slot->ors_pending))
+			continue;
+		set_bit(pg, slot->ors_pending);
+		set_bit(pg, admit);
+	}
+
+	/* hold the slot while the bios are built */
+	slot->ors_busy++;
+	gen = slot->ors_gen;
+	spin_unlock_irq(&orl->orl_lock);
+
+	slotno = slot - cache->orc_slots;
+	for (i = first; i < last; i++) {
+		pg = osd_rcache_index(iobuf, i) & (OSD_RCACHE_CHUNK_PAGES - 1);
+		if (!test_bit(pg, admit))
+			continue;
+
+		page = alloc_page(GFP_NOIO | __GFP_NOWARN);
+		if (!page)
+			break;
+		copy_highpage(page, iobuf->dr_pages[i]);
+
+		sector = osd_rcache_sector(cache, slot, pg);
+		if (bio && bio_end_sector(bio) == sector &&
+		    bio_add_page(bio, page, PAGE_SIZE, 0) == PAGE_SIZE) {
+			clear_bit(pg, admit);
+			wio->orw_count++;
+			continue;
+		}
+
+		if (bio) {
+			osd_rcache_submit_write(cache, bio);
+			bio = NULL;
+		}
+
+		OBD_ALLOC_GFP(wio, sizeof(*wio), GFP_NOIO);
+		if (!wio) {
+			__free_page(page);
+			break;
+		}
+
+		bio = bio_alloc(GFP_NOIO, min_t(int, BIO_MAX_PAGES,
+						last - i));
+		if (!bio) {
+			OBD_FREE_PTR(wio);
+			__free_page(page);
+			break;
+		}
+
+		wio->orw_cache = cache;
+		wio->orw_slot = slotno;
+		wio->orw_gen = gen;
+		wio->orw_first = pg;
+		wio->orw_count = 1;
+
+		bio_set_dev(bio, cache->orc_bdev);
+		bio_set_sector(bio, sector);
+		bio->bi_opf = WRITE;
+		bio->bi_end_io = osd_rcache_write_end_io;
+		bio->bi_private = wio;
+		bio_add_page(bio, page, PAGE_SIZE, 0);
+		clear_bit(pg, admit);
+	}
+	if (bio)
+		osd_rcache_submit_write(cache, bio);
+
+	/* the pages left in \a admit could not be submitted */
+	spin_lock_irq(&orl->orl_lock);
+	bitmap_andnot(slot->ors_pending, slot->ors_pending, admit,
+		      OSD_RCACHE_CHUNK_PAGES);
+	slot->ors_busy--;
+	spin_unlock_irq(&orl->orl_lock);
+}
+
+/**
+ * Admit the pages of \a iobuf just read from the OST device in the cache.
+ *
+ * Called with the pages still locked, so that they cannot be modified before
+ * they are copied, the cache device is written asynchronously.
+ */
+void osd_rcache_admit(struct osd_device *osd, struct inode *inode,
+		      struct osd_iobuf *iobuf)
+{
+	struct osd_rcache *cache;
+	pgoff_t chunk;
+	int i;
+	int j;
+
+	cache = osd_rcache_get(osd);
+	if (!cache)
+		return;
+
+	for (i = 0; i < iobuf->dr_npages; i = j) {
+		chunk = osd_rcache_index(iobuf, i) >>
+			OSD_RCACHE_CHUNK_PAGE_BITS;
+		for (j = i + 1; j < iobuf->dr_npages; j++)
+			if (osd_rcache_index(iobuf, j) >>
+			    OSD_RCACHE_CHUNK_PAGE_BITS != chunk)
+				break;
+
+		osd_rcache_admit_chunk(osd, cache, inode, iobuf, i, j);
+	}
+
+	osd_rcache_put(cache);
+}
+
+static void osd_rcache_slot_invalidate(struct osd_rcache_lock *orl,
+				       struct osd_rcache_slot *slot,
+				       pgoff_t first, pgoff_t last)
+{
+	pgoff_t base = slot->ors_chunk << OSD_RCACHE_CHUNK_PAGE_BITS;
+	unsigned int start;
+	unsigned int end;
+
+	start = max(first, base) - base;
+	end = min(last, base + OSD_RCACHE_CHUNK_PAGES - 1) - base;
+
+	bitmap_clear(slot->ors_valid, start, end - start + 1);
+	slot->ors_gen++;
+	orl->orl_invalidations++;
+}
+
+/* drop the pages of [start, end) of \a inode from the cache */
+void osd_rcache_invalidate(struct osd_device *osd, struct inode *inode,
+			   loff_t start, loff_t end)
+{
+	struct osd_rcache *cache;
+	struct osd_rcache_slot *slot;
+	struct osd_rcache_lock *orl;
+	unsigned int bucket;
+	pgoff_t first;
+	pgoff_t last;
+	pgoff_t chunk;
+	unsigned int i;
+
+	if (end <= start)
+		return;
+
+	cache = osd_rcache_get(osd);
+	if (!cache)
+		return;
+
+	first = start >> PAGE_SHIFT;
+	last = (end - 1) >> PAGE_SHIFT;
+
+	if ((last >> OSD_RCACHE_CHUNK_PAGE_BITS) -
+	    (first >> OSD_RCACHE_CHUNK_PAGE_BITS) >= cache->orc_nslots) {
+		/* cheaper to scan all the slots, e.g. punch to EOF */
+		for (i = 0; i < cache->orc_nslots; i++) {
+			slot = &cache->orc_slots[i];
+			/* checked again under the lock */
+			if (READ_ONCE(slot->ors_ino) != inode->i_ino)
+				continue;
+
+			orl = osd_rcache_slot_lock(cache, slot);
+			spin_lock_irq(&orl->orl_lock);
+			if (orl == osd_rcache_slot_lock(cache, slot) &&
+			    slot->ors_used && slot->ors_ino == inode->i_ino &&
+			    slot->ors_igen == inode->i_generation &&
+			    slot->ors_chunk >= first >> OSD_RCACHE_CHUNK_PAGE_BITS &&
+			    slot->ors_chunk <= last >> OSD_RCACHE_CHUNK_PAGE_BITS)
+				osd_rcache_slot_invalidate(orl, slot, first,
+							   last);
+			spin_unlock_irq(&orl->orl_lock);
+		}
+	} else {
+		for (chunk = first >> OSD_RCACHE_CHUNK_PAGE_BITS;
+		     chunk <= last >> OSD_RCACHE_CHUNK_PAGE_BITS; chunk++) {
+			bucket = osd_rcache_bucket(cache, inode, chunk);
+			orl = osd_rcache_lock(cache, bucket);
+			spin_lock_irq(&orl->orl_lock);
+			slot = osd_rcache_find(cache, bucket, inode, chunk);
+			if (slot)
+				osd_rcache_slot_invalidate(orl, slot, first,
+							   last);
+			spin_unlock_irq(&orl->orl_lock);
+		}
+	}
+
+	osd_rcache_put(cache);
+}
+
+static void osd_rcache_free(struct osd_rcache *cache)
+{
+	if (cache->orc_sketch)
+		OBD_FREE_LARGE(cache->orc_sketch,
+			       1U << OSD_RCACHE_SKETCH_BITS);
+	if (cache->orc_locks)
+		OBD_FREE_LARGE(cache->orc_locks, sizeof(*cache->orc_locks) *
+					       (cache->orc_lock_mask + 1));
+	if (cache->orc_hash)
+		OBD_FREE_LARGE(cache->orc_hash,
+			       sizeof(*cache->orc_hash) << cache->orc_hash_bits);
+	if (cache->orc_slots)
+		OBD_FREE_LARGE(cache->orc_slots,
+			       sizeof(*cache->orc_slots) * cache->orc_nslots);
+	if (cache->orc_path)
+		OBD_FREE(cache->orc_path, cache->orc_path_len);
+	if (cache->orc_bdev)
+		blkdev_put(cache->orc_bdev,
+			   FMODE_READ | FMODE_WRITE | FMODE_EXCL);
+	OBD_FREE_PTR(cache);
+}
+
+/* drop the reference of osd_device::od_rcache, wait for the users and bios */
+static void osd_rcache_release(struct osd_device *osd,
+			       struct osd_rcache *cache)
+{
+	osd_rcache_put(cache);
+	wait_event(osd->od_rcache_waitq, atomic_read(&cache->orc_refs) == 0);
+	osd_rcache_free(cache);
+}
+
+/**
+ * Use the block device \a path as read cache of \a osd.
+ *
+ * The device is opened exclusively, its whole content is overwritten. The
+ * current read cache, if any, is only replaced once the new one is ready, it
+ * is kept if \a path cannot be used or is already the cache device.
+ */
+int osd_rcache_attach(struct osd_device *osd, const char *path)
+{
+	struct block_device *bdev;
+	struct osd_rcache *cache;
+	struct osd_rcache *old;
+	unsigned long nslots;
+	unsigned int nlocks;
+	unsigned int i;
+	int rc;
+
+	ENTRY;
+
+	bdev = blkdev_get_by_path(path, FMODE_READ | FMODE_WRITE | FMODE_EXCL,
+				  osd);
+	if (IS_ERR(bdev))
+		RETURN(PTR_ERR(bdev));
+
+	OBD_ALLOC_PTR(cache);
+	if (!cache) {
+		blkdev_put(bdev, FMODE_READ | FMODE_WRITE | FMODE_EXCL);
+		RETURN(-ENOMEM);
+	}
+
+	cache->orc_osd = osd;
+	cache->orc_bdev = bdev;
+	atomic_set(&cache->orc_refs, 1);
+
+	nslots = i_size_read(bdev->bd_inode) >> OSD_RCACHE_CHUNK_SHIFT;
+	if (nslots < 2)
+		GOTO(out, rc = -EINVAL);
+	cache->orc_nslots = min_t(unsigned long, nslots, OSD_RCACHE_SLOTS_MAX);
+
+	cache->orc_path_len = strlen(path) + 1;
+	OBD_ALLOC(cache->orc_path, cache->orc_path_len);
+	if (!cache->orc_path)
+		GOTO(out, rc = -ENOMEM);
+	memcpy(cache->orc_path, path, cache->orc_path_len);
+
+	OBD_ALLOC_LARGE(cache->orc_slots,
+			sizeof(*cache->orc_slots) * cache->orc_nslots);
+	if (!cache->orc_slots)
+		GOTO(out, rc = -ENOMEM);
+
+	cache->orc_hash_bits = ilog2(roundup_pow_of_two(cache->orc_nslots));
+	OBD_ALLOC_LARGE(cache->orc_hash,
+			sizeof(*cache->orc_hash) << cache->orc_hash_bits);
+	if (!cache->orc_hash)
+		GOTO(out, rc = -ENOMEM);
+
+	nlocks = min_t(unsigned int, 1U << cache->orc_hash_bits,
+		       roundup_pow_of_two(num_possible_cpus() *
+					  OSD_RCACHE_LOCKS_PER_CPU));
+	OBD_ALLOC_LARGE(cache->orc_locks, sizeof(*cache->orc_locks) * nlocks);
+	if (!cache->orc_locks)
+		GOTO(out, rc = -ENOMEM);
+	cache->orc_lock_mask = nlocks - 1;
+
+	OBD_ALLOC_LARGE(cache->orc_sketch, 1U << OSD_RCACHE_SKETCH_BITS);
+	if (!cache->orc_sketch)
+		GOTO(out, rc = -ENOMEM);
+
+	for (i = 0; i < 1U << cache->orc_hash_bits; i++)
+		INIT_HLIST_HEAD(&cache->orc_hash[i]);
+	for (i = 0; i < nlocks; i++)
+		spin_lock_init(&cache->orc_locks[i].orl_lock);
+
+	spin_lock(&osd->od_rcache_lock);
+	old = osd->od_rcache;
+	if (old && old->orc_bdev == bdev) {
+		spin_unlock(&osd->od_rcache_lock);
+		GOTO(out, rc = 0);
+	}
+	osd->od_rcache = cache;
+	spin_unlock(&osd->od_rcache_lock);
+
+	if (old)
+		osd_rcache_release(osd, old);
+
+	LCONSOLE_INFO("%s: read cache on %s with %u chunks of %luKB\n",
+		      osd_name(osd), path, cache->orc_nslots,
+		      OSD_RCACHE_CHUNK_SIZE >> 10);
+	RETURN(0);
+
+out:
+	osd_rcache_free(cache);
+	RETURN(rc);
+}
+
+/* stop using the read cache of \a osd, wait for its users and bios */
+void osd_rcache_detach(struct osd_device *osd)
+{
+	struct osd_rcache *cache;
+
+	spin_lock(&osd->od_rcache_lock);
+	cache = osd->od_rcache;
+	osd->od_rcache = NULL;
+	spin_unlock(&osd->od_rcache_lock);
+
+	if (cache)
+		osd_rcache_release(osd, cache);
+}
+
+ssize_t osd_rcache_dev_show(struct osd_device *osd, char *buf)
+{
+	struct osd_rcache *cache;
+	ssize_t rc;
+
+	cache = osd_rcache_get(osd);
+	if (!cache)
+		return sprintf(buf, "none\n");
+
+	rc = scnprintf(buf, PAGE_SIZE, "%s\n", cache->orc_path);
+	osd_rcache_put(cache);
+
+	return rc;
+}
+
+void osd_rcache_dump(struct seq_file *m, struct osd_device *osd)
+{
+	struct osd_rcache *cache;
+	struct osd_rcache_lock *orl;
+	__u64 hits = 0;
+	__u64 misses = 0;
+	__u64 admits = 0;
+	__u64 evictions = 0;
+	__u64 invalidations = 0;
+	unsigned int i;
+
+	cache = osd_rcache_get(osd);
+	if (!cache) {
+		seq_puts(m, "device: none\n");
+		return;
+	}
+
+	for (i = 0; i <= cache->orc_lock_mask; i++) {
+		orl = &cache->orc_locks[i];
+		spin_lock_irq(&orl->orl_lock);
+		hits += orl->orl_hits;
+		misses += orl->orl_misses;
+		admits += orl->orl_admits;
+		evictions += orl->orl_evictions;
+		invalidations += orl->orl_invalidations;
+		spin_unlock_irq(&orl->orl_lock);
+	}
+
+	seq_printf(m, "device: %s\n"
+		   "chunks: %u\n"
+		   "chunk_kb: %lu\n"
+		   "hits: %llu\n"
+		   "misses: %llu\n"
+		   "admits: %llu\n"
+		   "evictions: %llu\n"
+		   "invalidations: %llu\n",
+		   cache->orc_path, cache->orc_nslots,
+		   OSD_RCACHE_CHUNK_SIZE >> 10, hits, misses, admits,
+		   evictions, invalidations);
+
+	osd_rcache_put(cache);
+}
@@ -51,6 +51,10 @@
 
 #define OSD_OTABLE_MAX_HASH		0x00000000ffffffffULL
 
+static unsigned int osd_scrub_threads = 1;
+module_param(osd_scrub_threads, uint, 0644);
+MODULE_PARM_DESC(osd_scrub_threads, "Default count of threads to scan the device in OI scrub at full speed");
+
 static inline int osd_scrub_has_window(struct lustre_scrub *scrub,
 				       struct osd_otable_cache *ooc)
 {
@@ -250,7 +254,7 @@ stop:
 
 static int
 osd_scrub_check_update(struct osd_thread_info *info, struct osd_device *dev,
-		       struct osd_idmap_cache *oic, int val)
+		       struct osd_idmap_cache *oic, int val, bool prior)
 {
 	struct lustre_scrub *scrub = &dev->od_scrub.os_scrub;
 	struct scrub_file	     *sf     = &scrub->os_file;
@@ -265,20 +269,27 @@ osd_scrub_check_update(struct osd_thread_info *info, struct osd_device *dev,
 	bool			      exist	= false;
 	ENTRY;
 
+	/* os_rwsem only protects the statistics and flags, the OI lookup and
+	 * update below may block on I/O and journal, and parallel OI scrub
+	 * threads call this concurrently. */
 	down_write(&scrub->os_rwsem);
 	scrub->os_new_checked++;
+	up_write(&scrub->os_rwsem);
 	if (val < 0)
 		GOTO(out, rc = val);
 
-	if (scrub->os_in_prior)
+	if (prior)
 		oii = list_entry(oic, struct osd_inconsistent_item,
 				 oii_cache);
 
 	if (lid->oii_ino < sf->sf_pos_latest_start && oii == NULL)
 		GOTO(out, rc = 0);
 
-	if (fid_is_igif(fid))
+	if (fid_is_igif(fid)) {
+		down_write(&scrub->os_rwsem);
 		sf->sf_items_igif++;
+		up_write(&scrub->os_rwsem);
+	}
 
 	if (val == SCRUB_NEXT_OSTOBJ_OLD) {
 		inode = osd_iget(info, dev, lid);
@@ -294,9 +305,11 @@ osd_scrub_check_update(struct osd_thread_info *info, struct osd_device *dev,
 		if (unlikely(osd_is_ea_inode(inode)))
 			GOTO(out, rc = 0);
 
+		down_write(&scrub->os_rwsem);
 		sf->sf_flags |= SF_UPGRADE;
 		sf->sf_internal_flags &= ~SIF_NO_HANDLE_OLD_FID;
 		dev->od_check_ff = 1;
+		up_write(&scrub->os_rwsem);
 		rc = osd_scrub_convert_ff(info, dev, inode, fid);
 		if (rc != 0)
 			GOTO(out, rc);
@@ -339,18 +352,21 @@ iget:
 				GOTO(out, rc = 0);
 		}
 
+		down_write(&scrub->os_rwsem);
 		if (!scrub->os_partial_scan)
 			scrub->os_full_speed = 1;
 
 		switch (val) {
 		case SCRUB_NEXT_NOLMA:
 			sf->sf_flags |= SF_UPGRADE;
+			up_write(&scrub->os_rwsem);
 			if (!(sf->sf_param & SP_DRYRUN)) {
 				rc = osd_ea_fid_set(info, inode, fid, 0, 0);
 				if (rc != 0)
 					GOTO(out, rc);
 			}
 
+			down_write(&scrub->os_rwsem);
 			if (!(sf->sf_flags & SF_INCONSISTENT))
 				dev->od_igif_inoi = 0;
 			break;
@@ -361,12 +377,17 @@ iget:
 		default:
 			break;
 		}
+		up_write(&scrub->os_rwsem);
 	} else if (osd_id_eq(lid, lid2)) {
-		if (converted)
+		if (converted) {
+			down_write(&scrub->os_rwsem);
 			sf->sf_items_updated++;
+			up_write(&scrub->os_rwsem);
+		}
 
 		GOTO(out, rc = 0);
 	} else {
+		down_write(&scrub->os_rwsem);
 		if (!scrub->os_partial_scan)
 			scrub->os_full_speed = 1;
 
@@ -385,6 +406,7 @@ iget:
 		 *	then ask the client to retry after upgrading completed.
 		 *	No better choice. */
 		dev->od_igif_inoi = 1;
+		up_write(&scrub->os_rwsem);
 	}
 
 	rc = osd_scrub_refresh_mapping(info, dev, fid, lid, ops, false,
@@ -392,7 +414,8 @@ iget:
 			 val == SCRUB_NEXT_OSTOBJ_OLD) ? OI_KNOWN_ON_OST : 0,
 			&exist);
 	if (rc == 0) {
-		if (scrub->os_in_prior)
+		down_write(&scrub->os_rwsem);
+		if (prior)
 			sf->sf_items_updated_prior++;
 		else
 			sf->sf_items_updated++;
@@ -404,16 +427,19 @@ iget:
 			if (unlikely(!ldiskfs_test_bit(idx, sf->sf_oi_bitmap)))
 				ldiskfs_set_bit(idx, sf->sf_oi_bitmap);
 		}
+		up_write(&scrub->os_rwsem);
 	}
 
 	GOTO(out, rc);
 
 out:
 	if (rc < 0) {
+		down_write(&scrub->os_rwsem);
 		sf->sf_items_failed++;
 		if (sf->sf_pos_first_inconsistent == 0 ||
 		    sf->sf_pos_first_inconsistent > lid->oii_ino)
 			sf->sf_pos_first_inconsistent = lid->oii_ino;
+		up_write(&scrub->os_rwsem);
 	} else {
 		rc = 0;
 	}
@@ -428,7 +454,6 @@ out:
 				(val == SCRUB_NEXT_OSTOBJ ||
 				 val == SCRUB_NEXT_OSTOBJ_OLD) ?
 				OI_KNOWN_ON_OST : 0, NULL);
-	up_write(&scrub->os_rwsem);
 
 	if (inode != NULL && !IS_ERR(inode))
 		iput(inode);
@@ -612,6 +637,43 @@ again:
 	return 0;
 }
 
+static inline ldiskfs_fsblk_t
+osd_scrub_itable_block(struct super_block *sb, struct ldiskfs_group_desc *desc)
+{
+	return le32_to_cpu(desc->bg_inode_table_lo) |
+	       (LDISKFS_DESC_SIZE(sb) >= LDISKFS_MIN_DESC_SIZE_64BIT ?
+		(ldiskfs_fsblk_t)le32_to_cpu(desc->bg_inode_table_hi) << 32 :
+		0);
+}
+
+/*
+ * Read ahead the inode table blocks of the group from \a offset to the last
+ * used inode, so that the inodes are not read one block each time.
+ */
+static void osd_scrub_prefetch(struct super_block *sb,
+			       struct ldiskfs_group_desc *desc, __u32 offset)
+{
+	__u32 used = LDISKFS_INODES_PER_GROUP(sb) -
+		     ldiskfs_itable_unused_count(sb, desc);
+	ldiskfs_fsblk_t block;
+	struct blk_plug plug;
+	__u64 start;
+	__u64 end;
+
+	if (offset >= used)
+		return;
+
+	block = osd_scrub_itable_block(sb, desc);
+	start = ((__u64)offset * LDISKFS_INODE_SIZE(sb)) >> sb->s_blocksize_bits;
+	end = ((__u64)used * LDISKFS_INODE_SIZE(sb) + sb->s_blocksize - 1) >>
+	      sb->s_blocksize_bits;
+
+	blk_start_plug(&plug);
+	for (; start < end; start++)
+		sb_breadahead(sb, block + start);
+	blk_finish_plug(&plug);
+}
+
 /**
  * \retval SCRUB_NEXT_OSTOBJ_OLD: FID-on-OST
  * \retval 0: FID-on-MDT
@@ -895,7 +957,7 @@ static int osd_scrub_exec(struct osd_thread_info *info, struct osd_device *dev,
 		goto wait;
 	}
 
-	rc = osd_scrub_check_update(info, dev, oic, rc);
+	rc = osd_scrub_check_update(info, dev, oic, rc, scrub->os_in_prior);
 	if (rc != 0) {
 		scrub->os_in_prior = 0;
 		return rc;
@@ -1026,6 +1088,287 @@ static void osd_scrub_join(const struct lu_env *env, struct osd_device *dev,
 	EXIT;
 }
 
+/* parallel OI scrub workers stop after one of them failed */
+static inline bool osd_scrub_workers_stopping(struct osd_device *dev)
+{
+	return READ_ONCE(dev->od_scrub.os_workers_rc) != 0;
+}
+
+/* check the inodes in block group \a bg from position \a pos */
+static int osd_scrub_group(struct osd_thread_info *info,
+			   struct osd_device *dev, struct osd_scrub_worker *osw,
+			   ldiskfs_group_t bg, __u64 pos)
+{
+	struct lustre_scrub *scrub = &dev->od_scrub.os_scrub;
+	struct ptlrpc_thread *thread = &scrub->os_thread;
+	struct scrub_file *sf = &scrub->os_file;
+	struct osd_iit_param *param = &osw->osw_param;
+	struct osd_idmap_cache *oic = &osw->osw_oic;
+	struct ldiskfs_group_desc *desc;
+	__u32 ipg = LDISKFS_INODES_PER_GROUP(param->sb);
+	int rc = 0;
+
+	desc = ldiskfs_get_group_desc(param->sb, bg, NULL);
+	if (!desc)
+		return -EIO;
+
+	if (desc->bg_flags & cpu_to_le16(LDISKFS_BG_INODE_UNINIT))
+		return 0;
+
+	param->bg = bg;
+	param->gbase = 1 + bg * ipg;
+	param->offset = (pos - 1) % ipg;
+	param->start = pos;
+
+	osd_scrub_prefetch(param->sb, desc, param->offset);
+	param->bitmap = ldiskfs_read_inode_bitmap(param->sb, bg);
+	if (!param->bitmap) {
+		CERROR("%s: fail to read bitmap for %u, scrub will stop, "
+		       "urgent mode\n", osd_scrub2name(scrub), (__u32)bg);
+		return -EIO;
+	}
+
+	while (thread_is_running(thread) && !osd_scrub_workers_stopping(dev)) {
+		if (param->offset + ldiskfs_itable_unused_count(param->sb, desc) >=
+		    ipg)
+			break;
+
+		rc = osd_iit_next(param, &pos);
+		if (rc == SCRUB_NEXT_BREAK) {
+			rc = 0;
+			break;
+		}
+
+		spin_lock(&scrub->os_lock);
+		osw->osw_pos = pos;
+		spin_unlock(&scrub->os_lock);
+
+		osw->osw_checked++;
+		rc = osd_iit_iget(info, dev, &oic->oic_fid, &oic->oic_lid, pos,
+				  param->sb, true);
+		if (rc == SCRUB_NEXT_NOSCRUB) {
+			down_write(&scrub->os_rwsem);
+			scrub->os_new_checked++;
+			sf->sf_items_noscrub++;
+			up_write(&scrub->os_rwsem);
+		}
+		if (rc == SCRUB_NEXT_NOSCRUB || rc == SCRUB_NEXT_CONTINUE) {
+			rc = 0;
+			continue;
+		}
+
+		rc = osd_scrub_check_update(info, dev, oic, rc, false);
+		if (rc)
+			break;
+	}
+
+	brelse(param->bitmap);
+	param->bitmap = NULL;
+
+	return rc;
+}
+
+static int osd_scrub_worker_main(void *args)
+{
+	struct osd_scrub_worker *osw = args;
+	struct osd_device *dev = osw->osw_dev;
+	struct osd_scrub *oscrub = &dev->od_scrub;
+	struct lustre_scrub *scrub = &oscrub->os_scrub;
+	struct ptlrpc_thread *thread = &scrub->os_thread;
+	struct super_block *sb = osd_sb(dev);
+	__u32 ipg = LDISKFS_INODES_PER_GROUP(sb);
+	__u32 limit = le32_to_cpu(LDISKFS_SB(sb)->s_es->s_inodes_count);
+	struct lu_env env;
+	ldiskfs_group_t bg;
+	__u64 pos;
+	int rc;
+
+	rc = lu_env_init(&env, LCT_LOCAL | LCT_DT_THREAD);
+	if (rc)
+		GOTO(out, rc);
+
+	osw->osw_param.sb = sb;
+	while (thread_is_running(thread) && !osd_scrub_workers_stopping(dev)) {
+		/* claim the next block group */
+		spin_lock(&scrub->os_lock);
+		pos = oscrub->os_next_pos;
+		if (pos > limit) {
+			osw->osw_pos = ~0ULL;
+			spin_unlock(&scrub->os_lock);
+			break;
+		}
+		bg = (pos - 1) / ipg;
+		oscrub->os_next_pos = 1 + (__u64)(bg + 1) * ipg;
+		osw->osw_pos = pos;
+		spin_unlock(&scrub->os_lock);
+
+		rc = osd_scrub_group(osd_oti_get(&env), dev, osw, bg, pos);
+		if (rc)
+			break;
+	}
+	lu_env_fini(&env);
+
+out:
+	spin_lock(&scrub->os_lock);
+	if (rc && !oscrub->os_workers_rc)
+		oscrub->os_workers_rc = rc;
+	osw->osw_pos = ~0ULL;
+	atomic_dec(&oscrub->os_workers_running);
+	wake_up_all(&thread->t_ctl_waitq);
+	spin_unlock(&scrub->os_lock);
+
+	return rc;
+}
+
+/*
+ * All inodes before the returned position have been checked, it's the lowest
+ * position of all workers, and the groups not claimed yet.
+ */
+static __u64 osd_scrub_workers_pos(struct osd_device *dev, int count)
+{
+	struct osd_scrub *oscrub = &dev->od_scrub;
+	__u64 pos;
+	int i;
+
+	spin_lock(&oscrub->os_scrub.os_lock);
+	pos = oscrub->os_next_pos;
+	for (i = 0; i < count; i++)
+		pos = min(pos, oscrub->os_workers[i].osw_pos);
+	spin_unlock(&oscrub->os_scrub.os_lock);
+
+	return pos;
+}
+
+/**
+ * Scan the device with multiple threads, used at full speed only.
+ *
+ * Block groups are claimed by the workers one by one in order, and each worker
+ * reads ahead the inode table of its group before checking the inodes. This
+ * thread handles the inconsistent items found by RPC, and saves checkpoint at
+ * the lowest position of the workers, so that a resumed scrub won't skip any
+ * inode.
+ *
+ * \retval SCRUB_IT_ALL	all the inodes have been checked
+ * \retval 0		the scrub is stopped
+ * \retval -ve		on error
+ */
+static int osd_scrub_parallel(struct osd_thread_info *info,
+			      struct osd_device *dev)
+{
+	struct osd_scrub *oscrub = &dev->od_scrub;
+	struct lustre_scrub *scrub = &oscrub->os_scrub;
+	struct ptlrpc_thread *thread = &scrub->os_thread;
+	struct osd_otable_it *it;
+	struct task_struct *task;
+	__u32 limit;
+	__u64 pos;
+	int count = oscrub->os_threads;
+	int rc = 0;
+	int i;
+
+	ENTRY;
+
+	OBD_ALLOC(oscrub->os_workers, sizeof(*oscrub->os_workers) * count);
+	if (!oscrub->os_workers)
+		RETURN(-ENOMEM);
+
+	limit = le32_to_cpu(LDISKFS_SB(osd_sb(dev))->s_es->s_inodes_count);
+	oscrub->os_next_pos = scrub->os_pos_current;
+	oscrub->os_workers_rc = 0;
+	for (i = 0; i < count; i++)
+		oscrub->os_workers[i].osw_pos = ~0ULL;
+
+	atomic_set(&oscrub->os_workers_running, count);
+	for (i = 0; i < count; i++) {
+		oscrub->os_workers[i].osw_dev = dev;
+		task = kthread_run(osd_scrub_worker_main, &oscrub->os_workers[i],
+				   "OI_scrub_%02d", i);
+		if (IS_ERR(task)) {
+			rc = PTR_ERR(task);
+			CERROR("%s: cannot start OI scrub thread %d: rc = %d\n",
+			       osd_scrub2name(scrub), i, rc);
+			atomic_sub(count - i, &oscrub->os_workers_running);
+			spin_lock(&scrub->os_lock);
+			oscrub->os_workers_rc = rc;
+			spin_unlock(&scrub->os_lock);
+			break;
+		}
+	}
+
+	CDEBUG(D_LFSCK, "%s: OI scrub with %d threads, pos = %llu\n",
+	       osd_scrub2name(scrub), i, scrub->os_pos_current);
+
+	while (atomic_read(&oscrub->os_workers_running) > 0) {
+		wait_event_idle_timeout(thread->t_ctl_waitq,
+			!thread_is_running(thread) ||
+			atomic_read(&oscrub->os_workers_running) == 0 ||
+			!list_empty(&scrub->os_inconsistent_items),
+			cfs_time_seconds(1));
+
+		/* handle the inconsistent items found by RPC */
+		while (thread_is_running(thread) &&
+		       !list_empty(&scrub->os_inconsistent_items)) {
+			struct osd_inconsistent_item *oii = NULL;
+
+			spin_lock(&scrub->os_lock);
+			if (likely(!list_empty(&scrub->os_inconsistent_items)))
+				oii = list_entry(
+					scrub->os_inconsistent_items.next,
+					struct osd_inconsistent_item, oii_list);
+			spin_unlock(&scrub->os_lock);
+			if (!oii)
+				break;
+
+			rc = osd_scrub_check_update(info, dev, &oii->oii_cache,
+						    0, true);
+			if (rc) {
+				spin_lock(&scrub->os_lock);
+				if (!oscrub->os_workers_rc)
+					oscrub->os_workers_rc = rc;
+				spin_unlock(&scrub->os_lock);
+				break;
+			}
+		}
+
+		pos = osd_scrub_workers_pos(dev, count);
+		down_write(&scrub->os_rwsem);
+		scrub->os_pos_current = pos - 1;
+		up_write(&scrub->os_rwsem);
+
+		it = dev->od_otable_it;
+		if (it && it->ooi_waiting &&
+		    it->ooi_cache.ooc_pos_preload < scrub->os_pos_current) {
+			spin_lock(&scrub->os_lock);
+			it->ooi_waiting = 0;
+			wake_up_all(&thread->t_ctl_waitq);
+			spin_unlock(&scrub->os_lock);
+		}
+
+		rc = scrub_checkpoint(info->oti_env, scrub);
+		if (rc)
+			CDEBUG(D_LFSCK, "%s: fail to checkpoint, pos = %llu: "
+			       "rc = %d\n", osd_scrub2name(scrub),
+			       scrub->os_pos_current, rc);
+	}
+
+	oscrub->os_workers_last = count;
+	for (i = 0; i < count; i++)
+		oscrub->os_workers_checked[i] =
+			oscrub->os_workers[i].osw_checked;
+
+	OBD_FREE(oscrub->os_workers, sizeof(*oscrub->os_workers) * count);
+	oscrub->os_workers = NULL;
+
+	if (oscrub->os_workers_rc)
+		RETURN(oscrub->os_workers_rc);
+
+	if (!thread_is_running(thread))
+		RETURN(0);
+
+	scrub->os_pos_current = oscrub->os_next_pos;
+	RETURN(scrub->os_pos_current > limit ? SCRUB_IT_ALL : 0);
+}
+
 static int osd_inode_iteration(struct osd_thread_info *info,
 			       struct osd_device *dev, __u32 max, bool preload)
 {
@@ -1132,6 +1475,9 @@ full:
 
 		if (unlikely(!thread_is_running(thread)))
 			RETURN(0);
+
+		if (scrub->os_full_speed && dev->od_scrub.os_threads > 1)
+			RETURN(osd_scrub_parallel(info, dev));
 	}
 
 	noslot = false;
@@ -1171,6 +1517,9 @@ full:
 			goto next_group;
 		}
 
+		if (!preload)
+			osd_scrub_prefetch(param->sb, desc, param->offset);
+
 		param->bitmap = ldiskfs_read_inode_bitmap(param->sb, param->bg);
 		if (!param->bitmap) {
 			CERROR("%s: fail to read bitmap for %u, "
@@ -2581,6 +2930,8 @@ int osd_scrub_setup(const struct lu_env *env, struct osd_device *dev)
 	ENTRY;
 
 	memset(&dev->od_scrub, 0, sizeof(struct osd_scrub));
+	dev->od_scrub.os_threads = clamp_t(unsigned int, osd_scrub_threads, 1,
+					   OSD_SCRUB_THREADS_MAX);
 	OBD_SET_CTXT_MAGIC(ctxt);
 	ctxt->pwdmnt = dev->od_mnt;
 	ctxt->pwd = dev->od_mnt->mnt_root;
@@ -3118,4 +3469,13 @@ void osd_scrub_dump(struct seq_file *m, struct osd_device *dev)
 			"inconsistent" : "repaired",
 		   scrub->os_lf_repaired,
 		   scrub->os_lf_failed);
+
+	if (scrub->os_workers_last > 1) {
+		int i;
+
+		seq_puts(m, "threads_checked:");
+		for (i = 0; i < scrub->os_workers_last; i++)
+			seq_printf(m, " %llu", scrub->os_workers_checked[i]);
+		seq_putc(m, '\n');
+	}
 }
@@ -51,6 +51,21 @@ struct osd_iit_param {
 	__u32 start;
 };
 
+/* max count of threads of parallel OI scrub */
+#define OSD_SCRUB_THREADS_MAX	32
+
+/* thread of parallel OI scrub, which checks one block group each time */
+struct osd_scrub_worker {
+	struct osd_device	*osw_dev;
+	struct osd_idmap_cache	 osw_oic;
+	struct osd_iit_param	 osw_param;
+	/* the inode under check, the ones before it in the group are done,
+	 * ~0ULL if the thread is idle, protected by lustre_scrub::os_lock */
+	__u64			 osw_pos;
+	/* count of inodes checked by the thread */
+	__u64			 osw_checked;
+};
+
 struct osd_scrub {
 	struct lustre_scrub	os_scrub;
 	struct lvfs_run_ctxt    os_ctxt;
@@ -69,6 +84,20 @@ struct osd_scrub {
 
 	__u64			os_bad_oimap_count;
 	time64_t		os_bad_oimap_time;
+
+	/* count of threads to scan the device at full speed */
+	unsigned int		os_threads;
+	/* parallel OI scrub: start position of the next block group to be
+	 * checked, protected by lustre_scrub::os_lock */
+	__u64			os_next_pos;
+	struct osd_scrub_worker	*os_workers;
+	atomic_t		os_workers_running;
+	/* the first failure of workers, which stops all of them */
+	int			os_workers_rc;
+	/* count of threads of the last parallel scan, and the count of
+	 * inodes checked by each of them */
+	int			os_workers_last;
+	__u64			os_workers_checked[OSD_SCRUB_THREADS_MAX];
 };
 
 #endif /* _OSD_SCRUB_H */
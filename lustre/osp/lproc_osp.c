@@ -296,6 +296,60 @@ static ssize_t max_rpcs_in_progress_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(max_rpcs_in_progress);
 
+/**
+ * Show maximum number of objects destroyed by one RPC
+ *
+ * \param[in] kobj	kobject of the OSP device
+ * \param[in] attr	unused
+ * \param[in] buf	buffer to write the value to
+ * \retval		number of bytes written
+ */
+static ssize_t destroy_batch_max_show(struct kobject *kobj,
+				      struct attribute *attr,
+				      char *buf)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osp_device *osp = dt2osp_dev(dt);
+
+	return sprintf(buf, "%u\n", osp->opd_sync_batch_max);
+}
+
+/**
+ * Change maximum number of objects destroyed by one RPC, 1 disables
+ * batching of destroys
+ *
+ * \param[in] kobj	kobject of the OSP device
+ * \param[in] attr	unused
+ * \param[in] buffer	string which represents maximum number
+ * \param[in] count	\a buffer length
+ * \retval		\a count on success
+ * \retval		negative number on error
+ */
+static ssize_t destroy_batch_max_store(struct kobject *kobj,
+				       struct attribute *attr,
+				       const char *buffer,
+				       size_t count)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osp_device *osp = dt2osp_dev(dt);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val == 0 || val > OST_DESTROY_BATCH_MAX)
+		return -ERANGE;
+
+	osp->opd_sync_batch_max = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(destroy_batch_max);
+
 /**
  * Show number of objects to precreate next time
  *
@@ -994,6 +1048,7 @@ static struct attribute *osp_obd_attrs[] = {
 	&lustre_attr_active.attr,
 	&lustre_attr_max_rpcs_in_flight.attr,
 	&lustre_attr_max_rpcs_in_progress.attr,
+	&lustre_attr_destroy_batch_max.attr,
 	&lustre_attr_maxage.attr,
 	&lustre_attr_ost_conn_uuid.attr,
 	&lustre_attr_ping.attr,
@@ -241,6 +241,13 @@ struct osp_device {
 	/* stop processing new requests until barrier=0 */
 	atomic_t			 opd_sync_barrier;
 	wait_queue_head_t		 opd_sync_barrier_waitq;
+	/* destroys collected for one OST_DESTROY RPC, only used by the
+	 * sync thread, see OBD_CONNECT2_DESTROY_BATCH */
+	struct ost_id			*opd_sync_batch_ids;
+	struct llog_cookie		*opd_sync_batch_cookies;
+	int				 opd_sync_batch_count;
+	/* max objects per batched destroy, 1 disables batching */
+	int				 opd_sync_batch_max;
 	/* last generated id */
 	ktime_t				 opd_sync_next_commit_cb;
 	atomic_t			 opd_commits_registered;
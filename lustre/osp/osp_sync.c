@@ -76,6 +76,12 @@
  *
  * opd_sync_rpcs_in_flight is a number of RPC in flight.
  * we control this with OSP_MAX_RPCS_IN_FLIGHT
+ *
+ * if the OST supports OBD_CONNECT2_DESTROY_BATCH then unlink records are
+ * collected in opd_sync_batch_* and sent as one OST_DESTROY RPC carrying
+ * an array of objects, once opd_sync_batch_max records are collected or
+ * the thread is going to wait. such RPC holds a single slot in the counters
+ * above, its cookies are cancelled together upon commit.
  */
 
 /* XXX: do math to learn reasonable threshold
@@ -84,6 +90,7 @@
 #define OSP_SYNC_THRESHOLD		10
 #define OSP_MAX_RPCS_IN_FLIGHT		8
 #define OSP_MAX_RPCS_IN_PROGRESS	4096
+#define OSP_DESTROY_BATCH_DEFAULT	64
 
 #define OSP_JOB_MAGIC		0x26112005
 
@@ -94,6 +101,10 @@ struct osp_job_req_args {
 	struct list_head		jra_in_flight_link;
 	struct llog_cookie		jra_lcookie;
 	__u32				jra_magic;
+	/* number of records in a batched destroy, 0 otherwise */
+	__u32				jra_count;
+	/* cookies of a batched destroy, jra_lcookie is unused then */
+	struct llog_cookie		*jra_lcookies;
 };
 
 static int osp_sync_add_commit_cb(const struct lu_env *env,
@@ -137,9 +148,11 @@ static inline int osp_sync_in_flight_conflict(struct osp_device *d,
 	struct osp_job_req_args	*jra;
 	struct ost_id		 ostid;
 	int			 conflict = 0;
+	int			 i;
 
 	if (h == NULL || h->lrh_type == LLOG_GEN_REC ||
-	    list_empty(&d->opd_sync_in_flight_list))
+	    (list_empty(&d->opd_sync_in_flight_list) &&
+	     d->opd_sync_batch_count == 0))
 		return conflict;
 
 	memset(&ostid, 0, sizeof(ostid));
@@ -166,16 +179,36 @@ static inline int osp_sync_in_flight_conflict(struct osp_device *d,
 		LBUG();
 	}
 
+	/* the batch being collected is sent once we have to wait */
+	for (i = 0; i < d->opd_sync_batch_count; i++)
+		if (memcmp(&ostid, &d->opd_sync_batch_ids[i],
+			   sizeof(ostid)) == 0)
+			return 1;
+
 	spin_lock(&d->opd_sync_lock);
 	list_for_each_entry(jra, &d->opd_sync_in_flight_list,
 			    jra_in_flight_link) {
 		struct ptlrpc_request	*req;
 		struct ost_body		*body;
+		struct ost_id		*oids;
 
 		LASSERT(jra->jra_magic == OSP_JOB_MAGIC);
 
 		req = container_of((void *)jra, struct ptlrpc_request,
 				   rq_async_args);
+		if (jra->jra_count > 0) {
+			oids = req_capsule_client_get(&req->rq_pill,
+						      &RMF_OST_ID_ARRAY);
+			LASSERT(oids);
+			for (i = 0; i < jra->jra_count; i++)
+				if (memcmp(&ostid, &oids[i],
+					   sizeof(ostid)) == 0)
+					conflict = 1;
+			if (conflict)
+				break;
+			continue;
+		}
+
 		body = req_capsule_client_get(&req->rq_pill,
 					      &RMF_OST_BODY);
 		LASSERT(body);
@@ -575,7 +608,11 @@ static int osp_sync_interpret(const struct lu_env *env,
 	if (rc == -ENOENT) {
 		/*
 		 * we tried to destroy object or update attributes,
-		 * but object doesn't exist anymore - cancell llog record
+		 * but object doesn't exist anymore - cancell llog record.
+		 * a batched destroy which stopped on an error after some
+		 * progress is replied with success, the records of the
+		 * objects it did not process are sent again once it's
+		 * committed, see osp_sync_batch_done().
 		 */
 		LASSERT(req->rq_transno == 0);
 		LASSERT(list_empty(&jra->jra_committed_link));
@@ -604,6 +641,12 @@ static int osp_sync_interpret(const struct lu_env *env,
 			 * will be called at some point */
 			LASSERT(atomic_read(&d->opd_sync_rpcs_in_progress) > 0);
 			atomic_dec(&d->opd_sync_rpcs_in_progress);
+			if (jra->jra_lcookies != NULL) {
+				OBD_FREE_LARGE(jra->jra_lcookies,
+					       sizeof(*jra->jra_lcookies) *
+					       jra->jra_count);
+				jra->jra_lcookies = NULL;
+			}
 		}
 
 		wake_up(&d->opd_sync_waitq);
@@ -633,20 +676,23 @@ static int osp_sync_interpret(const struct lu_env *env,
 	return 0;
 }
 
-/*
- ** Add request to ptlrpc queue.
+/**
+ * Add request to ptlrpc queue.
  *
- * This is just a tiny helper function to put the request on the sending list
+ * The request applies either a single change identified by \a lcookie, or
+ * \a count changes of a batched destroy whose cookies are in \a lcookies.
+ * The latter array is owned by the request since then.
  *
  * \param[in] d		OSP device
- * \param[in] llh	llog handle where the record is stored
- * \param[in] h		llog record
  * \param[in] req	request
+ * \param[in] lcookie	cookie of a single change
+ * \param[in] lcookies	cookies of a batched destroy
+ * \param[in] count	number of cookies in \a lcookies
  */
-static void osp_sync_send_new_rpc(struct osp_device *d,
-				  struct llog_handle *llh,
-				  struct llog_rec_hdr *h,
-				  struct ptlrpc_request *req)
+static void osp_sync_send_rpc(struct osp_device *d,
+			      struct ptlrpc_request *req,
+			      const struct llog_cookie *lcookie,
+			      struct llog_cookie *lcookies, int count)
 {
 	struct osp_job_req_args *jra;
 
@@ -655,9 +701,12 @@ static void osp_sync_send_new_rpc(struct osp_device *d,
 
 	jra = ptlrpc_req_async_args(jra, req);
 	jra->jra_magic = OSP_JOB_MAGIC;
-	jra->jra_lcookie.lgc_lgl = llh->lgh_id;
-	jra->jra_lcookie.lgc_subsys = LLOG_MDS_OST_ORIG_CTXT;
-	jra->jra_lcookie.lgc_index = h->lrh_index;
+	if (lcookies != NULL)
+		memset(&jra->jra_lcookie, 0, sizeof(jra->jra_lcookie));
+	else
+		jra->jra_lcookie = *lcookie;
+	jra->jra_lcookies = lcookies;
+	jra->jra_count = count;
 	INIT_LIST_HEAD(&jra->jra_committed_link);
 	spin_lock(&d->opd_sync_lock);
 	list_add_tail(&jra->jra_in_flight_link, &d->opd_sync_in_flight_list);
@@ -666,6 +715,31 @@ static void osp_sync_send_new_rpc(struct osp_device *d,
 	ptlrpcd_add_req(req);
 }
 
+/*
+ ** Add request to ptlrpc queue.
+ *
+ * This is just a tiny helper function to put the request applying the given
+ * llog record on the sending list
+ *
+ * \param[in] d		OSP device
+ * \param[in] llh	llog handle where the record is stored
+ * \param[in] h		llog record
+ * \param[in] req	request
+ */
+static void osp_sync_send_new_rpc(struct osp_device *d,
+				  struct llog_handle *llh,
+				  struct llog_rec_hdr *h,
+				  struct ptlrpc_request *req)
+{
+	struct llog_cookie lcookie;
+
+	lcookie.lgc_lgl = llh->lgh_id;
+	lcookie.lgc_subsys = LLOG_MDS_OST_ORIG_CTXT;
+	lcookie.lgc_index = h->lrh_index;
+
+	osp_sync_send_rpc(d, req, &lcookie, NULL, 0);
+}
+
 
 /**
  * Allocate and prepare RPC for a new change.
@@ -678,13 +752,15 @@ static void osp_sync_send_new_rpc(struct osp_device *d,
  * \param[in] d		OSP device
  * \param[in] op	type of the change
  * \param[in] format	request format to be used
+ * \param[in] count	number of objects in a batched destroy, 0 otherwise
  *
  * \retval pointer		new request on success
  * \retval ERR_PTR(errno)	on error
  */
 static struct ptlrpc_request *osp_sync_new_job(struct osp_device *d,
 					       enum ost_cmd op,
-					       const struct req_format *format)
+					       const struct req_format *format,
+					       int count)
 {
 	struct ptlrpc_request	*req;
 	struct obd_import	*imp;
@@ -701,6 +777,10 @@ static struct ptlrpc_request *osp_sync_new_job(struct osp_device *d,
 	if (req == NULL)
 		RETURN(ERR_PTR(-ENOMEM));
 
+	if (count > 0)
+		req_capsule_set_size(&req->rq_pill, &RMF_OST_ID_ARRAY,
+				     RCL_CLIENT, sizeof(struct ost_id) * count);
+
 	rc = ptlrpc_request_pack(req, LUSTRE_OST_VERSION, op);
 	if (rc) {
 		ptlrpc_req_finished(req);
@@ -754,7 +834,7 @@ static int osp_sync_new_setattr_job(struct osp_device *d,
 		RETURN(1);
 	}
 
-	req = osp_sync_new_job(d, OST_SETATTR, &RQF_OST_SETATTR);
+	req = osp_sync_new_job(d, OST_SETATTR, &RQF_OST_SETATTR, 0);
 	if (IS_ERR(req))
 		RETURN(PTR_ERR(req));
 
@@ -814,7 +894,7 @@ static int osp_sync_new_unlink_job(struct osp_device *d,
 	ENTRY;
 	LASSERT(h->lrh_type == MDS_UNLINK_REC);
 
-	req = osp_sync_new_job(d, OST_DESTROY, &RQF_OST_DESTROY);
+	req = osp_sync_new_job(d, OST_DESTROY, &RQF_OST_DESTROY, 0);
 	if (IS_ERR(req))
 		RETURN(PTR_ERR(req));
 
@@ -862,7 +942,7 @@ static int osp_sync_new_unlink64_job(struct osp_device *d,
 
 	ENTRY;
 	LASSERT(h->lrh_type == MDS_UNLINK64_REC);
-	req = osp_sync_new_job(d, OST_DESTROY, &RQF_OST_DESTROY);
+	req = osp_sync_new_job(d, OST_DESTROY, &RQF_OST_DESTROY, 0);
 	if (IS_ERR(req))
 		RETURN(PTR_ERR(req));
 
@@ -879,6 +959,223 @@ static int osp_sync_new_unlink64_job(struct osp_device *d,
 	RETURN(0);
 }
 
+/**
+ * Check whether unlink records can be batched.
+ *
+ * \param[in] d		OSP device
+ *
+ * \retval		max number of objects in a batched destroy
+ * \retval 0		if the OST doesn't support batched destroy
+ */
+static int osp_sync_batch_max(struct osp_device *d)
+{
+	struct obd_connect_data *ocd;
+	int max = min(d->opd_sync_batch_max, OST_DESTROY_BATCH_MAX);
+
+	if (d->opd_sync_batch_ids == NULL || max <= 1)
+		return 0;
+
+	ocd = &d->opd_obd->u.cli.cl_import->imp_connect_data;
+	if (!(ocd->ocd_connect_flags & OBD_CONNECT_FLAGS2) ||
+	    !(ocd->ocd_connect_flags2 & OBD_CONNECT2_DESTROY_BATCH))
+		return 0;
+
+	return max;
+}
+
+/**
+ * Forget the collected destroys.
+ *
+ * The records stay in the llog and are processed again on the next boot.
+ *
+ * \param[in] d		OSP device
+ */
+static void osp_sync_batch_drop(struct osp_device *d)
+{
+	if (d->opd_sync_batch_count == 0)
+		return;
+
+	d->opd_sync_batch_count = 0;
+	atomic_dec(&d->opd_sync_rpcs_in_flight);
+	atomic_dec(&d->opd_sync_rpcs_in_progress);
+	wake_up(&d->opd_sync_waitq);
+}
+
+/**
+ * Send a batched destroy.
+ *
+ * The function prepares one OST_DESTROY RPC with the array of objects
+ * \a oids. A single object is sent the usual way. The caller provides the
+ * slot in the flow control counters taken by the RPC.
+ *
+ * \param[in] d		OSP device
+ * \param[in] oids	objects to destroy
+ * \param[in] cookies	cookies of the llog records of \a oids
+ * \param[in] count	number of entries in \a oids
+ *
+ * \retval 0		on success
+ * \retval negative	negated errno on error
+ */
+static int osp_sync_batch_rpc(struct osp_device *d, const struct ost_id *oids,
+			      const struct llog_cookie *cookies, int count)
+{
+	struct llog_cookie *lcookies = NULL;
+	struct ptlrpc_request *req;
+	struct ost_body *body;
+	struct ost_id *ids;
+
+	ENTRY;
+
+	if (count > 1) {
+		OBD_ALLOC_LARGE(lcookies, sizeof(*lcookies) * count);
+		if (lcookies == NULL)
+			RETURN(-ENOMEM);
+		memcpy(lcookies, cookies, sizeof(*lcookies) * count);
+		req = osp_sync_new_job(d, OST_DESTROY, &RQF_OST_DESTROY_BATCH,
+				       count);
+	} else {
+		req = osp_sync_new_job(d, OST_DESTROY, &RQF_OST_DESTROY, 0);
+	}
+	if (IS_ERR(req)) {
+		if (lcookies != NULL)
+			OBD_FREE_LARGE(lcookies, sizeof(*lcookies) * count);
+		RETURN(PTR_ERR(req));
+	}
+
+	body = req_capsule_client_get(&req->rq_pill, &RMF_OST_BODY);
+	LASSERT(body);
+	body->oa.o_oi = oids[0];
+	body->oa.o_valid = OBD_MD_FLGROUP | OBD_MD_FLID;
+	if (count > 1) {
+		/* no OBD_MD_FLOBJCOUNT, o_misc is the array size only */
+		body->oa.o_misc = count;
+		ids = req_capsule_client_get(&req->rq_pill, &RMF_OST_ID_ARRAY);
+		LASSERT(ids);
+		memcpy(ids, oids, sizeof(*ids) * count);
+	} else {
+		body->oa.o_misc = 1;
+		body->oa.o_valid |= OBD_MD_FLOBJCOUNT;
+	}
+
+	CDEBUG(D_HA, "%s: destroy %d objects from "DOSTID"\n",
+	       d->opd_obd->obd_name, count, POSTID(&body->oa.o_oi));
+
+	osp_sync_send_rpc(d, req, &cookies[0], lcookies,
+			  count > 1 ? count : 0);
+	RETURN(0);
+}
+
+/**
+ * Send the collected destroys.
+ *
+ * The RPC takes the slot in the flow control counters held by the batch.
+ *
+ * \param[in] d		OSP device
+ */
+static void osp_sync_batch_send(struct osp_device *d)
+{
+	int count = d->opd_sync_batch_count;
+	int rc;
+
+	if (count == 0)
+		return;
+
+	rc = osp_sync_batch_rpc(d, d->opd_sync_batch_ids,
+				d->opd_sync_batch_cookies, count);
+	if (rc == 0) {
+		d->opd_sync_batch_count = 0;
+		return;
+	}
+
+	CERROR("%s: can't send destroy of %d objects: rc = %d\n",
+	       d->opd_obd->obd_name, count, rc);
+	osp_sync_batch_drop(d);
+}
+
+/**
+ * Send again the destroys of a batch the OST did not process.
+ *
+ * The OST stops at the first object it fails to destroy, the records of
+ * this object and the following ones are sent in a new batch instead of
+ * being kept till the next boot. This is only done if the OST processed
+ * some of the objects, so that a persistent failure doesn't loop.
+ *
+ * \param[in] d		OSP device
+ * \param[in] req	batched destroy replied
+ * \param[in] jra	request arguments
+ * \param[in] done	number of leading objects processed by the OST
+ */
+static void osp_sync_batch_requeue(struct osp_device *d,
+				   struct ptlrpc_request *req,
+				   struct osp_job_req_args *jra, int done)
+{
+	struct ost_id *oids;
+	int rc;
+
+	if (done == 0 || done >= jra->jra_count || !osp_sync_running(d))
+		return;
+
+	oids = req_capsule_client_get(&req->rq_pill, &RMF_OST_ID_ARRAY);
+	LASSERT(oids);
+
+	atomic_inc(&d->opd_sync_rpcs_in_flight);
+	atomic_inc(&d->opd_sync_rpcs_in_progress);
+	rc = osp_sync_batch_rpc(d, oids + done, jra->jra_lcookies + done,
+				jra->jra_count - done);
+	if (rc != 0) {
+		atomic_dec(&d->opd_sync_rpcs_in_flight);
+		atomic_dec(&d->opd_sync_rpcs_in_progress);
+		CERROR("%s: can't send destroy of %d objects again: rc = %d\n",
+		       d->opd_obd->obd_name, jra->jra_count - done, rc);
+	}
+}
+
+/**
+ * Collect unlink change into a batched destroy.
+ *
+ * Only the first record of a batch keeps the slot in the flow control
+ * counters taken by osp_sync_process_record(), the batch is sent once it
+ * is full or the sync thread is going to wait for something.
+ *
+ * \param[in] d		OSP device
+ * \param[in] llh	llog handle where the record is stored
+ * \param[in] h		llog record
+ * \param[in] max	max number of objects in the batch
+ *
+ * \retval 0		on success
+ * \retval negative	negated errno on error
+ */
+static int osp_sync_batch_add(struct osp_device *d, struct llog_handle *llh,
+			      struct llog_rec_hdr *h, int max)
+{
+	struct llog_unlink64_rec *rec = (struct llog_unlink64_rec *)h;
+	struct llog_cookie *lcookie;
+	int rc;
+
+	ENTRY;
+	LASSERT(h->lrh_type == MDS_UNLINK64_REC);
+
+	rc = fid_to_ostid(&rec->lur_fid,
+			  &d->opd_sync_batch_ids[d->opd_sync_batch_count]);
+	if (rc < 0)
+		RETURN(rc);
+
+	lcookie = &d->opd_sync_batch_cookies[d->opd_sync_batch_count];
+	lcookie->lgc_lgl = llh->lgh_id;
+	lcookie->lgc_subsys = LLOG_MDS_OST_ORIG_CTXT;
+	lcookie->lgc_index = h->lrh_index;
+
+	if (d->opd_sync_batch_count++ > 0) {
+		atomic_dec(&d->opd_sync_rpcs_in_flight);
+		atomic_dec(&d->opd_sync_rpcs_in_progress);
+	}
+
+	if (d->opd_sync_batch_count >= max)
+		osp_sync_batch_send(d);
+
+	RETURN(0);
+}
+
 /**
  * Process llog records.
  *
@@ -902,6 +1199,7 @@ static void osp_sync_process_record(const struct lu_env *env,
 {
 	struct llog_handle	*cathandle = llh->u.phd.phd_cat_handle;
 	struct llog_cookie	 cookie;
+	int			 batch_max;
 	int			 rc = 0;
 
 	ENTRY;
@@ -948,7 +1246,12 @@ static void osp_sync_process_record(const struct lu_env *env,
 		rc = osp_sync_new_unlink_job(d, llh, rec);
 		break;
 	case MDS_UNLINK64_REC:
-		rc = osp_sync_new_unlink64_job(d, llh, rec);
+		batch_max = osp_sync_batch_max(d);
+		if (batch_max > 0 &&
+		    ((struct llog_unlink64_rec *)rec)->lur_count <= 1)
+			rc = osp_sync_batch_add(d, llh, rec, batch_max);
+		else
+			rc = osp_sync_new_unlink64_job(d, llh, rec);
 		break;
 	case MDS_SETATTR64_REC:
 		rc = osp_sync_new_setattr_job(d, llh, rec);
@@ -996,6 +1299,39 @@ static void osp_sync_process_record(const struct lu_env *env,
 	RETURN_EXIT;
 }
 
+/**
+ * Get the number of records applied by a batched destroy.
+ *
+ * The OST returns the number of leading objects which are gone in o_misc
+ * of the reply, the rest of the records are sent again by
+ * osp_sync_batch_requeue().
+ *
+ * \param[in] req	request replied
+ * \param[in] jra	request arguments
+ *
+ * \retval		number of records to cancel
+ */
+static int osp_sync_batch_done(struct ptlrpc_request *req,
+			       struct osp_job_req_args *jra)
+{
+	struct ost_body *body = NULL;
+	int done = 0;
+
+	if (req->rq_repmsg != NULL)
+		body = req_capsule_server_get(&req->rq_pill, &RMF_OST_BODY);
+	if (body != NULL && body->oa.o_valid & OBD_MD_FLOBJCOUNT)
+		done = min_t(int, body->oa.o_misc, jra->jra_count);
+	else if (req->rq_status == 0 || req->rq_status == -ENOENT)
+		/* the OST handled the first object only */
+		done = 1;
+
+	if (done < jra->jra_count)
+		DEBUG_REQ(D_HA, req, "%d of %d objects destroyed", done,
+			  jra->jra_count);
+
+	return done;
+}
+
 /**
  * Cancel llog records for the committed changes.
  *
@@ -1019,7 +1355,7 @@ static void osp_sync_process_committed(const struct lu_env *env,
 	LIST_HEAD(list);
 	struct list_head	 *le;
 	struct llog_logid	 lgid;
-	int			 rc, i, count = 0, done = 0;
+	int			 rc, i, j, count = 0, done = 0;
 
 	ENTRY;
 
@@ -1053,8 +1389,13 @@ static void osp_sync_process_committed(const struct lu_env *env,
 	INIT_LIST_HEAD(&d->opd_sync_committed_there);
 	spin_unlock(&d->opd_sync_lock);
 
-	list_for_each(le, &list)
-		count++;
+	list_for_each(le, &list) {
+		struct osp_job_req_args	*jra;
+
+		jra = list_entry(le, struct osp_job_req_args,
+				 jra_committed_link);
+		count += jra->jra_count > 0 ? jra->jra_count : 1;
+	}
 	if (count > 2)
 		OBD_ALLOC_WAIT(arr, sizeof(int) * count);
 	else
@@ -1076,24 +1417,44 @@ static void osp_sync_process_committed(const struct lu_env *env,
 		/* import can be closing, thus all commit cb's are
 		 * called we can check committness directly */
 		if (req->rq_import_generation == imp->imp_generation) {
-			if (arr && (!i ||
-				    !memcmp(&jra->jra_lcookie.lgc_lgl, &lgid,
-					   sizeof(lgid)))) {
-				if (unlikely(!i))
-					lgid = jra->jra_lcookie.lgc_lgl;
-
-				arr[i++] = jra->jra_lcookie.lgc_index;
-			} else {
-				rc = llog_cat_cancel_records(env, llh, 1,
-							     &jra->jra_lcookie);
-				if (rc)
-					CERROR("%s: can't cancel record: %d\n",
-					       obd->obd_name, rc);
+			struct llog_cookie *lcookie = &jra->jra_lcookie;
+			int n = 1;
+
+			if (jra->jra_count > 0) {
+				lcookie = jra->jra_lcookies;
+				n = osp_sync_batch_done(req, jra);
+			}
+
+			for (j = 0; j < n; j++, lcookie++) {
+				if (arr && (!i ||
+					    !memcmp(&lcookie->lgc_lgl, &lgid,
+						    sizeof(lgid)))) {
+					if (unlikely(!i))
+						lgid = lcookie->lgc_lgl;
+
+					arr[i++] = lcookie->lgc_index;
+				} else {
+					rc = llog_cat_cancel_records(env, llh,
+								     1,
+								     lcookie);
+					if (rc)
+						CERROR("%s: can't cancel record: %d\n",
+						       obd->obd_name, rc);
+				}
 			}
+
+			if (jra->jra_count > 0)
+				osp_sync_batch_requeue(d, req, jra, n);
 		} else {
 			DEBUG_REQ(D_OTHER, req, "imp_committed = %llu",
 				  imp->imp_peer_committed_transno);
 		}
+		if (jra->jra_lcookies != NULL) {
+			OBD_FREE_LARGE(jra->jra_lcookies,
+				       sizeof(*jra->jra_lcookies) *
+				       jra->jra_count);
+			jra->jra_lcookies = NULL;
+		}
 		ptlrpc_req_finished(req);
 		done++;
 	}
@@ -1155,6 +1516,7 @@ static int osp_sync_process_queues(const struct lu_env *env,
 	do {
 		if (!osp_sync_running(d)) {
 			CDEBUG(D_HA, "stop llog processing\n");
+			osp_sync_batch_drop(d);
 			return LLOG_PROC_BREAK;
 		}
 
@@ -1181,6 +1543,11 @@ static int osp_sync_process_queues(const struct lu_env *env,
 			    cfs_fail_val != 1)
 			msleep(1 * MSEC_PER_SEC);
 
+		/* don't keep collected destroys while waiting */
+		if (d->opd_sync_batch_count > 0 &&
+		    !osp_sync_can_process_new(d, rec))
+			osp_sync_batch_send(d);
+
 		wait_event_idle(d->opd_sync_waitq,
 				!osp_sync_running(d) ||
 				osp_sync_can_process_new(d, rec) ||
@@ -1288,6 +1655,8 @@ next:
 			     d->opd_sync_last_catalog_idx == LLOG_CAT_FIRST));
 
 	if (rc < 0) {
+		/* the collected records are found again by the next scan */
+		osp_sync_batch_drop(d);
 		if (rc == -EINPROGRESS) {
 			/* can't access the llog now - OI scrub is trying to fix
 			 * underlying issue. let's wait and try again */
@@ -1513,6 +1882,26 @@ static void osp_sync_llog_fini(const struct lu_env *env, struct osp_device *d)
 	}
 }
 
+/**
+ * Release the buffers used to collect batched destroys.
+ *
+ * \param[in] d		OSP device
+ */
+static void osp_sync_batch_free(struct osp_device *d)
+{
+	if (d->opd_sync_batch_ids != NULL) {
+		OBD_FREE_LARGE(d->opd_sync_batch_ids,
+			       sizeof(struct ost_id) * OST_DESTROY_BATCH_MAX);
+		d->opd_sync_batch_ids = NULL;
+	}
+	if (d->opd_sync_batch_cookies != NULL) {
+		OBD_FREE_LARGE(d->opd_sync_batch_cookies,
+			       sizeof(struct llog_cookie) *
+			       OST_DESTROY_BATCH_MAX);
+		d->opd_sync_batch_cookies = NULL;
+	}
+}
+
 /**
  * Initialization of the sync component of OSP.
  *
@@ -1534,6 +1923,7 @@ int osp_sync_init(const struct lu_env *env, struct osp_device *d)
 
 	d->opd_sync_max_rpcs_in_flight = OSP_MAX_RPCS_IN_FLIGHT;
 	d->opd_sync_max_rpcs_in_progress = OSP_MAX_RPCS_IN_PROGRESS;
+	d->opd_sync_batch_max = OSP_DESTROY_BATCH_DEFAULT;
 	spin_lock_init(&d->opd_sync_lock);
 	init_waitqueue_head(&d->opd_sync_waitq);
 	init_waitqueue_head(&d->opd_sync_barrier_waitq);
@@ -1545,6 +1935,14 @@ int osp_sync_init(const struct lu_env *env, struct osp_device *d)
 	if (d->opd_storage->dd_rdonly)
 		RETURN(0);
 
+	OBD_ALLOC_LARGE(d->opd_sync_batch_ids,
+			sizeof(struct ost_id) * OST_DESTROY_BATCH_MAX);
+	OBD_ALLOC_LARGE(d->opd_sync_batch_cookies,
+			sizeof(struct llog_cookie) * OST_DESTROY_BATCH_MAX);
+	if (d->opd_sync_batch_ids == NULL ||
+	    d->opd_sync_batch_cookies == NULL)
+		GOTO(err_id, rc = -ENOMEM);
+
 	/*
 	 * initialize llog storing changes
 	 */
@@ -1574,6 +1972,7 @@ int osp_sync_init(const struct lu_env *env, struct osp_device *d)
 err_llog:
 	osp_sync_llog_fini(env, d);
 err_id:
+	osp_sync_batch_free(d);
 	return rc;
 }
 
@@ -1597,6 +1996,7 @@ int osp_sync_fini(struct osp_device *d)
 		wake_up(&d->opd_sync_waitq);
 		wait_event(thread->t_ctl_waitq, thread_is_stopped(thread));
 	}
+	osp_sync_batch_free(d);
 
 	RETURN(0);
 }
@@ -34,6 +34,7 @@
 #include <linux/slab.h>
 #include <linux/crypto.h>
 #include <linux/mutex.h>
+#include <linux/workqueue.h>
 #include <crypto/ctr.h>
 
 #include <obd.h>
@@ -627,9 +628,46 @@ __u32 gss_prep_bulk_sk(struct gss_ctx *gss_context,
 	return GSS_S_COMPLETE;
 }
 
-static __u32 sk_encrypt_bulk(struct crypto_blkcipher *tfm, __u8 *iv,
-			     struct ptlrpc_bulk_desc *desc, rawobj_t *cipher,
-			     int adj_nob)
+/* Bulk descriptors with at least this many pages have their privacy
+ * transform split into chunks of sk_bulk_chunk_pages pages which are
+ * processed concurrently by sk_bulk_wq.  This is only possible because
+ * the counter for each chunk can be derived from the message IV, so the
+ * resulting cipher text is identical to the serial transform. */
+static unsigned int sk_bulk_parallel_pages = 64;
+module_param(sk_bulk_parallel_pages, uint, 0644);
+MODULE_PARM_DESC(sk_bulk_parallel_pages,
+		 "Minimum pages in a bulk to encrypt it in parallel, 0 to disable");
+
+static unsigned int sk_bulk_chunk_pages = 16;
+module_param(sk_bulk_chunk_pages, uint, 0644);
+MODULE_PARM_DESC(sk_bulk_chunk_pages,
+		 "Number of bulk pages handled by one parallel crypto work item");
+
+static struct workqueue_struct *sk_bulk_wq;
+
+struct sk_bulk_batch {
+	struct crypto_blkcipher	*sbb_tfm;
+	struct ptlrpc_bulk_desc	*sbb_desc;
+	bool			 sbb_encrypt;
+	int			 sbb_rc;
+	atomic_t		 sbb_pending;
+	struct completion	 sbb_done;
+};
+
+struct sk_bulk_chunk {
+	struct work_struct	 sbc_work;
+	struct sk_bulk_batch	*sbc_batch;
+	int			 sbc_start;
+	int			 sbc_end;
+	__u8			 sbc_iv[SK_IV_SIZE];
+};
+
+/* Encrypt or decrypt pages [start, end) of @desc.  The bulk vectors must
+ * already have been validated and sized by the caller, and @iv is advanced
+ * past the processed data. */
+static int sk_crypt_bulk_pages(struct crypto_blkcipher *tfm, __u8 *iv,
+			       struct ptlrpc_bulk_desc *desc, int start,
+			       int end, bool encrypt)
 {
 	struct blkcipher_desc cdesc = {
 		.tfm = tfm,
@@ -641,67 +679,210 @@ static __u32 sk_encrypt_bulk(struct crypto_blkcipher *tfm, __u8 *iv,
 	int blocksize;
 	int i;
 	int rc;
-	int nob = 0;
 
 	blocksize = crypto_blkcipher_blocksize(tfm);
 
-	sg_init_table(&ptxt, 1);
-	sg_init_table(&ctxt, 1);
+	for (i = start; i < end; i++) {
+		lnet_kiov_t *piov = &BD_GET_KIOV(desc, i);
+		lnet_kiov_t *ciov = &BD_GET_ENC_KIOV(desc, i);
 
-	for (i = 0; i < desc->bd_iov_count; i++) {
-		sg_set_page(&ptxt, BD_GET_KIOV(desc, i).kiov_page,
-			    sk_block_mask(BD_GET_KIOV(desc, i).kiov_len,
-					  blocksize),
-			    BD_GET_KIOV(desc, i).kiov_offset);
-		nob += ptxt.length;
+		if (ciov->kiov_len == 0)
+			continue;
+
+		sg_init_table(&ctxt, 1);
+		sg_set_page(&ctxt, ciov->kiov_page, ciov->kiov_len,
+			    ciov->kiov_offset);
+
+		if (encrypt) {
+			sg_init_table(&ptxt, 1);
+			sg_set_page(&ptxt, piov->kiov_page, ciov->kiov_len,
+				    piov->kiov_offset);
 
-		sg_set_page(&ctxt, BD_GET_ENC_KIOV(desc, i).kiov_page,
-			    ptxt.length, ptxt.offset);
+			rc = crypto_blkcipher_encrypt_iv(&cdesc, &ctxt, &ptxt,
+							 ptxt.length);
+			if (rc) {
+				CERROR("failed to encrypt page: %d\n", rc);
+				return rc;
+			}
+			continue;
+		}
 
-		BD_GET_ENC_KIOV(desc, i).kiov_offset = ctxt.offset;
-		BD_GET_ENC_KIOV(desc, i).kiov_len = ctxt.length;
+		ptxt = ctxt;
 
-		rc = crypto_blkcipher_encrypt_iv(&cdesc, &ctxt, &ptxt,
-						 ptxt.length);
+		/* In the event the plain text size is not a multiple
+		 * of blocksize we decrypt in place and copy the result
+		 * after the decryption */
+		if (piov->kiov_len % blocksize == 0)
+			sg_assign_page(&ptxt, piov->kiov_page);
+
+		rc = crypto_blkcipher_decrypt_iv(&cdesc, &ptxt, &ctxt,
+						 ctxt.length);
 		if (rc) {
-			CERROR("failed to encrypt page: %d\n", rc);
+			CERROR("Decryption failed for page: %d\n", rc);
 			return rc;
 		}
+
+		if (piov->kiov_len % blocksize != 0) {
+			memcpy(page_address(piov->kiov_page) +
+			       piov->kiov_offset,
+			       page_address(ciov->kiov_page) +
+			       ciov->kiov_offset,
+			       piov->kiov_len);
+		}
 	}
 
+	return 0;
+}
+
+static void sk_bulk_chunk_work(struct work_struct *work)
+{
+	struct sk_bulk_chunk *chunk = container_of(work, struct sk_bulk_chunk,
+						   sbc_work);
+	struct sk_bulk_batch *batch = chunk->sbc_batch;
+	int rc;
+
+	rc = sk_crypt_bulk_pages(batch->sbb_tfm, chunk->sbc_iv,
+				 batch->sbb_desc, chunk->sbc_start,
+				 chunk->sbc_end, batch->sbb_encrypt);
+	if (rc)
+		cmpxchg(&batch->sbb_rc, 0, rc);
+
+	if (atomic_dec_and_test(&batch->sbb_pending))
+		complete(&batch->sbb_done);
+}
+
+/* Add @count to the big-endian counter block @ctr, the same way the kernel
+ * CTR template increments it after each cipher block. */
+static void sk_ctr_add(__u8 *ctr, unsigned int size, __u64 count)
+{
+	int i;
+
+	for (i = size - 1; i >= 0 && count; i--) {
+		count += ctr[i];
+		ctr[i] = count & 0xff;
+		count >>= 8;
+	}
+}
+
+static int sk_crypt_bulk(struct sk_ctx *skc, __u8 *iv,
+			 struct ptlrpc_bulk_desc *desc, int count,
+			 bool encrypt)
+{
+	struct crypto_blkcipher *tfm = skc->sc_session_kb.kb_tfm;
+	unsigned int min_pages = READ_ONCE(sk_bulk_parallel_pages);
+	unsigned int chunk_pages = READ_ONCE(sk_bulk_chunk_pages);
+	unsigned int ctrsize = crypto_blkcipher_ivsize(tfm);
+	struct sk_bulk_chunk *chunks;
+	struct sk_bulk_batch batch;
+	__u8 ctr[SK_IV_SIZE];
+	int nchunks;
+	int rc;
+	int c;
+	int i;
+
+	if (!sk_bulk_wq || skc->sc_crypt != CFS_CRYPT_ALG_AES256_CTR ||
+	    ctrsize != SK_IV_SIZE || chunk_pages == 0 || min_pages == 0 ||
+	    count < min_pages)
+		return sk_crypt_bulk_pages(tfm, iv, desc, 0, count, encrypt);
+
+	nchunks = DIV_ROUND_UP(count, chunk_pages);
+	if (nchunks < 2)
+		return sk_crypt_bulk_pages(tfm, iv, desc, 0, count, encrypt);
+
+	OBD_ALLOC_LARGE(chunks, nchunks * sizeof(*chunks));
+	if (!chunks)
+		return sk_crypt_bulk_pages(tfm, iv, desc, 0, count, encrypt);
+
+	batch.sbb_tfm = tfm;
+	batch.sbb_desc = desc;
+	batch.sbb_encrypt = encrypt;
+	batch.sbb_rc = 0;
+	atomic_set(&batch.sbb_pending, nchunks - 1);
+	init_completion(&batch.sbb_done);
+
+	/* each chunk starts with the counter a serial pass would have
+	 * reached, i.e. the IV advanced by one per (partial) cipher block */
+	memcpy(ctr, iv, ctrsize);
+	for (c = 0, i = 0; c < nchunks; c++) {
+		struct sk_bulk_chunk *chunk = &chunks[c];
+
+		chunk->sbc_batch = &batch;
+		chunk->sbc_start = i;
+		chunk->sbc_end = min_t(int, i + chunk_pages, count);
+		memcpy(chunk->sbc_iv, ctr, ctrsize);
+
+		for (; i < chunk->sbc_end; i++)
+			sk_ctr_add(ctr, ctrsize,
+				   DIV_ROUND_UP(BD_GET_ENC_KIOV(desc, i).kiov_len,
+						ctrsize));
+	}
+
+	for (c = 1; c < nchunks; c++) {
+		INIT_WORK(&chunks[c].sbc_work, sk_bulk_chunk_work);
+		queue_work(sk_bulk_wq, &chunks[c].sbc_work);
+	}
+
+	/* the calling thread takes the first chunk itself */
+	rc = sk_crypt_bulk_pages(tfm, chunks[0].sbc_iv, desc,
+				 chunks[0].sbc_start, chunks[0].sbc_end,
+				 encrypt);
+	wait_for_completion(&batch.sbb_done);
+	if (!rc)
+		rc = batch.sbb_rc;
+
+	memcpy(iv, ctr, ctrsize);
+	OBD_FREE_LARGE(chunks, nchunks * sizeof(*chunks));
+
+	return rc;
+}
+
+static __u32 sk_encrypt_bulk(struct sk_ctx *skc, __u8 *iv,
+			     struct ptlrpc_bulk_desc *desc, rawobj_t *cipher,
+			     int adj_nob)
+{
+	int blocksize;
+	int i;
+	int rc;
+	int nob = 0;
+
+	blocksize = crypto_blkcipher_blocksize(skc->sc_session_kb.kb_tfm);
+
+	for (i = 0; i < desc->bd_iov_count; i++) {
+		BD_GET_ENC_KIOV(desc, i).kiov_offset =
+			BD_GET_KIOV(desc, i).kiov_offset;
+		BD_GET_ENC_KIOV(desc, i).kiov_len =
+			sk_block_mask(BD_GET_KIOV(desc, i).kiov_len, blocksize);
+		nob += BD_GET_ENC_KIOV(desc, i).kiov_len;
+	}
+
+	rc = sk_crypt_bulk(skc, iv, desc, desc->bd_iov_count, true);
+	if (rc)
+		return rc;
+
 	if (adj_nob)
 		desc->bd_nob = nob;
 
 	return 0;
 }
 
-static __u32 sk_decrypt_bulk(struct crypto_blkcipher *tfm, __u8 *iv,
+static __u32 sk_decrypt_bulk(struct sk_ctx *skc, __u8 *iv,
 			     struct ptlrpc_bulk_desc *desc, rawobj_t *cipher,
 			     int adj_nob)
 {
-	struct blkcipher_desc cdesc = {
-		.tfm = tfm,
-		.info = iv,
-		.flags = 0,
-	};
-	struct scatterlist ptxt;
-	struct scatterlist ctxt;
 	int blocksize;
 	int i;
-	int rc;
 	int pnob = 0;
 	int cnob = 0;
 
-	sg_init_table(&ptxt, 1);
-	sg_init_table(&ctxt, 1);
-
-	blocksize = crypto_blkcipher_blocksize(tfm);
+	blocksize = crypto_blkcipher_blocksize(skc->sc_session_kb.kb_tfm);
 	if (desc->bd_nob_transferred % blocksize != 0) {
 		CERROR("Transfer not a multiple of block size: %d\n",
 		       desc->bd_nob_transferred);
 		return GSS_S_DEFECTIVE_TOKEN;
 	}
 
+	/* size every vector first so the pages can be decrypted
+	 * independently of each other below */
 	for (i = 0; i < desc->bd_iov_count && cnob < desc->bd_nob_transferred;
 	     i++) {
 		lnet_kiov_t *piov = &BD_GET_KIOV(desc, i);
@@ -737,39 +918,13 @@ static __u32 sk_decrypt_bulk(struct crypto_blkcipher *tfm, __u8 *iv,
 			}
 		}
 
-		if (ciov->kiov_len == 0)
-			continue;
-
-		sg_init_table(&ctxt, 1);
-		sg_set_page(&ctxt, ciov->kiov_page, ciov->kiov_len,
-			    ciov->kiov_offset);
-		ptxt = ctxt;
-
-		/* In the event the plain text size is not a multiple
-		 * of blocksize we decrypt in place and copy the result
-		 * after the decryption */
-		if (piov->kiov_len % blocksize == 0)
-			sg_assign_page(&ptxt, piov->kiov_page);
-
-		rc = crypto_blkcipher_decrypt_iv(&cdesc, &ptxt, &ctxt,
-						 ctxt.length);
-		if (rc) {
-			CERROR("Decryption failed for page: %d\n", rc);
-			return GSS_S_FAILURE;
-		}
-
-		if (piov->kiov_len % blocksize != 0) {
-			memcpy(page_address(piov->kiov_page) +
-			       piov->kiov_offset,
-			       page_address(ciov->kiov_page) +
-			       ciov->kiov_offset,
-			       piov->kiov_len);
-		}
-
 		cnob += ciov->kiov_len;
 		pnob += piov->kiov_len;
 	}
 
+	if (sk_crypt_bulk(skc, iv, desc, i, false))
+		return GSS_S_FAILURE;
+
 	/* if needed, clear up the rest unused iovs */
 	if (adj_nob)
 		while (i < desc->bd_iov_count)
@@ -814,8 +969,7 @@ __u32 gss_wrap_bulk_sk(struct gss_ctx *gss_context,
 	sk_construct_rfc3686_iv(local_iv, skc->sc_host_random, skh.skh_iv);
 	skw.skw_cipher.data = skw.skw_header.data + skw.skw_header.len;
 	skw.skw_cipher.len = token->len - skw.skw_header.len - sht_bytes;
-	if (sk_encrypt_bulk(skc->sc_session_kb.kb_tfm, local_iv,
-			    desc, &skw.skw_cipher, adj_nob))
+	if (sk_encrypt_bulk(skc, local_iv, desc, &skw.skw_cipher, adj_nob))
 		return GSS_S_FAILURE;
 
 	skw.skw_hmac.data = skw.skw_cipher.data + skw.skw_cipher.len;
@@ -865,8 +1019,7 @@ __u32 gss_unwrap_bulk_sk(struct gss_ctx *gss_context,
 		return rc;
 
 	sk_construct_rfc3686_iv(local_iv, skc->sc_peer_random, skh->skh_iv);
-	rc = sk_decrypt_bulk(skc->sc_session_kb.kb_tfm, local_iv,
-			     desc, &skw.skw_cipher, adj_nob);
+	rc = sk_decrypt_bulk(skc, local_iv, desc, &skw.skw_cipher, adj_nob);
 	if (rc)
 		return rc;
 
@@ -943,9 +1096,21 @@ int __init init_sk_module(void)
 {
 	int status;
 
+	/* bulk crypto can run on behalf of writeback, so the workers must be
+	 * able to make progress under memory pressure */
+	sk_bulk_wq = alloc_workqueue("sk_bulk", WQ_UNBOUND | WQ_MEM_RECLAIM,
+				     0);
+	if (!sk_bulk_wq)
+		CWARN("cannot start sk bulk workqueue, bulk crypto will be serial\n");
+
 	status = lgss_mech_register(&gss_sk_mech);
-	if (status)
+	if (status) {
 		CERROR("Failed to register sk gss mechanism!\n");
+		if (sk_bulk_wq) {
+			destroy_workqueue(sk_bulk_wq);
+			sk_bulk_wq = NULL;
+		}
+	}
 
 	return status;
 }
@@ -953,4 +1118,8 @@ int __init init_sk_module(void)
 void cleanup_sk_module(void)
 {
 	lgss_mech_unregister(&gss_sk_mech);
+	if (sk_bulk_wq) {
+		destroy_workqueue(sk_bulk_wq);
+		sk_bulk_wq = NULL;
+	}
 }
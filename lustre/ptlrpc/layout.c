@@ -631,6 +631,14 @@ static const struct req_msg_field *ost_destroy_client[] = {
         &RMF_CAPA1
 };
 
+static const struct req_msg_field *ost_destroy_batch_client[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_OST_BODY,
+	&RMF_DLM_REQ,
+	&RMF_CAPA1,
+	&RMF_OST_ID_ARRAY
+};
+
 
 static const struct req_msg_field *ost_brw_client[] = {
 	&RMF_PTLRPC_BODY,
@@ -810,6 +818,7 @@ static struct req_format *req_formats[] = {
 	&RQF_OST_PUNCH,
 	&RQF_OST_SYNC,
 	&RQF_OST_DESTROY,
+	&RQF_OST_DESTROY_BATCH,
 	&RQF_OST_BRW_READ,
 	&RQF_OST_BRW_WRITE,
 	&RQF_OST_STATFS,
@@ -1197,6 +1206,11 @@ struct req_msg_field RMF_OST_ID =
 		    sizeof(struct ost_id), lustre_swab_ost_id, NULL);
 EXPORT_SYMBOL(RMF_OST_ID);
 
+struct req_msg_field RMF_OST_ID_ARRAY =
+	DEFINE_MSGF("ost_id_array", RMF_F_STRUCT_ARRAY,
+		    sizeof(struct ost_id), lustre_swab_ost_id, NULL);
+EXPORT_SYMBOL(RMF_OST_ID_ARRAY);
+
 struct req_msg_field RMF_FIEMAP_KEY =
 	DEFINE_MSGF("fiemap_key", 0, sizeof(struct ll_fiemap_info_key),
 		    lustre_swab_fiemap_info_key, NULL);
@@ -1704,6 +1718,11 @@ struct req_format RQF_OST_DESTROY =
         DEFINE_REQ_FMT0("OST_DESTROY", ost_destroy_client, ost_body_only);
 EXPORT_SYMBOL(RQF_OST_DESTROY);
 
+struct req_format RQF_OST_DESTROY_BATCH =
+	DEFINE_REQ_FMT0("OST_DESTROY_BATCH", ost_destroy_batch_client,
+			ost_body_only);
+EXPORT_SYMBOL(RQF_OST_DESTROY_BATCH);
+
 struct req_format RQF_OST_BRW_READ =
         DEFINE_REQ_FMT0("OST_BRW_READ", ost_brw_client, ost_brw_read_server);
 EXPORT_SYMBOL(RQF_OST_BRW_READ);
@@ -0,0 +1,902 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * lustre/ptlrpc/nrs_codel.c
+ *
+ * Network Request Scheduler (NRS) CoDel policy
+ *
+ * Round-Robin scheduling over request classes, with classes that keep the
+ * service above a queueing delay target being de-prioritized.
+ */
+/**
+ * \addtogoup nrs
+ * @{
+ */
+#ifdef HAVE_SERVER_SUPPORT
+
+#define DEBUG_SUBSYSTEM S_RPC
+#include <obd_support.h>
+#include <obd_class.h>
+#include <lustre_net.h>
+#include <lprocfs_status.h>
+#include "ptlrpc_internal.h"
+
+/**
+ * \name codel
+ *
+ * The CoDel policy groups requests into classes by client NID, JobID or
+ * opcode (selected when the policy is started, e.g. "codel jobid") and
+ * serves the classes with queued requests in a Round-Robin manner.
+ *
+ * Every time a request is dequeued, the time it spent queued is compared
+ * with a target latency. A class whose requests have been queued for longer
+ * than the target for at least an interval, i.e. one that is building a
+ * standing queue rather than a transient burst, is moved to a "slow" list
+ * that is only served when no other class has requests pending, or once
+ * every NRS_CODEL_SLOW_RATIO requests so that it still makes progress. The
+ * class is restored as soon as one of its requests is dequeued within the
+ * target again, or once it has no more requests queued. No static rate or
+ * rule has to be configured.
+ *
+ * A class only lives as long as requests hold it, so that the classes of
+ * short-lived jobs or clients don't accumulate on a long-lived server.
+ *
+ * @{
+ */
+
+#define NRS_POL_NAME_CODEL	"codel"
+
+/* Default target queueing delay, in milliseconds. */
+#define NRS_CODEL_TARGET_DEFAULT	50
+/* Default interval a class may stay above target, in milliseconds. */
+#define NRS_CODEL_INTERVAL_DEFAULT	500
+/* Serve a penalized class at least once per this many requests. */
+#define NRS_CODEL_SLOW_RATIO		8
+
+static const struct rhashtable_params nrs_codel_hash_params = {
+	.key_len	= sizeof(__u64),
+	.key_offset	= offsetof(struct nrs_codel_class, cc_key),
+	.head_offset	= offsetof(struct nrs_codel_class, cc_rhead),
+};
+
+static void nrs_codel_class_exit(void *vcls, void *data)
+{
+	struct nrs_codel_class *cls = vcls;
+
+	LASSERTF(atomic_read(&cls->cc_ref) == 0,
+		 "Busy CoDel class %#llx, with %d refs\n", cls->cc_key,
+		 atomic_read(&cls->cc_ref));
+	LASSERT(list_empty(&cls->cc_reqs));
+
+	OBD_FREE_PTR(cls);
+}
+
+/**
+ * Frees class \a cls once its last request is released; lookups may still
+ * be walking it, hence the RCU delay.
+ */
+static void nrs_codel_class_free(struct nrs_codel_head *head,
+				 struct nrs_codel_class *cls)
+{
+	LASSERT(list_empty(&cls->cc_reqs));
+
+	rhashtable_remove_fast(&head->ch_class_hash, &cls->cc_rhead,
+			       nrs_codel_hash_params);
+	OBD_FREE_PRE(cls, sizeof(*cls), "rcu");
+	kfree_rcu(cls, cc_rcu);
+}
+
+/**
+ * Returns the key of the class request \a req belongs to.
+ *
+ * JobIDs are reduced to a hash, so two jobs may occasionally share a class;
+ * this only costs them some fairness amongst each other.
+ */
+static __u64 nrs_codel_req_key(struct nrs_codel_head *head,
+			       struct ptlrpc_request *req)
+{
+	const char *jobid;
+
+	switch (head->ch_type) {
+	case NRS_CODEL_CLASS_JOBID:
+		jobid = lustre_msg_get_jobid(req->rq_reqmsg);
+		if (jobid == NULL)
+			jobid = "";
+		return cfs_hash_djb2_hash(jobid,
+					  strnlen(jobid, LUSTRE_JOBID_SIZE),
+					  ~0U);
+	case NRS_CODEL_CLASS_OPCODE:
+		return lustre_msg_get_opc(req->rq_reqmsg);
+	case NRS_CODEL_CLASS_NID:
+	default:
+		return req->rq_peer.nid;
+	}
+}
+
+/**
+ * Called when a CoDel policy instance is started.
+ *
+ * \param[in] policy the policy
+ * \param[in] arg    class type; one of "nid" (default), "jobid" or "opcode"
+ *
+ * \retval -EINVAL unknown class type
+ * \retval -ENOMEM OOM error
+ * \retval 0	   success
+ */
+static int nrs_codel_start(struct ptlrpc_nrs_policy *policy, char *arg)
+{
+	struct nrs_codel_head *head;
+	enum nrs_codel_class_type type;
+	int rc;
+
+	ENTRY;
+
+	if (arg == NULL || strcmp(arg, "nid") == 0)
+		type = NRS_CODEL_CLASS_NID;
+	else if (strcmp(arg, "jobid") == 0)
+		type = NRS_CODEL_CLASS_JOBID;
+	else if (strcmp(arg, "opcode") == 0)
+		type = NRS_CODEL_CLASS_OPCODE;
+	else
+		RETURN(-EINVAL);
+
+	OBD_CPT_ALLOC_PTR(head, nrs_pol2cptab(policy), nrs_pol2cptid(policy));
+	if (head == NULL)
+		RETURN(-ENOMEM);
+
+	rc = rhashtable_init(&head->ch_class_hash, &nrs_codel_hash_params);
+	if (rc) {
+		OBD_FREE_PTR(head);
+		RETURN(rc);
+	}
+
+	INIT_LIST_HEAD(&head->ch_fast);
+	INIT_LIST_HEAD(&head->ch_slow);
+	head->ch_type = type;
+	head->ch_target = NRS_CODEL_TARGET_DEFAULT;
+	head->ch_interval = NRS_CODEL_INTERVAL_DEFAULT;
+
+	policy->pol_private = head;
+
+	RETURN(0);
+}
+
+/**
+ * Called when a CoDel policy instance is stopped.
+ *
+ * \param[in] policy the policy
+ */
+static void nrs_codel_stop(struct ptlrpc_nrs_policy *policy)
+{
+	struct nrs_codel_head *head = policy->pol_private;
+
+	LASSERT(head != NULL);
+	LASSERT(list_empty(&head->ch_fast));
+	LASSERT(list_empty(&head->ch_slow));
+
+	rhashtable_free_and_destroy(&head->ch_class_hash, nrs_codel_class_exit,
+				    NULL);
+
+	OBD_FREE_PTR(head);
+}
+
+/**
+ * Performs ctl functions specific to CoDel policy instances; similar to ioctl
+ *
+ * \param[in]     policy the policy instance
+ * \param[in]     opc    the opcode
+ * \param[in,out] arg    used for passing parameters and information
+ *
+ * \pre assert_spin_locked(&policy->pol_nrs->->nrs_lock)
+ * \post assert_spin_locked(&policy->pol_nrs->->nrs_lock)
+ *
+ * \retval 0   operation carried out successfully
+ * \retval -ve error
+ */
+static int nrs_codel_ctl(struct ptlrpc_nrs_policy *policy,
+			 enum ptlrpc_nrs_ctl opc, void *arg)
+{
+	struct nrs_codel_head *head = policy->pol_private;
+
+	assert_spin_locked(&policy->pol_nrs->nrs_lock);
+
+	switch ((enum nrs_ctl_codel)opc) {
+	default:
+		RETURN(-EINVAL);
+
+	case NRS_CTL_CODEL_RD_TARGET:
+		*(__u32 *)arg = head->ch_target;
+		break;
+
+	case NRS_CTL_CODEL_WR_TARGET:
+		head->ch_target = *(__u32 *)arg;
+		break;
+
+	case NRS_CTL_CODEL_RD_INTERVAL:
+		*(__u32 *)arg = head->ch_interval;
+		break;
+
+	case NRS_CTL_CODEL_WR_INTERVAL:
+		head->ch_interval = *(__u32 *)arg;
+		break;
+
+	/* accumulated over all the service partitions */
+	case NRS_CTL_CODEL_RD_STATS: {
+		struct nrs_codel_stats *stats = arg;
+
+		stats->cs_penalties += head->ch_penalties;
+		stats->cs_slow_classes += head->ch_slow_count;
+		}
+		break;
+	}
+
+	RETURN(0);
+}
+
+/**
+ * Obtains resources from CoDel policy instances. The top-level resource lives
+ * inside \e nrs_codel_head and the second-level resource inside
+ * \e nrs_codel_class object instances.
+ *
+ * \param[in]  policy	  the policy for which resources are being taken for
+ *			  request \a nrq
+ * \param[in]  nrq	  the request for which resources are being taken
+ * \param[in]  parent	  parent resource, embedded in nrs_codel_head
+ * \param[out] resp	  resources references are placed in this array
+ * \param[in]  moving_req signifies limited caller context; used to perform
+ *			  memory allocations in an atomic context in this
+ *			  policy
+ *
+ * \retval 0   we are returning a top-level, parent resource, one that is
+ *	       embedded in an nrs_codel_head object
+ * \retval 1   we are returning a bottom-level resource, one that is embedded
+ *	       in an nrs_codel_class object
+ *
+ * \see nrs_resource_get_safe()
+ */
+static int nrs_codel_res_get(struct ptlrpc_nrs_policy *policy,
+			     struct ptlrpc_nrs_request *nrq,
+			     const struct ptlrpc_nrs_resource *parent,
+			     struct ptlrpc_nrs_resource **resp, bool moving_req)
+{
+	struct nrs_codel_head *head;
+	struct nrs_codel_class *cls;
+	struct nrs_codel_class *tmp;
+	struct ptlrpc_request *req;
+	__u64 key;
+
+	if (parent == NULL) {
+		*resp = &((struct nrs_codel_head *)policy->pol_private)->ch_res;
+		return 0;
+	}
+
+	head = container_of(parent, struct nrs_codel_head, ch_res);
+	req = container_of(nrq, struct ptlrpc_request, rq_nrq);
+	key = nrs_codel_req_key(head, req);
+
+	rcu_read_lock();
+	cls = rhashtable_lookup_fast(&head->ch_class_hash, &key,
+				     nrs_codel_hash_params);
+	/* a class without refs is being freed */
+	if (cls && atomic_inc_not_zero(&cls->cc_ref)) {
+		rcu_read_unlock();
+		goto out;
+	}
+	rcu_read_unlock();
+
+	OBD_CPT_ALLOC_GFP(cls, nrs_pol2cptab(policy), nrs_pol2cptid(policy),
+			  sizeof(*cls), moving_req ? GFP_ATOMIC : GFP_NOFS);
+	if (cls == NULL)
+		return -ENOMEM;
+
+	cls->cc_key = key;
+	INIT_LIST_HEAD(&cls->cc_list);
+	INIT_LIST_HEAD(&cls->cc_reqs);
+	atomic_set(&cls->cc_ref, 1);
+
+again:
+	rcu_read_lock();
+	tmp = rhashtable_lookup_get_insert_fast(&head->ch_class_hash,
+						&cls->cc_rhead,
+						nrs_codel_hash_params);
+	if (tmp && !IS_ERR(tmp) && !atomic_inc_not_zero(&tmp->cc_ref)) {
+		/* wait for the class being freed to leave the hash */
+		rcu_read_unlock();
+		cpu_relax();
+		goto again;
+	}
+	rcu_read_unlock();
+	if (tmp) {
+		/* insertion failed */
+		OBD_FREE_PTR(cls);
+		if (IS_ERR(tmp))
+			return PTR_ERR(tmp);
+		cls = tmp;
+	}
+out:
+	*resp = &cls->cc_res;
+
+	return 1;
+}
+
+/**
+ * Called when releasing references to the resource hierachy obtained for a
+ * request for scheduling using the CoDel policy.
+ *
+ * \param[in] policy   the policy the resource belongs to
+ * \param[in] res      the resource to be released
+ */
+static void nrs_codel_res_put(struct ptlrpc_nrs_policy *policy,
+			      const struct ptlrpc_nrs_resource *res)
+{
+	struct nrs_codel_class *cls;
+
+	/**
+	 * Do nothing for freeing parent, nrs_codel_head resources
+	 */
+	if (res->res_parent == NULL)
+		return;
+
+	cls = container_of(res, struct nrs_codel_class, cc_res);
+
+	if (atomic_dec_and_test(&cls->cc_ref))
+		nrs_codel_class_free(container_of(res->res_parent,
+						  struct nrs_codel_head,
+						  ch_res), cls);
+}
+
+/**
+ * Selects the class the next request should be served from; penalized
+ * classes are only selected when no other class has pending requests, or
+ * when they have been passed over NRS_CODEL_SLOW_RATIO times in a row.
+ */
+static struct nrs_codel_class *nrs_codel_class_next(struct nrs_codel_head *head)
+{
+	struct list_head *list;
+
+	if (list_empty(&head->ch_slow))
+		list = &head->ch_fast;
+	else if (list_empty(&head->ch_fast) ||
+		 head->ch_fast_served >= NRS_CODEL_SLOW_RATIO)
+		list = &head->ch_slow;
+	else
+		list = &head->ch_fast;
+
+	if (list_empty(list))
+		return NULL;
+
+	return list_first_entry(list, struct nrs_codel_class, cc_list);
+}
+
+/**
+ * Updates the CoDel state of class \a cls with the queueing delay of a
+ * request that is being dequeued.
+ *
+ * \param[in] head    the policy private data
+ * \param[in] cls     the class the request belongs to
+ * \param[in] sojourn time the request spent queued, in microseconds
+ * \param[in] now     the current time
+ */
+static void nrs_codel_class_update(struct nrs_codel_head *head,
+				   struct nrs_codel_class *cls, s64 sojourn,
+				   ktime_t now)
+{
+	if (sojourn < (s64)head->ch_target * USEC_PER_MSEC) {
+		cls->cc_first_above = ktime_set(0, 0);
+		if (cls->cc_slow) {
+			cls->cc_slow = false;
+			head->ch_slow_count--;
+		}
+		return;
+	}
+
+	if (cls->cc_slow)
+		return;
+
+	if (ktime_to_ns(cls->cc_first_above) == 0) {
+		cls->cc_first_above = ktime_add_ms(now, head->ch_interval);
+		return;
+	}
+
+	if (ktime_before(now, cls->cc_first_above))
+		return;
+
+	cls->cc_slow = true;
+	head->ch_slow_count++;
+	head->ch_penalties++;
+
+	CDEBUG(D_RPCTRACE,
+	       "NRS: %s class %#llx above %ums target for %ums, deprioritizing\n",
+	       NRS_POL_NAME_CODEL, cls->cc_key, head->ch_target,
+	       head->ch_interval);
+}
+
+/**
+ * Resets the CoDel state of class \a cls which has no more requests queued,
+ * it is not building a standing queue anymore.
+ */
+static void nrs_codel_class_idle(struct nrs_codel_head *head,
+				 struct nrs_codel_class *cls)
+{
+	cls->cc_first_above = ktime_set(0, 0);
+	if (cls->cc_slow) {
+		cls->cc_slow = false;
+		head->ch_slow_count--;
+	}
+}
+
+/**
+ * Called when getting a request from the CoDel policy for handling, or just
+ * peeking; removes the request from the policy when it is to be handled.
+ *
+ * \param[in] policy the policy
+ * \param[in] peek   when set, signifies that we just want to examine the
+ *		     request, and not handle it, so the request is not removed
+ *		     from the policy.
+ * \param[in] force  force the policy to return a request; unused in this
+ *		     policy
+ *
+ * \retval the request to be handled
+ * \retval NULL no request available
+ *
+ * \see ptlrpc_nrs_req_get_nolock()
+ * \see nrs_request_get()
+ */
+static
+struct ptlrpc_nrs_request *nrs_codel_req_get(struct ptlrpc_nrs_policy *policy,
+					     bool peek, bool force)
+{
+	struct nrs_codel_head *head = policy->pol_private;
+	struct ptlrpc_nrs_request *nrq;
+	struct nrs_codel_class *cls;
+	struct ptlrpc_request *req;
+	ktime_t now;
+	s64 sojourn;
+
+	cls = nrs_codel_class_next(head);
+	if (cls == NULL)
+		return NULL;
+
+	LASSERT(!list_empty(&cls->cc_reqs));
+	nrq = list_first_entry(&cls->cc_reqs, struct ptlrpc_nrs_request,
+			       nr_u.codel.cr_list);
+	if (peek)
+		return nrq;
+
+	list_del_init(&nrq->nr_u.codel.cr_list);
+	cls->cc_queued--;
+
+	if (cls->cc_slow)
+		head->ch_fast_served = 0;
+	else
+		head->ch_fast_served++;
+
+	now = ktime_get();
+	sojourn = ktime_us_delta(now, nrq->nr_u.codel.cr_enqueue_time);
+	nrs_codel_class_update(head, cls, sojourn, now);
+
+	/* move the class to the tail of the list matching its (possibly new)
+	 * state, so that the classes are served in a round-robin manner */
+	list_del_init(&cls->cc_list);
+	if (cls->cc_queued > 0)
+		list_add_tail(&cls->cc_list,
+			      cls->cc_slow ? &head->ch_slow : &head->ch_fast);
+	else
+		nrs_codel_class_idle(head, cls);
+
+	req = container_of(nrq, struct ptlrpc_request, rq_nrq);
+	CDEBUG(D_RPCTRACE,
+	       "NRS: starting to handle %s request from %s, queued %lldus\n",
+	       NRS_POL_NAME_CODEL, libcfs_id2str(req->rq_peer), sojourn);
+
+	return nrq;
+}
+
+/**
+ * Adds request \a nrq to the queue of its class, and makes the class
+ * eligible for scheduling if it had no requests pending.
+ *
+ * \param[in] policy the policy
+ * \param[in] nrq    the request to add
+ *
+ * \retval 0 request added
+ */
+static int nrs_codel_req_add(struct ptlrpc_nrs_policy *policy,
+			     struct ptlrpc_nrs_request *nrq)
+{
+	struct nrs_codel_head *head = policy->pol_private;
+	struct nrs_codel_class *cls;
+
+	cls = container_of(nrs_request_resource(nrq), struct nrs_codel_class,
+			   cc_res);
+
+	nrq->nr_u.codel.cr_enqueue_time = ktime_get();
+	list_add_tail(&nrq->nr_u.codel.cr_list, &cls->cc_reqs);
+
+	if (cls->cc_queued++ == 0)
+		list_add_tail(&cls->cc_list,
+			      cls->cc_slow ? &head->ch_slow : &head->ch_fast);
+
+	return 0;
+}
+
+/**
+ * Removes request \a nrq from \a policy's list of queued requests.
+ *
+ * \param[in] policy the policy
+ * \param[in] nrq    the request to remove
+ */
+static void nrs_codel_req_del(struct ptlrpc_nrs_policy *policy,
+			      struct ptlrpc_nrs_request *nrq)
+{
+	struct nrs_codel_head *head = policy->pol_private;
+	struct nrs_codel_class *cls;
+
+	cls = container_of(nrs_request_resource(nrq), struct nrs_codel_class,
+			   cc_res);
+
+	list_del_init(&nrq->nr_u.codel.cr_list);
+	if (--cls->cc_queued == 0) {
+		list_del_init(&cls->cc_list);
+		nrs_codel_class_idle(head, cls);
+	}
+}
+
+/**
+ * Prints a debug statement right before the request \a nrq stops being
+ * handled.
+ *
+ * \param[in] policy the policy handling the request
+ * \param[in] nrq    the request being handled
+ *
+ * \see ptlrpc_server_finish_request()
+ * \see ptlrpc_nrs_req_stop_nolock()
+ */
+static void nrs_codel_req_stop(struct ptlrpc_nrs_policy *policy,
+			       struct ptlrpc_nrs_request *nrq)
+{
+	struct ptlrpc_request *req = container_of(nrq, struct ptlrpc_request,
+						  rq_nrq);
+
+	CDEBUG(D_RPCTRACE, "NRS: finished handling %s request from %s\n",
+	       NRS_POL_NAME_CODEL, libcfs_id2str(req->rq_peer));
+}
+
+/**
+ * debugfs interface
+ */
+
+#define LPROCFS_NRS_CODEL_LOWER_BOUND		1
+#define LPROCFS_NRS_CODEL_UPPER_BOUND		60000
+
+#define LPROCFS_NRS_CODEL_TARGET_NAME		"target:"
+#define LPROCFS_NRS_CODEL_TARGET_NAME_REG	"reg_target:"
+#define LPROCFS_NRS_CODEL_TARGET_NAME_HP	"hp_target:"
+
+#define LPROCFS_NRS_CODEL_INTERVAL_NAME		"interval:"
+#define LPROCFS_NRS_CODEL_INTERVAL_NAME_REG	"reg_interval:"
+#define LPROCFS_NRS_CODEL_INTERVAL_NAME_HP	"hp_interval:"
+
+/**
+ * Max size of the nrs_codel_* seq_write buffers. Needs to be large enough
+ * to hold the string: "reg_interval:60000 hp_interval:60000"
+ */
+#define LPROCFS_NRS_CODEL_SIZE						       \
+	sizeof(LPROCFS_NRS_CODEL_INTERVAL_NAME_REG			       \
+	       __stringify(LPROCFS_NRS_CODEL_UPPER_BOUND)		       \
+	       " " LPROCFS_NRS_CODEL_INTERVAL_NAME_HP			       \
+	       __stringify(LPROCFS_NRS_CODEL_UPPER_BOUND))
+
+/**
+ * Helper for the seq_show functions of the CoDel tunables.
+ */
+static int lprocfs_nrs_codel_seq_show_common(struct seq_file *m,
+					     const char *name_reg,
+					     const char *name_hp,
+					     enum ptlrpc_nrs_ctl opc)
+{
+	struct ptlrpc_service *svc = m->private;
+	__u32 val;
+	int rc;
+
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_REG,
+				       NRS_POL_NAME_CODEL, opc, true, &val);
+	if (rc == 0)
+		seq_printf(m, "%s%u\n", name_reg, val);
+		/**
+		 * Ignore -ENODEV as the regular NRS head's policy may be in
+		 * the ptlrpc_nrs_pol_state::NRS_POL_STATE_STOPPED state.
+		 */
+	else if (rc != -ENODEV)
+		return rc;
+
+	if (!nrs_svc_has_hp(svc))
+		return 0;
+
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_HP,
+				       NRS_POL_NAME_CODEL, opc, true, &val);
+	if (rc == 0)
+		seq_printf(m, "%s%u\n", name_hp, val);
+	else if (rc == -ENODEV)
+		rc = 0;
+
+	return rc;
+}
+
+/**
+ * Helper for the seq_write functions of the CoDel tunables; accepts either
+ * a single value applied to both NRS heads, or "reg_<name>:<val>" and/or
+ * "hp_<name>:<val>".
+ */
+static ssize_t
+lprocfs_nrs_codel_seq_write_common(const char __user *buffer, size_t count,
+				   const char *var_name,
+				   struct ptlrpc_service *svc,
+				   enum ptlrpc_nrs_ctl opc)
+{
+	enum ptlrpc_nrs_queue_type queue = 0;
+	char kernbuf[LPROCFS_NRS_CODEL_SIZE];
+	char name[LPROCFS_NRS_CODEL_SIZE];
+	unsigned int val_reg = 0;
+	unsigned int val_hp = 0;
+	size_t count_copy;
+	char *val_str;
+	__u32 val;
+	int rc;
+
+	if (count > sizeof(kernbuf) - 1)
+		return -EINVAL;
+
+	if (copy_from_user(kernbuf, buffer, count))
+		return -EFAULT;
+
+	kernbuf[count] = '\0';
+
+	/* look for "reg_<var_name>" in kernbuf */
+	snprintf(name, sizeof(name), "reg_%s", var_name);
+	count_copy = count;
+	val_str = lprocfs_find_named_value(kernbuf, name, &count_copy);
+	if (val_str != kernbuf) {
+		if (kstrtouint(val_str, 10, &val_reg) != 0)
+			return -EINVAL;
+		queue |= PTLRPC_NRS_QUEUE_REG;
+	}
+
+	/* look for "hp_<var_name>" in kernbuf */
+	snprintf(name, sizeof(name), "hp_%s", var_name);
+	count_copy = count;
+	val_str = lprocfs_find_named_value(kernbuf, name, &count_copy);
+	if (val_str != kernbuf) {
+		if (!nrs_svc_has_hp(svc))
+			return -ENODEV;
+
+		if (kstrtouint(val_str, 10, &val_hp) != 0)
+			return -EINVAL;
+		queue |= PTLRPC_NRS_QUEUE_HP;
+	}
+
+	if (queue == 0) {
+		if (!isdigit(kernbuf[0]))
+			return -EINVAL;
+
+		if (kstrtouint(kernbuf, 10, &val_reg) != 0)
+			return -EINVAL;
+
+		queue = PTLRPC_NRS_QUEUE_REG;
+		if (nrs_svc_has_hp(svc)) {
+			queue |= PTLRPC_NRS_QUEUE_HP;
+			val_hp = val_reg;
+		}
+	}
+
+	if (queue & PTLRPC_NRS_QUEUE_REG) {
+		if (val_reg < LPROCFS_NRS_CODEL_LOWER_BOUND ||
+		    val_reg > LPROCFS_NRS_CODEL_UPPER_BOUND)
+			return -EINVAL;
+
+		val = val_reg;
+		rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_REG,
+					       NRS_POL_NAME_CODEL, opc, false,
+					       &val);
+		if ((rc < 0 && rc != -ENODEV) ||
+		    (rc == -ENODEV && queue == PTLRPC_NRS_QUEUE_REG))
+			return rc;
+	}
+
+	if (queue & PTLRPC_NRS_QUEUE_HP) {
+		if (val_hp < LPROCFS_NRS_CODEL_LOWER_BOUND ||
+		    val_hp > LPROCFS_NRS_CODEL_UPPER_BOUND)
+			return -EINVAL;
+
+		val = val_hp;
+		rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_HP,
+					       NRS_POL_NAME_CODEL, opc, false,
+					       &val);
+		if ((rc < 0 && rc != -ENODEV) ||
+		    (rc == -ENODEV && queue == PTLRPC_NRS_QUEUE_HP))
+			return rc;
+	}
+
+	return count;
+}
+
+/**
+ * Retrieves the target queueing delay (in milliseconds) of CoDel policy
+ * instances on both the regular and high-priority NRS head of a service.
+ */
+static int ptlrpc_lprocfs_nrs_codel_target_seq_show(struct seq_file *m,
+						    void *data)
+{
+	return lprocfs_nrs_codel_seq_show_common(m,
+					LPROCFS_NRS_CODEL_TARGET_NAME_REG,
+					LPROCFS_NRS_CODEL_TARGET_NAME_HP,
+					NRS_CTL_CODEL_RD_TARGET);
+}
+
+/**
+ * Sets the target queueing delay (in milliseconds) of CoDel policy instances
+ * of a service.
+ *
+ * For example:
+ *
+ * lctl set_param *.*.ost_io.nrs_codel_target=20, to set the target of both
+ * the regular and high-priority NRS heads of the ost_io service to 20ms, and
+ *
+ * lctl set_param *.*.*.nrs_codel_target=reg_target:10, to set the target of
+ * regular requests on all PtlRPC services to 10ms.
+ */
+static ssize_t
+ptlrpc_lprocfs_nrs_codel_target_seq_write(struct file *file,
+					  const char __user *buffer,
+					  size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+
+	return lprocfs_nrs_codel_seq_write_common(buffer, count,
+					LPROCFS_NRS_CODEL_TARGET_NAME,
+					m->private, NRS_CTL_CODEL_WR_TARGET);
+}
+LDEBUGFS_SEQ_FOPS(ptlrpc_lprocfs_nrs_codel_target);
+
+/**
+ * Retrieves the interval (in milliseconds) a class may stay above target
+ * before being de-prioritized.
+ */
+static int ptlrpc_lprocfs_nrs_codel_interval_seq_show(struct seq_file *m,
+						      void *data)
+{
+	return lprocfs_nrs_codel_seq_show_common(m,
+					LPROCFS_NRS_CODEL_INTERVAL_NAME_REG,
+					LPROCFS_NRS_CODEL_INTERVAL_NAME_HP,
+					NRS_CTL_CODEL_RD_INTERVAL);
+}
+
+/**
+ * Sets the interval (in milliseconds) a class may stay above target before
+ * being de-prioritized, with the same syntax as nrs_codel_target.
+ */
+static ssize_t
+ptlrpc_lprocfs_nrs_codel_interval_seq_write(struct file *file,
+					    const char __user *buffer,
+					    size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+
+	return lprocfs_nrs_codel_seq_write_common(buffer, count,
+					LPROCFS_NRS_CODEL_INTERVAL_NAME,
+					m->private, NRS_CTL_CODEL_WR_INTERVAL);
+}
+LDEBUGFS_SEQ_FOPS(ptlrpc_lprocfs_nrs_codel_interval);
+
+/**
+ * Shows how many times classes have been de-prioritized, and how many are
+ * currently, summed over all service partitions.
+ */
+static int ptlrpc_lprocfs_nrs_codel_stats_seq_show(struct seq_file *m,
+						   void *data)
+{
+	struct ptlrpc_service *svc = m->private;
+	struct nrs_codel_stats stats;
+	int rc;
+
+	memset(&stats, 0, sizeof(stats));
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_REG,
+				       NRS_POL_NAME_CODEL,
+				       NRS_CTL_CODEL_RD_STATS, false, &stats);
+	if (rc == 0)
+		seq_printf(m, "regular_requests:\n"
+			   "  penalties: %llu\n"
+			   "  slow_classes: %u\n",
+			   stats.cs_penalties, stats.cs_slow_classes);
+	else if (rc != -ENODEV)
+		return rc;
+
+	if (!nrs_svc_has_hp(svc))
+		return 0;
+
+	memset(&stats, 0, sizeof(stats));
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_HP,
+				       NRS_POL_NAME_CODEL,
+				       NRS_CTL_CODEL_RD_STATS, false, &stats);
+	if (rc == 0)
+		seq_printf(m, "high_priority_requests:\n"
+			   "  penalties: %llu\n"
+			   "  slow_classes: %u\n",
+			   stats.cs_penalties, stats.cs_slow_classes);
+	else if (rc == -ENODEV)
+		rc = 0;
+
+	return rc;
+}
+LDEBUGFS_SEQ_FOPS_RO(ptlrpc_lprocfs_nrs_codel_stats);
+
+static int nrs_codel_lprocfs_init(struct ptlrpc_service *svc)
+{
+	struct lprocfs_vars nrs_codel_lprocfs_vars[] = {
+		{ .name		= "nrs_codel_target",
+		  .fops		= &ptlrpc_lprocfs_nrs_codel_target_fops,
+		  .data		= svc },
+		{ .name		= "nrs_codel_interval",
+		  .fops		= &ptlrpc_lprocfs_nrs_codel_interval_fops,
+		  .data		= svc },
+		{ .name		= "nrs_codel_stats",
+		  .fops		= &ptlrpc_lprocfs_nrs_codel_stats_fops,
+		  .data		= svc },
+		{ NULL }
+	};
+
+	if (!svc->srv_debugfs_entry)
+		return 0;
+
+	return ldebugfs_add_vars(svc->srv_debugfs_entry, nrs_codel_lprocfs_vars,
+				 NULL);
+}
+
+/**
+ * CoDel policy operations
+ */
+static const struct ptlrpc_nrs_pol_ops nrs_codel_ops = {
+	.op_policy_start	= nrs_codel_start,
+	.op_policy_stop		= nrs_codel_stop,
+	.op_policy_ctl		= nrs_codel_ctl,
+	.op_res_get		= nrs_codel_res_get,
+	.op_res_put		= nrs_codel_res_put,
+	.op_req_get		= nrs_codel_req_get,
+	.op_req_enqueue		= nrs_codel_req_add,
+	.op_req_dequeue		= nrs_codel_req_del,
+	.op_req_stop		= nrs_codel_req_stop,
+	.op_lprocfs_init	= nrs_codel_lprocfs_init,
+};
+
+/**
+ * CoDel policy configuration
+ */
+struct ptlrpc_nrs_pol_conf nrs_conf_codel = {
+	.nc_name		= NRS_POL_NAME_CODEL,
+	.nc_ops			= &nrs_codel_ops,
+	.nc_compat		= nrs_policy_compat_all,
+};
+
+/** @} codel */
+
+#endif /* HAVE_SERVER_SUPPORT */
+
+/** @} nrs */
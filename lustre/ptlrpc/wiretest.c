@@ -1359,6 +1359,8 @@ void lustre_assert_wire_constants(void)
 		 OBD_CONNECT2_ASYNC_DISCARD);
 	LASSERTF(OBD_CONNECT2_ENCRYPT == 0x8000ULL, "found 0x%.16llxULL\n",
 		 OBD_CONNECT2_ENCRYPT);
+	LASSERTF(OBD_CONNECT2_DESTROY_BATCH == 0x10000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_DESTROY_BATCH);
 	LASSERTF(OBD_CKSUM_CRC32 == 0x00000001UL, "found 0x%.8xUL\n",
 		(unsigned)OBD_CKSUM_CRC32);
 	LASSERTF(OBD_CKSUM_ADLER == 0x00000002UL, "found 0x%.8xUL\n",
@@ -1867,6 +1869,7 @@ void lustre_assert_wire_constants(void)
 	BUILD_BUG_ON(LMV_HASH_TYPE_MASK != 0x0000ffff);
 	BUILD_BUG_ON(LMV_HASH_FLAG_LOST_LMV != 0x10000000);
 	BUILD_BUG_ON(LMV_HASH_FLAG_BAD_TYPE != 0x20000000);
+	BUILD_BUG_ON(LMV_HASH_FLAG_SPLIT != 0x40000000);
 	BUILD_BUG_ON(LMV_HASH_FLAG_MIGRATION != 0x80000000);
 
 	/* Checks for struct obd_statfs */
@@ -3831,6 +3834,7 @@ void lustre_assert_wire_constants(void)
 	BUILD_BUG_ON(LLOG_GEN_REC != 274989056);
 	BUILD_BUG_ON(CHANGELOG_REC != 275120128);
 	BUILD_BUG_ON(CHANGELOG_USER_REC != 275185664);
+	BUILD_BUG_ON(CHANGELOG_USER_REC2 != 275185666);
 	BUILD_BUG_ON(LLOG_HDR_MAGIC != 275010873);
 	BUILD_BUG_ON(LLOG_LOGID_MAGIC != 275010875);
 
@@ -4149,6 +4153,62 @@ void lustre_assert_wire_constants(void)
 	LASSERTF((int)sizeof(((struct llog_changelog_user_rec *)0)->cur_tail) == 8, "found %lld\n",
 		 (long long)(int)sizeof(((struct llog_changelog_user_rec *)0)->cur_tail));
 
+	/* Checks for struct changelog_user_filter */
+	LASSERTF((int)sizeof(struct changelog_user_filter) == 64, "found %lld\n",
+		 (long long)(int)sizeof(struct changelog_user_filter));
+	LASSERTF((int)offsetof(struct changelog_user_filter, cuf_mask) == 0, "found %lld\n",
+		 (long long)(int)offsetof(struct changelog_user_filter, cuf_mask));
+	LASSERTF((int)sizeof(((struct changelog_user_filter *)0)->cuf_mask) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct changelog_user_filter *)0)->cuf_mask));
+	LASSERTF((int)offsetof(struct changelog_user_filter, cuf_flags) == 4, "found %lld\n",
+		 (long long)(int)offsetof(struct changelog_user_filter, cuf_flags));
+	LASSERTF((int)sizeof(((struct changelog_user_filter *)0)->cuf_flags) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct changelog_user_filter *)0)->cuf_flags));
+	LASSERTF((int)offsetof(struct changelog_user_filter, cuf_projid) == 8, "found %lld\n",
+		 (long long)(int)offsetof(struct changelog_user_filter, cuf_projid));
+	LASSERTF((int)sizeof(((struct changelog_user_filter *)0)->cuf_projid) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct changelog_user_filter *)0)->cuf_projid));
+	LASSERTF((int)offsetof(struct changelog_user_filter, cuf_padding) == 12, "found %lld\n",
+		 (long long)(int)offsetof(struct changelog_user_filter, cuf_padding));
+	LASSERTF((int)sizeof(((struct changelog_user_filter *)0)->cuf_padding) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct changelog_user_filter *)0)->cuf_padding));
+	LASSERTF((int)offsetof(struct changelog_user_filter, cuf_pfid) == 16, "found %lld\n",
+		 (long long)(int)offsetof(struct changelog_user_filter, cuf_pfid));
+	LASSERTF((int)sizeof(((struct changelog_user_filter *)0)->cuf_pfid) == 16, "found %lld\n",
+		 (long long)(int)sizeof(((struct changelog_user_filter *)0)->cuf_pfid));
+	LASSERTF((int)offsetof(struct changelog_user_filter, cuf_jobid) == 32, "found %lld\n",
+		 (long long)(int)offsetof(struct changelog_user_filter, cuf_jobid));
+	LASSERTF((int)sizeof(((struct changelog_user_filter *)0)->cuf_jobid) == 32, "found %lld\n",
+		 (long long)(int)sizeof(((struct changelog_user_filter *)0)->cuf_jobid));
+
+	/* Checks for struct llog_changelog_user_rec2 */
+	LASSERTF((int)sizeof(struct llog_changelog_user_rec2) == 104, "found %lld\n",
+		 (long long)(int)sizeof(struct llog_changelog_user_rec2));
+	LASSERTF((int)offsetof(struct llog_changelog_user_rec2, cur_hdr) == 0, "found %lld\n",
+		 (long long)(int)offsetof(struct llog_changelog_user_rec2, cur_hdr));
+	LASSERTF((int)sizeof(((struct llog_changelog_user_rec2 *)0)->cur_hdr) == 16, "found %lld\n",
+		 (long long)(int)sizeof(((struct llog_changelog_user_rec2 *)0)->cur_hdr));
+	LASSERTF((int)offsetof(struct llog_changelog_user_rec2, cur_id) == 16, "found %lld\n",
+		 (long long)(int)offsetof(struct llog_changelog_user_rec2, cur_id));
+	LASSERTF((int)sizeof(((struct llog_changelog_user_rec2 *)0)->cur_id) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct llog_changelog_user_rec2 *)0)->cur_id));
+	LASSERTF((int)offsetof(struct llog_changelog_user_rec2, cur_time) == 20, "found %lld\n",
+		 (long long)(int)offsetof(struct llog_changelog_user_rec2, cur_time));
+	LASSERTF((int)sizeof(((struct llog_changelog_user_rec2 *)0)->cur_time) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct llog_changelog_user_rec2 *)0)->cur_time));
+	LASSERTF((int)offsetof(struct llog_changelog_user_rec2, cur_endrec) == 24, "found %lld\n",
+		 (long long)(int)offsetof(struct llog_changelog_user_rec2, cur_endrec));
+	LASSERTF((int)sizeof(((struct llog_changelog_user_rec2 *)0)->cur_endrec) == 8, "found %lld\n",
+		 (long long)(int)sizeof(((struct llog_changelog_user_rec2 *)0)->cur_endrec));
+	LASSERTF((int)offsetof(struct llog_changelog_user_rec2, cur_filter) == 32, "found %lld\n",
+		 (long long)(int)offsetof(struct llog_changelog_user_rec2, cur_filter));
+	LASSERTF((int)sizeof(((struct llog_changelog_user_rec2 *)0)->cur_filter) == 64, "found %lld\n",
+		 (long long)(int)sizeof(((struct llog_changelog_user_rec2 *)0)->cur_filter));
+	LASSERTF((int)offsetof(struct llog_changelog_user_rec2, cur_tail) == 96, "found %lld\n",
+		 (long long)(int)offsetof(struct llog_changelog_user_rec2, cur_tail));
+	LASSERTF((int)sizeof(((struct llog_changelog_user_rec2 *)0)->cur_tail) == 8, "found %lld\n",
+		 (long long)(int)sizeof(((struct llog_changelog_user_rec2 *)0)->cur_tail));
+
 	/* Checks for struct llog_gen */
 	LASSERTF((int)sizeof(struct llog_gen) == 16, "found %lld\n",
 		 (long long)(int)sizeof(struct llog_gen));
@@ -1930,6 +1930,10 @@ int tgt_txn_stop_cb(const struct lu_env *env, struct thandle *th,
 			       tti->tti_transno);
 			RETURN(0);
 		}
+		/* a failed transaction must not reset the transno the reply
+		 * got from an earlier one */
+		if (th->th_result != 0)
+			RETURN(0);
 		/* we need another transno to be assigned */
 		tti->tti_transno = 0;
 	} else if (th->th_result == 0) {
@@ -1950,6 +1954,21 @@ int tgt_txn_stop_cb(const struct lu_env *env, struct thandle *th,
 	return rc;
 }
 
+/**
+ * Allow the request being handled to run several transactions.
+ *
+ * Each successful transaction then gets its own transno, and the reply
+ * carries the last one, so the client knows the request is committed only
+ * once all of them are.
+ *
+ * \param[in] env	execution environment
+ */
+void tgt_mult_trans_enable(const struct lu_env *env)
+{
+	tgt_th_info(env)->tti_mult_trans = 1;
+}
+EXPORT_SYMBOL(tgt_mult_trans_enable);
+
 int tgt_reply_data_init(const struct lu_env *env, struct lu_target *tgt)
 {
 	struct tgt_thread_info	*tti = tgt_th_info(env);
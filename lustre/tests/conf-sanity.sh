@@ -8859,6 +8859,103 @@ test_125()
 }
 run_test 125 "check l_tunedisk only tunes OSTs and their slave devices"
 
+# Restart the filesystem with ksocklnd loaded with the options given on
+# all nodes, the modules are unloaded again at the end of the test
+setup_ksocklnd_opts() {
+	setup
+	cleanup || error "cleanup failed with $?"
+	LOAD_MODULES_REMOTE=true unload_modules ||
+		error "unloading modules failed"
+	stack_trap "cleanup; LOAD_MODULES_REMOTE=true unload_modules" EXIT
+
+	MODOPTS_KSOCKLND="$MODOPTS_KSOCKLND $*" \
+		LOAD_MODULES_REMOTE=true load_modules
+	setup
+}
+
+test_126() {
+	[[ "$NETTYPE" =~ ^tcp ]] || skip "need socklnd"
+	[ "$OST1_VERSION" -lt $(version_code 2.13.55) ] &&
+		skip "Need OST version at least 2.13.55"
+	[ "$(facet_active_host ost1)" == "$HOSTNAME" ] &&
+		skip "need the OST on a remote node"
+
+	local param=/sys/module/ksocklnd/parameters
+	local conns=4
+	local expected
+	local i
+	local ip
+	local nr
+
+	# both ends must use the same conns_per_peer
+	setup_ksocklnd_opts conns_per_peer=$conns
+
+	(( $(cat $param/conns_per_peer) == conns )) ||
+		error "conns_per_peer is $(cat $param/conns_per_peer)"
+	# one control connection and conns_per_peer of each bulk type
+	if (( $(cat $param/typed_conns) )); then
+		expected=$((1 + 2 * conns))
+	else
+		expected=$conns
+	fi
+
+	ip=$($LCTL get_param -n osc.$FSNAME-OST0000-osc-[^M]*.ost_conn_uuid |
+	     sed -e 's/@.*//')
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=16 oflag=direct ||
+		error "dd to $DIR/$tfile failed"
+
+	# connd opens the extra connections one after the other
+	for i in {1..20}; do
+		nr=$(ss -tn state established dst $ip | grep -c "$ip:988")
+		(( nr == expected )) && break
+		sleep 1
+	done
+	ss -tn state established dst $ip
+	(( nr == expected )) ||
+		error "$nr connections to $ip, expected $expected"
+}
+run_test 126 "ksocklnd keeps conns_per_peer bulk connections"
+
+test_127() {
+	[[ "$NETTYPE" =~ ^tcp ]] || skip "need socklnd"
+	[ "$OST1_VERSION" -lt $(version_code 2.13.55) ] &&
+		skip "Need OST version at least 2.13.55"
+	[ "$(facet_active_host ost1)" == "$HOSTNAME" ] &&
+		skip "need the OST on a remote node"
+
+	local tf=$TMP/$tfile
+	local sum
+
+	# bulk in both directions is sent with MSG_ZEROCOPY
+	setup_ksocklnd_opts msg_zerocopy=1
+	# reset by ksocklnd when the kernel has no MSG_ZEROCOPY
+	(( $(cat /sys/module/ksocklnd/parameters/msg_zerocopy) == 1 )) ||
+		skip_env "no MSG_ZEROCOPY support"
+
+	stack_trap "rm -f $tf" EXIT
+	dd if=/dev/urandom of=$tf bs=1M count=64 || error "dd to $tf failed"
+	sum=$(md5sum < $tf)
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile ||
+		error "setstripe $DIR/$tfile failed"
+	dd if=$tf of=$DIR/$tfile bs=4M conv=fsync ||
+		error "dd to $DIR/$tfile failed"
+	cancel_lru_locks osc
+	[ "$(md5sum < $DIR/$tfile)" == "$sum" ] ||
+		error "data mismatch after buffered write"
+
+	dd if=$tf of=$DIR/$tfile bs=4M oflag=direct ||
+		error "direct write to $DIR/$tfile failed"
+	cancel_lru_locks osc
+	[ "$(dd if=$DIR/$tfile bs=4M iflag=direct | md5sum)" == "$sum" ] ||
+		error "data mismatch after direct write"
+
+	# connections with in-flight zero-copy sends are torn down cleanly
+	rm -f $DIR/$tfile
+	cleanup || error "cleanup with msg_zerocopy failed"
+}
+run_test 127 "ksocklnd MSG_ZEROCOPY transmit"
+
 if ! combined_mgs_mds ; then
 	stop mgs
 fi
@@ -0,0 +1,178 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+
+/* Check the ordering of the libcfs heap used by the NRS policies, and
+ * report the cost of its insert and remove operations for growing numbers
+ * of elements, as seen by a policy scheduling that many clients or
+ * classes. */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/random.h>
+#include <linux/vmalloc.h>
+
+#include <libcfs/libcfs.h>
+
+/* Random ID passed by userspace, and printed in messages, used to
+ * separate different runs of that module. */
+static int run_id;
+module_param(run_id, int, 0644);
+MODULE_PARM_DESC(run_id, "run ID");
+
+/* Largest heap to measure; sizes grow by 10x starting at 10000. */
+static unsigned int max_count = 1000000;
+module_param(max_count, uint, 0644);
+MODULE_PARM_DESC(max_count, "maximum number of heap elements");
+
+#define PREFIX "lustre_kheap_%u:"
+
+struct kheap_elem {
+	struct cfs_binheap_node	ke_node;
+	u64			ke_key;
+};
+
+static int kheap_compare(struct cfs_binheap_node *a,
+			 struct cfs_binheap_node *b)
+{
+	return container_of(a, struct kheap_elem, ke_node)->ke_key <=
+	       container_of(b, struct kheap_elem, ke_node)->ke_key;
+}
+
+static struct cfs_binheap_ops kheap_ops = {
+	.hop_enter	= NULL,
+	.hop_exit	= NULL,
+	.hop_compare	= kheap_compare,
+};
+
+static int kheap_run(unsigned int count)
+{
+	struct cfs_binheap *heap;
+	struct kheap_elem *elems;
+	struct kheap_elem *elem;
+	struct cfs_binheap_node *node;
+	ktime_t start;
+	s64 insert_ns;
+	s64 cycle_ns;
+	s64 remove_ns;
+	u64 last = 0;
+	unsigned int i;
+	int rc = 0;
+
+	elems = vmalloc(count * sizeof(*elems));
+	if (!elems)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++)
+		elems[i].ke_key = prandom_u32();
+
+	heap = cfs_binheap_create(&kheap_ops, 0, 4096, NULL, NULL, 0);
+	if (!heap) {
+		rc = -ENOMEM;
+		goto out_free;
+	}
+
+	start = ktime_get();
+	for (i = 0; i < count; i++) {
+		rc = cfs_binheap_insert(heap, &elems[i].ke_node);
+		if (rc)
+			goto out_heap;
+	}
+	insert_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	/* steady state: dequeue the first request and queue a later one, as
+	 * a policy does for a busy service */
+	start = ktime_get();
+	for (i = 0; i < count; i++) {
+		node = cfs_binheap_remove_root(heap);
+		elem = container_of(node, struct kheap_elem, ke_node);
+		elem->ke_key += prandom_u32();
+		rc = cfs_binheap_insert(heap, &elem->ke_node);
+		if (rc)
+			goto out_heap;
+	}
+	cycle_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	start = ktime_get();
+	for (i = 0; i < count; i++) {
+		node = cfs_binheap_remove_root(heap);
+		elem = container_of(node, struct kheap_elem, ke_node);
+		if (elem->ke_key < last) {
+			pr_err(PREFIX " heap order violated at %u/%u: %llu < %llu\n",
+			       run_id, i, count, elem->ke_key, last);
+			rc = -EINVAL;
+			goto out_heap;
+		}
+		last = elem->ke_key;
+	}
+	remove_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	pr_err(PREFIX " %u elements: insert %lld ns, remove+insert %lld ns, remove %lld ns per op\n",
+	       run_id, count, insert_ns / count, cycle_ns / count,
+	       remove_ns / count);
+
+out_heap:
+	while (!cfs_binheap_is_empty(heap))
+		cfs_binheap_remove_root(heap);
+	cfs_binheap_destroy(heap);
+out_free:
+	vfree(elems);
+
+	return rc;
+}
+
+static int __init kheap_init(void)
+{
+	unsigned int count;
+	int rc = 0;
+
+	for (count = 10000; count <= max_count; count *= 10) {
+		rc = kheap_run(count);
+		if (rc) {
+			pr_err(PREFIX " run with %u elements failed: %d\n",
+			       run_id, count, rc);
+			goto out;
+		}
+		if (count > UINT_MAX / 10)
+			break;
+		cond_resched();
+	}
+
+	/* below message is checked in sanity.sh test_423 */
+	pr_err(PREFIX " heap order verified\n", run_id);
+
+out:
+	/* Don't load. */
+	return -EINVAL;
+}
+
+static void __exit kheap_exit(void)
+{
+}
+
+MODULE_AUTHOR("OpenSFS, Inc. <http://www.lustre.org/>");
+MODULE_DESCRIPTION("Lustre NRS heap test module");
+MODULE_VERSION(LUSTRE_VERSION_STRING);
+MODULE_LICENSE("GPL");
+
+module_init(kheap_init);
+module_exit(kheap_exit);
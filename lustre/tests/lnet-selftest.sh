@@ -175,6 +175,54 @@ test_smoke () {
 }
 run_test smoke "lst regression test"
 
+test_latency () {
+	lst_prepare
+
+	local log=$TMP/$tfile.log
+	local rc
+
+	export LST_SESSION=$$
+
+	# latency histograms are opt-in, a default session must refuse them
+	$LST new_session --timeo 100000 hh || error "new_session failed"
+	$LST add_group c $(nids_list $lst_CLIENTS) || error "add_group c"
+	$LST add_group s $(nids_list $lst_SERVERS) || error "add_group s"
+	$LST stat --lat --count 1 c &&
+		error "latency reported without LST_FEATURES"
+	$LST end_session
+
+	LST_FEATURES=3 $LST new_session --timeo 100000 hh ||
+		error "new_session with latency failed"
+	$LST add_group c $(nids_list $lst_CLIENTS) || error "add_group c"
+	$LST add_group s $(nids_list $lst_SERVERS) || error "add_group s"
+	$LST add_batch b || error "add_batch failed"
+	$LST add_test --batch b --loop $lst_LOOP --concurrency 8 \
+		--from c --to s brw mix=30 check=full size=64k ||
+		error "add_test brw mix failed"
+	$LST add_test --batch b --loop $lst_LOOP --from c --to s ping ||
+		error "add_test ping failed"
+	$LST run b || error "run failed"
+	sleep 1
+
+	$LST stat --lat --delay 5 --count 3 c | tee $log
+	rc=${PIPESTATUS[0]}
+
+	lst_end_session --verbose | tee -a $log
+	[ $rc = 0 ] || { _restore_mount; error "stat --lat failed: $rc"; }
+
+	grep -q "^\[RPC Latency of c\]" $log ||
+		{ _restore_mount; error "no RPC latency reported for c"; }
+	# with 30% writes neither direction carries only RPC headers
+	awk '/^\[LNet Bandwidth of c\]/ { getline r; getline w;
+		split(r, rf); split(w, wf); rd = rf[3]; wr = wf[3] }
+	     END { exit !(rd > 0 && wr > 0 && rd < 10 * wr && wr < 10 * rd) }' \
+		$log || { _restore_mount; error "reads and writes not mixed"; }
+
+	check_lst_err $log
+	lst_cleanup_all
+}
+run_test latency "lst latency percentiles with mixed read/write"
+
 complete $SECONDS
 _restore_mount
 check_and_cleanup_lustre
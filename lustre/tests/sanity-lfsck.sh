@@ -5764,6 +5764,54 @@ test_39()
 }
 run_test 39 "LFSCK does not break foreign dir and reverse is also true"
 
+test_40() {
+	[ $MDS1_VERSION -lt $(version_code 2.13.55) ] &&
+		skip "Need MDS version at least 2.13.55"
+
+	local count=100
+	local threads
+
+	lfsck_prep 1 1
+
+	#define OBD_FAIL_LFSCK_LINKEA_CRASH	0x1603
+	do_facet $SINGLEMDS $LCTL set_param fail_loc=0x1603
+	createmany -o $DIR/$tdir/f $count ||
+		error "(1) Fail to create $count files"
+	do_facet $SINGLEMDS $LCTL set_param fail_loc=0
+
+	threads=$(do_facet $SINGLEMDS $LCTL get_param -n \
+		  mdd.${MDT_DEV}.lfsck_assistant_threads)
+	stack_trap "do_facet $SINGLEMDS $LCTL set_param \
+		    mdd.${MDT_DEV}.lfsck_assistant_threads=$threads" EXIT
+	do_facet $SINGLEMDS $LCTL set_param \
+		mdd.${MDT_DEV}.lfsck_assistant_threads=4 ||
+		error "(2) Fail to set lfsck_assistant_threads"
+
+	umount_client $MOUNT
+	$START_NAMESPACE -r || error "(3) Fail to start LFSCK for namespace!"
+	wait_update_facet $SINGLEMDS "$LCTL get_param -n \
+		mdd.${MDT_DEV}.lfsck_namespace |
+		awk '/^status/ { print \\\$2 }'" "completed" 32 || {
+		$SHOW_NAMESPACE
+		error "(4) unexpected status"
+	}
+
+	local repaired=$($SHOW_NAMESPACE |
+			 awk '/^linkea_repaired/ { print $2 }')
+
+	[ $repaired -eq $count ] ||
+		error "(5) Fail to repair crashed linkEA: $repaired/$count"
+
+	mount_client $MOUNT || error "(6) Fail to start client!"
+
+	local fid=$($LFS path2fid $DIR/$tdir/f$((count - 1)))
+	local name=$($LFS fid2path $DIR $fid)
+
+	[ "$name" == "$DIR/$tdir/f$((count - 1))" ] ||
+		error "(7) Fail to repair linkEA: $fid $name"
+}
+run_test 40 "namespace LFSCK with multiple assistant threads"
+
 # restore MDS/OST size
 MDSSIZE=${SAVED_MDSSIZE}
 OSTSIZE=${SAVED_OSTSIZE}
@@ -1142,6 +1142,29 @@ test_103() {
 }
 run_test 103 "Delete route with multiple gw (tcp)"
 
+test_104() {
+	local param=/sys/module/ksocklnd/parameters/conns_per_peer
+	local val
+
+	cleanup_lnet || exit 1
+	load_module ../libcfs/libcfs/libcfs
+	load_module ../lnet/lnet/lnet
+	load_module ../lnet/klnds/socklnd/ksocklnd conns_per_peer=1000 ||
+		error "Can't load ksocklnd.ko"
+	val=$(cat $param)
+	[[ $val -eq 127 ]] || error "conns_per_peer $val, expected 127"
+
+	cleanup_lnet || exit 1
+	load_module ../libcfs/libcfs/libcfs
+	load_module ../lnet/lnet/lnet
+	load_module ../lnet/klnds/socklnd/ksocklnd conns_per_peer=4 ||
+		error "Can't load ksocklnd.ko"
+	val=$(cat $param)
+	[[ $val -eq 4 ]] || error "conns_per_peer $val, expected 4"
+	cleanup_lnet
+}
+run_test 104 "ksocklnd conns_per_peer is kept within range"
+
 ### load lnet in default namespace, configure in target namespace
 
 test_200() {
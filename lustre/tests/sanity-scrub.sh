@@ -1273,6 +1273,158 @@ test_16() {
 }
 run_test 16 "Initial OI scrub can rebuild crashed index objects"
 
+test_17() {
+	[ $(facet_fstype $SINGLEMDS) != "ldiskfs" ] &&
+		skip "ldiskfs special test"
+
+	local mdts=$(comma_list $(mdts_nodes))
+	local threads=4
+	local saved_opts="$MDS_FS_MKFS_OPTS"
+	local ipg
+	local checked
+	local n
+	local i
+
+	# small block groups, so that the files span more groups than threads
+	MDS_FS_MKFS_OPTS="$MDS_FS_MKFS_OPTS -g 4096"
+	stack_trap "MDS_FS_MKFS_OPTS=\"$saved_opts\"" EXIT
+	formatall > /dev/null
+	setupall > /dev/null
+
+	ipg=$(do_facet mds1 "$DUMPE2FS -h $(mdsdevname 1)" 2>/dev/null |
+		awk '/^Inodes per group:/ { print $4 }')
+	[ -n "$ipg" ] || error "(0) Fail to get inodes per group"
+	echo "$ipg inodes per group"
+
+	scrub_prep $((ipg * threads * 2))
+	scrub_remove_ois 1 0
+	echo "start MDTs with OI scrub disabled"
+	scrub_start_mds 2 "$MOUNT_OPTS_NOSCRUB"
+	scrub_check_flags 3 recreated
+
+	do_nodes $mdts $LCTL set_param -n osd-ldiskfs.*.scrub_threads=$threads
+	stack_trap "do_nodes $mdts $LCTL set_param -n \
+		osd-ldiskfs.*.scrub_threads=1" EXIT
+
+	scrub_start 4
+	scrub_check_status 5 completed
+	scrub_check_flags 6 ""
+	scrub_check_repaired 7 1 0
+
+	for n in $(seq $MDSCOUNT); do
+		checked=$(scrub_status $n | awk '/^threads_checked:/ {
+			for (i = 2; i <= NF; i++) printf "%s ", $i }')
+		echo "mds$n: inodes checked by threads: $checked"
+		[ $(echo $checked | wc -w) -eq $threads ] ||
+			error "(8) Expected $threads threads on mds$n: $checked"
+		for i in $checked; do
+			[ $i -gt 0 ] ||
+				error "(9) Idle OI scrub thread on mds$n: $checked"
+		done
+	done
+
+	mount_client $MOUNT || error "(10) Fail to start client!"
+	scrub_check_data 11
+}
+run_test 17 "OI scrub rebuilds OI files with multiple threads"
+
+oi_cache_stat() {
+	do_facet $SINGLEMDS $LCTL get_param -n \
+		osd-ldiskfs.$(facet_svc $SINGLEMDS).oi_cache |
+		awk '/^'$1':/ { print $2 }'
+}
+
+oi_cache_hits() {
+	oi_cache_stat hits
+}
+
+# the lookup of a removed mapping must go past the OI cache
+oi_cache_check_miss() {
+	local fid=$1
+	local step=$2
+	local hits
+	local misses
+
+	oi_cache_flush
+	hits=$(oi_cache_hits)
+	misses=$(oi_cache_stat misses)
+	$LFS fid2path $MOUNT $fid && error "($step) $fid is found"
+	[ $(oi_cache_hits) -eq $hits ] ||
+		error "($step) stale $fid is hit in the OI cache"
+	[ $(oi_cache_stat misses) -gt $misses ] ||
+		error "($step) $fid lookup didn't reach the OI cache"
+}
+
+# drop the objects from the lu_site cache, so that the next lookup of them
+# goes to the OI files or the OI cache in front of them
+oi_cache_flush() {
+	cancel_lru_locks mdc
+	do_facet $SINGLEMDS "sync; echo 3 > /proc/sys/vm/drop_caches"
+}
+
+test_18() {
+	[ $(facet_fstype $SINGLEMDS) != "ldiskfs" ] &&
+		skip "ldiskfs special test"
+
+	local slots=$(do_facet $SINGLEMDS $LCTL get_param -n \
+		osd-ldiskfs.$(facet_svc $SINGLEMDS).oi_cache |
+		awk '/^slots:/ { print $2 }')
+	[ "$slots" -gt 0 ] || skip "OI cache is disabled"
+
+	local hits
+	local fid1
+	local fid2
+	local pid
+
+	check_mount_and_prep
+	$LFS mkdir -i 0 $DIR/$tdir/d || error "(1) Fail to mkdir"
+	touch $DIR/$tdir/d/f1 $DIR/$tdir/d/f2 || error "(2) Fail to touch"
+	fid1=$($LFS path2fid $DIR/$tdir/d/f1)
+	fid2=$($LFS path2fid $DIR/$tdir/d/f2)
+
+	# the second lookup is served by the OI cache
+	oi_cache_flush
+	$LFS fid2path $MOUNT $fid1 || error "(3) Fail to find $fid1"
+	hits=$(oi_cache_hits)
+	oi_cache_flush
+	$LFS fid2path $MOUNT $fid1 || error "(4) Fail to find $fid1"
+	[ $(oi_cache_hits) -gt $hits ] || error "(5) OI cache is not hit"
+
+	# destroy invalidates the cached mapping
+	rm -f $DIR/$tdir/d/f1 || error "(6) Fail to unlink"
+	oi_cache_check_miss $fid1 7
+
+	# ditto for rename over an existing file
+	oi_cache_flush
+	$LFS fid2path $MOUNT $fid2 || error "(8) Fail to find $fid2"
+	touch $DIR/$tdir/d/f3 || error "(9) Fail to touch"
+	fid1=$($LFS path2fid $DIR/$tdir/d/f3)
+	mv $DIR/$tdir/d/f3 $DIR/$tdir/d/f2 || error "(10) Fail to rename"
+	oi_cache_check_miss $fid2 11
+	[ "$($LFS path2fid $DIR/$tdir/d/f2)" == "$fid1" ] ||
+		error "(12) f2 is not $fid1 after rename"
+
+	# a lookup racing with destroy doesn't fill the cache with the
+	# removed mapping
+	touch $DIR/$tdir/d/f4 || error "(13) Fail to touch"
+	fid1=$($LFS path2fid $DIR/$tdir/d/f4)
+	oi_cache_flush
+
+	#define OBD_FAIL_OSD_OI_CACHE_RACE	0x19c
+	do_facet $SINGLEMDS $LCTL set_param fail_val=5 fail_loc=0x8000019c
+	$LFS fid2path $MOUNT $fid1 &
+	pid=$!
+	sleep 1
+	rm -f $DIR/$tdir/d/f4 || error "(14) Fail to unlink"
+	wait $pid
+	do_facet $SINGLEMDS $LCTL set_param fail_val=0 fail_loc=0
+
+	oi_cache_check_miss $fid1 15
+
+	rm -rf $DIR/$tdir || error "(16) Fail to cleanup"
+}
+run_test 18 "OI cache is invalidated by destroy"
+
 # restore MDS/OST size
 MDSSIZE=${SAVED_MDSSIZE}
 OSTSIZE=${SAVED_OSTSIZE}
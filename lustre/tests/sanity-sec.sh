@@ -2243,6 +2243,62 @@ test_30b() {
 }
 run_test 30b "basic test of all different SSK flavors"
 
+test_30c() {
+	local save_flvr=$SK_FLAVOR
+	local param=/sys/module/ptlrpc_gss/parameters
+	local cli_pages=$(cat $param/sk_bulk_parallel_pages)
+	local cli_chunk=$(cat $param/sk_bulk_chunk_pages)
+	local ost_pages
+	local ost_chunk
+	local tf=$TMP/$tfile
+	local sum
+	local mode
+
+	if ! $SHARED_KEY; then
+		skip "need shared key feature for this test"
+	fi
+	[ $OST1_VERSION -lt $(version_code 2.13.55) ] &&
+		skip "Need OST version at least 2.13.55"
+
+	ost_pages=$(do_facet ost1 cat $param/sk_bulk_parallel_pages)
+	ost_chunk=$(do_facet ost1 cat $param/sk_bulk_chunk_pages)
+
+	stack_trap restore_to_default_flavor EXIT
+	SK_FLAVOR=skpi
+	restore_to_default_flavor || error "cannot set skpi flavor"
+	SK_FLAVOR=$save_flvr
+
+	stack_trap "echo $cli_pages > $param/sk_bulk_parallel_pages; \
+		echo $cli_chunk > $param/sk_bulk_chunk_pages" EXIT
+	stack_trap "do_facet ost1 \"echo $ost_pages > \
+		$param/sk_bulk_parallel_pages; \
+		echo $ost_chunk > $param/sk_bulk_chunk_pages\"" EXIT
+	# odd chunk size so chunks don't start on the same pages as RPCs
+	echo 3 > $param/sk_bulk_chunk_pages
+	do_facet ost1 "echo 3 > $param/sk_bulk_chunk_pages"
+
+	stack_trap "rm -f $tf" EXIT
+	dd if=/dev/urandom of=$tf bs=1M count=16 || error "dd to $tf failed"
+	sum=$(md5sum < $tf)
+
+	# parallel on one side and serial on the other, then on both sides:
+	# the cipher text must not depend on how the pages were split
+	for mode in 1:0 0:1 1:1; do
+		echo ${mode%:*} > $param/sk_bulk_parallel_pages
+		do_facet ost1 "echo ${mode#*:} > $param/sk_bulk_parallel_pages"
+
+		$LFS setstripe -c 1 -i 0 $DIR/$tfile ||
+			error "setstripe $DIR/$tfile failed"
+		dd if=$tf of=$DIR/$tfile bs=4M conv=fsync ||
+			error "dd to $DIR/$tfile failed ($mode)"
+		cancel_lru_locks osc
+		[ "$(md5sum < $DIR/$tfile)" == "$sum" ] ||
+			error "data mismatch with client:OST parallel $mode"
+		rm -f $DIR/$tfile || error "rm $DIR/$tfile failed"
+	done
+}
+run_test 30c "SK privacy bulk encrypted in parallel chunks"
+
 cleanup_31() {
 	# unmount client
 	zconf_umount $HOSTNAME $MOUNT || error "unable to umount client"
@@ -14388,6 +14388,57 @@ test_160k() {
 }
 run_test 160k "Verify that changelog records are not lost"
 
+test_160l() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run"
+	remote_mds_nodsh && skip "remote MDS with nodsh"
+	[[ $MDS1_VERSION -ge $(version_code 2.13.55) ]] ||
+		skip "Need MDS version at least 2.13.55"
+
+	local mdt=$(facet_svc $SINGLEMDS)
+
+	test_mkdir -c1 -i0 $DIR/$tdir
+	test_mkdir -c1 -i0 $DIR/$tdir/watched
+	local pfid=$($LFS path2fid $DIR/$tdir/watched)
+
+	local cl_user
+	cl_user=$(do_facet $SINGLEMDS $LCTL --device $mdt \
+		  changelog_register -n -m MKDIR,RMDIR -P $pfid) ||
+		error "register filtered changelog user failed"
+	stack_trap "__changelog_deregister $SINGLEMDS $cl_user" EXIT
+
+	changelog_users $SINGLEMDS | grep "^$cl_user " | grep -q "parent=" ||
+		error "filter of '$cl_user' not shown in changelog_users"
+
+	mkdir $DIR/$tdir/watched/d1 || error "mkdir d1 failed"
+	touch $DIR/$tdir/watched/f1 || error "touch f1 failed"
+	mkdir $DIR/$tdir/d2 || error "mkdir d2 failed"
+	rmdir $DIR/$tdir/watched/d1 || error "rmdir d1 failed"
+
+	local recs=$($LFS changelog $mdt | grep -v MARK)
+
+	echo "$recs"
+	(( $(echo "$recs" | grep -c "MKDIR.*d1") == 1 )) ||
+		error "mkdir in watched directory not recorded"
+	(( $(echo "$recs" | grep -c "RMDIR.*d1") == 1 )) ||
+		error "rmdir in watched directory not recorded"
+	echo "$recs" | grep -q "CREAT" && error "unwanted create recorded"
+	echo "$recs" | grep -q "d2" && error "unwanted mkdir recorded"
+
+	__changelog_deregister $SINGLEMDS $cl_user ||
+		error "deregister '$cl_user' failed"
+
+	# a mask of all types is no filter, and keeps the old user record
+	# format that a downgraded MDT can still read
+	cl_user=$(do_facet $SINGLEMDS $LCTL --device $mdt \
+		  changelog_register -n -m ALL) ||
+		error "register changelog user with all types failed"
+	changelog_users $SINGLEMDS | grep "^$cl_user " | grep -q "mask=" &&
+		error "'$cl_user' registered with a filter"
+	__changelog_deregister $SINGLEMDS $cl_user ||
+		error "deregister '$cl_user' failed"
+}
+run_test 160l "changelog records are filtered for registered users"
+
 test_161a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 
@@ -15919,14 +15970,25 @@ test_215() { # for bugs 18102, 21079, 21517
 	remove_lnet_proc_files "peers"
 
 	# lnet.buffers  should look like this:
-	# pages count credits min
-	# where pages >=0, count >=0, credits and min are numeric (0 or >0 or <0)
-	L1="^pages +count +credits +min$"
-	BR="^ +$N +$N +$I +$I$"
+	# pages count credits min waits wait_ms
+	# where pages >=0, count >=0, credits and min are numeric (0 or >0 or <0),
+	# waits >= 0, wait_ms >= 0
+	L1="^pages +count +credits +min +waits +wait_ms$"
+	BR="^ +$N +$N +$I +$I +$N +$N$"
 	create_lnet_proc_files "buffers"
 	check_lnet_proc_entry "buffers.sys" "lnet.buffers" "$BR" "$L1"
 	remove_lnet_proc_files "buffers"
 
+	# lnet.caches should look like this:
+	# object cpt count hits misses
+	# where object is msg/md/me, cpt >= 0, count >= 0, hits >= 0,
+	# misses >= 0
+	L1="^object +cpt +count +hits +misses$"
+	BR="^(msg|md|me) +$N +$N +$N +$N$"
+	create_lnet_proc_files "caches"
+	check_lnet_proc_entry "caches.sys" "lnet.caches" "$BR" "$L1"
+	remove_lnet_proc_files "caches"
+
 	# lnet.nis should look like this:
 	# nid status alive refs peer rtr max tx min
 	# where nid is a string like 192.168.1.1@tcp2, status is up/down,
@@ -17159,6 +17221,116 @@ test_230m() {
 }
 run_test 230m "xattrs not changed after dir migration"
 
+test_230n() {
+	[ $MDSCOUNT -lt 2 ] && skip "needs >= 2 MDTs"
+	[ $MDS1_VERSION -lt $(version_code 2.13.55) ] &&
+		skip "Need MDS version at least 2.13.55"
+
+	local mdts=$(comma_list $(mdts_nodes))
+	local total=1000
+	local count
+	local fid
+
+	do_nodes $mdts "$LCTL set_param mdt.*.dir_split_count=100 \
+		mdt.*.dir_split_delta=1 mdt.*.enable_dir_auto_split=1"
+	stack_trap "do_nodes $mdts $LCTL set_param \
+		mdt.*.dir_split_count=50000 mdt.*.dir_split_delta=4 \
+		mdt.*.enable_dir_auto_split=0" EXIT
+
+	$LFS mkdir -i 0 -c 1 $DIR/$tdir || error "mkdir failed"
+	fid=$($LFS path2fid $DIR/$tdir)
+	createmany -o $DIR/$tdir/f_________________________________________ \
+		$total || error "create files failed"
+
+	wait_update $HOSTNAME "$LFS getdirstripe -c $DIR/$tdir" "2" 60 ||
+		error "$tdir not split"
+	$LFS getdirstripe $DIR/$tdir
+
+	# split in place, open handles and cwd are still valid
+	[ "$($LFS path2fid $DIR/$tdir)" == "$fid" ] ||
+		error "$tdir FID changed from $fid"
+
+	count=$(ls $DIR/$tdir | wc -l)
+	[ $count -eq $total ] || error "$count files left, expect $total"
+
+	count=$($LFS getdirstripe -i $DIR/$tdir)
+	[ $count -eq 0 ] || error "master on MDT$count, expect MDT0"
+
+	# files moved to the stripe on MDT1 are migrated there too
+	count=$($LFS getstripe -m $DIR/$tdir/f* | grep -c "^1$")
+	[ $count -gt 0 ] || error "no file migrated to MDT1"
+	createmany -o $DIR/$tdir/g 100 || error "create after split failed"
+	unlinkmany $DIR/$tdir/f_________________________________________ \
+		$total || error "unlink files failed"
+	unlinkmany $DIR/$tdir/g 100 || error "unlink after split failed"
+	rmdir $DIR/$tdir || error "rmdir failed"
+}
+run_test 230n "directory is split when it grows large"
+
+test_230o() {
+	[ $MDSCOUNT -lt 2 ] && skip "needs >= 2 MDTs"
+	[ $MDS1_VERSION -lt $(version_code 2.13.55) ] &&
+		skip "Need MDS version at least 2.13.55"
+
+	local mdts=$(comma_list $(mdts_nodes))
+	local total=1000
+	local count
+	local fid
+	local i
+
+	do_nodes $mdts "$LCTL set_param mdt.*.dir_split_count=100 \
+		mdt.*.dir_split_delta=1 mdt.*.enable_dir_auto_split=1"
+	stack_trap "do_nodes $mdts $LCTL set_param \
+		mdt.*.dir_split_count=50000 mdt.*.dir_split_delta=4 \
+		mdt.*.enable_dir_auto_split=0" EXIT
+
+	$LFS mkdir -i 0 -c 1 $DIR/$tdir || error "mkdir failed"
+	fid=$($LFS path2fid $DIR/$tdir)
+
+	# stop the split once some entries are moved
+	#define OBD_FAIL_MIGRATE_SPLIT_STOP	0x1802
+	do_facet mds1 $LCTL set_param fail_loc=0x1802
+	stack_trap "do_facet mds1 $LCTL set_param fail_loc=0" EXIT
+	createmany -o $DIR/$tdir/f_________________________________________ \
+		$total || error "create files failed"
+
+	wait_update_facet mds1 "dmesg | grep -cF 'split of $fid was interrupted'" \
+		"1" 60 || error "split of $tdir is not interrupted"
+	do_facet mds1 $LCTL set_param fail_loc=0
+	$LFS getdirstripe $DIR/$tdir
+	$LFS getdirstripe -H $DIR/$tdir | grep -q split ||
+		error "$tdir is not being split"
+
+	count=$(ls $DIR/$tdir | wc -l)
+	[ $count -eq $total ] || error "$count files in split, expect $total"
+
+	# namespace LFSCK leaves the directory being split alone
+	do_facet mds1 $LCTL lfsck_start -M $(facet_svc mds1) -A -C \
+		-t namespace
+	for i in $(seq $MDSCOUNT); do
+		wait_update_facet mds$i "$LCTL get_param -n \
+			mdd.$(facet_svc mds$i).lfsck_namespace |
+			awk '/^status/ { print \\\$2 }'" "completed" ||
+			error "LFSCK on mds$i not completed"
+	done
+	count=$(ls $DIR/$tdir | wc -l)
+	[ $count -eq $total ] || error "$count files after LFSCK, expect $total"
+
+	# resume the split as the MDT suggests
+	$LFS migrate -m 0 -c 2 -H fnv_1a_64 $DIR/$tdir ||
+		error "resume split failed"
+	$LFS getdirstripe $DIR/$tdir
+	[ $($LFS getdirstripe -c $DIR/$tdir) -eq 2 ] ||
+		error "$tdir is not split to 2 stripes"
+
+	count=$(ls $DIR/$tdir | wc -l)
+	[ $count -eq $total ] || error "$count files left, expect $total"
+	unlinkmany $DIR/$tdir/f_________________________________________ \
+		$total || error "unlink files failed"
+	rmdir $DIR/$tdir || error "rmdir failed"
+}
+run_test 230o "interrupted directory split can be resumed"
+
 test_231a()
 {
 	# For simplicity this test assumes that max_pages_per_rpc
@@ -21920,6 +22092,152 @@ test_422() {
 }
 run_test 422 "kill a process with RPC in progress"
 
+test_423() {
+	[[ -f $LUSTRE/tests/kernel/kheap.ko ]] ||
+		skip "kheap.ko module not available"
+
+	local run_id=$RANDOM
+
+	# The module runs its checks at load time and always refuses to load.
+	insmod $LUSTRE/tests/kernel/kheap.ko run_id=$run_id \
+		max_count=1000000 &> /dev/null
+
+	dmesg | grep "lustre_kheap_$run_id:"
+	dmesg | grep -q "lustre_kheap_$run_id: heap order verified" ||
+		error "NRS heap test failed"
+}
+run_test 423 "NRS heap ordering and insert/remove cost"
+
+test_424() {
+	[ "$ost1_FSTYPE" != "ldiskfs" ] && skip_env "ldiskfs only test"
+	[ $OST1_VERSION -lt $(version_code 2.13.55) ] &&
+		skip "Need OST version at least 2.13.55"
+
+	local pipeline=$(do_facet ost1 $LCTL get_param -n \
+			 osd-ldiskfs.$FSNAME-OST0000.write_pipeline_kb)
+	local tf=$TMP/$tfile
+	local sum1
+	local sum2
+
+	stack_trap "do_facet ost1 $LCTL set_param \
+		osd-ldiskfs.$FSNAME-OST0000.write_pipeline_kb=$pipeline" EXIT
+	do_facet ost1 $LCTL set_param \
+		osd-ldiskfs.$FSNAME-OST0000.write_pipeline_kb=64 ||
+		error "set write_pipeline_kb failed"
+
+	stack_trap "rm -f $tf" EXIT
+	dd if=/dev/urandom of=$tf bs=1M count=16 ||
+		error "dd to $tf failed"
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile ||
+		error "setstripe $DIR/$tfile failed"
+	dd if=$tf of=$DIR/$tfile bs=4M oflag=direct ||
+		error "dd to $DIR/$tfile failed"
+
+	cancel_lru_locks osc
+	sum1=$(md5sum < $tf)
+	sum2=$(md5sum < $DIR/$tfile)
+	[ "$sum1" == "$sum2" ] ||
+		error "data mismatch with pipelined write: $sum1 != $sum2"
+}
+run_test 424 "write mapped and submitted by chunks on OST"
+
+test_425() {
+	[ "$ost1_FSTYPE" != "ldiskfs" ] && skip_env "ldiskfs only test"
+	[ $OST1_VERSION -lt $(version_code 2.13.55) ] &&
+		skip "Need OST version at least 2.13.55"
+	[ -n "$OST_RCACHE_DEV" ] ||
+		skip_env "OST_RCACHE_DEV is not set"
+
+	local param=osd-ldiskfs.$FSNAME-OST0000
+	local admit=$(do_facet ost1 $LCTL get_param -n $param.read_cache_admit)
+	local rcache=$(do_facet ost1 $LCTL get_param -n $param.read_cache_enable)
+	local tf=$TMP/$tfile
+	local hits
+	local sum
+
+	stack_trap "do_facet ost1 $LCTL set_param $param.read_cache_dev=none \
+		$param.read_cache_admit=$admit \
+		$param.read_cache_enable=$rcache" EXIT
+	do_facet ost1 $LCTL set_param $param.read_cache_dev=$OST_RCACHE_DEV \
+		$param.read_cache_admit=1 $param.read_cache_enable=0 ||
+		error "cannot use $OST_RCACHE_DEV as read cache"
+
+	# a bad device must not drop the current one
+	do_facet ost1 $LCTL set_param $param.read_cache_dev=/dev/$tfile &&
+		error "/dev/$tfile used as read cache"
+	[ "$(do_facet ost1 $LCTL get_param -n $param.read_cache_dev)" == \
+	  "$OST_RCACHE_DEV" ] || error "read cache $OST_RCACHE_DEV dropped"
+
+	stack_trap "rm -f $tf" EXIT
+	dd if=/dev/urandom of=$tf bs=1M count=8 || error "dd to $tf failed"
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile ||
+		error "setstripe $DIR/$tfile failed"
+	cp $tf $DIR/$tfile || error "cp to $DIR/$tfile failed"
+	sum=$(md5sum < $tf)
+
+	# first read admits the chunks, second one is served from the cache
+	for i in 1 2; do
+		cancel_lru_locks osc
+		[ "$(md5sum < $DIR/$tfile)" == "$sum" ] ||
+			error "data mismatch on read $i"
+	done
+	do_facet ost1 $LCTL get_param $param.read_cache_stats
+	hits=$(do_facet ost1 $LCTL get_param -n $param.read_cache_stats |
+	       awk '/^hits:/ { print $2 }')
+	(( hits > 0 )) || error "no read served from the cache"
+
+	# overwrite and truncate must drop the stale cached pages
+	dd if=/dev/urandom of=$tf bs=64K count=4 seek=3 conv=notrunc ||
+		error "dd to $tf failed"
+	$TRUNCATE $tf $((6 * 1048576 + 1234)) || error "truncate $tf failed"
+	dd if=$tf of=$DIR/$tfile bs=64K count=4 skip=3 seek=3 conv=notrunc ||
+		error "dd to $DIR/$tfile failed"
+	$TRUNCATE $DIR/$tfile $((6 * 1048576 + 1234)) ||
+		error "truncate $DIR/$tfile failed"
+	sum=$(md5sum < $tf)
+	cancel_lru_locks osc
+	[ "$(md5sum < $DIR/$tfile)" == "$sum" ] ||
+		error "stale data read from the cache"
+}
+run_test 425 "OST read cache on a local block device"
+
+test_426() {
+	[ $MDS1_VERSION -lt $(version_code 2.13.55) ] &&
+		skip "Need MDS version at least 2.13.55"
+	[ $OST1_VERSION -lt $(version_code 2.13.55) ] &&
+		skip "Need OST version at least 2.13.55"
+
+	local osp=$(get_mdtosc_proc_path mds1 $FSNAME-OST0000)
+	local max=$(do_facet mds1 $LCTL get_param -n osp.$osp.destroy_batch_max)
+	local nr=500
+	local destroys
+
+	do_facet mds1 $LCTL get_param -n osp.$osp.import |
+		grep -q "destroy_batch" || error "destroy_batch not negotiated"
+
+	stack_trap "do_facet mds1 $LCTL set_param \
+		osp.$osp.destroy_batch_max=$max" EXIT
+	do_facet mds1 $LCTL set_param osp.$osp.destroy_batch_max=64 ||
+		error "set destroy_batch_max failed"
+
+	test_mkdir -i 0 $DIR/$tdir || error "mkdir $tdir failed"
+	$LFS setstripe -c 1 -i 0 $DIR/$tdir || error "setstripe $tdir failed"
+	createmany -o $DIR/$tdir/f $nr || error "create $nr files failed"
+	wait_delete_completed
+
+	do_facet ost1 $LCTL set_param -n obdfilter.$FSNAME-OST0000.stats=clear
+	unlinkmany $DIR/$tdir/f $nr || error "unlink $nr files failed"
+	wait_delete_completed
+
+	destroys=$(do_facet ost1 $LCTL get_param -n \
+		   obdfilter.$FSNAME-OST0000.stats |
+		   awk '/^destroy/ { print $2 }')
+	echo "$nr objects destroyed by ${destroys:-0} RPCs"
+	(( ${destroys:-0} > 0 && destroys < nr )) ||
+		error "$nr objects destroyed by ${destroys:-0} RPCs"
+}
+run_test 426 "batched OST object destroy from MDT"
+
 prep_801() {
 	[[ $MDS1_VERSION -lt $(version_code 2.9.55) ]] ||
 	[[ $OST1_VERSION -lt $(version_code 2.9.55) ]] &&
@@ -2996,6 +2996,106 @@ test_55d()
 }
 run_test 55d "rename file vs link"
 
+test_55e()
+{
+	local count=200
+
+	mkdir -p $DIR/$tdir/d1 $DIR/$tdir/d2 || error "(1) mkdir failed"
+	createmany -o $DIR/$tdir/d1/f $count || error "(2) create failed"
+	createmany -o $DIR/$tdir/d2/g $count || error "(3) create failed"
+
+	# file renames between directories share the BFL lock, so renames
+	# in opposite directions must not deadlock
+	for ((i = 0; i < count; i++)); do
+		mv $DIR/$tdir/d1/f$i $DIR/$tdir/d2/ || exit 1
+	done &
+	PID1=$!
+	for ((i = 0; i < count; i++)); do
+		mv $DIR2/$tdir/d2/g$i $DIR2/$tdir/d1/ || exit 1
+	done &
+	PID2=$!
+
+	wait $PID1 || error "(4) rename d1 -> d2 failed"
+	wait $PID2 || error "(5) rename d2 -> d1 failed"
+
+	local nr1=$(ls $DIR/$tdir/d1 | wc -l)
+	local nr2=$(ls $DIR/$tdir/d2 | wc -l)
+	(( nr1 == count && nr2 == count )) ||
+		error "(6) d1 has $nr1 and d2 has $nr2 entries, expect $count"
+
+	# directory renames still can't create a loop
+	mkdir $DIR/$tdir/d1/s1 $DIR/$tdir/d2/s2 || error "(7) mkdir failed"
+	mv -T $DIR/$tdir/d1 $DIR/$tdir/d2/s2/d1 &
+	PID1=$!
+	mv -T $DIR2/$tdir/d2 $DIR2/$tdir/d1/s1/d2 &
+	PID2=$!
+	wait $PID1
+	local rc1=$?
+	wait $PID2
+	local rc2=$?
+	(( rc1 != 0 || rc2 != 0 )) || error "(8) both renames succeeded"
+
+	rm -rf $DIR/$tdir
+}
+run_test 55e "cross-directory file renames in both directions"
+
+test_55f()
+{
+	local count=200
+	local x=$tdir/x
+	local y=$tdir/x/a/y
+	local z=$tdir/z
+	local pids=""
+	local pid
+
+	mkdir -p $DIR/$y $DIR/$z || error "(1) mkdir failed"
+	createmany -o $DIR/$x/f $count || error "(2) create failed"
+	createmany -o $DIR/$y/g $count || error "(3) create failed"
+	createmany -o $DIR/$z/h $count || error "(4) create failed"
+
+	# x is an ancestor of y, so "ancestor first" and FID order may
+	# disagree; renames x -> y, y -> z and z -> x form a cycle that
+	# deadlocks unless every rename locks the parents in one order
+	for ((i = 0; i < count; i++)); do
+		mv $DIR/$x/f$i $DIR/$y/ || exit 1
+	done &
+	pids="$pids $!"
+	for ((i = 0; i < count; i++)); do
+		mv $DIR2/$y/g$i $DIR2/$z/ || exit 1
+	done &
+	pids="$pids $!"
+	for ((i = 0; i < count; i++)); do
+		mv $DIR/$z/h$i $DIR/$x/ || exit 1
+	done &
+	pids="$pids $!"
+	# and the same pair in the other direction, descendant to ancestor
+	for ((i = 0; i < count; i++)); do
+		touch $DIR2/$y/r$i && mv $DIR2/$y/r$i $DIR2/$x/ || exit 1
+	done &
+	pids="$pids $!"
+	# directory moves take the BFL lock exclusively, and must not
+	# deadlock with the file renames between the same parents
+	mkdir $DIR/$x/d || error "(5) mkdir failed"
+	for ((i = 0; i < count / 10; i++)); do
+		mv -T $DIR/$x/d $DIR/$y/d && mv -T $DIR/$y/d $DIR/$x/d ||
+			exit 1
+	done &
+	pids="$pids $!"
+
+	for pid in $pids; do
+		wait $pid || error "(6) rename failed"
+	done
+
+	local nrx=$(ls $DIR/$x | grep -c -v '^[ad]$')
+	local nry=$(ls $DIR/$y | wc -l)
+	local nrz=$(ls $DIR/$z | wc -l)
+	(( nrx == 2 * count && nry == count && nrz == count )) ||
+		error "(7) x has $nrx, y $nry and z $nrz entries"
+
+	rm -rf $DIR/$tdir
+}
+run_test 55f "cross-directory file renames between nested directories"
+
 test_60() {
 	[ $MDS1_VERSION -lt $(version_code 2.3.0) ] &&
 		skip "MDS version must be >= 2.3.0"
@@ -4056,6 +4156,41 @@ test_77n() { #LU-10802
 }
 run_test 77n "check wildcard support for TBF JobID NRS policy"
 
+test_77o() {
+	[ "$OST1_VERSION" -lt $(version_code 2.13.55) ] &&
+		skip "Need OST version at least 2.13.55"
+
+	local nodes=$(comma_list $(osts_nodes))
+	local type
+
+	for type in nid jobid opcode; do
+		do_nodes $nodes lctl set_param \
+			ost.OSS.ost_io.nrs_policies="codel\ $type" ||
+			error "failed to set codel $type policy"
+
+		do_nodes $nodes lctl set_param \
+			ost.OSS.ost_io.nrs_codel_target=1 \
+			ost.OSS.ost_io.nrs_codel_interval=10 ||
+			error "failed to set codel tunables"
+
+		echo "policy: codel $type, target 1ms, interval 10ms"
+		nrs_write_read
+
+		do_facet ost1 lctl get_param ost.OSS.ost_io.nrs_codel_stats ||
+			error "failed to read codel stats"
+	done
+
+	do_nodes $nodes lctl set_param ost.OSS.ost_io.nrs_codel_target=0 &&
+		error "codel target 0 should be rejected"
+
+	do_nodes $nodes lctl set_param ost.OSS.ost_io.nrs_policies="codel\ foo" &&
+		error "codel with unknown class type should fail"
+
+	do_nodes $nodes lctl set_param ost.OSS.ost_io.nrs_policies="fifo" ||
+		error "failed to set policy back to fifo"
+}
+run_test 77o "check CoDel NRS policy"
+
 test_78() { #LU-6673
 	local rc
 
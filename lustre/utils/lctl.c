@@ -374,7 +374,11 @@ command_t cmdlist[] = {
 	{"===  Changelogs ==", NULL, 0, "changelog user management"},
 	{"changelog_register", jt_changelog_register, 0,
 	 "register a new persistent changelog user, returns id\n"
-	 "usage: --device <mdtname> changelog_register [-n]"},
+	 "usage: --device <mdtname> changelog_register [-n] [-m type[,...]]\n"
+	 "       [-p projid] [-P parent_fid] [-j jobid]\n"
+	 "  -m: only record these changelog types (e.g. CREAT,UNLNK)\n"
+	 "  -p/-P/-j: only record changes to files of this project, in this\n"
+	 "            directory or made by this job"},
 	{"changelog_deregister", jt_changelog_deregister, 0,
 	 "deregister an existing changelog user\n"
 	 "usage: --device <mdtname> changelog_deregister <id>"},
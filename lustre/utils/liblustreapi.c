@@ -3092,6 +3092,8 @@ void lmv_dump_user_lmm(struct lmv_user_md *lum, char *pool_name,
 
 		if (flags & LMV_HASH_FLAG_MIGRATION)
 			llapi_printf(LLAPI_MSG_NORMAL, ",migrating");
+		if (flags & LMV_HASH_FLAG_SPLIT)
+			llapi_printf(LLAPI_MSG_NORMAL, ",splitting");
 		if (flags & LMV_HASH_FLAG_BAD_TYPE)
 			llapi_printf(LLAPI_MSG_NORMAL, ",bad_type");
 		if (flags & LMV_HASH_FLAG_LOST_LMV)
@@ -664,6 +664,24 @@ static void print_hsm_action(struct llog_agent_req_rec *larr)
 	       hai_dump_data_field(&larr->arr_hai, buf, sizeof(buf)));
 }
 
+static void print_changelog_user_rec2(struct llog_changelog_user_rec2 *rec)
+{
+	__u32 flags = __le32_to_cpu(rec->cur_filter.cuf_flags);
+
+	printf("changelog_user record id:0x%x user:%u endrec:%llu mask:0x%x",
+	       __le32_to_cpu(rec->cur_hdr.lrh_id), __le32_to_cpu(rec->cur_id),
+	       (unsigned long long)__le64_to_cpu(rec->cur_endrec),
+	       __le32_to_cpu(rec->cur_filter.cuf_mask));
+	if (flags & CLUF_PROJID)
+		printf(" projid:%u", __le32_to_cpu(rec->cur_filter.cuf_projid));
+	if (flags & CLUF_PFID)
+		printf(" parent:"DFID, PFID(&rec->cur_filter.cuf_pfid));
+	if (flags & CLUF_JOBID)
+		printf(" jobid:%.*s", LUSTRE_JOBID_SIZE,
+		       rec->cur_filter.cuf_jobid);
+	printf("\n");
+}
+
 void print_changelog_rec(struct llog_changelog_rec *rec)
 {
 	time_t secs;
@@ -811,6 +829,10 @@ static void print_records(struct llog_rec_hdr **recs,
 			printf("changelog_user record id:0x%x\n",
 			       __le32_to_cpu(recs[i]->lrh_id));
 			break;
+		case CHANGELOG_USER_REC2:
+			print_changelog_user_rec2(
+				(struct llog_changelog_user_rec2 *)recs[i]);
+			break;
 		default:
 			printf("unknown type %x\n", lopt);
 			break;
@@ -5315,34 +5315,110 @@ int jt_get_obj_version(int argc, char **argv)
 	return 0;
 }
 
+/* parse a comma separated list of changelog record type names into a mask */
+static int changelog_str2mask(const char *str, __u32 *mask)
+{
+	char *buf;
+	char *name;
+	char *tmp;
+	int type;
+
+	buf = strdup(str);
+	if (buf == NULL)
+		return -ENOMEM;
+
+	*mask = 0;
+	tmp = buf;
+	while ((name = strsep(&tmp, ",")) != NULL) {
+		if (*name == '\0')
+			continue;
+		if (strcasecmp(name, "ALL") == 0) {
+			*mask = (1U << CL_LAST) - 1;
+			continue;
+		}
+		for (type = 0; type < CL_LAST; type++)
+			if (strcasecmp(name, changelog_type2str(type)) == 0)
+				break;
+		if (type == CL_LAST) {
+			fprintf(stderr, "error: unknown changelog type '%s'\n",
+				name);
+			free(buf);
+			return -EINVAL;
+		}
+		*mask |= 1U << type;
+	}
+	free(buf);
+
+	return *mask == 0 ? -EINVAL : 0;
+}
+
 int jt_changelog_register(int argc, char **argv)
 {
 	struct obd_ioctl_data	 data = { 0 };
 	char			 rawbuf[MAX_IOC_BUFLEN] = "";
 	char			*buf = rawbuf;
 	char			*device = lcfg_get_devname();
+	struct changelog_user_filter filter = { 0 };
 	bool			 print_name_only = false;
+	char			*end;
 	int			 c;
 	int			 rc;
 
-	if (argc > 2)
-		return CMD_HELP;
-
-	while ((c = getopt(argc, argv, "hn")) >= 0) {
+	while ((c = getopt(argc, argv, "hj:m:nP:p:")) >= 0) {
 		switch (c) {
+		case 'j':
+			if (strlen(optarg) >= sizeof(filter.cuf_jobid)) {
+				fprintf(stderr, "error: %s: jobid too long\n",
+					jt_cmdname(argv[0]));
+				return CMD_HELP;
+			}
+			strncpy(filter.cuf_jobid, optarg,
+				sizeof(filter.cuf_jobid) - 1);
+			filter.cuf_flags |= CLUF_JOBID;
+			break;
+		case 'm':
+			rc = changelog_str2mask(optarg, &filter.cuf_mask);
+			if (rc < 0)
+				return CMD_HELP;
+			break;
 		case 'n':
 			print_name_only = true;
 			break;
+		case 'P':
+			rc = llapi_fid_parse(optarg, &filter.cuf_pfid, &end);
+			if (rc < 0 || *end != '\0') {
+				fprintf(stderr, "error: %s: bad parent FID '%s'\n",
+					jt_cmdname(argv[0]), optarg);
+				return CMD_HELP;
+			}
+			filter.cuf_flags |= CLUF_PFID;
+			break;
+		case 'p':
+			filter.cuf_projid = strtoul(optarg, &end, 0);
+			if (*end != '\0') {
+				fprintf(stderr, "error: %s: bad projid '%s'\n",
+					jt_cmdname(argv[0]), optarg);
+				return CMD_HELP;
+			}
+			filter.cuf_flags |= CLUF_PROJID;
+			break;
 		case 'h':
 		default:
 			return CMD_HELP;
 		}
 	}
 
+	if (optind != argc)
+		return CMD_HELP;
+
 	if (cur_device < 0 || device == NULL)
 		return CMD_HELP;
 
 	data.ioc_dev = cur_device;
+	if (filter.cuf_mask != 0 || filter.cuf_flags != 0) {
+		data.ioc_inlbuf1 = (char *)&filter;
+		data.ioc_inllen1 = sizeof(filter);
+	}
 
 	rc = llapi_ioctl_pack(&data, &buf, sizeof(rawbuf));
 	if (rc < 0) {
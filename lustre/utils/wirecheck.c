@@ -615,6 +615,7 @@ check_obd_connect_data(void)
 	CHECK_DEFINE_64X(OBD_CONNECT2_CRUSH);
 	CHECK_DEFINE_64X(OBD_CONNECT2_ASYNC_DISCARD);
 	CHECK_DEFINE_64X(OBD_CONNECT2_ENCRYPT);
+	CHECK_DEFINE_64X(OBD_CONNECT2_DESTROY_BATCH);
 
 	CHECK_VALUE_X(OBD_CKSUM_CRC32);
 	CHECK_VALUE_X(OBD_CKSUM_ADLER);
@@ -855,6 +856,7 @@ check_lmv_mds_md_v1(void)
 	CHECK_CDEFINE(LMV_HASH_TYPE_MASK);
 	CHECK_CDEFINE(LMV_HASH_FLAG_LOST_LMV);
 	CHECK_CDEFINE(LMV_HASH_FLAG_BAD_TYPE);
+	CHECK_CDEFINE(LMV_HASH_FLAG_SPLIT);
 	CHECK_CDEFINE(LMV_HASH_FLAG_MIGRATION);
 }
 
@@ -1661,6 +1663,7 @@ check_llog_logid(void)
 	CHECK_CVALUE(LLOG_GEN_REC);
 	CHECK_CVALUE(CHANGELOG_REC);
 	CHECK_CVALUE(CHANGELOG_USER_REC);
+	CHECK_CVALUE(CHANGELOG_USER_REC2);
 	CHECK_CVALUE(LLOG_HDR_MAGIC);
 	CHECK_CVALUE(LLOG_LOGID_MAGIC);
 }
@@ -1827,6 +1830,32 @@ check_llog_changelog_user_rec(void)
 	CHECK_MEMBER(llog_changelog_user_rec, cur_tail);
 }
 
+static void
+check_changelog_user_filter(void)
+{
+	BLANK_LINE();
+	CHECK_STRUCT(changelog_user_filter);
+	CHECK_MEMBER(changelog_user_filter, cuf_mask);
+	CHECK_MEMBER(changelog_user_filter, cuf_flags);
+	CHECK_MEMBER(changelog_user_filter, cuf_projid);
+	CHECK_MEMBER(changelog_user_filter, cuf_padding);
+	CHECK_MEMBER(changelog_user_filter, cuf_pfid);
+	CHECK_MEMBER(changelog_user_filter, cuf_jobid);
+}
+
+static void
+check_llog_changelog_user_rec2(void)
+{
+	BLANK_LINE();
+	CHECK_STRUCT(llog_changelog_user_rec2);
+	CHECK_MEMBER(llog_changelog_user_rec2, cur_hdr);
+	CHECK_MEMBER(llog_changelog_user_rec2, cur_id);
+	CHECK_MEMBER(llog_changelog_user_rec2, cur_time);
+	CHECK_MEMBER(llog_changelog_user_rec2, cur_endrec);
+	CHECK_MEMBER(llog_changelog_user_rec2, cur_filter);
+	CHECK_MEMBER(llog_changelog_user_rec2, cur_tail);
+}
+
 static void
 check_llog_gen(void)
 {
@@ -2923,6 +2952,8 @@ main(int argc, char **argv)
 	check_changelog_setinfo();
 	check_llog_changelog_rec();
 	check_llog_changelog_user_rec();
+	check_changelog_user_filter();
+	check_llog_changelog_user_rec2();
 	check_llog_gen();
 	check_llog_gen_rec();
 	check_llog_log_hdr();